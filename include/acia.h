@@ -0,0 +1,52 @@
+#ifndef ACIA_H
+#define ACIA_H
+
+#include "cpu.h"
+#include "sched.h"
+
+// --- ACIA 6551 (UART) ---
+// L'émission écrit dans un descripteur de fichier hôte (pipe, fichier, terminal),
+// la réception lit un descripteur non bloquant. La durée d'un octet est
+// calculée à partir du débit programmé et de la fréquence du CPU émulé ;
+// les échéances d'émission et de réception passent par l'ordonnanceur.
+
+// Registres (adresse & 0x03)
+enum { ACIA_DATA, ACIA_STATUS, ACIA_COMMAND, ACIA_CONTROL };
+
+// Bits du registre d'état
+#define ACIA_ST_OVERRUN (1 << 2)
+#define ACIA_ST_RDRF    (1 << 3) // Octet reçu disponible
+#define ACIA_ST_TDRE    (1 << 4) // Registre d'émission vide
+#define ACIA_ST_IRQ     (1 << 7)
+
+typedef struct {
+    u8 rx_data, tx_data;
+    u8 tx_shift;    // Octet en cours d'émission
+    u8 status, command, control;
+    u8 tx_busy;
+    u8 rx_eof;      // Fin de fichier atteinte sur l'entrée
+    int rx_fd, tx_fd; // -1 : non connecté
+    int rx_flags;     // Drapeaux d'origine de rx_fd (-1 : non modifiés)
+    u64 cpu_hz;     // Fréquence du CPU émulé (cycles par seconde)
+
+    CPU *cpu;
+    Scheduler *sched;
+    u8 irq_source;
+    int ev_tx, ev_rx;
+
+    u64 bytes_rx, bytes_tx;
+} Acia;
+
+// Initialise l'ACIA et le mappe sur la page 'page' (registres répétés tous les 4 octets).
+// rx_fd est passé en mode non bloquant jusqu'à acia_detach.
+void acia_attach(Acia *acia, Memory *mem, u8 page, CPU *cpu, Scheduler *sched, u8 irq_source,
+                 int rx_fd, int tx_fd, u64 cpu_hz);
+// Rend à rx_fd ses drapeaux d'origine : O_NONBLOCK porte sur la description
+// de fichier, partagée avec le shell quand rx_fd est l'entrée standard
+void acia_detach(Acia *acia);
+u8 acia_read(void *ctx, u16 address);
+void acia_write(void *ctx, u16 address, u8 value);
+
+// Durée d'un octet (start + bits + stop) en cycles CPU, selon le registre de contrôle
+u64 acia_byte_cycles(const Acia *acia);
+#endif
@@ -0,0 +1,94 @@
+#ifndef AOT_H
+#define AOT_H
+
+#include "cpu.h"
+
+// --- Exécution de code traduit à l'avance (rec6502) ---
+// rec6502 traduit une ROM en C : une fonction par routine découverte par
+// l'analyse statique, qui appelle directement les handlers de
+// instructions.c et addressing.c avec les adresses résolues à la traduction.
+// Ce module est le petit runtime lié au fichier généré : il aiguille PC vers
+// la fonction qui contient le bloc, et rend la main à l'interpréteur pour
+// tout ce qui n'a pas été traduit (saut indirect vers une cible inconnue,
+// interruption, code modifié depuis la traduction).
+//
+// Les octets recopiés dans le C (opcodes, opérandes des adresses fixes) sont
+// surveillés : un bloc dont un de ces octets diffère de l'image traduite
+// repasse à l'interpréteur, et redevient natif si l'octet est restauré.
+
+typedef struct AotRuntime AotRuntime;
+// 'entry' : numéro du bloc dans la fonction (switch dense à l'entrée)
+typedef void (*AotFunc)(CPU *cpu, AotRuntime *rt, int entry);
+
+// Début de bloc de base -> fonction qui le contient
+typedef struct {
+    u16 address;
+    u16 entry;
+    AotFunc func;
+} AotBlock;
+
+// Octets d'une instruction recopiés dans le code traduit
+typedef struct {
+    u16 block;   // Début du bloc qui les utilise
+    u16 address;
+    u8 length;   // 1 à 3
+    u8 bytes[3]; // Valeurs dans l'image traduite
+} AotSpan;
+
+// Image traduite (symbole "aot_image" du fichier généré)
+typedef struct {
+    const char *rom;
+    u16 base;         // Adresse de chargement de la ROM
+    u16 start;        // Point d'entrée (premier -e de rec6502, sinon reset)
+    u8 variant;       // CpuVariant
+    u64 image_hash;   // codemap_hash de la mémoire après chargement
+    int routines;
+    const AotBlock *blocks;
+    int block_count;
+    const AotSpan *spans;
+    int span_count;
+} AotImage;
+
+// Défini par le fichier généré
+extern const AotImage aot_image;
+
+struct AotRuntime {
+    CPU *cpu;
+    const AotImage *image;
+    u64 until;                // Échéance de l'appel en cours
+    int dirty;                // Un bloc est devenu invalide pendant l'appel
+    AotFunc funcs[MAX_MEMORY];
+    u16 entries[MAX_MEMORY];
+    u8 valid[MAX_MEMORY];     // Début de bloc encore conforme à l'image
+    u16 owner[MAX_MEMORY];    // Bloc qui a recopié cet octet
+    u8 expected[MAX_MEMORY];
+    u8 baked[MAX_MEMORY];     // 1 : octet recopié, 2 : et modifié depuis
+    u16 mismatches[MAX_MEMORY]; // Par bloc : octets modifiés
+    u64 calls, interpreted, invalidated;
+};
+
+// Alloue le runtime (environ 1,1 Mo) et s'accroche aux écritures de la mémoire
+// du CPU. Retourne NULL si la mémoire ne contient pas l'image traduite.
+AotRuntime *aot_create(CPU *cpu, const AotImage *image);
+void aot_free(AotRuntime *rt);
+
+// Exécute jusqu'à cpu->cycles >= until. Retourne 0 si l'interpréteur tombe
+// sur un opcode non implémenté (PC reste dessus), 1 sinon.
+int aot_run(AotRuntime *rt, u64 until);
+
+// Test fait par le code généré à chaque entrée de bloc : interruption
+// en attente, échéance atteinte ou bloc modifié -> retour à aot_run
+static inline int aot_leave(const CPU *cpu, const AotRuntime *rt, u16 block) {
+    return cpu->events || cpu->cycles >= rt->until || !rt->valid[block];
+}
+
+// Test fait au milieu d'un bloc après une instruction qui peut lever un
+// événement (écriture, CLI, SEI, PLP) : c'est la scrutation que ferait
+// l'interpréteur avant l'instruction suivante. Un changement de I sans
+// interruption en attente n'a pas d'effet : on l'oublie comme lui, sinon
+// retour à aot_run qui prend l'interruption.
+static inline int aot_interrupted(CPU *cpu) {
+    if (cpu->events == CPU_EVENT_I_DELAY) cpu->events = 0;
+    return cpu->events != 0;
+}
+#endif
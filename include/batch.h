@@ -0,0 +1,83 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "cpu.h"
+
+// --- Exécution par lots (Batch SIMD) ---
+// BATCH_LANES instances du même programme, registres rangés en
+// structure-de-tableaux (une "lane" par instance). Tant que les lanes partagent
+// le même PC, une instruction est exécutée pour toutes à la fois par un noyau
+// vectoriel ; les lanes divergentes repassent par le cœur scalaire (cpu_run,
+// un pas à la fois), de même que tout groupe dont une lane a une
+// interruption en attente. Une lane qui tombe sur un opcode non implémenté
+// s'arrête seule (bit dans 'halted'), les autres continuent.
+// Les noyaux sont écrits en SSE2 (16 x u8 = un registre) ; PC et compteurs
+// passent en AVX2 si le processeur le permet (choisi à l'exécution). Sans
+// SSE2 (autre architecture), toutes les lanes passent par le chemin scalaire.
+
+#define BATCH_LANES 16
+
+typedef struct BatchCPU BatchCPU;
+
+// Contexte du watchpoint posé sur la mémoire d'une lane
+typedef struct {
+    BatchCPU *batch;
+    u32 bit; // 1 << lane
+} BatchLaneHook;
+
+struct BatchCPU {
+    _Alignas(32) u8 A[BATCH_LANES];
+    _Alignas(16) u8 X[BATCH_LANES];
+    _Alignas(16) u8 Y[BATCH_LANES];
+    _Alignas(16) u8 SP[BATCH_LANES];
+    _Alignas(16) u8 P[BATCH_LANES];
+    _Alignas(16) u8 active[BATCH_LANES]; // 0xFF si la lane tourne encore, 0 sinon
+    _Alignas(16) u8 events[BATCH_LANES]; // CPU_EVENT_* en attente (comme CPU.events)
+    _Alignas(16) u8 irq_lines[BATCH_LANES];
+    _Alignas(16) u8 nmi_lines[BATCH_LANES];
+    _Alignas(32) u16 PC[BATCH_LANES];
+    _Alignas(32) u64 cycles[BATCH_LANES];
+    _Alignas(32) u64 instructions[BATCH_LANES];
+
+    // Chaque lane a sa mémoire, issue d'un mem_fork de l'image partagée :
+    // seules les pages qu'elle écrit sont recopiées (256 octets chacune).
+    // written[page] = lanes ayant écrit dans la page (contenu propre possible) ;
+    // les autres lisent l'octet directement dans l'image partagée.
+    Memory *shared;
+    Memory *mem[BATCH_LANES];
+    u32 written[256];
+    BatchLaneHook hooks[BATCH_LANES];
+
+    int lanes;
+    u32 pending;            // Lanes dont events != 0
+    u32 halted;             // Lanes arrêtées sur un opcode non implémenté (PC sur l'opcode)
+    CPU scratch;            // CPU temporaire pour le chemin scalaire
+
+    // Statistiques
+    u64 vector_steps;  // Instructions exécutées par un noyau vectoriel (par groupe)
+    u64 scalar_steps;  // Pas exécutés par le cœur scalaire (par lane)
+};
+
+// Initialise 'lanes' instances (<= BATCH_LANES) sur l'image 'shared', toutes à 'pc'
+// dans l'état de reset NMOS. L'image n'est pas modifiée, ni par batch_init
+// ni par les lanes, et ne doit plus l'être avant batch_free.
+void batch_init(BatchCPU *b, Memory *shared, int lanes, u16 pc);
+void batch_free(BatchCPU *b);
+
+// Niveau d'une source IRQ / NMI d'une lane (comme cpu_set_irq / cpu_set_nmi)
+void batch_set_irq(BatchCPU *b, int lane, u8 source, int level);
+void batch_set_nmi(BatchCPU *b, int lane, u8 source, int level);
+
+// Écrit un octet dans la mémoire d'une seule lane
+void batch_poke(BatchCPU *b, int lane, u16 address, u8 value);
+u8 batch_peek(const BatchCPU *b, int lane, u16 address);
+
+// Exécute un pas (un groupe de lanes au même PC). Retourne 0 quand plus aucune lane n'est active.
+int batch_step(BatchCPU *b);
+
+// Fait tourner chaque lane jusqu'à 'max_instructions' instructions
+void batch_run(BatchCPU *b, u64 max_instructions);
+
+// Vrai si les pas vectoriels utilisent AVX2 sur cette machine
+int batch_uses_avx2(void);
+#endif
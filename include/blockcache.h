@@ -0,0 +1,78 @@
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include "cpu.h"
+#include "codemap.h"
+
+// --- Cache de blocs prédécodés ---
+// Une suite d'instructions sans rupture de séquence est décodée une fois :
+// handler, mode d'adressage et, quand elle ne dépend pas des registres,
+// adresse effective. L'exécution d'un bloc ne refait ni le fetch ni le
+// décodage. Les pages qui contiennent des blocs sont signalées
+// (MEM_PAGE_CODE) : une écriture sur un octet recopié dans un bloc (opcode,
+// opérande d'une adresse fixe) invalide les blocs qui le contiennent. Les
+// opérandes immédiats ou indexés sont relus à l'exécution. Les pages de
+// périphériques et celles surveillées en lecture ne sont pas prédécodées
+// (le cœur de référence s'en charge).
+//
+// Superinstructions : au décodage, les suites fréquentes (comparaison puis
+// branchement, INX/DEX puis branchement, INX ; CPX ; BNE, LDA ; STA,
+// CLC ; ADC) reçoivent un handler fusionné, appelé sur leur première
+// instruction : un seul appel pour toute la suite, et les drapeaux
+// intermédiaires que la suite écrase ne sont pas calculés. Le handler
+// signale encore chaque instruction (mem_exec : watchpoints d'exécution) et
+// s'arrête après la première si son opérande est lu dans une page lente ;
+// block_exec ne l'appelle que si aucune échéance ne tombe au milieu. Une
+// interruption ne peut donc être prise qu'aux mêmes frontières
+// d'instruction que dans le cœur de référence.
+
+#define BLOCK_MAX_INSNS 32
+#define BLOCK_MAX_BYTES (BLOCK_MAX_INSNS * 3)
+
+typedef struct PredecodedOp PredecodedOp;
+// Exécute la suite fusionnée qui commence en 'op' (PC et cycles compris).
+// Retourne le nombre d'instructions exécutées.
+typedef int (*FusedFunc)(CPU *cpu, const PredecodedOp *op);
+
+struct PredecodedOp {
+    InstructionFunc instruction;
+    AddrModeFunc addrmode; // NULL : adresse résolue au décodage
+    u16 pc;
+    u16 addr;              // Adresse effective (si addrmode == NULL)
+    u16 next_pc;
+    u8 cycles;
+    u8 fixed;              // Opérande recopié dans addr (ZP, ABS, relatif)
+    u8 fused_cycles;       // Cycles de la suite fusionnée, dernière instruction exclue
+    FusedFunc fused;       // NULL : pas de superinstruction à partir d'ici
+};
+
+typedef struct Block {
+    u16 start, end;        // Octets couverts, bornes incluses
+    int count;
+    struct Block *next_retired;
+    PredecodedOp ops[];
+} Block;
+
+typedef struct {
+    CPU *cpu;
+    Block *blocks[MAX_MEMORY];  // Par adresse de départ (NULL : pas décodé)
+    u16 covered[MAX_MEMORY];    // Nombre de blocs qui ont recopié chaque octet
+    Block *retired;             // Invalidés, libérés hors de l'exécution
+    int dirty;                  // Invalidation pendant le bloc courant
+    int fuse;                   // Superinstructions (1 par défaut, pour les blocs décodés ensuite)
+    u64 built, preloaded, invalidated;
+    u64 fused;                  // Superinstructions décodées
+} BlockCache;
+
+// Alloue un cache pour ce CPU (environ 640 Ko) et s'accroche aux écritures
+// de sa mémoire. Retourne NULL si erreur.
+BlockCache *block_create(CPU *cpu);
+void block_free(BlockCache *bc);
+
+// Prédécode tous les blocs de la carte statique. Retourne le nombre de blocs construits.
+int block_preload(BlockCache *bc, const CodeMap *cm);
+
+// Exécute au plus un bloc à partir de PC (ou prend une interruption), en
+// s'arrêtant dès que cpu->cycles >= until. Retourne le nombre de pas.
+int block_exec(BlockCache *bc, u64 until);
+#endif
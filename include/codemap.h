@@ -0,0 +1,76 @@
+#ifndef CODEMAP_H
+#define CODEMAP_H
+
+#include <stdio.h>
+#include "cpu.h"
+
+// --- Analyse statique du flot de contrôle ---
+// Part des vecteurs (reset, IRQ/BRK, NMI) et de points d'entrée
+// supplémentaires, suit JMP/JSR/branchements et construit la carte du code
+// (quels octets sont des opcodes ou des opérandes) et le graphe des blocs de
+// base. Le résultat peut être gardé dans un fichier cache ("rom.bin.cfg"),
+// valable pour la même image, la même variante et les mêmes points d'entrée.
+
+// Drapeaux de la carte (un octet par adresse)
+#define CODE_OPCODE  (1 << 0) // Premier octet d'une instruction
+#define CODE_OPERAND (1 << 1) // Octet d'opérande
+#define CODE_LEADER  (1 << 2) // Début de bloc de base
+#define CODE_TARGET  (1 << 3) // Cible d'un saut, d'un appel ou d'un vecteur
+
+// Fin d'un bloc de base
+typedef enum {
+    BLOCK_FALL,     // Continue dans le bloc suivant (qui est une cible)
+    BLOCK_BRANCH,   // Branchement conditionnel : cible + instruction suivante
+    BLOCK_JUMP,     // JMP absolu, BRA
+    BLOCK_CALL,     // JSR : cible + adresse de retour
+    BLOCK_RETURN,   // RTS, RTI
+    BLOCK_INDIRECT, // JMP (ind) : successeur supposé d'après l'image, ou inconnu
+    BLOCK_STOP,     // BRK (successeur : retour à +2), opcode non implémenté, fin de mémoire
+} BlockKind;
+
+typedef struct {
+    u16 start, end;  // Octets du bloc, bornes incluses
+    u16 insns;       // Nombre d'instructions
+    u8 kind;         // BlockKind
+    u8 succ_count;   // 0 à 2
+    u16 succ[2];     // Successeurs statiques
+} CodeBlock;
+
+#define CODEMAP_MAX_ENTRIES 16
+
+typedef struct {
+    u8 map[MAX_MEMORY];
+    CodeBlock *blocks;   // Triés par adresse de départ
+    int block_count, block_capacity;
+    u16 entries[CODEMAP_MAX_ENTRIES]; // Points d'entrée (vecteurs compris)
+    int entry_count;
+    u8 variant;          // CpuVariant utilisée pour décoder
+    u64 image_hash;      // FNV-1a de l'image analysée
+    int conflicts;       // Sauts au milieu d'une instruction déjà décodée
+} CodeMap;
+
+void codemap_init(CodeMap *cm);
+void codemap_free(CodeMap *cm);
+
+// Analyse l'image à partir des vecteurs et de 'extra' points d'entrée.
+// Retourne le nombre de blocs, ou -1 si erreur.
+int codemap_analyze(CodeMap *cm, const Memory *mem, CpuVariant variant, const u16 *extra, int extra_count);
+
+// Hash de l'image mémoire (clé de validité du cache)
+u64 codemap_hash(const Memory *mem);
+
+// Nom du cache : "<rom>.cfg"
+void codemap_cache_path(const char *rom, char *buf, size_t size);
+int codemap_save(const CodeMap *cm, const char *path);
+// Charge le cache s'il correspond à cette image, à cette variante et aux
+// points d'entrée que donnerait codemap_analyze avec 'extra'.
+// Retourne 1 si chargé, 0 si absent ou périmé, -1 si invalide.
+int codemap_load(CodeMap *cm, const char *path, const Memory *mem, CpuVariant variant,
+                 const u16 *extra, int extra_count);
+
+// Le bloc qui commence à cette adresse, ou NULL
+const CodeBlock *codemap_block_at(const CodeMap *cm, u16 address);
+
+// Graphe des blocs au format Graphviz (dot)
+void codemap_write_dot(const CodeMap *cm, FILE *out);
+#endif
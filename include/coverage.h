@@ -0,0 +1,79 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stdio.h>
+#include "cpu.h"
+
+// --- Couverture du code invité (--coverage=FICHIER) ---
+// Trois bitmaps d'un bit par adresse : instructions exécutées (adresse de
+// l'opcode), branches conditionnelles prises et non prises (BEQ, BNE, BPL,
+// BMI, BCS, BCC, BVS, BVC, repérées par leur handler dans la table de la
+// variante). Coût fixe par instruction : un octet lu, un bit posé, et pour
+// une branche une comparaison du PC (une branche de déplacement nul compte
+// comme non prise). Les bitmaps se fusionnent par OU : cov_save ajoute la
+// couverture du run à celle déjà dans le fichier, sous verrou, si bien que
+// des runs parallèles peuvent viser le même fichier.
+//
+// Fichier (24 Ko + 8) : "E65V", version, variante, 2 octets nuls, puis les
+// bitmaps exécutées, prises, non prises (bit (adresse & 7) de l'octet adresse / 8).
+
+#define COV_BITMAP_SIZE (MAX_MEMORY / 8)
+
+typedef struct {
+    u8 executed[COV_BITMAP_SIZE];
+    u8 taken[COV_BITMAP_SIZE];
+    u8 not_taken[COV_BITMAP_SIZE];
+    u8 branch[256];   // Opcode de branche conditionnelle (pour la variante)
+    CpuVariant variant;
+} Coverage;
+
+// Bit déjà posé (presque toujours) : lecture seule, pas d'écriture qui
+// chaînerait les instructions voisines sur le même octet
+static inline void cov_mark(u8 *bitmap, u16 address) {
+    u8 bit = (u8)(1 << (address & 7));
+    if (!(bitmap[address >> 3] & bit)) bitmap[address >> 3] |= bit;
+}
+
+static inline int cov_test(const u8 *bitmap, u16 address) {
+    return (bitmap[address >> 3] >> (address & 7)) & 1;
+}
+
+// Bitmaps vides, branches repérées dans la table de la variante
+void cov_init(Coverage *c, CpuVariant variant);
+// Lit un fichier (c prend sa variante). Retourne 0 en cas d'erreur (message affiché).
+int cov_load(Coverage *c, const char *path);
+// Fusionne avec le fichier (créé s'il n'existe pas) sous flock exclusif.
+// Retourne 0 en cas d'erreur (message affiché).
+int cov_save(const Coverage *c, const char *path);
+// c |= other. Retourne 0 si les variantes diffèrent.
+int cov_merge(Coverage *c, const Coverage *other);
+
+// cpu_step, en notant l'instruction exécutée et le sens de la branche
+static inline void cov_step(Coverage *c, CPU *cpu) {
+    // Une interruption prise n'exécute aucune instruction
+    if (cpu->events && cpu_service_events(cpu)) return;
+    u16 pc = cpu->PC;
+    u8 op = mem_peek(cpu->mem, pc);
+    cov_mark(c->executed, pc);
+    cpu_step_instruction(cpu);
+    if (c->branch[op]) cov_mark(cpu->PC != (u16)(pc + 2) ? c->taken : c->not_taken, pc);
+}
+
+// Totaux : instructions exécutées, branches exécutées, prises dans les deux sens
+typedef struct {
+    u32 instructions;
+    u32 branches, both_ways;
+} CovSummary;
+
+void cov_summary(const Coverage *c, CovSummary *s);
+
+// Rapport lcov (SF/DA/BRDA/LF/LH/BRF/BRH) : les lignes source viennent du
+// fichier --dbgfile de ld65 (records file, line, span, seg), les
+// instructions de la mémoire 'mem' (le programme chargé). Une ligne est
+// couverte si une instruction de ses spans a été exécutée (compte 0 ou 1) ;
+// chaque branche conditionnelle donne deux BRDA (prise, non prise), "-" si
+// elle n'a jamais été exécutée. Les spans de données (avec type=) sont
+// ignorés ; une ligne de macro cumule toutes ses expansions. Retourne 0 en
+// cas d'erreur (message affiché).
+int cov_write_lcov(const Coverage *c, Memory *mem, const char *dbg_path, FILE *out);
+#endif
@@ -14,38 +14,188 @@
 #define FLAG_V (1 << 6)
 #define FLAG_N (1 << 7)
 
+// Variantes de CPU (choisies à la création de l'instance)
+typedef enum {
+    CPU_NMOS,   // MOS 6502 d'origine
+    CPU_65C02,  // WDC/Rockwell 65C02
+    CPU_2A03,   // Ricoh 2A03 (NES), sans mode décimal
+    CPU_VARIANT_COUNT
+} CpuVariant;
+
+struct OpcodeEntry;
+struct MachineDesc;
+struct IrqLatency;
+
+// Événements en attente (mot CPU.events) : un seul test par instruction
+// quand rien n'est demandé.
+#define CPU_EVENT_NMI (1 << 0) // Front NMI mémorisé
+#define CPU_EVENT_IRQ (1 << 1) // Au moins une ligne IRQ active (masquable par I)
+// CLI, SEI ou PLP vient de changer I : le 6502 lit I avant la fin de
+// l'instruction, la prochaine décision d'IRQ se fait avec l'ancienne valeur
+#define CPU_EVENT_I_DELAY (1 << 2)
+// WAI (65C02) : le temps passe sans instruction jusqu'à une IRQ ou une NMI
+#define CPU_EVENT_WAIT (1 << 3)
+// STP (65C02) : plus aucune instruction jusqu'au reset
+#define CPU_EVENT_STOP (1 << 4)
+
+// Source réservée à cpu_nmi (impulsion)
+#define CPU_NMI_PULSE (1 << 7)
+
+// L'état est rangé pour la boucle chaude : registres, événements, cycles et
+// pointeurs de dispatch tiennent dans une seule ligne de cache de 64 octets.
 typedef struct {
     u8 A, X, Y, SP;
-    u16 PC;
     u8 P;
+    u8 events;   // CPU_EVENT_*, 0 = aucune interruption à traiter
+    u16 PC;
     u64 cycles;
     Memory *mem;
+    const struct OpcodeEntry *ops; // Table de dispatch propre à la variante
+    u16 op_pc;   // Adresse de l'instruction en cours (pour les watchpoints)
 
-    // Variables temporaires adressage
-    u16 addr_abs;
-    u8 fetched;
+    // Moins chaud : lu seulement à l'entrée d'une interruption
+    u8 irq_lines; // Sources IRQ actives (OU câblé, une par bit)
+    u8 nmi_lines; // Sources NMI actives (OU câblé) : seul le front montant compte
+    const struct MachineDesc *machine;
+    struct IrqLatency *latency; // Mesure des latences (NULL : aucune), remis à NULL par le reset
+} __attribute__((aligned(64))) CPU;
 
-    // NOUVEAU : Interruptions en attente
-    u8 irq_pending; // Interrupt Request
-    u8 nmi_pending; // Non-Maskable Interrupt
+_Static_assert(sizeof(CPU) == 64, "l'état du CPU doit tenir dans une ligne de cache");
 
-} CPU;
+// Empreinte de l'état complet (registres, interruptions en attente, mémoire)
+// en O(1) grâce à mem->hash (mem_set_hashing doit l'avoir activée). Le
+// compteur de cycles n'en fait pas partie : deux passages par le même état
+// ont la même empreinte.
+static inline u64 cpu_fingerprint(const CPU *cpu) {
+    u64 regs = cpu->A | (u64)cpu->X << 8 | (u64)cpu->Y << 16 | (u64)cpu->SP << 24
+             | (u64)cpu->P << 32 | (u64)cpu->events << 40 | (u64)cpu->PC << 48;
+    u64 x = regs * 0xBF58476D1CE4E5B9ULL ^ cpu->irq_lines ^ (u64)cpu->nmi_lines << 8;
+    x ^= x >> 31;
+    x *= 0x94D049BB133111EBULL;
+    return (x ^ (x >> 29)) ^ cpu->mem->hash;
+}
 
 // Prototypes interruption
-void cpu_nmi(CPU *cpu); // Déclencher une NMI
+// Niveau de la ligne IRQ d'une source (masque d'un bit) : la requête reste
+// active tant qu'au moins une source est à 1
+void cpu_set_irq(CPU *cpu, u8 source, int level);
+// Niveau de la ligne NMI d'une source : la NMI est mémorisée quand la ligne
+// (OU des sources) passe de inactive à active ; une source qui monte pendant
+// qu'une autre tient la ligne ne déclenche rien
+void cpu_set_nmi(CPU *cpu, u8 source, int level);
+// Variantes datées : 'when' (<= cpu->cycles) est le cycle exact du
+// changement, quand le périphérique le connaît (mesure de latence)
+void cpu_set_irq_at(CPU *cpu, u8 source, int level, u64 when);
+void cpu_set_nmi_at(CPU *cpu, u8 source, int level, u64 when);
+// Impulsion NMI (source CPU_NMI_PULSE) : sans effet si la ligne est déjà active
+void cpu_nmi(CPU *cpu);
 // Prototypes
-void cpu_reset(CPU *cpu, Memory *mem);
+void cpu_reset(CPU *cpu, Memory *mem); // Variante NMOS
+void cpu_reset_variant(CPU *cpu, Memory *mem, CpuVariant variant);
 void cpu_step(CPU *cpu);
+// L'instruction en PC seule, sans scrutation (déjà faite par cpu_service_events :
+// une deuxième scrutation lirait I sans le retard de CLI/SEI/PLP)
+void cpu_step_instruction(CPU *cpu);
+// Exécute des instructions jusqu'à atteindre 'until' cycles, ou s'arrête juste
+// avant un opcode non implémenté (cpu->cycles < until). Retourne le nombre de
+// pas exécutés (instructions et entrées d'interruption).
+u64 cpu_run(CPU *cpu, u64 until);
+// Traite les événements en attente (à appeler si cpu->events != 0). Retourne
+// 1 si une interruption a été prise : elle remplace l'instruction de ce pas.
+// Après WAI ou STP, retourne aussi 1 pour chaque cycle passé à attendre.
+int cpu_service_events(CPU *cpu);
 void cpu_set_flag(CPU *cpu, u8 flag, int value);
 int cpu_get_flag(CPU *cpu, u8 flag);
 
-// Définition du type Pointeur de Fonction pour les instructions/adressages
-typedef void (*InstructionFunc)(CPU *cpu);
-typedef void (*AddrModeFunc)(CPU *cpu);
+// Définition du type Pointeur de Fonction pour les instructions/adressages.
+// Le mode d'adressage retourne l'adresse effective (PC pour l'immédiat, 0
+// sans opérande) et l'instruction la reçoit en argument : elle reste dans un
+// registre au lieu de transiter par la structure.
+typedef void (*InstructionFunc)(CPU *cpu, u16 addr);
+typedef u16 (*AddrModeFunc)(CPU *cpu);
+
+// Structure pour une entrée de la table
+typedef struct OpcodeEntry {
+    InstructionFunc instruction; // NULL = opcode non implémenté
+    AddrModeFunc addrmode;
+    const char *name;
+    u8 cycles;
+} OpcodeEntry;
+
+// Noms C du handler et du mode d'adressage d'un opcode (traduction en C, rec6502)
+typedef struct {
+    const char *instruction; // NULL = opcode non implémenté
+    const char *addrmode;
+} OpcodeSymbols;
+
+// Description d'une variante de CPU
+typedef struct MachineDesc {
+    const char *name;
+    const OpcodeEntry *ops; // Table de dispatch (256 entrées)
+    u8 irq_clears;          // Flags effacés à l'entrée d'une interruption
+    const OpcodeSymbols *symbols; // Mêmes 256 entrées, par nom
+} MachineDesc;
+
+const MachineDesc *cpu_machine(CpuVariant variant);
+int cpu_variant_from_name(const char *name);
+
+// --- Pile (page 1) ---
+// En ligne : accès direct à mem->data quand la page 1 est de la RAM sans
+// watchpoint (empreinte mise à jour comme dans mem_write), chemin lent sinon.
+// Un mot n'est testé qu'une fois.
+
+// Écrire un octet sur la pile (la pile descend, adresse 0x0100 + SP)
+static inline void cpu_push_byte(CPU *cpu, u8 value) {
+    Memory *mem = cpu->mem;
+    if (mem->page_flags[1] & MEM_SLOW_WRITE) {
+        mem_write_slow(mem, 0x0100 | cpu->SP, value);
+    } else {
+        u8 *p = &mem->page[1][cpu->SP];
+        mem_hash_update(mem, 0x0100 | cpu->SP, *p, value);
+        *p = value;
+    }
+    cpu->SP--;
+}
+
+// Lire un octet depuis la pile (la pile remonte)
+static inline u8 cpu_pull_byte(CPU *cpu) {
+    Memory *mem = cpu->mem;
+    cpu->SP++;
+    if (mem->page_flags[1] & MEM_SLOW_READ) {
+        return mem_read_slow(mem, 0x0100 | cpu->SP);
+    }
+    return mem->page[1][cpu->SP];
+}
+
+// Écrire une adresse (16 bits) sur la pile (JSR, interruptions) : octet haut puis octet bas
+static inline void cpu_push_word(CPU *cpu, u16 value) {
+    Memory *mem = cpu->mem;
+    if (mem->page_flags[1] & MEM_SLOW_WRITE) {
+        cpu_push_byte(cpu, value >> 8);
+        cpu_push_byte(cpu, value & 0xFF);
+        return;
+    }
+    u8 *stack = mem->page[1];
+    u8 hi = (u8)cpu->SP, lo = (u8)(cpu->SP - 1);
+    mem_hash_update(mem, 0x0100 | hi, stack[hi], value >> 8);
+    mem_hash_update(mem, 0x0100 | lo, stack[lo], value & 0xFF);
+    stack[hi] = value >> 8;
+    stack[lo] = value & 0xFF;
+    cpu->SP -= 2;
+}
 
-void cpu_push_byte(CPU *cpu, u8 value);
-u8 cpu_pull_byte(CPU *cpu);
-void cpu_push_word(CPU *cpu, u16 value);
-u16 cpu_pull_word(CPU *cpu);
+// Lire une adresse (16 bits) depuis la pile (RTS, RTI)
+static inline u16 cpu_pull_word(CPU *cpu) {
+    Memory *mem = cpu->mem;
+    if (mem->page_flags[1] & MEM_SLOW_READ) {
+        u16 lo = cpu_pull_byte(cpu);
+        u16 hi = cpu_pull_byte(cpu);
+        return (hi << 8) | lo;
+    }
+    u16 lo = mem->page[1][(u8)(cpu->SP + 1)];
+    u16 hi = mem->page[1][(u8)(cpu->SP + 2)];
+    cpu->SP += 2;
+    return (hi << 8) | lo;
+}
 
 #endif
\ No newline at end of file
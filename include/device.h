@@ -0,0 +1,66 @@
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <stddef.h>
+#include "cpu.h"
+#include "sched.h"
+
+// --- Périphériques en coroutines ---
+// Un périphérique s'écrit comme du code séquentiel :
+//     for (;;) { device_wait(dev, 1000); cpu_set_irq(dev->cpu, IRQ_TICK, 1); ... }
+// Chaque périphérique a sa propre pile et tourne sur le thread du CPU. Une
+// attente programme un événement de l'ordonnanceur puis rend la main à la
+// boucle d'exécution ; sched_poll ne reprend la coroutine qu'une fois
+// l'échéance atteinte (pas de réveil entre-temps). Le changement de contexte
+// ne sauve que les registres préservés par l'ABI (assembleur sur x86-64,
+// ucontext ailleurs).
+
+#define DEVICE_STACK_SIZE (64 * 1024)
+
+typedef struct Device Device;
+typedef void (*DeviceBody)(Device *dev);
+
+struct Device {
+    void *sp;            // Pile de la coroutine suspendue
+    void *host_sp;       // Pile de la boucle d'exécution pendant que la coroutine tourne
+    void *uctx;          // Contextes ucontext (sans assembleur), NULL sinon
+    u8 *stack;           // Zone allouée (page de garde comprise)
+    size_t stack_size;
+
+    DeviceBody body;
+    void *ctx;           // Données du périphérique
+    const char *name;
+    CPU *cpu;
+    Scheduler *sched;
+    int event;
+
+    u64 target;          // Dernière échéance demandée (base de device_wait)
+    u64 now;             // Cycle de la dernière reprise (>= target)
+    int running, done;
+    u64 resumes;         // Reprises de la coroutine
+};
+
+// Alloue la pile, enregistre l'événement et exécute le corps jusqu'à sa
+// première attente. Retourne 0 en cas d'erreur.
+int device_start(Device *dev, const char *name, CPU *cpu, Scheduler *sched, DeviceBody body, void *ctx);
+// Libère la pile (la coroutine ne doit pas être en cours d'exécution)
+void device_stop(Device *dev);
+
+// Suspend le périphérique jusqu'au cycle 'cycle' (sans effet s'il est passé).
+// SCHED_NEVER : jusqu'à un device_wake.
+void device_wait_until(Device *dev, u64 cycle);
+// n cycles après l'échéance précédente (et non après la reprise, qui peut
+// arriver quelques cycles plus tard) : un périphérique périodique ne dérive pas
+void device_wait(Device *dev, u64 cycles);
+// Reprend le périphérique à la prochaine vérification de l'ordonnanceur
+// (depuis un handler d'E/S : écriture dans un registre...)
+void device_wake(Device *dev);
+
+// Cycle courant vu par le périphérique
+static inline u64 device_now(const Device *dev) {
+    return dev->cpu->cycles;
+}
+
+// Coût d'un aller-retour boucle -> coroutine -> boucle, en nanosecondes
+double device_switch_cost(int rounds);
+#endif
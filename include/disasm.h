@@ -0,0 +1,72 @@
+#ifndef DISASM_H
+#define DISASM_H
+
+#include <stdio.h>
+#include "cpu.h"
+
+// --- Désassembleur ---
+// Décode les instructions complètes (opcode + opérandes) à partir des tables
+// de la variante choisie, avec un cache d'instructions décodées indexé par
+// adresse et invalidé sur écriture.
+
+// Format de l'opérande (déduit du mode d'adressage de la table)
+typedef enum {
+    DIS_IMPLIED, DIS_ACCUMULATOR, DIS_IMMEDIATE, DIS_ZERO_PAGE, DIS_ZERO_PAGE_X,
+    DIS_ZERO_PAGE_Y, DIS_ABSOLUTE, DIS_ABSOLUTE_X, DIS_ABSOLUTE_Y, DIS_INDIRECT,
+    DIS_INDIRECT_X, DIS_INDIRECT_Y, DIS_INDIRECT_ZP, DIS_ABSOLUTE_INDIRECT_X,
+    DIS_RELATIVE, DIS_ZERO_PAGE_RELATIVE, DIS_UNKNOWN
+} DisMode;
+
+typedef struct {
+    u16 address;
+    u8 length;   // 1 à 3 octets
+    u8 mode;     // DisMode
+    u8 bytes[3];
+    u16 operand; // Opérande brute (8 ou 16 bits)
+    u16 target;  // Adresse référencée (branche résolue, ZP, absolue...)
+    const OpcodeEntry *entry; // NULL si opcode inconnu
+    char text[40];            // Texte formaté (rempli par le cache)
+} DecodedInsn;
+
+// Table de symboles : un nom par adresse
+typedef struct {
+    char *names[MAX_MEMORY];
+    int count;
+} SymbolTable;
+
+typedef struct {
+    Memory *mem;
+    const OpcodeEntry *ops;
+    DecodedInsn insns[MAX_MEMORY];
+    u8 valid[MAX_MEMORY];
+    u64 hits, misses;
+    const SymbolTable *symbols; // Optionnel (à fixer avant le premier disasm_get)
+    int watch;                  // Index du watchpoint d'invalidation, ou -1
+} DisasmCache;
+
+// Décodage brut (sans cache)
+void disasm_decode(const OpcodeEntry *ops, Memory *mem, u16 address, DecodedInsn *out);
+
+// Cache : alloué sur le tas (environ 4 Mo). Retourne NULL si erreur.
+DisasmCache *disasm_create(Memory *mem, CpuVariant variant);
+void disasm_free(DisasmCache *cache);
+const DecodedInsn *disasm_get(DisasmCache *cache, u16 address);
+// Invalide les instructions qui couvrent cette adresse
+void disasm_invalidate(DisasmCache *cache, u16 address);
+// Invalide automatiquement sur chaque écriture en mémoire (via un watchpoint)
+int disasm_track_writes(DisasmCache *cache);
+
+// Formate l'instruction ("LDA #$10", "JSR init"...). Retourne la longueur écrite.
+int disasm_format(const DecodedInsn *insn, const SymbolTable *symbols, char *buf, int size);
+
+// Écrit le listing de [start, end] (labels, octets, instruction)
+void disasm_listing(DisasmCache *cache, u16 start, u16 end, FILE *out);
+
+// --- Symboles ---
+void symbols_init(SymbolTable *symbols);
+void symbols_free(SymbolTable *symbols);
+int symbols_add(SymbolTable *symbols, u16 address, const char *name);
+// Charge un fichier de labels VICE ("al C:1234 .nom", produit par ld65 -Ln)
+// ou un fichier de debug ca65/ld65 (--dbgfile). Retourne le nombre de symboles, -1 si erreur.
+int symbols_load(SymbolTable *symbols, const char *filename);
+#endif
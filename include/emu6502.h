@@ -0,0 +1,115 @@
+#ifndef EMU6502_H
+#define EMU6502_H
+
+// --- API publique de l'émulateur 6502 (libemu6502) ---
+// Interface stable pour intégrer le cœur dans d'autres programmes. Les
+// structures internes ne sont pas exposées : une instance est un pointeur
+// opaque créé par emu6502_create. Le numéro de version majeure change à chaque
+// rupture de compatibilité (c'est aussi le soname de libemu6502.so).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EMU6502_VERSION_MAJOR 1
+#define EMU6502_VERSION_MINOR 3
+#define EMU6502_VERSION_PATCH 0
+#define EMU6502_VERSION ((EMU6502_VERSION_MAJOR << 16) | (EMU6502_VERSION_MINOR << 8) | EMU6502_VERSION_PATCH)
+
+#if defined(__GNUC__)
+#define EMU6502_API __attribute__((visibility("default")))
+#else
+#define EMU6502_API
+#endif
+
+typedef struct Emu6502 Emu6502;
+
+typedef enum {
+    EMU6502_NMOS,
+    EMU6502_65C02,
+    EMU6502_2A03
+} Emu6502Variant;
+
+typedef struct {
+    uint8_t a, x, y, sp, p;
+    uint16_t pc;
+    uint64_t cycles;
+} Emu6502Regs;
+
+// Périphérique sur le bus : appelé pour chaque accès aux pages mappées
+typedef uint8_t (*Emu6502ReadFunc)(void *ctx, uint16_t address);
+typedef void (*Emu6502WriteFunc)(void *ctx, uint16_t address, uint8_t value);
+
+// Version de la bibliothèque chargée (à comparer à EMU6502_VERSION)
+EMU6502_API uint32_t emu6502_version(void);
+
+// --- Instances ---
+// Retourne NULL si la variante est inconnue ou en cas de manque de mémoire.
+// L'instance démarre avec 64 Ko de RAM à zéro ; appeler emu6502_reset après le chargement.
+EMU6502_API Emu6502 *emu6502_create(Emu6502Variant variant);
+EMU6502_API void emu6502_destroy(Emu6502 *emu);
+
+// --- Mémoire et bus ---
+// RAM de l'instance (64 Ko, accès direct sans passer par les périphériques)
+EMU6502_API uint8_t *emu6502_memory(Emu6502 *emu);
+// Copie 'size' octets à partir de 'address'. Retourne 0, ou -1 si cela dépasse $FFFF.
+EMU6502_API int emu6502_load(Emu6502 *emu, uint16_t address, const void *data, size_t size);
+// Accès comme le CPU (périphériques compris)
+EMU6502_API uint8_t emu6502_read(Emu6502 *emu, uint16_t address);
+EMU6502_API void emu6502_write(Emu6502 *emu, uint16_t address, uint8_t value);
+// Mappe un périphérique sur les pages [first_page, last_page] (write peut être NULL)
+EMU6502_API void emu6502_map(Emu6502 *emu, uint8_t first_page, uint8_t last_page,
+                             Emu6502ReadFunc read, Emu6502WriteFunc write, void *ctx);
+EMU6502_API void emu6502_unmap(Emu6502 *emu, uint8_t first_page, uint8_t last_page);
+
+// --- Exécution ---
+// Reset : registres à l'état initial, PC lu dans le vecteur $FFFC
+EMU6502_API void emu6502_reset(Emu6502 *emu);
+// Exécute au moins 'cycles' cycles (l'instruction en cours est terminée).
+// Retourne le nombre de cycles réellement exécutés ; s'arrête plus tôt sur un
+// opcode non implémenté (voir emu6502_halted).
+EMU6502_API uint64_t emu6502_run(Emu6502 *emu, uint64_t cycles);
+// Instructions exécutées par emu6502_run depuis la création (interruptions comprises)
+EMU6502_API uint64_t emu6502_instructions(const Emu6502 *emu);
+// Non nul si la dernière exécution s'est arrêtée sur un opcode non implémenté
+EMU6502_API int emu6502_halted(const Emu6502 *emu);
+
+EMU6502_API void emu6502_get_regs(const Emu6502 *emu, Emu6502Regs *regs);
+EMU6502_API void emu6502_set_regs(Emu6502 *emu, const Emu6502Regs *regs);
+
+// --- Interruptions ---
+// Ligne IRQ 'line' (0 à 7), en OU câblé : l'IRQ reste demandée tant qu'une ligne est active
+EMU6502_API void emu6502_set_irq(Emu6502 *emu, unsigned line, int level);
+// Ligne NMI 'line' (0 à 6), en OU câblé : la NMI se déclenche sur le front
+// montant de l'ensemble (une ligne qui monte pendant qu'une autre est active
+// ne fait rien)
+EMU6502_API void emu6502_set_nmi(Emu6502 *emu, unsigned line, int level);
+// Impulsion NMI (prise en compte avant la prochaine instruction si la ligne était au repos)
+EMU6502_API void emu6502_nmi(Emu6502 *emu);
+
+// --- Snapshots ---
+// Registres, lignes d'interruption et 64 Ko de RAM. L'état des périphériques
+// mappés appartient à l'application et n'est pas inclus.
+EMU6502_API size_t emu6502_snapshot_size(void);
+// Retourne 0, ou -1 si le tampon est trop petit
+EMU6502_API int emu6502_snapshot(const Emu6502 *emu, void *buffer, size_t size);
+// Retourne 0, ou -1 si le snapshot est invalide (format, version ou variante)
+EMU6502_API int emu6502_restore(Emu6502 *emu, const void *buffer, size_t size);
+
+// --- Statistiques (format texte Prometheus) ---
+// Publie les compteurs de l'instance (instructions, cycles, interruptions,
+// accès aux périphériques, fréquence effective) à la fin de chaque emu6502_run.
+// Retourne 0, ou -1 si trop d'instances sont suivies.
+EMU6502_API int emu6502_stats_enable(Emu6502 *emu, const char *name);
+// Démarre l'export de toutes les instances suivies : 'target' est un fichier
+// (réécrit toutes les 'interval' secondes) ou "unix:CHEMIN". Retourne 0, ou -1 si erreur.
+EMU6502_API int emu6502_stats_export(const char *target, double interval);
+EMU6502_API void emu6502_stats_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,63 @@
+#ifndef EXPLORE_H
+#define EXPLORE_H
+
+#include "cpu.h"
+
+// --- Exploration parallèle de l'espace des entrées ---
+// Depuis un état de la machine, essaie toutes les suites d'entrées : à chaque
+// point de décision (le programme arrive sur decision_pc), l'état est figé et
+// une branche est lancée par valeur possible de l'octet d'entrée (écrit en
+// input_address). Une branche part d'un mem_fork de l'état figé : seules les
+// pages qu'elle écrit sont recopiées. Les branches tournent sur un pool de
+// threads à vol de travail (une file par thread, le propriétaire prend la
+// dernière tâche poussée, un voleur la plus ancienne). Deux branches qui
+// arrivent au même point de décision dans le même état (cpu_fingerprint :
+// registres et mémoire, hors compteur de cycles) ont la même suite : la
+// seconde est élaguée.
+// La mémoire doit être de la RAM simple : ni périphérique, ni watchpoint, ni
+// registre de mapper (leur état n'est pas dupliqué).
+
+#define EXPLORE_MAX_DEPTH 16
+
+typedef enum {
+    EXPLORE_WAITING, // Point de décision atteint, plus d'entrée à fournir
+    EXPLORE_STOP,    // stop_pc atteint
+    EXPLORE_TRAP,    // Saut sur elle-même
+    EXPLORE_HALT,    // Opcode non implémenté
+    EXPLORE_BUDGET,  // max_cycles dépassé depuis la dernière entrée
+} ExploreEnd;
+
+// Fin d'une suite d'entrées (inputs[0..count-1]). Appelé sous verrou depuis
+// n'importe quel thread ; cpu->mem est libérée au retour.
+typedef void (*ExploreLeafFunc)(void *ctx, const CPU *cpu, const u8 *inputs, int count, ExploreEnd end);
+
+typedef struct {
+    u16 decision_pc;
+    u16 input_address;
+    int choices;          // Valeurs essayées : 0 .. choices - 1 (256 : octet entier)
+    int depth;            // Entrées par suite (1 .. EXPLORE_MAX_DEPTH)
+    long stop_pc;         // -1 : aucun
+    u64 max_cycles;       // Budget d'une branche entre deux entrées
+    int threads;          // 0 : un par cœur
+    int dedup;            // Élagage des états déjà vus
+    int table_bits;       // Taille de la table des états vus (2^bits), 0 : 2^20
+    ExploreLeafFunc leaf; // NULL : aucun rapport
+    void *ctx;
+} ExploreConfig;
+
+typedef struct {
+    u64 branches;     // Branches exécutées (une entrée, jusqu'au point suivant)
+    u64 forks;        // États figés en point de décision
+    u64 leaves;
+    u64 pruned;       // États déjà vus
+    u64 instructions;
+    u64 pages_copied; // Pages recopiées à l'écriture
+    u64 steals;       // Tâches prises dans la file d'un autre thread
+    int threads;
+    double seconds;
+} ExploreStats;
+
+// Explore depuis l'état de cpu (et cpu->mem, qui n'est pas modifiée).
+// Retourne 0 en cas d'erreur (message affiché).
+int explore_run(const ExploreConfig *cfg, const CPU *cpu, ExploreStats *stats);
+#endif
@@ -0,0 +1,79 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdio.h>
+#include "memory.h"
+
+// --- Écran en mémoire (framebuffer sans fenêtre) ---
+// Une zone de RAM lue comme un écran, pour des captures de non-régression
+// (PNG, PPM ou texte) sans interface graphique. Les écritures dans ses pages
+// sont interceptées (mem_trap_writes : les lectures restent directes) et ne
+// font que marquer la ligne mémoire touchée ; fb_render ne redessine que les
+// lignes marquées dans une image RGB gardée entre deux captures. L'image est
+// rangée comme les lignes d'un PNG (un octet de filtre puis les pixels), si
+// bien que l'encodeur PNG (blocs deflate non compressés) l'écrit telle quelle.
+//
+// Modes (octets d'une ligne mémoire consécutifs, lignes consécutives) :
+//  - FB_TEXT   : un octet par caractère, police 8x8 (bit 7 = pixel de gauche,
+//                comme un chargen) ; 128 glyphes ou moins : les codes >= $80
+//                sont les codes - $80 en inverse vidéo
+//  - FB_MONO   : 1 bit par pixel, bit 7 à gauche, 1 = allumé
+//  - FB_RGB332 : 1 octet par pixel, RRRGGGBB
+// Une écriture qui contourne mem_write (chargement, banque changée sous
+// l'écran) doit être suivie de fb_invalidate.
+
+typedef enum { FB_TEXT, FB_MONO, FB_RGB332 } FbMode;
+
+#define FB_MAX_WIDTH 4096 // Pixels
+
+typedef struct {
+    FbMode mode;
+    u16 base;          // Adresse du premier octet
+    u32 size;          // Octets lus
+    int stride;        // Octets par ligne mémoire
+    int lines;         // Lignes mémoire (rangées de caractères en mode texte)
+    int line_height;   // Pixels par ligne mémoire (8 en mode texte, 1 sinon)
+    int width, height; // Pixels
+
+    u8 glyphs[256 * 8]; // Police du mode texte, inverse vidéo déjà appliquée
+    u8 *pixels;         // height lignes de 1 + 3 * width octets
+    u8 *dirty;          // Une case par ligne mémoire
+    int dirty_any;
+
+    Memory *mem;
+    u64 writes;         // Écritures interceptées
+    u64 lines_rendered; // Lignes mémoire redessinées
+    u64 renders;
+} Framebuffer;
+
+// Nom du mode ("text", "mono", "rgb332"), -1 si inconnu
+int fb_mode_from_name(const char *name);
+
+// Écran de cols x rows caractères (FB_TEXT) ou width x height pixels à partir
+// de 'base', police intégrée (ASCII). Les pages de l'écran ne doivent pas
+// déjà être interceptées (périphérique, registres de mapper). Retourne 0 en
+// cas d'erreur (message affiché).
+int fb_attach(Framebuffer *fb, Memory *mem, u16 base, FbMode mode, int width, int height);
+// Rend les pages à la RAM et libère l'image
+void fb_detach(Framebuffer *fb);
+
+// Police de 'glyph_count' glyphes de 8 octets (les suivants restent vides)
+void fb_set_font(Framebuffer *fb, const u8 *font, int glyph_count);
+// Police lue dans un fichier (chargen : 8 octets par glyphe, 256 au plus
+// lus). Retourne 0 en cas d'erreur (message affiché).
+int fb_load_font(Framebuffer *fb, const char *path);
+
+// Toutes les lignes à redessiner
+void fb_invalidate(Framebuffer *fb);
+// Redessine les lignes marquées. Retourne leur nombre.
+int fb_render(Framebuffer *fb);
+
+// Capture de l'écran courant (fb_render d'abord) selon l'extension : .ppm
+// (P6), .txt (mode texte : une ligne par rangée, '.' pour les codes non
+// imprimables), PNG sinon. Retourne 0 en cas d'erreur (message affiché).
+// Les fonctions fb_write_* écrivent l'image telle que rendue.
+int fb_save(Framebuffer *fb, const char *path);
+int fb_write_png(const Framebuffer *fb, FILE *out);
+int fb_write_ppm(const Framebuffer *fb, FILE *out);
+int fb_write_text(const Framebuffer *fb, FILE *out);
+#endif
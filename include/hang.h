@@ -0,0 +1,54 @@
+#ifndef HANG_H
+#define HANG_H
+
+#include "cpu.h"
+
+// --- Détection des boucles infinies ---
+// Un programme sans périphérique qui repasse par un état déjà vu (même
+// cpu_fingerprint : registres et mémoire, hors cycles) refera la même suite
+// pour toujours. Deux vérifications, appelées après chaque pas :
+//  - sur place : une instruction qui se succède à elle-même (JMP *, BNE *)
+//    est reconnue dès sa troisième exécution ;
+//  - méthode de Brent : l'état repère est comparé à chaque passage par son PC
+//    (une comparaison par pas, l'empreinte n'est calculée qu'à ce moment) et
+//    avance au bout de 'power' pas, power doublant jusqu'à HANG_MAX_POWER.
+//    Une boucle de période <= HANG_MAX_POWER pas est détectée moins de
+//    2 x HANG_MAX_POWER pas après y être entrée.
+// Un pas peut être une instruction ou un bloc entier (moteur à blocs).
+// L'empreinte de la mémoire doit être tenue à jour (mem_set_hashing).
+
+#define HANG_MAX_POWER (1u << 22)
+
+typedef struct {
+    u64 mark;          // Empreinte de l'état repère
+    u64 mark_cycles;
+    u16 mark_pc;
+    u32 power, steps;  // Pas depuis le repère, et avant de le déplacer
+
+    u16 last_pc;       // PC après le pas précédent
+    int self_valid;    // self_print : empreinte au PC last_pc
+    u64 self_print, self_cycles;
+
+    // Boucle détectée
+    u64 period_cycles; // Cycles d'un tour
+    u32 period_steps;  // Pas d'un tour
+} HangDetector;
+
+void hang_init(HangDetector *h, const CPU *cpu);
+// Chemins lents (PC du repère ou instruction sur place)
+int hang_check_self(HangDetector *h, const CPU *cpu);
+int hang_check_mark(HangDetector *h, const CPU *cpu);
+
+// Après chaque pas : vrai si l'état courant a déjà été vu (période dans h)
+static inline int hang_check(HangDetector *h, const CPU *cpu) {
+    u16 pc = cpu->PC;
+    if (pc == h->last_pc) {
+        if (hang_check_self(h, cpu)) return 1;
+    } else {
+        h->last_pc = pc;
+        h->self_valid = 0;
+    }
+    if (++h->steps == h->power || pc == h->mark_pc) return hang_check_mark(h, cpu);
+    return 0;
+}
+#endif
@@ -0,0 +1,84 @@
+#ifndef HOSTCALL_H
+#define HOSTCALL_H
+
+#include "cpu.h"
+
+// --- Appels à l'hôte (porte paravirtuelle) ---
+// Une page de périphérique sert de porte vers l'hôte : écrire un numéro de
+// service dans HC_CALL l'exécute pendant l'écriture, pour le prix des cycles
+// de l'instruction (un STA peut déplacer 64 Ko). Convention d'appel :
+//   A = service (la valeur écrite), X = argument d'un octet, ou X/Y =
+//   adresse (octets bas/haut) du bloc de paramètres (mots little-endian)
+//   Retour : C = 0 et A/X = résultat (octets bas/haut), ou C = 1 et A = errno
+//   de l'hôte (X = 0). Résultat et errno restent lisibles dans les registres.
+// Les handlers reçoivent le CPU (registres) et lisent ou écrivent la mémoire
+// invitée sans copie quand la plage est de la RAM contiguë sans
+// surveillance ; sinon octet par octet, avec les effets de mem_read et
+// mem_write (périphériques, code prédécodé, watchpoints).
+
+// Registres (adresse & 0x07)
+enum { HC_CALL, HC_RESULT_LO, HC_RESULT_HI, HC_ERRNO };
+
+// Services intégrés
+enum {
+    HC_EXIT,  // X = code de sortie : le run s'arrête après l'instruction
+    HC_WRITE, // { u8 fichier, u16 adresse, u16 taille } -> octets écrits
+    HC_READ,  // { u8 fichier, u16 adresse, u16 taille } -> octets lus (0 : fin)
+    HC_OPEN,  // { u16 chemin (terminé par 0), u8 mode } -> fichier ; mode 0 lecture, 1 écriture, 2 ajout
+    HC_CLOSE, // X = fichier
+    HC_LOAD,  // { u16 chemin, u16 adresse, u16 taille max } -> octets chargés
+    HC_TIME,  // { u64 µs depuis 1970 (hôte), u64 cycles émulés } remplis -> 0
+    HC_BUILTIN_COUNT
+};
+
+// Fichiers 0, 1, 2 : entrée, sortie et erreur standard de l'émulateur
+#define HOSTCALL_MAX_FILES 16
+
+typedef struct HostCall HostCall;
+// Service : résultat >= 0 (16 bits utiles), ou -errno
+typedef long (*HostCallFunc)(HostCall *hc, CPU *cpu, void *ctx);
+
+struct HostCall {
+    HostCallFunc services[256];
+    void *service_ctx[256];
+    int fds[HOSTCALL_MAX_FILES]; // -1 : libre
+
+    CPU *cpu;
+    u16 result;
+    u8 error;
+    int exited, exit_code;  // HC_EXIT appelé
+    u8 bounce[MAX_MEMORY];  // Copie des plages qui ne sont pas vues directement
+
+    u64 calls;
+    u64 bytes_direct, bytes_copied; // Octets passés sans copie / octet par octet
+};
+
+// Services intégrés, fichiers standard, et mappe la porte sur 'page'
+void hostcall_attach(HostCall *hc, Memory *mem, u8 page, CPU *cpu);
+// Ferme les fichiers ouverts par l'invité
+void hostcall_close_all(HostCall *hc);
+// Ajoute ou remplace un service (fn == NULL : service inconnu, ENOSYS)
+void hostcall_register(HostCall *hc, u8 service, HostCallFunc fn, void *ctx);
+
+u8 hostcall_read(void *ctx, u16 address);
+void hostcall_write(void *ctx, u16 address, u8 value);
+
+// --- Pour les services ---
+// Adresse du bloc de paramètres (X/Y) et mot little-endian qu'il contient
+static inline u16 hostcall_block(const CPU *cpu) {
+    return (u16)(cpu->X | cpu->Y << 8);
+}
+u16 hostcall_word(Memory *mem, u16 address);
+// Octets [address, address + len) vus directement dans l'hôte (pages
+// consécutives d'une même zone, sans chemin lent ; en écriture, l'appelant
+// met ensuite mem->hash à jour). NULL sinon.
+u8 *hostcall_view(Memory *mem, u16 address, u32 len, int writing);
+// Données invitées -> hôte : vue directe, ou copie dans hc->bounce
+const u8 *hostcall_source(HostCall *hc, u16 address, u32 len);
+// Hôte -> invité : hostcall_target donne où écrire au plus len octets,
+// hostcall_commit (obligatoire, même si rien n'a été écrit) rend visibles
+// les 'written' premiers : empreinte mise à jour, ou mem_write de la copie.
+// address + len doit rester sous $10000.
+u8 *hostcall_target(HostCall *hc, u16 address, u32 len);
+void hostcall_commit(HostCall *hc, u16 address, u32 len, u32 written, u8 *target);
+#endif
@@ -0,0 +1,63 @@
+#ifndef HWPROF_H
+#define HWPROF_H
+
+#include <stdio.h>
+#include "cpu.h"
+
+// --- Profil matériel par opcode (--hwprof) ---
+// Compteurs du processeur hôte (perf_event_open : cycles, instructions,
+// branch-misses, défauts de cache L1d) lus autour d'une instruction émulée
+// sur PERIODE en moyenne (intervalle pseudo-aléatoire, pour ne pas se caler
+// sur une boucle du programme). Le coût d'une mesure à vide, étalonné à
+// l'ouverture, est soustrait de chaque échantillon. Toutes les instructions
+// sont comptées par opcode : coût moyen x exécutions donne la part de chaque
+// handler de instructions.c, puis de chaque opcode (mode d'adressage).
+// Sans compteur matériel (machine virtuelle...), les cycles viennent du TSC.
+
+typedef enum {
+    HWPROF_CYCLES, HWPROF_INSTRUCTIONS, HWPROF_BRANCH_MISSES, HWPROF_L1D_MISSES,
+    HWPROF_EVENT_COUNT
+} HwprofEvent;
+
+typedef struct {
+    u64 count;                      // Exécutions (toutes)
+    u64 samples;
+    double sum[HWPROF_EVENT_COUNT]; // Deltas échantillonnés, mesure à vide déduite
+} HwprofOpcode;
+
+typedef struct {
+    int fd[HWPROF_EVENT_COUNT];
+    int group;                      // Leader du groupe perf, -1 si aucun compteur
+    int slot[HWPROF_EVENT_COUNT];   // Position dans la lecture du groupe, -1 : indisponible
+    int nr;                         // Compteurs dans le groupe
+    int tsc;                        // Cycles mesurés par rdtsc
+    u32 period, countdown, rng;
+    double baseline[HWPROF_EVENT_COUNT];
+    u64 samples;
+    HwprofOpcode ops[256];
+} HwProfile;
+
+// Ouvre les compteurs et étalonne. Retourne 0 si aucun compteur n'est utilisable.
+int hwprof_open(HwProfile *p, u32 period);
+void hwprof_close(HwProfile *p);
+
+// Mesure une instruction (cpu_step) et accumule ses compteurs
+void hwprof_sample(HwProfile *p, CPU *cpu);
+
+// cpu_step, avec comptage de l'opcode et échantillonnage
+static inline void hwprof_step(HwProfile *p, CPU *cpu) {
+    if (cpu->events) { // Peut-être une interruption : non attribuée
+        cpu_step(cpu);
+        return;
+    }
+    if (--p->countdown == 0) {
+        hwprof_sample(p, cpu);
+        return;
+    }
+    p->ops[mem_peek(cpu->mem, cpu->PC)].count++;
+    cpu_step(cpu);
+}
+
+// Tableau hiérarchique : total, puis par handler, puis par opcode
+void hwprof_report(const HwProfile *p, CpuVariant variant, FILE *out);
+#endif
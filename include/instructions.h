@@ -3,91 +3,121 @@
 
 #include "cpu.h"
 
-void ins_LDA(CPU *cpu);
-void ins_LDX(CPU *cpu);
-void ins_STA(CPU *cpu);
-void ins_NOP(CPU *cpu);
+void ins_LDA(CPU *cpu, u16 addr);
+void ins_LDX(CPU *cpu, u16 addr);
+void ins_STA(CPU *cpu, u16 addr);
+void ins_NOP(CPU *cpu, u16 addr);
 // Transferts
-void ins_TAX(CPU *cpu); // A -> X
-void ins_TXA(CPU *cpu); // X -> A
+void ins_TAX(CPU *cpu, u16 addr); // A -> X
+void ins_TXA(CPU *cpu, u16 addr); // X -> A
 
 // Incréments
-void ins_INX(CPU *cpu); // X + 1
-void ins_DEX(CPU *cpu); // X - 1
+void ins_INX(CPU *cpu, u16 addr); // X + 1
+void ins_DEX(CPU *cpu, u16 addr); // X - 1
 
 // Branchements (Sauts conditionnels)
-void ins_BEQ(CPU *cpu); // Branch if Equal (Z == 1)
-void ins_BNE(CPU *cpu); // Branch if Not Equal (Z == 0)
+void ins_BEQ(CPU *cpu, u16 addr); // Branch if Equal (Z == 1)
+void ins_BNE(CPU *cpu, u16 addr); // Branch if Not Equal (Z == 0)
 
 // Contrôle
-void ins_JMP(CPU *cpu); // Saut inconditionnel
+void ins_JMP(CPU *cpu, u16 addr); // Saut inconditionnel
 
-void ins_PHA(CPU *cpu);
-void ins_PLA(CPU *cpu);
-void ins_JSR(CPU *cpu); // Attention, conflit avec le nom de l'instruction JMP qu'on a mis avant
-void ins_RTS(CPU *cpu);
+void ins_PHA(CPU *cpu, u16 addr);
+void ins_PLA(CPU *cpu, u16 addr);
+void ins_JSR(CPU *cpu, u16 addr); // Attention, conflit avec le nom de l'instruction JMP qu'on a mis avant
+void ins_RTS(CPU *cpu, u16 addr);
 
 // Arithmétique
-void ins_ADC(CPU *cpu); // Addition avec retenue
-void ins_SBC(CPU *cpu); // Soustraction avec retenue
+void ins_ADC(CPU *cpu, u16 addr); // Addition avec retenue
+void ins_SBC(CPU *cpu, u16 addr); // Soustraction avec retenue
 
 // Comparaison
-void ins_CMP(CPU *cpu); // Comparer A
-void ins_CPX(CPU *cpu); // Comparer X
-void ins_CPY(CPU *cpu); // Comparer Y
+void ins_CMP(CPU *cpu, u16 addr); // Comparer A
+void ins_CPX(CPU *cpu, u16 addr); // Comparer X
+void ins_CPY(CPU *cpu, u16 addr); // Comparer Y
 
 // Logique
-void ins_AND(CPU *cpu); // ET binaire
-void ins_ORA(CPU *cpu); // OU binaire
-void ins_EOR(CPU *cpu); // OU exclusif binaire
-
-void ins_CLC(CPU *cpu);
-void ins_SEC(CPU *cpu);
-void ins_CLD(CPU *cpu);
-void ins_SED(CPU *cpu);
-void ins_CLI(CPU *cpu);
-void ins_SEI(CPU *cpu);
-void ins_CLV(CPU *cpu);
+void ins_AND(CPU *cpu, u16 addr); // ET binaire
+void ins_ORA(CPU *cpu, u16 addr); // OU binaire
+void ins_EOR(CPU *cpu, u16 addr); // OU exclusif binaire
+
+void ins_CLC(CPU *cpu, u16 addr);
+void ins_SEC(CPU *cpu, u16 addr);
+void ins_CLD(CPU *cpu, u16 addr);
+void ins_SED(CPU *cpu, u16 addr);
+void ins_CLI(CPU *cpu, u16 addr);
+void ins_SEI(CPU *cpu, u16 addr);
+void ins_CLV(CPU *cpu, u16 addr);
 
 // --- Registre Y ---
-void ins_LDY(CPU *cpu);
-void ins_STY(CPU *cpu);
-void ins_INY(CPU *cpu);
-void ins_DEY(CPU *cpu);
+void ins_LDY(CPU *cpu, u16 addr);
+void ins_STY(CPU *cpu, u16 addr);
+void ins_INY(CPU *cpu, u16 addr);
+void ins_DEY(CPU *cpu, u16 addr);
 
 // --- Mémoire ---
-void ins_INC(CPU *cpu); // Incrémente une case mémoire
-void ins_DEC(CPU *cpu); // Décrémente une case mémoire
+void ins_INC(CPU *cpu, u16 addr); // Incrémente une case mémoire
+void ins_DEC(CPU *cpu, u16 addr); // Décrémente une case mémoire
 
 // --- Bits ---
-void ins_ASL(CPU *cpu); // Shift Left (Décalage à gauche)
-void ins_LSR(CPU *cpu); // Shift Right (Décalage à droite)
-
-void ins_ASL_ACC(CPU *cpu); // Shift Left (Décalage à gauche)
-void ins_LSR_ACC(CPU *cpu); // Shift Right (Décalage à droite)
-
-void ins_BRK(CPU *cpu); // Break (Software Interrupt)
-void ins_RTI(CPU *cpu); // Return from Interrupt
-
-void ins_TXS(CPU *cpu);
-void ins_TSX(CPU *cpu);
-
-void ins_TYA(CPU *cpu);
-void ins_TAY(CPU *cpu);
-
-void ins_BPL(CPU *cpu);
-void ins_BMI(CPU *cpu);
-void ins_BCS(CPU *cpu);
-void ins_BCC(CPU *cpu);
-void ins_BVS(CPU *cpu);
-void ins_BVC(CPU *cpu);
-
-void ins_PLP(CPU *cpu);
-void ins_PHP(CPU *cpu);
-void ins_STX(CPU *cpu);
-void ins_BIT(CPU *cpu);
-void ins_ROL_ACC(CPU *cpu);
-void ins_ROL(CPU *cpu);
-void ins_ROR_ACC(CPU *cpu);
-void ins_ROR(CPU *cpu);
+void ins_ASL(CPU *cpu, u16 addr); // Shift Left (Décalage à gauche)
+void ins_LSR(CPU *cpu, u16 addr); // Shift Right (Décalage à droite)
+
+void ins_ASL_ACC(CPU *cpu, u16 addr); // Shift Left (Décalage à gauche)
+void ins_LSR_ACC(CPU *cpu, u16 addr); // Shift Right (Décalage à droite)
+
+void ins_BRK(CPU *cpu, u16 addr); // Break (Software Interrupt)
+void ins_RTI(CPU *cpu, u16 addr); // Return from Interrupt
+
+void ins_TXS(CPU *cpu, u16 addr);
+void ins_TSX(CPU *cpu, u16 addr);
+
+void ins_TYA(CPU *cpu, u16 addr);
+void ins_TAY(CPU *cpu, u16 addr);
+
+void ins_BPL(CPU *cpu, u16 addr);
+void ins_BMI(CPU *cpu, u16 addr);
+void ins_BCS(CPU *cpu, u16 addr);
+void ins_BCC(CPU *cpu, u16 addr);
+void ins_BVS(CPU *cpu, u16 addr);
+void ins_BVC(CPU *cpu, u16 addr);
+
+void ins_PLP(CPU *cpu, u16 addr);
+void ins_PHP(CPU *cpu, u16 addr);
+void ins_STX(CPU *cpu, u16 addr);
+void ins_BIT(CPU *cpu, u16 addr);
+void ins_ROL_ACC(CPU *cpu, u16 addr);
+void ins_ROL(CPU *cpu, u16 addr);
+void ins_ROR_ACC(CPU *cpu, u16 addr);
+void ins_ROR(CPU *cpu, u16 addr);
+
+// --- Variantes ---
+void ins_ADC_BIN(CPU *cpu, u16 addr);  // 2A03 : ADC sans mode décimal
+void ins_SBC_BIN(CPU *cpu, u16 addr);  // 2A03 : SBC sans mode décimal
+void ins_ADC_CMOS(CPU *cpu, u16 addr); // 65C02 : N/Z valides en décimal
+void ins_SBC_CMOS(CPU *cpu, u16 addr);
+void ins_BRK_CMOS(CPU *cpu, u16 addr); // 65C02 : BRK efface aussi D
+
+// --- Nouveaux opcodes 65C02 ---
+void ins_BRA(CPU *cpu, u16 addr); // Branch Always
+void ins_PHX(CPU *cpu, u16 addr);
+void ins_PLX(CPU *cpu, u16 addr);
+void ins_PHY(CPU *cpu, u16 addr);
+void ins_PLY(CPU *cpu, u16 addr);
+void ins_STZ(CPU *cpu, u16 addr); // Store Zero
+void ins_INC_ACC(CPU *cpu, u16 addr);
+void ins_DEC_ACC(CPU *cpu, u16 addr);
+void ins_TSB(CPU *cpu, u16 addr); // Test and Set Bits
+void ins_TRB(CPU *cpu, u16 addr); // Test and Reset Bits
+void ins_BIT_IMM(CPU *cpu, u16 addr); // BIT #imm : seul Z est modifié
+void ins_WAI(CPU *cpu, u16 addr); // Attend une interruption
+void ins_STP(CPU *cpu, u16 addr); // Arrête le CPU jusqu'au reset
+
+// RMBn/SMBn : efface / met le bit n de l'octet en page 0
+// BBRn/BBSn : branche si le bit n est à 0 / à 1 (mode addr_zero_page_relative)
+#define DECLARE_BIT_OPS(n) \
+    void ins_RMB##n(CPU *cpu, u16 addr); void ins_SMB##n(CPU *cpu, u16 addr); \
+    void ins_BBR##n(CPU *cpu, u16 addr); void ins_BBS##n(CPU *cpu, u16 addr);
+DECLARE_BIT_OPS(0) DECLARE_BIT_OPS(1) DECLARE_BIT_OPS(2) DECLARE_BIT_OPS(3)
+DECLARE_BIT_OPS(4) DECLARE_BIT_OPS(5) DECLARE_BIT_OPS(6) DECLARE_BIT_OPS(7)
 #endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef IRQLAT_H
+#define IRQLAT_H
+
+#include <stdio.h>
+#include "cpu.h"
+
+// --- Latence des interruptions (--irq-latency) ---
+// Par source (un bit des lignes IRQ ou NMI) : cycles entre la montée de sa
+// ligne et la première instruction du handler (après la séquence
+// d'interruption). Le cœur appelle ce module seulement si cpu->latency est
+// fixé, et seulement quand une ligne change ou qu'une interruption est prise.
+//  - IRQ (niveau) : toutes les sources en attente et toujours actives sont
+//    servies par la même entrée ; une source qui retombe avant (scrutée et
+//    acquittée par le programme, I à 1...) est comptée comme retirée.
+//  - NMI (front) : les sources du front sont servies à l'entrée suivante ; une
+//    source qui monte quand la ligne est déjà tenue, ou pendant qu'une NMI
+//    attend, ne produit pas d'interruption et est comptée comme perdue.
+// Histogramme : un seau par cycle jusqu'à IRQLAT_EXACT - 1, puis un par
+// puissance de deux.
+
+#define IRQLAT_SOURCES 8
+#define IRQLAT_EXACT_BITS 8
+#define IRQLAT_EXACT (1 << IRQLAT_EXACT_BITS)
+#define IRQLAT_BUCKETS (IRQLAT_EXACT + 64 - IRQLAT_EXACT_BITS) // Jusqu'à 2^64 - 1
+
+typedef struct {
+    u64 count;    // Latences mesurées
+    u64 dropped;  // IRQ retirées avant d'être servies, NMI perdues
+    u64 min, max, sum;
+    u64 hist[IRQLAT_BUCKETS];
+} IrqLatencyStats;
+
+typedef struct IrqLatency {
+    u64 irq_since[IRQLAT_SOURCES]; // Cycle de montée de la ligne
+    u8 irq_waiting;                // Sources montées, pas encore servies
+    u8 nmi_waiting;                // Sources du front NMI mémorisé
+    u64 nmi_since;                 // Cycle de ce front
+    IrqLatencyStats irq[IRQLAT_SOURCES], nmi[IRQLAT_SOURCES];
+} IrqLatency;
+
+void irqlat_init(IrqLatency *l);
+
+// Appels du cœur (cpu.c)
+// Sources IRQ montées / retombées au cycle 'when'
+void irqlat_irq_lines(IrqLatency *l, u8 rose, u8 fell, u64 when);
+// Sources NMI montées : front (edge) ou ligne déjà active
+void irqlat_nmi_rise(IrqLatency *l, u8 rose, int edge, u64 when);
+// Entrée dans le handler, première instruction au cycle 'now'
+void irqlat_irq_taken(IrqLatency *l, u8 lines, u64 now);
+void irqlat_nmi_taken(IrqLatency *l, u64 now);
+
+// Tableau par source (servies, retirées/perdues, min, moyenne, max) et histogrammes
+void irqlat_report(const IrqLatency *l, FILE *out);
+#endif
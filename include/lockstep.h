@@ -0,0 +1,55 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <stdio.h>
+#include "cpu.h"
+#include "codemap.h"
+
+// --- Exécution différentielle (Lock-step) ---
+// Fait tourner l'interpréteur de référence (cpu_step) et un moteur optimisé
+// côte à côte, et compare l'état architectural à chaque frontière
+// d'instruction ou de bloc.
+
+// Un moteur exécute une ou plusieurs instructions et retourne leur nombre.
+// ctx = état propre au moteur (créé par 'create', NULL s'il n'en a pas).
+typedef int (*EngineStepFunc)(CPU *cpu, void *ctx);
+
+typedef struct {
+    const char *name;
+    EngineStepFunc step;
+    void *(*create)(CPU *cpu, const CodeMap *cm); // cm : carte statique, ou NULL
+    void (*destroy)(void *ctx);
+} Engine;
+
+// Journal des écritures mémoire, gardé sous forme de hash (FNV-1a)
+typedef struct {
+    u64 hash;
+    u64 count;
+} WriteLog;
+
+typedef struct {
+    CPU ref, test;
+    Memory *ref_mem, *test_mem;
+    WriteLog ref_log, test_log;
+    const Engine *engine;
+    void *engine_ctx;
+    u64 instructions; // Instructions exécutées par la référence
+} Lockstep;
+
+// Moteurs disponibles (le premier est la référence)
+const Engine *lockstep_find_engine(const char *name);
+void lockstep_list_engines(FILE *out);
+
+// Copie l'image mémoire dans les deux machines, les initialise dans la
+// variante donnée et place PC. La carte statique (optionnelle, construite
+// pour la même variante) est passée au moteur testé. Retourne 0 si erreur.
+int lockstep_init(Lockstep *ls, const Memory *image, u16 pc, CpuVariant variant, const Engine *engine,
+                  const CodeMap *cm);
+void lockstep_free(Lockstep *ls);
+
+// Avance d'une frontière (instruction ou bloc). Retourne 0 en cas de divergence.
+int lockstep_step(Lockstep *ls);
+
+// Affiche un diff complet des deux états
+void lockstep_report(const Lockstep *ls, FILE *out);
+#endif
@@ -0,0 +1,19 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include "types.h"
+
+// --- Compression LZ4 (format bloc) ---
+// Implémentation minimale et autonome du format bloc de LZ4 : les blocs
+// produits sont lisibles par LZ4_decompress_safe et inversement. Compression
+// gloutonne (table de hachage de 4096 positions), sans dictionnaire.
+
+// Taille maximale d'un bloc compressé à partir de n octets
+#define LZ4_BOUND(n) ((n) + (n) / 255 + 16)
+
+// Retourne la taille compressée, ou -1 si dst (cap octets) est trop petit
+int lz4_compress(const u8 *src, int n, u8 *dst, int cap);
+// Retourne la taille décompressée, ou -1 si le bloc est invalide ou ne
+// tient pas dans dst (cap octets). N'écrit jamais hors de dst.
+int lz4_decompress(const u8 *src, int n, u8 *dst, int cap);
+#endif
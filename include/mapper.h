@@ -0,0 +1,64 @@
+#ifndef MAPPER_H
+#define MAPPER_H
+
+#include "memory.h"
+
+// --- Mappers (changement de banque) ---
+// La ROM et la RAM d'une cartouche ou d'une machine dépassent souvent 64 Ko :
+// elles sont gardées dans des pools de taille quelconque et une banque est
+// rendue visible en faisant pointer des pages de la table de Memory dans le
+// pool (mem_map_pages). Un changement de banque coûte quelques affectations
+// de pointeurs ; seuls les blocs prédécodés des pages remappées sont
+// invalidés. Les registres du mapper sont déclenchés par les écritures sur
+// leurs adresses (pages MEM_PAGE_WRITE_TRAP : les lectures restent directes).
+
+// Mappers iNES pris en charge (numéro de l'en-tête)
+#define MAPPER_NROM  0
+#define MAPPER_MMC1  1
+#define MAPPER_UXROM 2
+#define MAPPER_AXROM 7
+// Port $01 du C64 (pas un numéro iNES)
+#define MAPPER_C64   256
+
+#define INES_HEADER_SIZE 16
+#define INES_PRG_BANK    0x4000 // 16 Ko
+#define INES_PRG_RAM     0x2000 // 8 Ko en $6000-$7FFF
+
+typedef struct {
+    Memory *mem;
+    int kind;            // MAPPER_*
+    u8 *rom;             // Pool de ROM (PRG pour l'iNES, BASIC + KERNAL + CHARGEN pour le C64)
+    u32 rom_size;
+    u8 *ram;             // Pool de RAM de cartouche (PRG RAM), NULL si aucune
+    u32 ram_size;
+    u32 prg_banks;       // Banques de 16 Ko (iNES)
+    u8 mirroring;        // iNES : 0 horizontal, 1 vertical (informatif, pas de PPU)
+
+    // MMC1 : registre à décalage série et registres internes
+    u8 shift, shift_count;
+    u8 control, chr0, chr1, prg;
+
+    u64 switches;        // Changements de banque effectifs
+    u64 register_writes; // Écritures sur les registres du mapper
+} Mapper;
+
+// Vrai si le fichier commence par l'en-tête iNES ("NES\x1A")
+int mapper_is_ines(const char *filename);
+
+// Charge une ROM iNES : PRG ROM dans le pool, RAM de la NES ($0000-$07FF
+// répétée jusqu'à $1FFF), PRG RAM en $6000, banques initiales et registres
+// en $8000-$FFFF. Retourne 0 en cas d'erreur (message affiché).
+int mapper_load_ines(Mapper *m, Memory *mem, const char *filename);
+
+// Banques du C64 commandées par le port $01 (LORAM, HIRAM, CHAREN) et son
+// registre de direction $00 : BASIC en $A000, KERNAL en $E000 et CHARGEN en
+// $D000 (sinon E/S : la RAM, où les périphériques éventuels se mappent).
+// Les écritures sous une ROM vont toujours dans la RAM.
+int mapper_load_c64(Mapper *m, Memory *mem, const char *basic, const char *kernal, const char *chargen);
+
+// Rend les pages à la RAM interne et libère les pools
+void mapper_free(Mapper *m);
+
+// Nom du mapper ("MMC1", "C64"...)
+const char *mapper_name(const Mapper *m);
+#endif
@@ -6,16 +6,203 @@
 // 64 Ko de RAM (0x0000 à 0xFFFF)
 #define MAX_MEMORY 0x10000
 
+// --- Points de surveillance (Watchpoints) ---
+// Types d'accès surveillés (combinables)
+#define MEM_WATCH_READ  (1 << 0)
+#define MEM_WATCH_WRITE (1 << 1)
+#define MEM_WATCH_EXEC  (1 << 2)
+
+#define MAX_WATCHPOINTS 16
+
+// Page occupée par un périphérique (MMIO) : lectures et écritures passent par le chemin lent
+#define MEM_PAGE_IO (1 << 3)
+// Page contenant du code prédécodé : les écritures doivent l'invalider
+#define MEM_PAGE_CODE (1 << 4)
+// Page en lecture seule (banque de ROM) : les écritures vont à write_page
+#define MEM_PAGE_ROM (1 << 5)
+// Écritures interceptées (registres d'un mapper), lectures directes
+#define MEM_PAGE_WRITE_TRAP (1 << 6)
+// Page partagée avec la mémoire d'origine d'un mem_fork : recopiée à la
+// première écriture
+#define MEM_PAGE_COW (1 << 7)
+#define MEM_SLOW_READ  (MEM_WATCH_READ | MEM_PAGE_IO)
+#define MEM_SLOW_WRITE (MEM_WATCH_WRITE | MEM_PAGE_IO | MEM_PAGE_CODE | MEM_PAGE_ROM | MEM_PAGE_WRITE_TRAP \
+                        | MEM_PAGE_COW)
+
+// Callback appelé lors d'un accès surveillé :
+// pc = adresse de l'instruction en cours, kind = MEM_WATCH_READ/WRITE/EXEC
+typedef void (*WatchFunc)(void *ctx, u16 pc, u16 address, u8 value, u8 kind);
+
+typedef struct {
+    u16 start, end; // Plage surveillée (bornes incluses)
+    u8 kinds;       // Types d'accès surveillés
+    WatchFunc callback;
+    void *ctx;
+} Watchpoint;
+
+// Périphérique mappé en mémoire (une ou plusieurs pages de 256 octets)
+typedef u8 (*IoReadFunc)(void *ctx, u16 address);
+typedef void (*IoWriteFunc)(void *ctx, u16 address, u8 value);
+
+typedef struct {
+    IoReadFunc read;
+    IoWriteFunc write;
+    void *ctx;
+} IoHandler;
+
+// Appelé après une écriture dans une page MEM_PAGE_CODE
+typedef void (*CodeWriteFunc)(void *ctx, u16 address);
+// Appelé quand une page MEM_PAGE_CODE change de banque
+typedef void (*CodeRemapFunc)(void *ctx, u8 page);
+
 // Structure représentant la mémoire de l'ordinateur
 typedef struct {
     u8 data[MAX_MEMORY];
+
+    // Une entrée par page de 256 octets : les types d'accès qui doivent
+    // passer par le chemin lent. 0 = page normale (accès direct).
+    u8 page_flags[256];
+
+    // Table des pages : l'octet visible en A est page[A >> 8][A & 0xFF].
+    // Par défaut chaque page pointe dans data ; un mapper les fait pointer
+    // dans ses banques (changer de banque = changer des pointeurs).
+    u8 *page[256];
+    u8 *write_page[256]; // Pages MEM_PAGE_ROM : cible des écritures (NULL : ignorées)
+
+    // Empreinte de la RAM : XOR de mem_byte_hash(A, octet) sur toutes les
+    // adresses dont la page a une cible d'écriture. Tenue à jour à chaque
+    // écriture (O(1)) seulement si 'hashing' (mem_set_hashing) ; une écriture
+    // qui contourne mem_write doit être suivie de mem_rehash.
+    u64 hash;
+    int hashing; // Empreinte tenue à jour (détection de boucles, exploration)
+
+    const u16 *pc; // Adresse de l'instruction en cours (fournie par le CPU)
+    Watchpoint watches[MAX_WATCHPOINTS];
+    int watch_count;
+
+    IoHandler io[256]; // Périphérique de chaque page (read == NULL : RAM)
+
+    CodeWriteFunc code_write; // Invalidation du code prédécodé (NULL : aucun)
+    CodeRemapFunc code_remap;
+    void *code_ctx;
 } Memory;
 
 // Prototypes des fonctions
 void mem_init(Memory *mem);
-u8 mem_read(Memory *mem, u16 address);
-void mem_write(Memory *mem, u16 address, u8 value);
 // Charge un fichier binaire en mémoire à partir d'une adresse donnée
 // Retourne la taille du fichier chargé, ou 0 si erreur
 int mem_load(Memory *mem, const char *filename, u16 offset);
-#endif
\ No newline at end of file
+// Copie size octets dans la RAM interne (data) à partir de address, sans
+// passer par les périphériques, et met l'empreinte à jour
+void mem_load_bytes(Memory *mem, u16 address, const void *bytes, u32 size);
+
+// --- Empreinte incrémentale ---
+// Contribution de l'octet 'value' en 'address' à mem->hash (les 2^24 couples
+// ont des valeurs distinctes : le mélange est une bijection sur 64 bits)
+static inline u64 mem_byte_hash(u16 address, u8 value) {
+    u64 x = (((u64)address << 8) | value) + 1;
+    x *= 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 32;
+    x *= 0xD6E8FEB86659FD93ULL;
+    return x ^ (x >> 32);
+}
+// Recalcule mem->hash depuis le contenu (après des écritures directes dans
+// data ou dans un pool de mapper). Une page visible par deux adresses (miroir)
+// n'est à jour que par l'adresse où elle a été écrite : sans rehash, deux
+// états égaux peuvent alors avoir des empreintes différentes, jamais l'inverse
+// (à une collision près). Sans effet si l'empreinte n'est pas tenue à jour.
+void mem_rehash(Memory *mem);
+// Active (et recalcule) ou coupe l'empreinte. Coupée par défaut : mem->hash
+// et cpu_fingerprint n'ont alors pas de sens, mais une écriture ne coûte
+// qu'un test de plus.
+void mem_set_hashing(Memory *mem, int on);
+
+// Ajoute un watchpoint sur [start, end]. Retourne son index, ou -1 si la table est pleine.
+int mem_add_watch(Memory *mem, u16 start, u16 end, u8 kinds, WatchFunc callback, void *ctx);
+void mem_remove_watch(Memory *mem, int index);
+
+// Mappe un périphérique sur les pages [first_page, last_page]
+void mem_map_io(Memory *mem, u8 first_page, u8 last_page, IoReadFunc read, IoWriteFunc write, void *ctx);
+void mem_unmap_io(Memory *mem, u8 first_page, u8 last_page);
+
+// Signale (ou non) une page comme contenant du code prédécodé
+void mem_mark_code(Memory *mem, u8 page, int on);
+
+// --- Banques ---
+// Les pages [first_page, first_page + count) lisent 'read' et écrivent dans
+// 'write' (count x 256 octets chacun, pris dans un pool de taille
+// quelconque). read == write : RAM ; sinon ROM (write == NULL : écritures
+// ignorées). Le code prédécodé n'est invalidé que sur ces pages.
+void mem_map_pages(Memory *mem, u8 first_page, int count, u8 *read, u8 *write);
+// Remet les pages sur la RAM interne (data)
+void mem_unmap_pages(Memory *mem, u8 first_page, int count);
+// Les écritures dans ces pages appellent 'write' après avoir été faites
+// (registres d'un mapper) ; les lectures restent directes
+void mem_trap_writes(Memory *mem, u8 first_page, u8 last_page, IoWriteFunc write, void *ctx);
+// Copie une mémoire : les pages de la RAM interne de src pointent dans celle de dst
+void mem_copy(Memory *dst, const Memory *src);
+// Copie sur écriture : dst lit les pages de src sans les recopier (seuls la
+// table des pages et les drapeaux le sont) ; une page n'est recopiée dans
+// dst->data qu'à sa première écriture. src ne doit plus être modifiée tant
+// que dst existe. Les pools des mappers restent partagés.
+void mem_fork(Memory *dst, const Memory *src);
+// dst vient d'un mem_fork(dst, src) : annule ses écritures en remettant en
+// partage les seules pages recopiées depuis (bien moins cher qu'un mem_fork)
+void mem_refork(Memory *dst, const Memory *src);
+// Vrai si la page a été recopiée dans la RAM interne (écrite depuis le mem_fork)
+static inline int mem_page_private(const Memory *mem, u8 page) {
+    return mem->write_page[page] == &mem->data[page << 8];
+}
+
+// Chemins lents (pages signalées uniquement)
+u8 mem_read_slow(Memory *mem, u16 address);
+void mem_write_slow(Memory *mem, u16 address, u8 value);
+void mem_exec_slow(Memory *mem, u16 address);
+
+// Lit un octet à une adresse donnée
+static inline u8 mem_read(Memory *mem, u16 address) {
+    if (mem->page_flags[address >> 8] & MEM_SLOW_READ) {
+        return mem_read_slow(mem, address);
+    }
+    return mem->page[address >> 8][address & 0xFF];
+}
+
+// Octet visible à cette adresse, sans effet de bord (ni périphérique ni
+// watchpoint) : désassembleur, analyse statique, outils
+static inline u8 mem_peek(const Memory *mem, u16 address) {
+    return mem->page[address >> 8][address & 0xFF];
+}
+
+// Remplace l'octet 'old' par 'value' en 'address' dans l'empreinte (si elle
+// est tenue à jour)
+static inline void mem_hash_update(Memory *mem, u16 address, u8 old, u8 value) {
+    if (mem->hashing) mem->hash ^= mem_byte_hash(address, old) ^ mem_byte_hash(address, value);
+}
+
+// Écrit un octet à une adresse donnée
+static inline void mem_write(Memory *mem, u16 address, u8 value) {
+    if (mem->page_flags[address >> 8] & MEM_SLOW_WRITE) {
+        mem_write_slow(mem, address, value);
+        return;
+    }
+    u8 *p = &mem->page[address >> 8][address & 0xFF];
+    mem_hash_update(mem, address, *p, value);
+    *p = value;
+}
+
+// Lit un pointeur 16 bits en page zéro ((zp), (zp,X), (zp),Y). L'octet haut
+// est lu en zp + 1 modulo 256. Un seul test de page quand la page 0 est de la RAM.
+static inline u16 mem_read_zp_word(Memory *mem, u8 zp) {
+    if (mem->page_flags[0] & MEM_SLOW_READ) {
+        return mem_read_slow(mem, zp) | (mem_read_slow(mem, (u8)(zp + 1)) << 8);
+    }
+    return mem->page[0][zp] | (mem->page[0][(u8)(zp + 1)] << 8);
+}
+
+// Signale l'exécution d'une instruction à l'adresse donnée (appelé au fetch)
+static inline void mem_exec(Memory *mem, u16 address) {
+    if (mem->page_flags[address >> 8] & MEM_WATCH_EXEC) {
+        mem_exec_slow(mem, address);
+    }
+}
+#endif
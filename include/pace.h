@@ -0,0 +1,52 @@
+#ifndef PACE_H
+#define PACE_H
+
+#include <stdio.h>
+#include "types.h"
+
+// --- Cadencement temps réel ---
+// Le CPU tourne par tranches de cycles correspondant à une durée hôte
+// (1 ms par défaut), puis dort avec clock_nanosleep jusqu'à l'échéance absolue
+// de la tranche. Les échéances sont calculées depuis une origine fixe : pas de
+// dérive cumulée. Si l'hôte prend du retard, les tranches suivantes
+// s'enchaînent sans dormir (rattrapage) jusqu'à max_lag_ns, au-delà duquel on
+// abandonne le retard (resynchronisation).
+
+typedef struct {
+    double hz;           // Fréquence cible du CPU émulé
+    u64 slice_ns;        // Durée d'une tranche
+    u64 slice_cycles;    // Cycles par tranche
+    u64 max_lag_ns;      // Retard maximal rattrapé
+
+    u64 origin_ns;       // Temps hôte (CLOCK_MONOTONIC) de l'origine
+    u64 origin_cycles;   // Cycle émulé à l'origine
+    u64 slice_end;       // Cycle de fin de la tranche en cours
+    u64 start_ns, start_cycles; // Début du cadencement (pour la fréquence effective)
+
+    // Statistiques
+    u64 slices;          // Tranches terminées
+    u64 overruns;        // Tranches finies après leur échéance (pas de sommeil)
+    u64 resyncs;         // Retards abandonnés
+    u64 lag_max_ns;      // Plus grand retard constaté en fin de tranche
+    u64 busy_ns;         // Temps passé à émuler (hors sommeil)
+    u64 sleeps;          // Réveils mesurés
+    s64 jitter_min_ns, jitter_max_ns; // Retard du réveil sur l'échéance
+    double jitter_sum, jitter_sq;
+    u64 last_wake_ns;
+} Pacer;
+
+// slice_us = 0 : 1000 us par défaut
+void pace_init(Pacer *p, double hz, u64 slice_us, u64 now_cycles);
+
+// Vérification à faire après chaque instruction (une seule comparaison)
+static inline int pace_due(const Pacer *p, u64 now_cycles) {
+    return now_cycles >= p->slice_end;
+}
+
+// Fin de tranche : dort jusqu'à l'échéance de 'now_cycles' et prépare la suivante
+void pace_wait(Pacer *p, u64 now_cycles);
+
+// Fréquence effective depuis l'origine (cycles par seconde hôte)
+double pace_effective_hz(const Pacer *p, u64 now_cycles);
+void pace_report(const Pacer *p, u64 now_cycles, FILE *out);
+#endif
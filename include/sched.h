@@ -0,0 +1,45 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "cpu.h"
+
+// --- Ordonnanceur d'événements (en cycles CPU) ---
+// Les périphériques programment une échéance au lieu d'être interrogés après
+// chaque cpu_step : la boucle d'exécution ne compare qu'un seul compteur
+// (next) et n'appelle les événements qu'une fois leur échéance atteinte.
+
+#define MAX_EVENTS 32
+#define SCHED_NEVER UINT64_MAX
+
+// Callback d'un événement : now = cycle courant (>= échéance)
+typedef void (*SchedFunc)(void *ctx, u64 now);
+
+typedef struct {
+    u64 deadline; // SCHED_NEVER si inactif
+    SchedFunc fn;
+    void *ctx;
+} SchedEvent;
+
+typedef struct {
+    SchedEvent events[MAX_EVENTS];
+    int count;
+    u64 next; // Plus proche échéance
+} Scheduler;
+
+void sched_init(Scheduler *s);
+// Enregistre un événement (inactif). Retourne son identifiant, ou -1 si la table est pleine.
+int sched_add(Scheduler *s, SchedFunc fn, void *ctx);
+void sched_set(Scheduler *s, int id, u64 deadline);
+void sched_cancel(Scheduler *s, int id);
+
+// Appelle tous les événements échus (à appeler quand now >= s->next)
+void sched_dispatch(Scheduler *s, u64 now);
+
+// Vérification à faire après chaque instruction (une seule comparaison)
+static inline void sched_poll(Scheduler *s, u64 now) {
+    if (now >= s->next) sched_dispatch(s, now);
+}
+
+// Exécute le CPU jusqu'au cycle 'until' en déclenchant les événements à leur échéance
+void sched_run(Scheduler *s, CPU *cpu, u64 until);
+#endif
@@ -0,0 +1,51 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "cpu.h"
+
+// --- Statistiques d'exécution (format texte Prometheus) ---
+// Chaque instance d'émulation a ses compteurs, incrémentés sans
+// synchronisation par le thread qui la fait tourner (via le pointeur de thread
+// stats_current). Ce thread publie régulièrement une copie cohérente
+// (seqlock) que le thread d'export lit et écrit dans un fichier ou sert sur
+// une socket Unix.
+
+typedef struct {
+    u64 instructions;
+    u64 cycles;
+    u64 irqs, nmis;               // Interruptions prises
+    u64 mmio_reads, mmio_writes;  // Accès aux pages de périphériques
+    u64 cache_hits, cache_misses; // Cache de blocs / code traduit
+} StatCounters;
+
+#define STATS_MAX_INSTANCES 64
+
+typedef struct {
+    char name[96];           // Valeur de l'étiquette instance, déjà échappée
+    StatCounters local;      // Écrit par le thread propriétaire uniquement
+    StatCounters published;  // Dernière copie publiée
+    unsigned seq;            // Impair pendant une publication
+    u64 published_ns;        // Temps hôte de la publication
+    double mhz;              // Fréquence émulée depuis la publication précédente
+    u64 start_ns;
+    int used;
+} StatsInstance;
+
+// Compteurs du thread courant (jamais NULL : un bloc muet par défaut)
+extern __thread StatCounters *stats_current;
+
+// Enregistre une instance et la rend courante sur ce thread. NULL si la table est pleine.
+StatsInstance *stats_register(const char *name);
+void stats_unregister(StatsInstance *inst);
+// Copie les compteurs locaux (et cpu->cycles) dans la version publiée
+void stats_publish(StatsInstance *inst, const CPU *cpu);
+
+// Écrit toutes les instances au format Prometheus. Retourne la longueur écrite.
+int stats_render(char *buf, int size);
+
+// Export périodique par un thread dédié. 'target' = chemin d'un fichier
+// (réécrit atomiquement toutes les 'interval' secondes) ou "unix:CHEMIN"
+// (chaque connexion reçoit l'état courant). Retourne 0 si erreur.
+int stats_export_start(const char *target, double interval);
+void stats_export_stop(void);
+#endif
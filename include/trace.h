@@ -0,0 +1,113 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include "cpu.h"
+
+// --- Trace d'exécution binaire ---
+// Une entrée par instruction : l'état avant l'instruction (cycles, PC,
+// registres) et les écritures mémoire qu'elle a faites. Chaque entrée ne
+// code que ce qui change depuis la précédente (quelques octets), et les
+// entrées sont groupées par paquets de TRACE_CHUNK_STEPS compressés en LZ4,
+// chacun décodable seul : il commence par l'état complet de sa première
+// entrée. Un index en fin de fichier (premier numéro d'instruction et
+// premier cycle de chaque paquet) permet d'aller à une instruction ou à un
+// cycle sans lire le reste. La lecture ne garde qu'un paquet en mémoire.
+//
+// Format (petit-boutiste) :
+//   en-tête (32)  "E65T", version, 3 octets nuls, TRACE_CHUNK_STEPS (4),
+//                 position de l'index (8, 0 : trace non terminée),
+//                 nombre d'entrées (8), 4 octets nuls
+//   paquets       "E65K", taille stockée (4), taille décodée (4), entrées (4),
+//                 drapeaux (1 : bit 0 = non compressé), A X Y SP P, PC (2),
+//                 numéro de la première entrée (8), son cycle (8), données
+//   index         "E65I", nombre de paquets (4), puis par paquet : position (8),
+//                 première entrée (8), premier cycle (8), entrées (4), 4 octets nuls
+// Données décodées : une suite d'opérations
+//   pas       0b0RRRRRMM : MM = 1..3 : PC = PC précédent + MM, 0 : PC suit (2) ;
+//             bits R : A, X, Y, SP, P changés, suivis de leur valeur ;
+//             puis écart de cycles avec l'entrée précédente (LEB128)
+//   écriture  0x80 adresse (2) valeur, 0x81 page zéro (1) valeur,
+//             0x82 pile (1) valeur : appartient au dernier pas
+
+#define TRACE_CHUNK_STEPS 16384
+#define TRACE_MAX_WRITES 16 // Écritures gardées par entrée à la lecture
+
+typedef struct {
+    u64 index;   // Numéro de l'instruction (0 : première tracée)
+    u64 cycles;  // Compteur de cycles avant l'instruction
+    u16 PC;
+    u8 A, X, Y, SP, P;
+    int write_count; // Écritures de l'instruction (au plus TRACE_MAX_WRITES gardées)
+    u16 write_address[TRACE_MAX_WRITES];
+    u8 write_value[TRACE_MAX_WRITES];
+} TraceEntry;
+
+typedef struct {
+    u64 offset;       // Position de l'en-tête du paquet
+    u64 first_index;
+    u64 first_cycles;
+    u32 steps;
+} TraceChunkInfo;
+
+// --- Écriture ---
+
+typedef struct {
+    FILE *f;
+    const char *path;
+    u8 *raw;                 // Paquet en cours, avant compression
+    u32 raw_size, raw_cap;
+    u8 *packed;
+    u32 packed_cap;
+    u32 steps;               // Entrées du paquet en cours
+    TraceEntry first, prev;  // Première et dernière entrée du paquet (état seul)
+    TraceChunkInfo *chunks;
+    u32 chunk_count, chunk_cap;
+    u64 total_steps;
+    u64 raw_bytes, file_bytes;
+    int error;
+} TraceWriter;
+
+// Retourne 0 en cas d'erreur (message affiché)
+int trace_create(TraceWriter *w, const char *path);
+// Nouvelle entrée : état du CPU avant l'instruction qui va s'exécuter
+void trace_step(TraceWriter *w, const CPU *cpu);
+// Écriture faite par l'instruction de la dernière entrée
+void trace_write(TraceWriter *w, u16 address, u8 value);
+// Écrit le dernier paquet et l'index, ferme le fichier. Retourne 0 en cas d'erreur.
+int trace_finish(TraceWriter *w);
+
+// --- Lecture ---
+
+typedef struct {
+    FILE *f;
+    TraceChunkInfo *chunks;
+    u32 chunk_count;
+    u64 steps;          // Entrées du fichier
+    int indexed;        // Index lu en fin de fichier (sinon reconstruit)
+
+    u32 chunk;          // Paquet décodé (chunk_count : aucun)
+    u8 *raw, *packed;
+    u32 raw_size, raw_cap, packed_cap;
+    u32 pos;            // Position dans raw
+    TraceEntry cur;     // Dernière entrée décodée (base des écarts)
+    u64 next_index;
+} TraceReader;
+
+// Ouvre une trace et lit son index (ou le reconstruit en parcourant les
+// en-têtes des paquets si l'émulateur a été interrompu). Retourne 0 en cas
+// d'erreur (message affiché).
+int trace_open(TraceReader *r, const char *path);
+void trace_close(TraceReader *r);
+// Place la lecture sur l'entrée 'index' (ou la première entrée de cycle
+// >= cycle). Retourne 0 au-delà de la fin.
+int trace_seek(TraceReader *r, u64 index);
+int trace_seek_cycle(TraceReader *r, u64 cycle);
+// Entrée suivante : 1, 0 en fin de trace, -1 si le fichier est corrompu
+int trace_next(TraceReader *r, TraceEntry *e);
+
+// Une ligne : numéro, cycle, registres (comme --trace) et écritures
+void trace_print(const TraceEntry *e, FILE *out);
+// Vrai si les deux entrées ont le même état et les mêmes écritures
+int trace_equal(const TraceEntry *a, const TraceEntry *b);
+#endif
@@ -6,9 +6,11 @@
 // Définition des types standards pour l'émulation
 typedef uint8_t u8;   // Un octet (0 à 255)
 typedef uint16_t u16; // Deux octets (0 à 65535) - pour les adresses
+typedef uint32_t u32;
 typedef int8_t s8;    // Signé pour certains calculs
 
 // AJOUT : Pour le compteur de cycles (peut devenir très grand)
 typedef uint64_t u64;
+typedef int64_t s64;  // Écarts de temps (peuvent être négatifs)
 
 #endif
\ No newline at end of file
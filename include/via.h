@@ -0,0 +1,61 @@
+#ifndef VIA_H
+#define VIA_H
+
+#include "cpu.h"
+#include "sched.h"
+
+// --- VIA 6522 (Versatile Interface Adapter) ---
+// Ports A/B, timers T1/T2 et registre à décalage. Les timers ne sont pas
+// décrémentés à chaque cycle : leur valeur est calculée à partir du compteur
+// de cycles, et l'ordonnanceur déclenche l'IRQ au cycle exact d'expiration.
+
+// Registres (adresse & 0x0F)
+enum {
+    VIA_ORB, VIA_ORA, VIA_DDRB, VIA_DDRA, VIA_T1CL, VIA_T1CH, VIA_T1LL, VIA_T1LH,
+    VIA_T2CL, VIA_T2CH, VIA_SR, VIA_ACR, VIA_PCR, VIA_IFR, VIA_IER, VIA_ORA_NH
+};
+
+// Bits de IFR / IER
+#define VIA_INT_CA2 (1 << 0)
+#define VIA_INT_CA1 (1 << 1)
+#define VIA_INT_SR  (1 << 2)
+#define VIA_INT_CB2 (1 << 3)
+#define VIA_INT_CB1 (1 << 4)
+#define VIA_INT_T2  (1 << 5)
+#define VIA_INT_T1  (1 << 6)
+
+typedef void (*ViaShiftFunc)(void *ctx, u8 byte);
+
+typedef struct {
+    u8 ora, orb, ddra, ddrb;
+    u8 port_in[2]; // Niveaux présents sur les broches des ports A et B (entrées)
+    u8 acr, pcr, ifr, ier;
+
+    // Timer 1
+    u16 t1_latch;
+    u64 t1_expire;   // Cycle de la prochaine expiration
+    u8 t1_running;
+
+    // Timer 2 (one-shot)
+    u8 t2_latch_lo;
+    u16 t2_start;    // Valeur chargée
+    u64 t2_loaded;   // Cycle du chargement
+    u8 t2_running;
+
+    // Registre à décalage
+    u8 sr;
+    u8 sr_in;              // Octet présenté sur CB2 en mode entrée
+    ViaShiftFunc sr_out;   // Reçoit chaque octet décalé en sortie (optionnel)
+    void *sr_ctx;
+
+    CPU *cpu;
+    Scheduler *sched;
+    u8 irq_source;
+    int ev_t1, ev_t2, ev_sr;
+} Via;
+
+// Initialise le VIA et le mappe sur la page 'page' (registres répétés tous les 16 octets)
+void via_attach(Via *via, Memory *mem, u8 page, CPU *cpu, Scheduler *sched, u8 irq_source);
+u8 via_read(void *ctx, u16 address);
+void via_write(void *ctx, u16 address, u8 value);
+#endif
@@ -0,0 +1,158 @@
+#include "acia.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Débits du registre de contrôle (bits 0-3). 0 = horloge externe x16 : on prend 115200.
+static const unsigned int baud_rates[16] = {
+    115200, 50, 75, 110, 135, 150, 300, 600,
+    1200, 1800, 2400, 3600, 4800, 7200, 9600, 19200
+};
+
+u64 acia_byte_cycles(const Acia *acia) {
+    int data_bits = 8 - ((acia->control >> 5) & 3);
+    int stop_bits = (acia->control & 0x80) ? 2 : 1;
+    int parity = (acia->command & 0x20) ? 1 : 0;
+    u64 bits = 1 + data_bits + parity + stop_bits;
+    u64 cycles = acia->cpu_hz * bits / baud_rates[acia->control & 0x0F];
+    return cycles ? cycles : 1;
+}
+
+// IRQ : réception si les interruptions RX sont autorisées (commande bit 1 = 0),
+// émission si les bits 2-3 de la commande valent 01
+static void acia_update_irq(Acia *acia) {
+    int rx_irq = (acia->status & ACIA_ST_RDRF) && !(acia->command & 0x02);
+    int tx_irq = (acia->status & ACIA_ST_TDRE) && ((acia->command & 0x0C) == 0x04);
+    if (rx_irq || tx_irq) acia->status |= ACIA_ST_IRQ;
+    // Le bit IRQ reste levé jusqu'à la lecture du registre d'état
+    cpu_set_irq(acia->cpu, acia->irq_source, (acia->status & ACIA_ST_IRQ) != 0);
+}
+
+// Le récepteur n'est actif que si DTR est à 1 (commande bit 0)
+static void acia_schedule_rx(Acia *acia, u64 now) {
+    if (acia->rx_fd >= 0 && !acia->rx_eof && (acia->command & 0x01)) {
+        sched_set(acia->sched, acia->ev_rx, now + acia_byte_cycles(acia));
+    } else {
+        sched_cancel(acia->sched, acia->ev_rx);
+    }
+}
+
+static void acia_rx_event(void *ctx, u64 now) {
+    Acia *acia = (Acia *)ctx;
+    // Tant que l'octet précédent n'est pas lu, on laisse les données dans le
+    // descripteur hôte (contrôle de flux implicite, rien n'est perdu)
+    if (!(acia->status & ACIA_ST_RDRF)) {
+        u8 byte;
+        ssize_t n = read(acia->rx_fd, &byte, 1);
+        if (n == 1) {
+            acia->rx_data = byte;
+            acia->status |= ACIA_ST_RDRF;
+            acia->bytes_rx++;
+            acia_update_irq(acia);
+        } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            acia->rx_eof = 1;
+            return;
+        }
+    }
+    acia_schedule_rx(acia, now);
+}
+
+// Charge le registre de décalage et programme la fin de l'émission
+static void acia_tx_start(Acia *acia, u64 now) {
+    acia->tx_shift = acia->tx_data;
+    acia->tx_busy = 1;
+    acia->status |= ACIA_ST_TDRE;
+    sched_set(acia->sched, acia->ev_tx, now + acia_byte_cycles(acia));
+}
+
+static void acia_tx_event(void *ctx, u64 now) {
+    Acia *acia = (Acia *)ctx;
+    if (acia->tx_fd >= 0) {
+        ssize_t n;
+        do {
+            n = write(acia->tx_fd, &acia->tx_shift, 1);
+        } while (n < 0 && errno == EINTR);
+    }
+    acia->bytes_tx++;
+    acia->tx_busy = 0;
+    if (!(acia->status & ACIA_ST_TDRE)) acia_tx_start(acia, now); // Octet en attente
+    acia_update_irq(acia);
+}
+
+u8 acia_read(void *ctx, u16 address) {
+    Acia *acia = (Acia *)ctx;
+    switch (address & 0x03) {
+    case ACIA_DATA:
+        acia->status &= ~(ACIA_ST_RDRF | ACIA_ST_OVERRUN);
+        return acia->rx_data;
+    case ACIA_STATUS: {
+        u8 value = acia->status;
+        acia->status &= ~ACIA_ST_IRQ;
+        acia_update_irq(acia);
+        return value;
+    }
+    case ACIA_COMMAND: return acia->command;
+    default:           return acia->control;
+    }
+}
+
+void acia_write(void *ctx, u16 address, u8 value) {
+    Acia *acia = (Acia *)ctx;
+    u64 now = acia->cpu->cycles;
+    switch (address & 0x03) {
+    case ACIA_DATA:
+        // Registre de données + registre de décalage : un octet peut attendre
+        // pendant l'émission du précédent. Écrire alors que TDRE = 0 l'écrase.
+        acia->tx_data = value;
+        acia->status &= ~ACIA_ST_TDRE;
+        if (!acia->tx_busy) acia_tx_start(acia, now);
+        acia_update_irq(acia);
+        break;
+    case ACIA_STATUS:
+        // Reset logiciel : efface les bits 0-4 de la commande et l'overrun
+        acia->command &= 0xE0;
+        acia->status &= ~ACIA_ST_OVERRUN;
+        acia_schedule_rx(acia, now);
+        acia_update_irq(acia);
+        break;
+    case ACIA_COMMAND:
+        acia->command = value;
+        acia_schedule_rx(acia, now);
+        acia_update_irq(acia);
+        break;
+    default:
+        acia->control = value;
+        acia_schedule_rx(acia, now);
+        break;
+    }
+}
+
+void acia_attach(Acia *acia, Memory *mem, u8 page, CPU *cpu, Scheduler *sched, u8 irq_source,
+                 int rx_fd, int tx_fd, u64 cpu_hz) {
+    memset(acia, 0, sizeof(*acia));
+    acia->cpu = cpu;
+    acia->sched = sched;
+    acia->irq_source = irq_source;
+    acia->rx_fd = rx_fd;
+    acia->tx_fd = tx_fd;
+    acia->cpu_hz = cpu_hz;
+    acia->status = ACIA_ST_TDRE;
+    acia->rx_flags = -1;
+    if (rx_fd >= 0) {
+        int flags = fcntl(rx_fd, F_GETFL);
+        if (flags >= 0 && !(flags & O_NONBLOCK) && fcntl(rx_fd, F_SETFL, flags | O_NONBLOCK) == 0) {
+            acia->rx_flags = flags;
+        }
+    }
+    acia->ev_tx = sched_add(sched, acia_tx_event, acia);
+    acia->ev_rx = sched_add(sched, acia_rx_event, acia);
+    mem_map_io(mem, page, page, acia_read, acia_write, acia);
+}
+
+void acia_detach(Acia *acia) {
+    if (acia->rx_flags >= 0) {
+        fcntl(acia->rx_fd, F_SETFL, acia->rx_flags);
+        acia->rx_flags = -1;
+    }
+}
@@ -10,43 +10,38 @@ static u16 addr_absolute_helper(CPU *cpu) {
     return (hi << 8) | lo;
 }
 // Mode Immediate: La valeur est celle à PC
-void addr_immediate(CPU *cpu) {
-    // L'adresse "effective" est juste PC, mais pour simplifier,
-    // on lit directement la valeur dans 'fetched'
-    cpu->fetched = mem_read(cpu->mem, cpu->PC);
-    cpu->PC++;
+u16 addr_immediate(CPU *cpu) {
+    // L'adresse "effective" est juste PC : l'instruction y lira la donnée
+    return cpu->PC++;
 }
 
 // Mode Zero Page: L'adresse est un octet (0x00 à 0xFF)
-void addr_zero_page(CPU *cpu) {
-    cpu->addr_abs = mem_read(cpu->mem, cpu->PC); // Lit l'adresse
+u16 addr_zero_page(CPU *cpu) {
+    u16 address = mem_read(cpu->mem, cpu->PC); // Lit l'adresse
     cpu->PC++;
-    // On lit la donnée à cette adresse
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
+    return address;
 }
 
 // Mode Absolute: L'adresse est sur 2 octets
-void addr_absolute(CPU *cpu) {
+u16 addr_absolute(CPU *cpu) {
     u16 lo = mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
     u16 hi = mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
     
-    cpu->addr_abs = (hi << 8) | lo;
-    // On lit la donnée à cette adresse
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
+    return (hi << 8) | lo;
 }
 
 // Mode Implied : L'instruction n'a pas d'opérande (ex: NOP, INX)
-void addr_implied(CPU *cpu) {
+u16 addr_implied(CPU *cpu) {
     // Rien à faire, pas d'adresse à calculer.
-    // On met fetched à 0 par sécurité
-    cpu->fetched = 0;
+    (void)cpu;
+    return 0;
 }
 
 // Mode Relative : Utilisé pour les sauts conditionnels (BNE, BEQ...)
 // L'opérande est un nombre signé (s8) qui dit de combien sauter.
-void addr_relative(CPU *cpu) {
+u16 addr_relative(CPU *cpu) {
     // 1. Lire l'offset (signé)
     s8 offset = (s8)mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
@@ -54,57 +49,50 @@ void addr_relative(CPU *cpu) {
     // 2. Calculer l'adresse de destination
     // L'adresse cible = PC actuel + l'offset
     // Note: Le PC pointe déjà sur l'instruction suivante ici
-    cpu->addr_abs = cpu->PC + offset;
-    
-    // On ne touche pas à fetched car les branchements n'ont pas besoin de lire une donnée,
-    // ils modifient juste le PC.
+    // Les branchements ne lisent pas de donnée, ils modifient juste le PC.
+    return cpu->PC + offset;
 }
 
 // Mode Zero Page,X : L'adresse est (base + X) modulo 256 (on reste en page 0)
-void addr_zero_page_x(CPU *cpu) {
+u16 addr_zero_page_x(CPU *cpu) {
     u8 base = mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
     
     // L'addition se fait sur 8 bits, on ignore la retenue au-delà de 255
-    cpu->addr_abs = (base + cpu->X) & 0x00FF; 
-    
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
+    return (base + cpu->X) & 0x00FF;
 }
 
 // Mode Zero Page,Y : Similaire mais avec Y (rare, utilisé pour LDX/STX)
-void addr_zero_page_y(CPU *cpu) {
+u16 addr_zero_page_y(CPU *cpu) {
     u8 base = mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
     
-    cpu->addr_abs = (base + cpu->Y) & 0x00FF;
-    
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
+    return (base + cpu->Y) & 0x00FF;
 }
 
 // Mode Absolute,X : Adresse 16 bits + registre X
-void addr_absolute_x(CPU *cpu) {
+u16 addr_absolute_x(CPU *cpu) {
     u16 base = addr_absolute_helper(cpu); // On va créer cette aide ci-dessous
     
-    cpu->addr_abs = base + cpu->X;
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
+    return base + cpu->X;
 }
 
 // Mode Absolute,Y : Adresse 16 bits + registre Y
-void addr_absolute_y(CPU *cpu) {
+u16 addr_absolute_y(CPU *cpu) {
     u16 base = addr_absolute_helper(cpu);
     
-    cpu->addr_abs = base + cpu->Y;
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
+    return base + cpu->Y;
 }
 
 // Mode Accumulator : L'opération se fait sur le registre A
-void addr_accumulator(CPU *cpu) {
-    // On met fetched à la valeur de A pour que l'instruction puisse travailler dessus
-    cpu->fetched = cpu->A;
+u16 addr_accumulator(CPU *cpu) {
+    // Les instructions "A" travaillent directement sur le registre
+    (void)cpu;
+    return 0;
 }
 
 // Mode Indirect : Utilisé par JMP (0x6C)
-void addr_indirect(CPU *cpu) {
+u16 addr_indirect(CPU *cpu) {
     // 1. Lire l'adresse pointeur (16 bits)
     u16 ptr_lo = mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
@@ -127,38 +115,64 @@ void addr_indirect(CPU *cpu) {
         addr_hi = mem_read(cpu->mem, ptr + 1); // Cas normal
     }
     
-    cpu->addr_abs = (addr_hi << 8) | addr_lo;
+    return (addr_hi << 8) | addr_lo;
 }
 // Mode Zero Page,Y
 // Mode (Indirect, X) : "Indexed Indirect"
 // Ex: LDA ($20, X). On prend l'adresse $20, on ajoute X, on lit l'adresse réelle à cet endroit.
-void addr_indirect_x(CPU *cpu) {
+u16 addr_indirect_x(CPU *cpu) {
     u8 zp_base = mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
     
     // L'adresse du pointeur est (zp_base + X) & 0xFF (on reste dans la Zero Page)
     u16 ptr_addr = (u16)(zp_base + cpu->X) & 0x00FF;
     
-    // On lit l'adresse 16 bits à l'adresse du pointeur
-    u16 lo = mem_read(cpu->mem, ptr_addr);
-    u16 hi = mem_read(cpu->mem, (ptr_addr + 1) & 0x00FF); // Wrap si on dépasse la page
-    
-    cpu->addr_abs = (hi << 8) | lo;
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
+    // On lit l'adresse 16 bits à l'adresse du pointeur (wrap si on dépasse la page)
+    return mem_read_zp_word(cpu->mem, (u8)ptr_addr);
 }
 
 // Mode (Indirect), Y : "Indirect Indexed"
 // Ex: LDA ($20), Y. On lit l'adresse à $20, puis on ajoute Y.
-void addr_indirect_y(CPU *cpu) {
+u16 addr_indirect_y(CPU *cpu) {
     u8 zp_base = mem_read(cpu->mem, cpu->PC);
     cpu->PC++;
     
-    // On lit l'adresse 16 bits stockée dans la Zero Page (sans ajouter Y !)
-    u16 lo = mem_read(cpu->mem, (u16)zp_base);
-    u16 hi = mem_read(cpu->mem, (u16)((zp_base + 1) & 0xFF)); // Wrap
+    // On lit l'adresse 16 bits stockée dans la Zero Page (sans ajouter Y !), avec wrap
+    u16 base = mem_read_zp_word(cpu->mem, zp_base);
     
-    u16 base = (hi << 8) | lo;
-    
-    cpu->addr_abs = base + cpu->Y;
-    cpu->fetched = mem_read(cpu->mem, cpu->addr_abs);
-}
\ No newline at end of file
+    return base + cpu->Y;
+}
+
+// --- Modes propres au 65C02 ---
+
+// Mode Indirect corrigé : l'octet haut est lu à ptr + 1, même sur une frontière de page
+u16 addr_indirect_fixed(CPU *cpu) {
+    u16 ptr = addr_absolute_helper(cpu);
+    u16 lo = mem_read(cpu->mem, ptr);
+    u16 hi = mem_read(cpu->mem, ptr + 1);
+    return (hi << 8) | lo;
+}
+
+// Mode (ZP) : comme (ZP),Y mais sans ajouter Y
+u16 addr_indirect_zp(CPU *cpu) {
+    u8 zp = mem_read(cpu->mem, cpu->PC);
+    cpu->PC++;
+
+    return mem_read_zp_word(cpu->mem, zp); // Wrap en page 0
+}
+
+// Mode ZP + relatif (BBR/BBS) : retourne l'adresse en page 0 et saute aussi
+// l'offset, que l'instruction relit en PC - 1 si elle branche
+u16 addr_zero_page_relative(CPU *cpu) {
+    u16 address = mem_read(cpu->mem, cpu->PC);
+    cpu->PC += 2;
+    return address;
+}
+
+// Mode (ABS,X) : utilisé par JMP ($xxxx,X)
+u16 addr_absolute_indirect_x(CPU *cpu) {
+    u16 ptr = addr_absolute_helper(cpu) + cpu->X;
+    u16 lo = mem_read(cpu->mem, ptr);
+    u16 hi = mem_read(cpu->mem, ptr + 1);
+    return (hi << 8) | lo;
+}
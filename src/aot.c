@@ -0,0 +1,109 @@
+#include "aot.h"
+#include "codemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Écriture dans une page de code traduit : on ne compare que les octets
+// recopiés dans le C, à leur valeur dans l'image
+static void aot_on_write(void *ctx, u16 address) {
+    AotRuntime *rt = (AotRuntime *)ctx;
+    if (!rt->baked[address]) return;
+    int differs = mem_peek(rt->cpu->mem, address) != rt->expected[address];
+    if (differs == (rt->baked[address] == 2)) return;
+
+    u16 block = rt->owner[address];
+    rt->baked[address] = differs ? 2 : 1;
+    if (differs) {
+        if (rt->mismatches[block]++ == 0) {
+            rt->valid[block] = 0;
+            rt->dirty = 1;
+            rt->invalidated++;
+        }
+    } else if (--rt->mismatches[block] == 0) {
+        rt->valid[block] = 1; // Octets restaurés : le bloc redevient natif
+    }
+}
+
+// Changement de banque : les octets recopiés de la page ont pu changer
+static void aot_on_remap(void *ctx, u8 page) {
+    for (int i = 0; i < 256; i++) aot_on_write(ctx, (u16)(page << 8 | i));
+}
+
+AotRuntime *aot_create(CPU *cpu, const AotImage *image) {
+    Memory *mem = cpu->mem;
+    if (cpu->machine != cpu_machine((CpuVariant)image->variant)) {
+        printf("Erreur : %s a ete traduit pour la variante %s\n", image->rom,
+               cpu_machine((CpuVariant)image->variant)->name);
+        return NULL;
+    }
+    if (codemap_hash(mem) != image->image_hash) {
+        printf("Erreur : la memoire ne contient pas l'image traduite (%s)\n", image->rom);
+        return NULL;
+    }
+    AotRuntime *rt = calloc(1, sizeof(AotRuntime));
+    if (rt == NULL) {
+        printf("Erreur : mémoire insuffisante pour le code traduit\n");
+        return NULL;
+    }
+    rt->cpu = cpu;
+    rt->image = image;
+
+    for (int i = 0; i < image->block_count; i++) {
+        const AotBlock *b = &image->blocks[i];
+        rt->funcs[b->address] = b->func;
+        rt->entries[b->address] = b->entry;
+        rt->valid[b->address] = 1;
+    }
+    for (int i = 0; i < image->span_count; i++) {
+        const AotSpan *s = &image->spans[i];
+        for (int k = 0; k < s->length; k++) {
+            u16 a = (u16)(s->address + k);
+            rt->owner[a] = s->block;
+            rt->expected[a] = s->bytes[k];
+            rt->baked[a] = 1;
+            mem_mark_code(mem, a >> 8, 1);
+        }
+    }
+    mem->code_write = aot_on_write;
+    mem->code_remap = aot_on_remap;
+    mem->code_ctx = rt;
+    return rt;
+}
+
+void aot_free(AotRuntime *rt) {
+    if (rt == NULL) return;
+    Memory *mem = rt->cpu->mem;
+    for (int page = 0; page < 256; page++) mem_mark_code(mem, (u8)page, 0);
+    mem->code_write = NULL;
+    mem->code_remap = NULL;
+    mem->code_ctx = NULL;
+    free(rt);
+}
+
+int aot_run(AotRuntime *rt, u64 until) {
+    CPU *cpu = rt->cpu;
+    rt->until = until;
+    while (cpu->cycles < until) {
+        if (cpu->events) {
+            // Une seule scrutation (retard de CLI/SEI/PLP), puis l'interruption
+            // ou une instruction interprétée
+            if (cpu_run(cpu, cpu->cycles + 1) == 0) return 0;
+            rt->interpreted++;
+            continue;
+        }
+        u16 pc = cpu->PC;
+        AotFunc func = rt->funcs[pc];
+        if (func && rt->valid[pc]) {
+            // La fonction enchaîne ses blocs et revient sur un saut hors
+            // d'elle (appel, retour, indirect) ou au premier aot_leave vrai
+            rt->dirty = 0;
+            rt->calls++;
+            func(cpu, rt, rt->entries[pc]);
+        } else {
+            // Hors du code traduit : une instruction interprétée
+            if (cpu_run(cpu, cpu->cycles + 1) == 0) return 0;
+            rt->interpreted++;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,556 @@
+#include "batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_AVX2 1 // Chemin AVX2 compilé, utilisé si le processeur le permet
+#endif
+#endif
+
+static int batch_avx2;
+
+int batch_uses_avx2(void) {
+    return batch_avx2;
+}
+
+// --- Gestion des lanes ---
+
+// Watchpoint posé sur toute la mémoire de chaque lane : note les pages
+// qu'elle a écrites (ce sont les seules dont le contenu peut différer de l'image)
+static void batch_on_write(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)pc; (void)value; (void)kind;
+    BatchLaneHook *hook = ctx;
+    hook->batch->written[address >> 8] |= hook->bit;
+}
+
+void batch_init(BatchCPU *b, Memory *shared, int lanes, u16 pc) {
+    memset(b, 0, sizeof(*b));
+    if (lanes > BATCH_LANES) lanes = BATCH_LANES;
+    b->lanes = lanes;
+    b->shared = shared;
+#if defined(BATCH_AVX2)
+    batch_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    // CPU du chemin scalaire dans l'état de reset NMOS, sans lire le vecteur
+    // de reset dans l'image partagée
+    b->scratch.SP = 0xFD;
+    b->scratch.P = 0x24;
+    b->scratch.machine = cpu_machine(CPU_NMOS);
+    b->scratch.ops = b->scratch.machine->ops;
+    for (int l = 0; l < lanes; l++) {
+        b->A[l] = b->scratch.A;
+        b->X[l] = b->scratch.X;
+        b->Y[l] = b->scratch.Y;
+        b->SP[l] = b->scratch.SP;
+        b->P[l] = b->scratch.P;
+        b->PC[l] = pc;
+        b->active[l] = 0xFF;
+
+        // Les tables de pages sont copiées, pas les 64 Ko de données
+        Memory *mem = malloc(sizeof(Memory));
+        if (mem == NULL) {
+            printf("Erreur : mémoire insuffisante pour la lane %d\n", l);
+            exit(1);
+        }
+        mem_fork(mem, shared);
+        mem->pc = &b->scratch.op_pc;
+        b->hooks[l].batch = b;
+        b->hooks[l].bit = 1u << l;
+        if (mem_add_watch(mem, 0x0000, 0xFFFF, MEM_WATCH_WRITE, batch_on_write, &b->hooks[l]) < 0) {
+            // Plus de watchpoint libre : toutes les pages sont réputées écrites
+            for (int page = 0; page < 256; page++) b->written[page] |= 1u << l;
+        }
+        b->mem[l] = mem;
+    }
+}
+
+void batch_free(BatchCPU *b) {
+    for (int l = 0; l < b->lanes; l++) {
+        free(b->mem[l]);
+        b->mem[l] = NULL;
+    }
+}
+
+void batch_poke(BatchCPU *b, int lane, u16 address, u8 value) {
+    mem_write(b->mem[lane], address, value);
+}
+
+u8 batch_peek(const BatchCPU *b, int lane, u16 address) {
+    return mem_peek(b->mem[lane], address);
+}
+
+// Chemin scalaire : la lane est recopiée dans un CPU classique, interruptions
+// en attente comprises, le temps d'un pas
+static void batch_lane_load(BatchCPU *b, int l) {
+    CPU *c = &b->scratch;
+    c->A = b->A[l]; c->X = b->X[l]; c->Y = b->Y[l];
+    c->SP = b->SP[l]; c->P = b->P[l]; c->PC = b->PC[l];
+    c->cycles = b->cycles[l];
+    c->mem = b->mem[l];
+    c->events = b->events[l];
+    c->irq_lines = b->irq_lines[l];
+    c->nmi_lines = b->nmi_lines[l];
+}
+
+static void batch_lane_store(BatchCPU *b, int l) {
+    const CPU *c = &b->scratch;
+    b->A[l] = c->A; b->X[l] = c->X; b->Y[l] = c->Y;
+    b->SP[l] = c->SP; b->P[l] = c->P; b->PC[l] = c->PC;
+    b->cycles[l] = c->cycles;
+    b->events[l] = c->events;
+    b->irq_lines[l] = c->irq_lines;
+    b->nmi_lines[l] = c->nmi_lines;
+    if (c->events) b->pending |= 1u << l; else b->pending &= ~(1u << l);
+}
+
+static void batch_scalar_step(BatchCPU *b, int l) {
+    CPU *c = &b->scratch;
+    batch_lane_load(b, l);
+    // Un pas (instruction ou entrée d'interruption) ; 0 si l'opcode n'est pas
+    // implémenté : seule cette lane s'arrête, PC sur l'opcode
+    u64 steps = cpu_run(c, c->cycles + 1);
+    batch_lane_store(b, l);
+    if (steps == 0) {
+        b->active[l] = 0;
+        b->halted |= 1u << l;
+        return;
+    }
+    b->instructions[l]++;
+    b->scalar_steps++;
+}
+
+void batch_set_irq(BatchCPU *b, int lane, u8 source, int level) {
+    batch_lane_load(b, lane);
+    cpu_set_irq(&b->scratch, source, level);
+    batch_lane_store(b, lane);
+}
+
+void batch_set_nmi(BatchCPU *b, int lane, u8 source, int level) {
+    batch_lane_load(b, lane);
+    cpu_set_nmi(&b->scratch, source, level);
+    batch_lane_store(b, lane);
+}
+
+static void batch_scalar_group(BatchCPU *b, u32 group) {
+    while (group) {
+        batch_scalar_step(b, __builtin_ctz(group));
+        group &= group - 1;
+    }
+}
+
+#if defined(__SSE2__)
+
+// --- Noyaux vectoriels ---
+// Un registre SSE2 porte le même registre 6502 des 16 lanes. m vaut 0xFF pour
+// les lanes du groupe courant et 0 pour les autres : les résultats sont
+// mélangés avec l'ancien état, sans branchement. val est l'opérande de
+// chaque lane (immédiat, ou octet lu en page zéro / absolue).
+// Les branchements retournent la condition de saut, les autres zéro.
+
+// Mode d'accès à l'opérande, résolu par le pilote avant l'appel au noyau
+enum { BM_IMP, BM_IMM, BM_ZP, BM_ABS, BM_REL, BM_JMP };
+
+typedef __m128i (*BatchKernelFunc)(BatchCPU *b, __m128i m, __m128i val);
+
+typedef struct {
+    BatchKernelFunc fn;
+    u8 mode;
+    u8 cycles;
+} BatchKernel;
+
+#define LOAD(p) _mm_load_si128((const __m128i *)(p))
+#define STORE(p, v) _mm_store_si128((__m128i *)(p), (v))
+#define SPLAT(x) _mm_set1_epi8((char)(x))
+
+static inline __m128i blend8(__m128i m, __m128i v, __m128i old) {
+    return _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, old));
+}
+
+// P avec N et Z calculés à partir de v
+static inline __m128i set_nz(__m128i p, __m128i v) {
+    __m128i z = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()), SPLAT(FLAG_Z));
+    __m128i n = _mm_and_si128(v, SPLAT(FLAG_N));
+    return _mm_or_si128(_mm_andnot_si128(SPLAT(FLAG_Z | FLAG_N), p), _mm_or_si128(z, n));
+}
+
+// Chargements / transferts : reg = expr, puis N et Z
+#define KERNEL_LOAD(name, reg, expr)                                            \
+    static __m128i name(BatchCPU *b, __m128i m, __m128i val) {                  \
+        __m128i a = LOAD(b->A), x = LOAD(b->X), y = LOAD(b->Y), s = LOAD(b->SP); \
+        (void)a; (void)x; (void)y; (void)s; (void)val;                          \
+        __m128i r = (expr), p = LOAD(b->P);                                     \
+        STORE(b->reg, blend8(m, r, LOAD(b->reg)));                              \
+        STORE(b->P, blend8(m, set_nz(p, r), p));                                \
+        return _mm_setzero_si128();                                             \
+    }
+
+KERNEL_LOAD(k_LDA, A, val)
+KERNEL_LOAD(k_LDX, X, val)
+KERNEL_LOAD(k_LDY, Y, val)
+KERNEL_LOAD(k_AND, A, _mm_and_si128(a, val))
+KERNEL_LOAD(k_ORA, A, _mm_or_si128(a, val))
+KERNEL_LOAD(k_EOR, A, _mm_xor_si128(a, val))
+KERNEL_LOAD(k_TAX, X, a)
+KERNEL_LOAD(k_TAY, Y, a)
+KERNEL_LOAD(k_TXA, A, x)
+KERNEL_LOAD(k_TYA, A, y)
+KERNEL_LOAD(k_TSX, X, s)
+KERNEL_LOAD(k_INX, X, _mm_add_epi8(x, SPLAT(1)))
+KERNEL_LOAD(k_INY, Y, _mm_add_epi8(y, SPLAT(1)))
+KERNEL_LOAD(k_DEX, X, _mm_sub_epi8(x, SPLAT(1)))
+KERNEL_LOAD(k_DEY, Y, _mm_sub_epi8(y, SPLAT(1)))
+
+static __m128i k_TXS(BatchCPU *b, __m128i m, __m128i val) {
+    (void)val;
+    STORE(b->SP, blend8(m, LOAD(b->X), LOAD(b->SP)));
+    return _mm_setzero_si128();
+}
+
+static __m128i k_NOP(BatchCPU *b, __m128i m, __m128i val) {
+    (void)b; (void)m; (void)val;
+    return _mm_setzero_si128();
+}
+
+// Drapeaux : P = (P & ~flag) | set
+#define KERNEL_FLAG(name, flag, set)                                            \
+    static __m128i name(BatchCPU *b, __m128i m, __m128i val) {                  \
+        (void)val;                                                              \
+        __m128i p = LOAD(b->P);                                                 \
+        __m128i np = _mm_or_si128(_mm_andnot_si128(SPLAT(flag), p), SPLAT(set)); \
+        STORE(b->P, blend8(m, np, p));                                          \
+        return _mm_setzero_si128();                                             \
+    }
+
+KERNEL_FLAG(k_CLC, FLAG_C, 0)
+KERNEL_FLAG(k_SEC, FLAG_C, FLAG_C)
+KERNEL_FLAG(k_CLD, FLAG_D, 0)
+KERNEL_FLAG(k_SED, FLAG_D, FLAG_D)
+KERNEL_FLAG(k_CLV, FLAG_V, 0)
+
+// Comparaisons : C = reg >= val (max non signé), Z = reg == val, N = bit 7 de (reg - val)
+#define KERNEL_CMP(name, reg)                                                   \
+    static __m128i name(BatchCPU *b, __m128i m, __m128i val) {                  \
+        __m128i r = LOAD(b->reg), p = LOAD(b->P);                               \
+        __m128i c = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(r, val), r), SPLAT(FLAG_C)); \
+        __m128i z = _mm_and_si128(_mm_cmpeq_epi8(r, val), SPLAT(FLAG_Z));       \
+        __m128i n = _mm_and_si128(_mm_sub_epi8(r, val), SPLAT(FLAG_N));         \
+        __m128i np = _mm_or_si128(_mm_andnot_si128(SPLAT(FLAG_C | FLAG_Z | FLAG_N), p), \
+                                  _mm_or_si128(c, _mm_or_si128(z, n)));         \
+        STORE(b->P, blend8(m, np, p));                                          \
+        return _mm_setzero_si128();                                             \
+    }
+
+KERNEL_CMP(k_CMP, A)
+KERNEL_CMP(k_CPX, X)
+KERNEL_CMP(k_CPY, Y)
+
+// Décalages et rotations de l'accumulateur. SSE2 n'a pas de décalage sur
+// 8 bits : a << 1 = a + a, a >> 1 = décalage 16 bits masqué. c vaut 0 ou 1.
+#define KERNEL_SHIFT(name, carry_out, result)                                   \
+    static __m128i name(BatchCPU *b, __m128i m, __m128i val) {                  \
+        (void)val;                                                              \
+        __m128i a = LOAD(b->A), p = LOAD(b->P);                                 \
+        __m128i c = _mm_and_si128(p, SPLAT(FLAG_C));                            \
+        (void)c;                                                                \
+        __m128i r = (result);                                                   \
+        __m128i np = _mm_or_si128(_mm_andnot_si128(SPLAT(FLAG_C), p), (carry_out)); \
+        STORE(b->A, blend8(m, r, a));                                           \
+        STORE(b->P, blend8(m, set_nz(np, r), p));                               \
+        return _mm_setzero_si128();                                             \
+    }
+
+#define BIT7(a) _mm_and_si128(_mm_srli_epi16(a, 7), SPLAT(1))
+#define BIT0(a) _mm_and_si128(a, SPLAT(1))
+#define SHR1(a) _mm_and_si128(_mm_srli_epi16(a, 1), SPLAT(0x7F))
+
+KERNEL_SHIFT(k_ASL_ACC, BIT7(a), _mm_add_epi8(a, a))
+KERNEL_SHIFT(k_LSR_ACC, BIT0(a), SHR1(a))
+KERNEL_SHIFT(k_ROL_ACC, BIT7(a), _mm_or_si128(_mm_add_epi8(a, a), c))
+KERNEL_SHIFT(k_ROR_ACC, BIT0(a), _mm_or_si128(SHR1(a), _mm_slli_epi16(c, 7)))
+
+// Branchements : condition de chaque lane (les lanes peuvent diverger)
+#define KERNEL_BRANCH(name, flag, want)                                         \
+    static __m128i name(BatchCPU *b, __m128i m, __m128i val) {                  \
+        (void)m; (void)val;                                                     \
+        __m128i f = _mm_and_si128(LOAD(b->P), SPLAT(flag));                     \
+        return _mm_cmpeq_epi8(f, SPLAT((want) ? (flag) : 0));                   \
+    }
+
+KERNEL_BRANCH(k_BPL, FLAG_N, 0)
+KERNEL_BRANCH(k_BMI, FLAG_N, 1)
+KERNEL_BRANCH(k_BVC, FLAG_V, 0)
+KERNEL_BRANCH(k_BVS, FLAG_V, 1)
+KERNEL_BRANCH(k_BCC, FLAG_C, 0)
+KERNEL_BRANCH(k_BCS, FLAG_C, 1)
+KERNEL_BRANCH(k_BNE, FLAG_Z, 0)
+KERNEL_BRANCH(k_BEQ, FLAG_Z, 1)
+
+// Table des noyaux (les opcodes absents passent par le cœur scalaire, dont
+// CLI et SEI qui retardent la prise en compte de I)
+static const BatchKernel kernels[256] = {
+    [0xA9] = { k_LDA, BM_IMM, 2 }, [0xA5] = { k_LDA, BM_ZP, 3 }, [0xAD] = { k_LDA, BM_ABS, 4 },
+    [0xA2] = { k_LDX, BM_IMM, 2 }, [0xA6] = { k_LDX, BM_ZP, 3 }, [0xAE] = { k_LDX, BM_ABS, 4 },
+    [0xA0] = { k_LDY, BM_IMM, 2 }, [0xA4] = { k_LDY, BM_ZP, 3 }, [0xAC] = { k_LDY, BM_ABS, 4 },
+    [0x29] = { k_AND, BM_IMM, 2 }, [0x25] = { k_AND, BM_ZP, 3 }, [0x2D] = { k_AND, BM_ABS, 4 },
+    [0x09] = { k_ORA, BM_IMM, 2 }, [0x05] = { k_ORA, BM_ZP, 3 }, [0x0D] = { k_ORA, BM_ABS, 4 },
+    [0x49] = { k_EOR, BM_IMM, 2 }, [0x45] = { k_EOR, BM_ZP, 3 }, [0x4D] = { k_EOR, BM_ABS, 4 },
+    [0xC9] = { k_CMP, BM_IMM, 2 }, [0xC5] = { k_CMP, BM_ZP, 3 }, [0xCD] = { k_CMP, BM_ABS, 4 },
+    [0xE0] = { k_CPX, BM_IMM, 2 }, [0xE4] = { k_CPX, BM_ZP, 3 }, [0xEC] = { k_CPX, BM_ABS, 4 },
+    [0xC0] = { k_CPY, BM_IMM, 2 }, [0xC4] = { k_CPY, BM_ZP, 3 }, [0xCC] = { k_CPY, BM_ABS, 4 },
+    [0xAA] = { k_TAX, BM_IMP, 2 }, [0xA8] = { k_TAY, BM_IMP, 2 },
+    [0x8A] = { k_TXA, BM_IMP, 2 }, [0x98] = { k_TYA, BM_IMP, 2 },
+    [0xBA] = { k_TSX, BM_IMP, 2 }, [0x9A] = { k_TXS, BM_IMP, 2 },
+    [0xE8] = { k_INX, BM_IMP, 2 }, [0xC8] = { k_INY, BM_IMP, 2 },
+    [0xCA] = { k_DEX, BM_IMP, 2 }, [0x88] = { k_DEY, BM_IMP, 2 },
+    [0x18] = { k_CLC, BM_IMP, 2 }, [0x38] = { k_SEC, BM_IMP, 2 },
+    [0xD8] = { k_CLD, BM_IMP, 2 }, [0xF8] = { k_SED, BM_IMP, 2 },
+    [0xB8] = { k_CLV, BM_IMP, 2 }, [0xEA] = { k_NOP, BM_IMP, 2 },
+    [0x0A] = { k_ASL_ACC, BM_IMP, 2 }, [0x4A] = { k_LSR_ACC, BM_IMP, 2 },
+    [0x2A] = { k_ROL_ACC, BM_IMP, 2 }, [0x6A] = { k_ROR_ACC, BM_IMP, 2 },
+    [0x10] = { k_BPL, BM_REL, 2 }, [0x30] = { k_BMI, BM_REL, 2 },
+    [0x50] = { k_BVC, BM_REL, 2 }, [0x70] = { k_BVS, BM_REL, 2 },
+    [0x90] = { k_BCC, BM_REL, 2 }, [0xB0] = { k_BCS, BM_REL, 2 },
+    [0xD0] = { k_BNE, BM_REL, 2 }, [0xF0] = { k_BEQ, BM_REL, 2 },
+    [0x4C] = { k_NOP, BM_JMP, 3 },
+};
+
+// --- Groupe courant et avancement des lanes ---
+// Le groupe = lanes actives au plus petit PC. Les lanes en avance attendent :
+// après un saut en avant, les autres les rattrapent et le groupe se reforme
+// (reconvergence). Retourne le masque des lanes du groupe (0 : plus aucune).
+
+static inline u32 batch_group_sse2(const BatchCPU *b, u16 *pc, __m128i *m) {
+    __m128i act = LOAD(b->active);
+    __m128i p0 = LOAD(b->PC), p1 = LOAD(b->PC + 8);
+    // Lanes inactives vues à 0xFFFF ; biais de 0x8000 pour un min non signé avec pminsw
+    __m128i bias = _mm_set1_epi16((short)0x8000), ones = _mm_set1_epi8(-1);
+    __m128i s0 = _mm_xor_si128(_mm_or_si128(p0, _mm_xor_si128(_mm_unpacklo_epi8(act, act), ones)), bias);
+    __m128i s1 = _mm_xor_si128(_mm_or_si128(p1, _mm_xor_si128(_mm_unpackhi_epi8(act, act), ones)), bias);
+    __m128i mn = _mm_min_epi16(s0, s1);
+    mn = _mm_min_epi16(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+    mn = _mm_min_epi16(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+    mn = _mm_min_epi16(mn, _mm_shufflelo_epi16(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+    *pc = (u16)(_mm_cvtsi128_si32(mn) ^ 0x8000);
+    __m128i v = _mm_set1_epi16((short)*pc);
+    *m = _mm_and_si128(_mm_packs_epi16(_mm_cmpeq_epi16(p0, v), _mm_cmpeq_epi16(p1, v)), act);
+    return (u32)_mm_movemask_epi8(*m);
+}
+
+// Lanes du groupe : PC = taken ? target : next, cycles += n (+ extra si taken)
+static inline void batch_count4_sse2(u64 *cycles, u64 *instructions, __m128i m32, __m128i t32,
+                                     __m128i n, __m128i extra) {
+    __m128i m0 = _mm_unpacklo_epi32(m32, m32), m1 = _mm_unpackhi_epi32(m32, m32);
+    __m128i t0 = _mm_unpacklo_epi32(t32, t32), t1 = _mm_unpackhi_epi32(t32, t32);
+    __m128i one = _mm_set_epi32(0, 1, 0, 1);
+    STORE(cycles, _mm_add_epi64(LOAD(cycles), _mm_add_epi64(_mm_and_si128(m0, n), _mm_and_si128(t0, extra))));
+    STORE(cycles + 2, _mm_add_epi64(LOAD(cycles + 2), _mm_add_epi64(_mm_and_si128(m1, n), _mm_and_si128(t1, extra))));
+    STORE(instructions, _mm_add_epi64(LOAD(instructions), _mm_and_si128(m0, one)));
+    STORE(instructions + 2, _mm_add_epi64(LOAD(instructions + 2), _mm_and_si128(m1, one)));
+}
+
+static inline void batch_advance_sse2(BatchCPU *b, __m128i m, __m128i taken, u16 next, u16 target,
+                                      u8 cycles, u8 extra) {
+    __m128i m0 = _mm_unpacklo_epi8(m, m), m1 = _mm_unpackhi_epi8(m, m);
+    __m128i t0 = _mm_unpacklo_epi8(taken, taken), t1 = _mm_unpackhi_epi8(taken, taken);
+    __m128i vn = _mm_set1_epi16((short)next), vt = _mm_set1_epi16((short)target);
+    STORE(b->PC, blend8(m0, blend8(t0, vt, vn), LOAD(b->PC)));
+    STORE(b->PC + 8, blend8(m1, blend8(t1, vt, vn), LOAD(b->PC + 8)));
+
+    __m128i n = _mm_set_epi32(0, cycles, 0, cycles), e = _mm_set_epi32(0, extra, 0, extra);
+    batch_count4_sse2(b->cycles, b->instructions, _mm_unpacklo_epi16(m0, m0), _mm_unpacklo_epi16(t0, t0), n, e);
+    batch_count4_sse2(b->cycles + 4, b->instructions + 4, _mm_unpackhi_epi16(m0, m0), _mm_unpackhi_epi16(t0, t0), n, e);
+    batch_count4_sse2(b->cycles + 8, b->instructions + 8, _mm_unpacklo_epi16(m1, m1), _mm_unpacklo_epi16(t1, t1), n, e);
+    batch_count4_sse2(b->cycles + 12, b->instructions + 12, _mm_unpackhi_epi16(m1, m1), _mm_unpackhi_epi16(t1, t1), n, e);
+}
+
+#if defined(BATCH_AVX2)
+// Mêmes opérations en AVX2 : les 16 PC tiennent dans un registre, les
+// compteurs 64 bits en quatre, et phminposuw donne directement le minimum.
+__attribute__((target("avx2")))
+static inline u32 batch_group_avx2(const BatchCPU *b, u16 *pc, __m128i *m) {
+    __m128i act = LOAD(b->active);
+    __m256i p = _mm256_load_si256((const __m256i *)b->PC);
+    __m256i s = _mm256_or_si256(p, _mm256_xor_si256(_mm256_cvtepi8_epi16(act), _mm256_set1_epi8(-1)));
+    __m128i mn = _mm_minpos_epu16(_mm_min_epu16(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+    *pc = (u16)_mm_cvtsi128_si32(mn);
+    __m256i eq = _mm256_cmpeq_epi16(p, _mm256_set1_epi16((short)*pc));
+    *m = _mm_and_si128(_mm_packs_epi16(_mm256_castsi256_si128(eq), _mm256_extracti128_si256(eq, 1)), act);
+    return (u32)_mm_movemask_epi8(*m);
+}
+
+#define COUNT4_AVX2(i)                                                                    \
+    do {                                                                                  \
+        __m256i mm = _mm256_cvtepi8_epi64(_mm_srli_si128(m, 4 * (i)));                    \
+        __m256i tt = _mm256_cvtepi8_epi64(_mm_srli_si128(taken, 4 * (i)));                \
+        __m256i *c = (__m256i *)(b->cycles + 4 * (i)), *k = (__m256i *)(b->instructions + 4 * (i)); \
+        _mm256_store_si256(c, _mm256_add_epi64(_mm256_load_si256(c),                      \
+            _mm256_add_epi64(_mm256_and_si256(mm, n), _mm256_and_si256(tt, e))));         \
+        _mm256_store_si256(k, _mm256_add_epi64(_mm256_load_si256(k), _mm256_and_si256(mm, one))); \
+    } while (0)
+
+__attribute__((target("avx2")))
+static inline void batch_advance_avx2(BatchCPU *b, __m128i m, __m128i taken, u16 next, u16 target,
+                                      u8 cycles, u8 extra) {
+    __m256i m16 = _mm256_cvtepi8_epi16(m), t16 = _mm256_cvtepi8_epi16(taken);
+    __m256i npc = _mm256_blendv_epi8(_mm256_set1_epi16((short)next), _mm256_set1_epi16((short)target), t16);
+    __m256i *pc = (__m256i *)b->PC;
+    _mm256_store_si256(pc, _mm256_blendv_epi8(_mm256_load_si256(pc), npc, m16));
+
+    __m256i n = _mm256_set1_epi64x(cycles), e = _mm256_set1_epi64x(extra), one = _mm256_set1_epi64x(1);
+    COUNT4_AVX2(0);
+    COUNT4_AVX2(1);
+    COUNT4_AVX2(2);
+    COUNT4_AVX2(3);
+}
+#endif
+
+// Octet 'address' vu par chaque lane du groupe. Les lanes qui n'ont pas écrit
+// la page le lisent dans l'image partagée (une seule lecture pour toutes).
+// Retourne 0 si la lecture doit passer par mem_read (périphérique, watchpoint).
+static inline int batch_load(const BatchCPU *b, u16 address, u32 group, __m128i *val) {
+    const Memory *img = b->shared;
+    if (img->page_flags[address >> 8] & MEM_SLOW_READ) return 0;
+    u8 base = mem_peek(img, address);
+    u32 own = b->written[address >> 8] & group;
+    if (!own) {
+        *val = SPLAT(base);
+        return 1;
+    }
+    _Alignas(16) u8 v[BATCH_LANES];
+    memset(v, base, sizeof(v));
+    for (; own; own &= own - 1) {
+        int l = __builtin_ctz(own);
+        v[l] = mem_peek(b->mem[l], address);
+    }
+    *val = LOAD(v);
+    return 1;
+}
+
+// Le code de [pc, pc + len) est-il le même pour tout le groupe, lu sans effet de bord ?
+static inline int batch_code_shared(const BatchCPU *b, u16 pc, u8 len, u32 group) {
+    u8 first = pc >> 8, last = (u16)(pc + len - 1) >> 8;
+    return !((b->shared->page_flags[first] | b->shared->page_flags[last]) & MEM_SLOW_READ)
+        && !((b->written[first] | b->written[last]) & group);
+}
+
+static inline __attribute__((always_inline)) int batch_step_simd(BatchCPU *b, int avx2) {
+    u16 pc;
+    __m128i m;
+    u32 group;
+#if defined(BATCH_AVX2)
+    if (avx2) group = batch_group_avx2(b, &pc, &m);
+    else
+#endif
+    group = batch_group_sse2(b, &pc, &m);
+    if (!group) return 0;
+
+    // Groupe d'une lane, interruption en attente, code propre à certaines
+    // lanes (auto-modifié), code lu sur un périphérique ou opcode sans noyau :
+    // chemin scalaire
+    if ((group & (group - 1)) == 0 || (group & b->pending) || !batch_code_shared(b, pc, 1, group)) {
+        batch_scalar_group(b, group);
+        return 1;
+    }
+    const Memory *img = b->shared;
+    const BatchKernel *k = &kernels[mem_peek(img, pc)];
+    u8 len = (k->mode == BM_IMP) ? 1 : (k->mode == BM_ABS || k->mode == BM_JMP) ? 3 : 2;
+    if (k->fn == NULL || !batch_code_shared(b, pc, len, group)) {
+        batch_scalar_group(b, group);
+        return 1;
+    }
+
+    // Opérande : identique pour tout le groupe, sauf l'octet lu en mémoire
+    u8 lo = mem_peek(img, pc + 1), hi = mem_peek(img, pc + 2);
+    __m128i val = _mm_setzero_si128();
+    u16 target = 0;
+    switch (k->mode) {
+    case BM_IMM:
+        val = SPLAT(lo);
+        break;
+    case BM_ZP:
+    case BM_ABS:
+        if (!batch_load(b, k->mode == BM_ZP ? lo : (u16)(lo | (hi << 8)), group, &val)) {
+            batch_scalar_group(b, group);
+            return 1;
+        }
+        break;
+    case BM_REL:
+        target = (u16)(pc + 2 + (s8)lo);
+        break;
+    case BM_JMP:
+        target = (u16)(lo | (hi << 8));
+        break;
+    }
+
+    __m128i cond = k->fn(b, m, val);
+    __m128i taken = (k->mode == BM_JMP) ? m : _mm_and_si128(cond, m);
+    u8 extra = (k->mode == BM_REL) ? 1 : 0; // Branchement pris : un cycle de plus
+#if defined(BATCH_AVX2)
+    if (avx2) batch_advance_avx2(b, m, taken, (u16)(pc + len), target, k->cycles, extra);
+    else
+#endif
+    batch_advance_sse2(b, m, taken, (u16)(pc + len), target, k->cycles, extra);
+    b->vector_steps++;
+    return 1;
+}
+
+#if defined(BATCH_AVX2)
+__attribute__((target("avx2")))
+static int batch_step_avx2(BatchCPU *b) {
+    return batch_step_simd(b, 1);
+}
+#endif
+
+int batch_step(BatchCPU *b) {
+#if defined(BATCH_AVX2)
+    if (batch_avx2) return batch_step_avx2(b);
+#endif
+    return batch_step_simd(b, 0);
+}
+
+#else
+
+// Sans SSE2 : chaque lane du groupe passe par le cœur scalaire
+int batch_step(BatchCPU *b) {
+    u32 group = 0;
+    u16 pc = 0;
+    for (int l = 0; l < b->lanes; l++) {
+        if (!b->active[l]) continue;
+        if (!group || b->PC[l] < pc) {
+            pc = b->PC[l];
+            group = 0;
+        }
+        if (b->PC[l] == pc) group |= 1u << l;
+    }
+    if (!group) return 0;
+    batch_scalar_group(b, group);
+    return 1;
+}
+
+#endif
+
+void batch_run(BatchCPU *b, u64 max_instructions) {
+    for (;;) {
+        // Une lane avance d'au plus une instruction par pas : aucune ne peut
+        // dépasser la limite pendant (limite - la plus avancée) pas
+        u64 ahead = 0;
+        int running = 0;
+        for (int l = 0; l < b->lanes; l++) {
+            if (!b->active[l]) continue;
+            if (b->instructions[l] >= max_instructions) {
+                b->active[l] = 0;
+            } else {
+                running = 1;
+                if (b->instructions[l] > ahead) ahead = b->instructions[l];
+            }
+        }
+        if (!running) break;
+        for (u64 n = max_instructions - ahead; n > 0; n--) {
+            if (!batch_step(b)) return;
+        }
+    }
+}
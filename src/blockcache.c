@@ -0,0 +1,442 @@
+#include "blockcache.h"
+#include "disasm.h"
+#include "instructions.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Instructions qui modifient PC : elles terminent un bloc
+static int ends_block(const DecodedInsn *insn) {
+    switch (insn->bytes[0]) {
+    case 0x4C: case 0x6C: case 0x7C: // JMP
+    case 0x20: case 0x60:            // JSR, RTS
+    case 0x40: case 0x00:            // RTI, BRK
+    case 0xCB: case 0xDB:            // WAI, STP (65C02) : attente hors du bloc
+        return 1;
+    default:
+        return insn->mode == DIS_RELATIVE || insn->mode == DIS_ZERO_PAGE_RELATIVE;
+    }
+}
+
+static void block_on_write(void *ctx, u16 address);
+static void block_on_remap(void *ctx, u8 page);
+
+BlockCache *block_create(CPU *cpu) {
+    BlockCache *bc = calloc(1, sizeof(BlockCache));
+    if (bc == NULL) {
+        printf("Erreur : mémoire insuffisante pour le cache de blocs\n");
+        return NULL;
+    }
+    bc->cpu = cpu;
+    bc->fuse = 1;
+    cpu->mem->code_write = block_on_write;
+    cpu->mem->code_remap = block_on_remap;
+    cpu->mem->code_ctx = bc;
+    return bc;
+}
+
+static void free_retired(BlockCache *bc) {
+    while (bc->retired) {
+        Block *b = bc->retired;
+        bc->retired = b->next_retired;
+        free(b);
+    }
+}
+
+void block_free(BlockCache *bc) {
+    if (bc == NULL) return;
+    Memory *mem = bc->cpu->mem;
+    for (int a = 0; a < MAX_MEMORY; a++) free(bc->blocks[a]);
+    free_retired(bc);
+    for (int page = 0; page < 256; page++) mem_mark_code(mem, (u8)page, 0);
+    mem->code_write = NULL;
+    mem->code_remap = NULL;
+    mem->code_ctx = NULL;
+    free(bc);
+}
+
+// Compte (delta = 1) ou décompte (-1) les octets recopiés dans le bloc
+static void block_cover(BlockCache *bc, const Block *b, int delta) {
+    for (int i = 0; i < b->count; i++) {
+        const PredecodedOp *op = &b->ops[i];
+        bc->covered[op->pc] += delta;
+        if (op->fixed) {
+            for (u16 a = op->pc + 1; a != op->next_pc; a++) bc->covered[a] += delta;
+        }
+    }
+}
+
+// --- Superinstructions ---
+// Suites choisies d'après le profil des paires exécutées : sur le test
+// fonctionnel de Klaus Dormann, CMP zp ; BNE fait à elle seule 16 % des
+// paires ; les boucles de copie et de comptage (run_builtin_test, programme
+// de --batch-bench) tournent sur INX ; CPX #imm ; BNE, DEX ; BNE et LDA ; STA.
+// Toutes commencent par une instruction qui n'écrit pas en mémoire : rien
+// ne peut invalider le bloc ni lever d'interruption au milieu, sauf une
+// lecture dans une page lente, après laquelle le handler s'arrête.
+
+// Branchement final de la suite (comme ins_BNE...)
+static inline int fused_branch(CPU *cpu, const PredecodedOp *br, int taken) {
+    cpu->op_pc = br->pc;
+    mem_exec(cpu->mem, br->pc);
+    cpu->PC = taken ? br->addr : br->next_pc;
+    cpu->cycles += br->cycles + (taken ? 1 : 0);
+    return 2;
+}
+
+// N et Z d'un résultat, autres drapeaux inchangés
+static inline u8 flags_nz(u8 p, u8 result) {
+    return (u8)((p & ~(FLAG_N | FLAG_Z)) | (result & FLAG_N) | (result ? 0 : FLAG_Z));
+}
+
+// Comparaison (immédiat ou adresse fixe) puis branchement sur son résultat
+#define FUSED_CMP_BRANCH(name, reg, cond)                                       \
+static int name(CPU *cpu, const PredecodedOp *op) {                             \
+    Memory *mem = cpu->mem;                                                     \
+    cpu->op_pc = op->pc;                                                        \
+    mem_exec(mem, op->pc);                                                      \
+    int slow = mem->page_flags[op->addr >> 8] & MEM_SLOW_READ;                  \
+    u8 value = mem_read(mem, op->addr);                                         \
+    u8 r = (u8)(cpu->reg - value);                                              \
+    int carry = cpu->reg >= value;                                              \
+    cpu->P = (u8)((flags_nz(cpu->P, r) & ~FLAG_C) | (carry ? FLAG_C : 0));      \
+    cpu->cycles += op->cycles;                                                  \
+    if (slow) {                                                                 \
+        cpu->PC = op->next_pc;                                                  \
+        return 1;                                                               \
+    }                                                                           \
+    return fused_branch(cpu, op + 1, cond);                                     \
+}
+FUSED_CMP_BRANCH(fused_cmp_bne, A, r != 0)
+FUSED_CMP_BRANCH(fused_cmp_beq, A, r == 0)
+FUSED_CMP_BRANCH(fused_cmp_bcc, A, !carry)
+FUSED_CMP_BRANCH(fused_cmp_bcs, A, carry)
+FUSED_CMP_BRANCH(fused_cpx_bne, X, r != 0)
+FUSED_CMP_BRANCH(fused_cpx_beq, X, r == 0)
+FUSED_CMP_BRANCH(fused_cpx_bcc, X, !carry)
+FUSED_CMP_BRANCH(fused_cpx_bcs, X, carry)
+FUSED_CMP_BRANCH(fused_cpy_bne, Y, r != 0)
+FUSED_CMP_BRANCH(fused_cpy_beq, Y, r == 0)
+FUSED_CMP_BRANCH(fused_cpy_bcc, Y, !carry)
+FUSED_CMP_BRANCH(fused_cpy_bcs, Y, carry)
+
+// INX/INY/DEX/DEY puis branchement sur N ou Z du registre
+#define FUSED_STEP_BRANCH(name, reg, delta, cond)                               \
+static int name(CPU *cpu, const PredecodedOp *op) {                             \
+    cpu->op_pc = op->pc;                                                        \
+    mem_exec(cpu->mem, op->pc);                                                 \
+    u8 r = (u8)(cpu->reg + (delta));                                            \
+    cpu->reg = r;                                                               \
+    cpu->P = flags_nz(cpu->P, r);                                               \
+    cpu->cycles += op->cycles;                                                  \
+    return fused_branch(cpu, op + 1, cond);                                     \
+}
+FUSED_STEP_BRANCH(fused_inx_bne, X, 1, r != 0)
+FUSED_STEP_BRANCH(fused_inx_beq, X, 1, r == 0)
+FUSED_STEP_BRANCH(fused_inx_bpl, X, 1, !(r & 0x80))
+FUSED_STEP_BRANCH(fused_inx_bmi, X, 1, r & 0x80)
+FUSED_STEP_BRANCH(fused_iny_bne, Y, 1, r != 0)
+FUSED_STEP_BRANCH(fused_iny_beq, Y, 1, r == 0)
+FUSED_STEP_BRANCH(fused_iny_bpl, Y, 1, !(r & 0x80))
+FUSED_STEP_BRANCH(fused_iny_bmi, Y, 1, r & 0x80)
+FUSED_STEP_BRANCH(fused_dex_bne, X, -1, r != 0)
+FUSED_STEP_BRANCH(fused_dex_beq, X, -1, r == 0)
+FUSED_STEP_BRANCH(fused_dex_bpl, X, -1, !(r & 0x80))
+FUSED_STEP_BRANCH(fused_dex_bmi, X, -1, r & 0x80)
+FUSED_STEP_BRANCH(fused_dey_bne, Y, -1, r != 0)
+FUSED_STEP_BRANCH(fused_dey_beq, Y, -1, r == 0)
+FUSED_STEP_BRANCH(fused_dey_bpl, Y, -1, !(r & 0x80))
+FUSED_STEP_BRANCH(fused_dey_bmi, Y, -1, r & 0x80)
+
+// INX/INY/DEX/DEY puis comparaison-branchement du même registre (déjà
+// fusionnée) : la comparaison écrase N et Z, l'incrément ne les calcule pas
+#define FUSED_STEP_THEN(name, reg, delta)                                       \
+static int name(CPU *cpu, const PredecodedOp *op) {                             \
+    cpu->op_pc = op->pc;                                                        \
+    mem_exec(cpu->mem, op->pc);                                                 \
+    cpu->reg = (u8)(cpu->reg + (delta));                                        \
+    cpu->cycles += op->cycles;                                                  \
+    return 1 + op[1].fused(cpu, op + 1);                                        \
+}
+FUSED_STEP_THEN(fused_inx_then, X, 1)
+FUSED_STEP_THEN(fused_iny_then, Y, 1)
+FUSED_STEP_THEN(fused_dex_then, X, -1)
+FUSED_STEP_THEN(fused_dey_then, Y, -1)
+
+// LDA (immédiat ou adresse fixe) ; STA adresse fixe
+static int fused_lda_sta(CPU *cpu, const PredecodedOp *op) {
+    Memory *mem = cpu->mem;
+    cpu->op_pc = op->pc;
+    mem_exec(mem, op->pc);
+    int slow = mem->page_flags[op->addr >> 8] & MEM_SLOW_READ;
+    u8 value = mem_read(mem, op->addr);
+    cpu->A = value;
+    cpu->P = flags_nz(cpu->P, value);
+    cpu->cycles += op->cycles;
+    const PredecodedOp *st = op + 1;
+    if (slow) {
+        cpu->PC = op->next_pc;
+        return 1;
+    }
+    cpu->op_pc = st->pc;
+    mem_exec(mem, st->pc);
+    cpu->PC = st->next_pc;
+    mem_write(mem, st->addr, value);
+    cpu->cycles += st->cycles;
+    return 2;
+}
+
+// CLC ; ADC (tous modes) : l'ADC de la variante, retenue déjà nulle
+static int fused_clc_adc(CPU *cpu, const PredecodedOp *op) {
+    cpu->op_pc = op->pc;
+    mem_exec(cpu->mem, op->pc);
+    cpu->P &= ~FLAG_C;
+    cpu->cycles += op->cycles;
+    const PredecodedOp *adc = op + 1;
+    cpu->op_pc = adc->pc;
+    mem_exec(cpu->mem, adc->pc);
+    if (adc->addrmode) {
+        cpu->PC = adc->pc + 1;
+        adc->instruction(cpu, adc->addrmode(cpu));
+    } else {
+        cpu->PC = adc->next_pc;
+        adc->instruction(cpu, adc->addr);
+    }
+    cpu->cycles += adc->cycles;
+    return 2;
+}
+
+// Indices dans les tables ci-dessous (-1 : l'instruction n'y figure pas)
+static int compare_index(InstructionFunc f) {
+    return f == ins_CMP ? 0 : f == ins_CPX ? 1 : f == ins_CPY ? 2 : -1;
+}
+
+static int step_index(InstructionFunc f) {
+    return f == ins_INX ? 0 : f == ins_INY ? 1 : f == ins_DEX ? 2 : f == ins_DEY ? 3 : -1;
+}
+
+// BNE, BEQ, puis le branchement sur le drapeau à 0 et celui sur le drapeau à 1
+static int branch_index(InstructionFunc f, InstructionFunc if_clear, InstructionFunc if_set) {
+    return f == ins_BNE ? 0 : f == ins_BEQ ? 1 : f == if_clear ? 2 : f == if_set ? 3 : -1;
+}
+
+static const FusedFunc compare_branch[3][4] = {
+    { fused_cmp_bne, fused_cmp_beq, fused_cmp_bcc, fused_cmp_bcs },
+    { fused_cpx_bne, fused_cpx_beq, fused_cpx_bcc, fused_cpx_bcs },
+    { fused_cpy_bne, fused_cpy_beq, fused_cpy_bcc, fused_cpy_bcs },
+};
+static const FusedFunc step_branch[4][4] = {
+    { fused_inx_bne, fused_inx_beq, fused_inx_bpl, fused_inx_bmi },
+    { fused_iny_bne, fused_iny_beq, fused_iny_bpl, fused_iny_bmi },
+    { fused_dex_bne, fused_dex_beq, fused_dex_bpl, fused_dex_bmi },
+    { fused_dey_bne, fused_dey_beq, fused_dey_bpl, fused_dey_bmi },
+};
+static const FusedFunc step_then[4] = { fused_inx_then, fused_iny_then, fused_dex_then, fused_dey_then };
+
+// Handler fusionné de la suite qui commence en ops[i] (les suivantes sont
+// déjà traitées : une suite de trois réutilise celle de deux qui la termine,
+// i + 1 < nombre d'instructions).
+// *length reçoit le nombre d'instructions couvertes.
+static FusedFunc fuse_at(const PredecodedOp *ops, int i, int *length) {
+    const PredecodedOp *a = &ops[i], *b = &ops[i + 1];
+    *length = 2;
+    int c = compare_index(a->instruction);
+    if (c >= 0 && a->addrmode == NULL) {
+        int br = branch_index(b->instruction, ins_BCC, ins_BCS);
+        return br >= 0 ? compare_branch[c][br] : NULL;
+    }
+    int s = step_index(a->instruction);
+    if (s >= 0) {
+        int br = branch_index(b->instruction, ins_BPL, ins_BMI);
+        if (br >= 0) return step_branch[s][br];
+        // Même registre : INX/DEX avec CPX, INY/DEY avec CPY
+        if (b->fused && compare_index(b->instruction) == 1 + (s & 1)) {
+            *length = 3;
+            return step_then[s];
+        }
+        return NULL;
+    }
+    if (a->instruction == ins_LDA && a->addrmode == NULL && b->instruction == ins_STA && b->addrmode == NULL) {
+        return fused_lda_sta;
+    }
+    if (a->instruction == ins_CLC
+        && (b->instruction == ins_ADC || b->instruction == ins_ADC_BIN || b->instruction == ins_ADC_CMOS)) {
+        return fused_clc_adc;
+    }
+    return NULL;
+}
+
+// Repère les superinstructions du bloc, de la fin vers le début
+static void block_fuse(BlockCache *bc, PredecodedOp *ops, int count) {
+    for (int i = count - 2; i >= 0; i--) {
+        int length = 0;
+        FusedFunc f = fuse_at(ops, i, &length);
+        if (f == NULL) continue;
+        ops[i].fused = f;
+        ops[i].fused_cycles = 0;
+        for (int k = 0; k < length - 1; k++) ops[i].fused_cycles += ops[i + k].cycles;
+        bc->fused++;
+    }
+}
+
+// Décode le bloc qui commence à 'start'. Retourne NULL si la première
+// instruction ne peut pas être prédécodée.
+static Block *block_build(BlockCache *bc, u16 start) {
+    CPU *cpu = bc->cpu;
+    Memory *mem = cpu->mem;
+    PredecodedOp ops[BLOCK_MAX_INSNS];
+    int count = 0;
+    unsigned int pc = start;
+
+    while (count < BLOCK_MAX_INSNS) {
+        DecodedInsn insn;
+        disasm_decode(cpu->ops, mem, (u16)pc, &insn);
+        unsigned int last = pc + insn.length - 1;
+        if (insn.entry == NULL || last > 0xFFFF
+            || ((mem->page_flags[pc >> 8] | mem->page_flags[last >> 8]) & MEM_SLOW_READ)) {
+            break;
+        }
+
+        PredecodedOp *op = &ops[count++];
+        op->instruction = insn.entry->instruction;
+        op->addrmode = NULL;
+        op->pc = (u16)pc;
+        op->next_pc = (u16)(pc + insn.length);
+        op->cycles = insn.entry->cycles;
+        op->fused = NULL;
+        op->fused_cycles = 0;
+        // Les modes sans index ni indirection ont une adresse fixe. Les
+        // opérandes immédiats et ceux des autres modes sont relus à
+        // l'exécution : les modifier n'invalide pas le bloc.
+        op->fixed = 0;
+        switch (insn.mode) {
+        case DIS_IMPLIED: case DIS_ACCUMULATOR: op->addr = 0; break;
+        case DIS_IMMEDIATE: op->addr = (u16)(pc + 1); break;
+        case DIS_ZERO_PAGE: case DIS_ABSOLUTE: case DIS_RELATIVE: op->addr = insn.target; op->fixed = 1; break;
+        case DIS_ZERO_PAGE_RELATIVE: op->addr = insn.operand; op->fixed = 1; break;
+        default: op->addrmode = insn.entry->addrmode; op->addr = 0; break;
+        }
+
+        pc = last + 1;
+        if (ends_block(&insn)) break;
+    }
+    if (count == 0) return NULL;
+    if (bc->fuse) block_fuse(bc, ops, count);
+
+    Block *b = malloc(sizeof(Block) + count * sizeof(PredecodedOp));
+    if (b == NULL) return NULL;
+    b->start = start;
+    b->end = (u16)(pc - 1);
+    b->count = count;
+    b->next_retired = NULL;
+    memcpy(b->ops, ops, count * sizeof(PredecodedOp));
+
+    bc->blocks[start] = b;
+    block_cover(bc, b, 1);
+    mem_mark_code(mem, b->start >> 8, 1);
+    mem_mark_code(mem, b->end >> 8, 1);
+    bc->built++;
+    return b;
+}
+
+// Retire le bloc (il peut être en cours d'exécution : libéré plus tard)
+static void block_retire(BlockCache *bc, u16 start) {
+    Block *b = bc->blocks[start];
+    bc->blocks[start] = NULL;
+    block_cover(bc, b, -1);
+    b->next_retired = bc->retired;
+    bc->retired = b;
+    bc->dirty = 1;
+    bc->invalidated++;
+}
+
+// Écriture dans une page de code : seuls les blocs qui couvrent l'octet sont
+// invalidés (une page peut mêler code et données). La page reste signalée.
+static void block_on_write(void *ctx, u16 address) {
+    BlockCache *bc = (BlockCache *)ctx;
+    for (int d = 0; d < BLOCK_MAX_BYTES && bc->covered[address]; d++) {
+        u16 start = (u16)(address - d);
+        Block *b = bc->blocks[start];
+        if (b && b->start <= address && address <= b->end) block_retire(bc, start);
+    }
+}
+
+// Changement de banque : tous les blocs qui touchent la page sont invalidés,
+// ceux des autres pages restent
+static void block_on_remap(void *ctx, u8 page) {
+    BlockCache *bc = (BlockCache *)ctx;
+    int first = page << 8, last = first + 255;
+    for (int a = first - BLOCK_MAX_BYTES; a <= last; a++) {
+        u16 start = (u16)a;
+        Block *b = bc->blocks[start];
+        if (b == NULL) continue;
+        // Un bloc qui reboucle de $FFFF à $0000 est toujours retiré
+        if (b->start > b->end || (b->end >= first && b->start <= last)) block_retire(bc, start);
+    }
+}
+
+int block_preload(BlockCache *bc, const CodeMap *cm) {
+    int built = 0;
+    for (int i = 0; i < cm->block_count; i++) {
+        // Un bloc de base plus long que BLOCK_MAX_INSNS donne plusieurs blocs
+        unsigned int a = cm->blocks[i].start;
+        while (a <= cm->blocks[i].end) {
+            Block *b = bc->blocks[a];
+            if (b == NULL) {
+                b = block_build(bc, (u16)a);
+                if (b == NULL) break;
+                built++;
+            }
+            a = b->end + 1u;
+        }
+    }
+    bc->preloaded += built;
+    return built;
+}
+
+int block_exec(BlockCache *bc, u64 until) {
+    CPU *cpu = bc->cpu;
+    if (cpu->events && cpu_service_events(cpu)) return 1;
+
+    Block *b = bc->blocks[cpu->PC];
+    if (b) {
+        stats_current->cache_hits++;
+    } else {
+        stats_current->cache_misses++;
+        b = block_build(bc, cpu->PC);
+        if (b == NULL) { // Page de périphérique, opcode non implémenté...
+            cpu_step_instruction(cpu);
+            return 1;
+        }
+    }
+
+    Memory *mem = cpu->mem;
+    const PredecodedOp *op = b->ops, *end = b->ops + b->count;
+    int n = 0;
+    bc->dirty = 0;
+    for (;;) {
+        // Superinstruction, si l'échéance ne tombe pas avant sa dernière instruction
+        if (op->fused && cpu->cycles + op->fused_cycles < until) {
+            int k = op->fused(cpu, op);
+            n += k;
+            op += k;
+        } else {
+            cpu->op_pc = op->pc;
+            mem_exec(mem, op->pc);
+            if (op->addrmode) {
+                cpu->PC = op->pc + 1;
+                op->instruction(cpu, op->addrmode(cpu));
+            } else {
+                cpu->PC = op->next_pc;
+                op->instruction(cpu, op->addr);
+            }
+            cpu->cycles += op->cycles;
+            n++;
+            op++;
+        }
+        // Comme le cœur de référence : interruptions et échéances entre deux instructions
+        if (op == end || cpu->events || bc->dirty || cpu->cycles >= until) break;
+    }
+    if (bc->retired) free_retired(bc);
+    return n;
+}
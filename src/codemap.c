@@ -0,0 +1,390 @@
+#include "codemap.h"
+#include "disasm.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Les longueurs et les modes viennent du désassembleur (mêmes tables que le
+// cœur) : l'analyse ne garde qu'une classification du flot de contrôle.
+
+// Classe d'une instruction décodée
+static BlockKind classify(const DecodedInsn *insn) {
+    if (insn->entry == NULL) return BLOCK_STOP;
+    switch (insn->bytes[0]) {
+    case 0x4C: return BLOCK_JUMP;     // JMP abs
+    case 0x80: return BLOCK_JUMP;     // BRA (65C02, absent des autres tables)
+    case 0x6C: case 0x7C: return BLOCK_INDIRECT;
+    case 0x20: return BLOCK_CALL;
+    case 0x60: case 0x40: return BLOCK_RETURN;
+    case 0x00: return BLOCK_STOP;     // BRK (voir stop_return)
+    case 0xCB: case 0xDB: return BLOCK_STOP; // WAI, STP (65C02)
+    default: break;
+    }
+    return insn->mode == DIS_RELATIVE || insn->mode == DIS_ZERO_PAGE_RELATIVE ? BLOCK_BRANCH : BLOCK_FALL;
+}
+
+void codemap_init(CodeMap *cm) {
+    memset(cm, 0, sizeof(*cm));
+}
+
+void codemap_free(CodeMap *cm) {
+    free(cm->blocks);
+    cm->blocks = NULL;
+    cm->block_count = 0;
+    cm->block_capacity = 0;
+}
+
+u64 codemap_hash(const Memory *mem) {
+    u64 h = 0xcbf29ce484222325ULL; // FNV-1a 64 bits
+    for (int i = 0; i < MAX_MEMORY; i++) {
+        h = (h ^ mem_peek(mem, (u16)i)) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int add_block(CodeMap *cm, const CodeBlock *b) {
+    if (cm->block_count == cm->block_capacity) {
+        int capacity = cm->block_capacity ? cm->block_capacity * 2 : 256;
+        CodeBlock *blocks = realloc(cm->blocks, capacity * sizeof(CodeBlock));
+        if (blocks == NULL) return 0;
+        cm->blocks = blocks;
+        cm->block_capacity = capacity;
+    }
+    cm->blocks[cm->block_count++] = *b;
+    return 1;
+}
+
+// JMP ($xxxx) : on suit la valeur du pointeur dans l'image analysée. C'est
+// une supposition (le pointeur peut être en RAM et changer) : un bloc faux ou
+// manquant est simplement décodé à nouveau à l'exécution.
+static int indirect_target(const CodeMap *cm, const Memory *mem, const DecodedInsn *insn, u16 *target) {
+    if (insn->bytes[0] != 0x6C) return 0; // JMP (ABS,X) dépend de X
+    u16 ptr = insn->operand;
+    u16 hi = ((ptr & 0xFF) == 0xFF && cm->variant != CPU_65C02) ? (ptr & 0xFF00) : (u16)(ptr + 1);
+    *target = mem_peek(mem, ptr) | (mem_peek(mem, hi) << 8);
+    return 1;
+}
+
+// BRK revient (RTI) deux octets plus loin. On suit ce retour, sauf sur de la
+// mémoire à zéro (BRK suivi de BRK) qui n'est pas du code. WAI reprend à
+// l'instruction suivante après l'interruption ; STP ne revient pas.
+static int stop_return(const Memory *mem, const DecodedInsn *insn, u16 *target) {
+    if (insn->bytes[0] == 0xCB && insn->address < 0xFFFF) {
+        *target = (u16)(insn->address + 1);
+        return 1;
+    }
+    if (insn->bytes[0] != 0x00 || insn->address >= 0xFFFE) return 0;
+    *target = (u16)(insn->address + 2);
+    return mem_peek(mem, *target) != 0x00;
+}
+
+// Pile des adresses à explorer (une adresse n'est empilée qu'une fois)
+typedef struct {
+    u16 items[MAX_MEMORY];
+    int count;
+} Worklist;
+
+static void push_target(CodeMap *cm, Worklist *work, u16 address) {
+    if (cm->map[address] & CODE_TARGET) return;
+    cm->map[address] |= CODE_TARGET | CODE_LEADER;
+    work->items[work->count++] = address;
+}
+
+// Décodage linéaire depuis une cible jusqu'à une rupture de séquence
+static void trace_from(CodeMap *cm, Worklist *work, Memory *mem, const OpcodeEntry *ops, u16 start) {
+    unsigned int pc = start;
+    while (pc <= 0xFFFF) {
+        if (cm->map[pc] & CODE_OPCODE) {
+            cm->map[pc] |= CODE_LEADER; // On rejoint du code déjà exploré
+            return;
+        }
+        if (cm->map[pc] & CODE_OPERAND) {
+            cm->conflicts++;
+            return;
+        }
+
+        DecodedInsn insn;
+        disasm_decode(ops, mem, (u16)pc, &insn);
+        if (insn.entry == NULL || pc + insn.length > MAX_MEMORY) return;
+        for (int i = 1; i < insn.length; i++) {
+            if (cm->map[pc + i] & (CODE_OPCODE | CODE_OPERAND)) {
+                cm->conflicts++;
+                return;
+            }
+        }
+        cm->map[pc] |= CODE_OPCODE;
+        for (int i = 1; i < insn.length; i++) cm->map[pc + i] |= CODE_OPERAND;
+
+        unsigned int next = pc + insn.length;
+        switch (classify(&insn)) {
+        case BLOCK_BRANCH:
+        case BLOCK_CALL:
+            push_target(cm, work, insn.target);
+            if (next <= 0xFFFF) cm->map[next] |= CODE_LEADER;
+            break;
+        case BLOCK_JUMP:
+            push_target(cm, work, insn.target);
+            return;
+        case BLOCK_INDIRECT: {
+            u16 target;
+            if (indirect_target(cm, mem, &insn, &target)) push_target(cm, work, target);
+            return;
+        }
+        case BLOCK_STOP: {
+            u16 target;
+            if (stop_return(mem, &insn, &target)) push_target(cm, work, target);
+            return;
+        }
+        case BLOCK_FALL:
+            break;
+        default:
+            return;
+        }
+        pc = next;
+    }
+}
+
+// Découpe le code exploré en blocs de base
+static int build_blocks(CodeMap *cm, Memory *mem, const OpcodeEntry *ops) {
+    unsigned int a = 0;
+    while (a <= 0xFFFF) {
+        if (!(cm->map[a] & CODE_OPCODE)) {
+            a++;
+            continue;
+        }
+        cm->map[a] |= CODE_LEADER;
+        CodeBlock b = { (u16)a, (u16)a, 0, BLOCK_STOP, 0, { 0, 0 } };
+        unsigned int pc = a;
+        for (;;) {
+            DecodedInsn insn;
+            disasm_decode(ops, mem, (u16)pc, &insn);
+            unsigned int next = pc + insn.length;
+            b.insns++;
+            b.end = (u16)(next - 1);
+
+            BlockKind kind = classify(&insn);
+            if (kind != BLOCK_FALL) {
+                b.kind = kind;
+                if (kind == BLOCK_BRANCH || kind == BLOCK_CALL || kind == BLOCK_JUMP) {
+                    b.succ[b.succ_count++] = insn.target;
+                }
+                if ((kind == BLOCK_BRANCH || kind == BLOCK_CALL) && next <= 0xFFFF) {
+                    b.succ[b.succ_count++] = (u16)next;
+                }
+                if ((kind == BLOCK_INDIRECT && indirect_target(cm, mem, &insn, &b.succ[0]))
+                    || (kind == BLOCK_STOP && stop_return(mem, &insn, &b.succ[0]))) {
+                    b.succ_count = 1;
+                }
+                break;
+            }
+            if (next > 0xFFFF || !(cm->map[next] & CODE_OPCODE)) break; // BLOCK_STOP
+            if (cm->map[next] & CODE_LEADER) {
+                b.kind = BLOCK_FALL;
+                b.succ[b.succ_count++] = (u16)next;
+                break;
+            }
+            pc = next;
+        }
+        if (!add_block(cm, &b)) return 0;
+        a = b.end + 1u;
+    }
+    return 1;
+}
+
+// Vecteurs (NMI, RESET, IRQ/BRK) puis points d'entrée supplémentaires, sans
+// doublon. Retourne leur nombre.
+static int collect_entries(const Memory *mem, const u16 *extra, int extra_count, u16 *entries) {
+    static const u16 vectors[] = { 0xFFFA, 0xFFFC, 0xFFFE };
+    int count = 0;
+    for (int i = 0; i < 3 + extra_count && count < CODEMAP_MAX_ENTRIES; i++) {
+        u16 entry = i < 3 ? (u16)(mem_peek(mem, vectors[i]) | (mem_peek(mem, vectors[i] + 1) << 8)) : extra[i - 3];
+        int known = 0;
+        for (int j = 0; j < count; j++) known |= entries[j] == entry;
+        if (!known) entries[count++] = entry;
+    }
+    return count;
+}
+
+int codemap_analyze(CodeMap *cm, const Memory *mem, CpuVariant variant, const u16 *extra, int extra_count) {
+    codemap_free(cm);
+    codemap_init(cm);
+    cm->variant = (u8)variant;
+    cm->image_hash = codemap_hash(mem);
+
+    // disasm_decode ne lit que mem->data
+    Memory *image = (Memory *)mem;
+    const OpcodeEntry *ops = cpu_machine(variant)->ops;
+
+    Worklist *work = malloc(sizeof(Worklist));
+    if (work == NULL) {
+        printf("Erreur : mémoire insuffisante pour l'analyse statique\n");
+        return -1;
+    }
+    work->count = 0;
+
+    cm->entry_count = collect_entries(mem, extra, extra_count, cm->entries);
+    for (int i = 0; i < cm->entry_count; i++) push_target(cm, work, cm->entries[i]);
+
+    while (work->count > 0) {
+        trace_from(cm, work, image, ops, work->items[--work->count]);
+    }
+    free(work);
+
+    if (!build_blocks(cm, image, ops)) {
+        printf("Erreur : mémoire insuffisante pour l'analyse statique\n");
+        return -1;
+    }
+    return cm->block_count;
+}
+
+const CodeBlock *codemap_block_at(const CodeMap *cm, u16 address) {
+    int lo = 0, hi = cm->block_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (cm->blocks[mid].start == address) return &cm->blocks[mid];
+        if (cm->blocks[mid].start < address) lo = mid + 1; else hi = mid - 1;
+    }
+    return NULL;
+}
+
+// --- Cache sur disque ---
+// Format (petit-boutiste) : "E65C", version, variante, nombre d'entrées (2),
+// nombre de blocs (4), hash de l'image (8), conflits (4), entrées (2 chacune),
+// blocs (12 octets : début, fin, instructions, type, successeurs), carte (64 Ko).
+
+#define CACHE_MAGIC "E65C"
+#define CACHE_FORMAT 1
+#define CACHE_HEADER 24
+#define CACHE_BLOCK 12
+
+static void put16(u8 *p, u16 v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+static u16 get16(const u8 *p) { return p[0] | (p[1] << 8); }
+
+void codemap_cache_path(const char *rom, char *buf, size_t size) {
+    snprintf(buf, size, "%s.cfg", rom);
+}
+
+int codemap_save(const CodeMap *cm, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        printf("Erreur : Impossible d'écrire le fichier %s\n", path);
+        return 0;
+    }
+    u8 header[CACHE_HEADER];
+    memcpy(header, CACHE_MAGIC, 4);
+    header[4] = CACHE_FORMAT;
+    header[5] = cm->variant;
+    put16(header + 6, (u16)cm->entry_count);
+    for (int i = 0; i < 4; i++) header[8 + i] = (u8)((unsigned)cm->block_count >> (8 * i));
+    for (int i = 0; i < 8; i++) header[12 + i] = (u8)(cm->image_hash >> (8 * i));
+    for (int i = 0; i < 4; i++) header[20 + i] = (u8)((unsigned)cm->conflicts >> (8 * i));
+    int ok = fwrite(header, 1, CACHE_HEADER, f) == CACHE_HEADER;
+
+    for (int i = 0; ok && i < cm->entry_count; i++) {
+        u8 e[2];
+        put16(e, cm->entries[i]);
+        ok = fwrite(e, 1, 2, f) == 2;
+    }
+    for (int i = 0; ok && i < cm->block_count; i++) {
+        const CodeBlock *b = &cm->blocks[i];
+        u8 rec[CACHE_BLOCK];
+        put16(rec, b->start);
+        put16(rec + 2, b->end);
+        put16(rec + 4, b->insns);
+        rec[6] = b->kind;
+        rec[7] = b->succ_count;
+        put16(rec + 8, b->succ[0]);
+        put16(rec + 10, b->succ[1]);
+        ok = fwrite(rec, 1, CACHE_BLOCK, f) == CACHE_BLOCK;
+    }
+    if (ok) ok = fwrite(cm->map, 1, MAX_MEMORY, f) == MAX_MEMORY;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) printf("Erreur : écriture incomplète de %s\n", path);
+    return ok;
+}
+
+int codemap_load(CodeMap *cm, const char *path, const Memory *mem, CpuVariant variant,
+                 const u16 *extra, int extra_count) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return 0;
+
+    u8 header[CACHE_HEADER];
+    if (fread(header, 1, CACHE_HEADER, f) != CACHE_HEADER || memcmp(header, CACHE_MAGIC, 4) != 0
+        || header[4] != CACHE_FORMAT) {
+        fclose(f);
+        return -1;
+    }
+    u64 hash = 0;
+    for (int i = 0; i < 8; i++) hash |= (u64)header[12 + i] << (8 * i);
+    if (header[5] != (u8)variant || hash != codemap_hash(mem)) {
+        fclose(f);
+        return 0; // Périmé : la ROM ou la variante a changé
+    }
+
+    codemap_free(cm);
+    codemap_init(cm);
+    cm->variant = header[5];
+    cm->image_hash = hash;
+    cm->entry_count = get16(header + 6);
+    unsigned int count = 0, conflicts = 0;
+    for (int i = 0; i < 4; i++) count |= (unsigned int)header[8 + i] << (8 * i);
+    for (int i = 0; i < 4; i++) conflicts |= (unsigned int)header[20 + i] << (8 * i);
+    cm->conflicts = (int)conflicts;
+    if (cm->entry_count > CODEMAP_MAX_ENTRIES || count > MAX_MEMORY) {
+        fclose(f);
+        return -1;
+    }
+
+    // Les points d'entrée font partie de la clé : une carte calculée depuis
+    // d'autres entrées ne couvre pas le même code
+    u16 expected[CODEMAP_MAX_ENTRIES];
+    int stale = collect_entries(mem, extra, extra_count, expected) != cm->entry_count;
+    int ok = 1;
+    for (int i = 0; ok && i < cm->entry_count; i++) {
+        u8 e[2];
+        ok = fread(e, 1, 2, f) == 2;
+        cm->entries[i] = get16(e);
+        if (!stale && cm->entries[i] != expected[i]) stale = 1;
+    }
+    if (ok && stale) {
+        fclose(f);
+        codemap_free(cm);
+        return 0;
+    }
+    for (unsigned int i = 0; ok && i < count; i++) {
+        u8 rec[CACHE_BLOCK];
+        ok = fread(rec, 1, CACHE_BLOCK, f) == CACHE_BLOCK;
+        CodeBlock b = { get16(rec), get16(rec + 2), get16(rec + 4), rec[6], rec[7],
+                        { get16(rec + 8), get16(rec + 10) } };
+        if (ok) ok = b.succ_count <= 2 && add_block(cm, &b);
+    }
+    if (ok) ok = fread(cm->map, 1, MAX_MEMORY, f) == MAX_MEMORY;
+    fclose(f);
+    if (!ok) {
+        codemap_free(cm);
+        return -1;
+    }
+    return 1;
+}
+
+// --- Graphe ---
+
+void codemap_write_dot(const CodeMap *cm, FILE *out) {
+    static const char *kinds[] = { "", "branchement", "saut", "appel", "retour", "indirect", "arret" };
+    fprintf(out, "digraph cfg {\n");
+    fprintf(out, "  node [shape=box, fontname=\"monospace\"];\n");
+    for (int i = 0; i < cm->entry_count; i++) {
+        fprintf(out, "  b%04X [style=bold];\n", cm->entries[i]);
+    }
+    for (int i = 0; i < cm->block_count; i++) {
+        const CodeBlock *b = &cm->blocks[i];
+        fprintf(out, "  b%04X [label=\"$%04X-$%04X\\n%u instr. %s\"];\n",
+                b->start, b->start, b->end, b->insns, kinds[b->kind]);
+        for (int s = 0; s < b->succ_count; s++) {
+            const char *label = "";
+            if (b->kind == BLOCK_BRANCH) label = s == 0 ? "pris" : "suivant";
+            if (b->kind == BLOCK_CALL) label = s == 0 ? "appel" : "retour";
+            fprintf(out, "  b%04X -> b%04X [label=\"%s\"];\n", b->start, b->succ[s], label);
+        }
+    }
+    fprintf(out, "}\n");
+}
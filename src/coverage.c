@@ -0,0 +1,386 @@
+#include "coverage.h"
+#include "disasm.h"
+#include "instructions.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#define COV_VERSION 1
+#define COV_HEADER_SIZE 8
+#define COV_FILE_SIZE (COV_HEADER_SIZE + 3 * COV_BITMAP_SIZE)
+
+void cov_init(Coverage *c, CpuVariant variant) {
+    memset(c, 0, sizeof(*c));
+    c->variant = variant;
+    // Par handler : les opcodes illégaux ou propres à une variante suivent
+    const OpcodeEntry *ops = cpu_machine(variant)->ops;
+    for (int op = 0; op < 256; op++) {
+        InstructionFunc f = ops[op].instruction;
+        c->branch[op] = f == ins_BEQ || f == ins_BNE || f == ins_BPL || f == ins_BMI
+                     || f == ins_BCS || f == ins_BCC || f == ins_BVS || f == ins_BVC;
+    }
+}
+
+int cov_merge(Coverage *c, const Coverage *other) {
+    if (c->variant != other->variant) return 0;
+    for (int i = 0; i < COV_BITMAP_SIZE; i++) {
+        c->executed[i] |= other->executed[i];
+        c->taken[i] |= other->taken[i];
+        c->not_taken[i] |= other->not_taken[i];
+    }
+    return 1;
+}
+
+// --- Fichier ---
+
+static void encode(const Coverage *c, u8 *buf) {
+    memcpy(buf, "E65V", 4);
+    buf[4] = COV_VERSION;
+    buf[5] = (u8)c->variant;
+    buf[6] = buf[7] = 0;
+    memcpy(buf + COV_HEADER_SIZE, c->executed, COV_BITMAP_SIZE);
+    memcpy(buf + COV_HEADER_SIZE + COV_BITMAP_SIZE, c->taken, COV_BITMAP_SIZE);
+    memcpy(buf + COV_HEADER_SIZE + 2 * COV_BITMAP_SIZE, c->not_taken, COV_BITMAP_SIZE);
+}
+
+static int decode(Coverage *c, const u8 *buf, size_t size, const char *path) {
+    if (size != COV_FILE_SIZE || memcmp(buf, "E65V", 4) != 0 || buf[4] != COV_VERSION
+        || buf[5] >= CPU_VARIANT_COUNT) {
+        printf("Erreur : %s n'est pas un fichier de couverture\n", path);
+        return 0;
+    }
+    cov_init(c, (CpuVariant)buf[5]);
+    memcpy(c->executed, buf + COV_HEADER_SIZE, COV_BITMAP_SIZE);
+    memcpy(c->taken, buf + COV_HEADER_SIZE + COV_BITMAP_SIZE, COV_BITMAP_SIZE);
+    memcpy(c->not_taken, buf + COV_HEADER_SIZE + 2 * COV_BITMAP_SIZE, COV_BITMAP_SIZE);
+    return 1;
+}
+
+// Lit au plus 'size' octets (moins en fin de fichier)
+static size_t read_full(int fd, u8 *buf, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buf + done, size - done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    return done;
+}
+
+int cov_load(Coverage *c, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", path);
+        return 0;
+    }
+    static u8 buf[COV_FILE_SIZE + 1];
+    size_t size = read_full(fd, buf, sizeof(buf));
+    close(fd);
+    return decode(c, buf, size, path);
+}
+
+int cov_save(const Coverage *c, const char *path) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", path);
+        return 0;
+    }
+    // Lecture, fusion et réécriture sous le même verrou : un autre run qui
+    // sauve en même temps attend, puis fusionne par-dessus
+    if (flock(fd, LOCK_EX) < 0) {
+        printf("Erreur : verrou impossible sur %s\n", path);
+        close(fd);
+        return 0;
+    }
+    static u8 buf[COV_FILE_SIZE + 1];
+    static Coverage merged;
+    size_t size = read_full(fd, buf, sizeof(buf));
+    if (size == 0) {
+        merged = *c;
+    } else if (!decode(&merged, buf, size, path)) {
+        close(fd);
+        return 0;
+    } else if (!cov_merge(&merged, c)) {
+        printf("Erreur : %s a ete produit pour le CPU %s\n", path, cpu_machine(merged.variant)->name);
+        close(fd);
+        return 0;
+    }
+    encode(&merged, buf);
+    int ok = pwrite(fd, buf, COV_FILE_SIZE, 0) == COV_FILE_SIZE;
+    if (!ok) printf("Erreur : ecriture de %s impossible\n", path);
+    close(fd); // Libère le verrou
+    return ok;
+}
+
+void cov_summary(const Coverage *c, CovSummary *s) {
+    memset(s, 0, sizeof(*s));
+    for (int i = 0; i < COV_BITMAP_SIZE; i++) {
+        s->instructions += (u32)__builtin_popcount(c->executed[i]);
+        s->branches += (u32)__builtin_popcount(c->taken[i] | c->not_taken[i]);
+        s->both_ways += (u32)__builtin_popcount(c->taken[i] & c->not_taken[i]);
+    }
+}
+
+// --- Informations de débogage ld65 (--dbgfile) ---
+// Une ligne par record : "type<TAB>clé=valeur,clé=valeur,..." ; les noms de
+// fichiers sont entre guillemets (et peuvent contenir des virgules).
+
+typedef struct {
+    long seg, start, size;
+    int data; // Span typé (.byte, .word...) : pas du code
+} DbgSpan;
+
+typedef struct {
+    u32 file, line;
+    u32 first_span, span_count; // Dans DbgInfo.line_spans
+} DbgLine;
+
+typedef struct {
+    char **files;     // Par id (NULL : absent)
+    u32 file_count;
+    long *seg_start;  // Par id (-1 : absent)
+    u32 seg_count;
+    DbgSpan *spans;   // Par id (seg -1 : absent)
+    u32 span_count;
+    DbgLine *lines;
+    u32 line_count, line_cap;
+    u32 *line_spans;
+    u32 line_span_count, line_span_cap;
+} DbgInfo;
+
+// Agrandit un tableau pour contenir l'index 'need' (nouvelles cases remplies de 'fill')
+static int grow(void **array, u32 *count, u32 need, size_t elem, int fill) {
+    if (need < *count) return 1;
+    u32 cap = *count ? *count : 64;
+    while (cap <= need) cap *= 2;
+    u8 *p = realloc(*array, cap * elem);
+    if (p == NULL) return 0;
+    memset(p + *count * elem, fill, (cap - *count) * elem);
+    *array = p;
+    *count = cap;
+    return 1;
+}
+
+// Valeur du champ 'key' (pointeur juste après "key="), NULL si absent
+static const char *field(const char *rec, const char *key) {
+    size_t len = strlen(key);
+    const char *p = rec;
+    while (*p) {
+        if (strncmp(p, key, len) == 0 && p[len] == '=') return p + len + 1;
+        // Champ suivant : virgule hors guillemets
+        int quoted = 0;
+        while (*p && (quoted || *p != ',')) {
+            if (*p == '"') quoted = !quoted;
+            p++;
+        }
+        if (*p == ',') p++;
+    }
+    return NULL;
+}
+
+static long number(const char *rec, const char *key) {
+    const char *v = field(rec, key);
+    return v ? strtol(v, NULL, 0) : -1;
+}
+
+static int dbg_record(DbgInfo *d, const char *type, const char *rec) {
+    long id = number(rec, "id");
+    if (id < 0) return 1;
+    if (strcmp(type, "file") == 0) {
+        const char *name = field(rec, "name");
+        const char *end = name && *name == '"' ? strchr(name + 1, '"') : NULL;
+        if (end == NULL) return 1;
+        if (!grow((void **)&d->files, &d->file_count, (u32)id, sizeof(char *), 0)) return 0;
+        free(d->files[id]);
+        d->files[id] = strndup(name + 1, end - name - 1);
+        return d->files[id] != NULL;
+    }
+    if (strcmp(type, "seg") == 0) {
+        if (!grow((void **)&d->seg_start, &d->seg_count, (u32)id, sizeof(long), 0xFF)) return 0;
+        d->seg_start[id] = number(rec, "start");
+        return 1;
+    }
+    if (strcmp(type, "span") == 0) {
+        if (!grow((void **)&d->spans, &d->span_count, (u32)id, sizeof(DbgSpan), 0xFF)) return 0;
+        DbgSpan *s = &d->spans[id];
+        s->seg = number(rec, "seg");
+        s->start = number(rec, "start");
+        s->size = number(rec, "size");
+        s->data = field(rec, "type") != NULL;
+        return 1;
+    }
+    if (strcmp(type, "line") == 0) {
+        const char *spans = field(rec, "span");
+        long file = number(rec, "file"), line = number(rec, "line");
+        if (spans == NULL || file < 0 || line < 0) return 1; // Ligne sans octet produit
+        if (d->line_count == d->line_cap) {
+            u32 cap = d->line_cap ? d->line_cap * 2 : 256;
+            DbgLine *p = realloc(d->lines, cap * sizeof(DbgLine));
+            if (p == NULL) return 0;
+            d->lines = p;
+            d->line_cap = cap;
+        }
+        DbgLine *l = &d->lines[d->line_count++];
+        l->file = (u32)file;
+        l->line = (u32)line;
+        l->first_span = d->line_span_count;
+        l->span_count = 0;
+        // "span=12" ou "span=12+13+20"
+        for (const char *p = spans;;) {
+            char *end;
+            unsigned long span = strtoul(p, &end, 10);
+            if (end == p) break;
+            if (d->line_span_count == d->line_span_cap) {
+                u32 cap = d->line_span_cap ? d->line_span_cap * 2 : 256;
+                u32 *q = realloc(d->line_spans, cap * sizeof(u32));
+                if (q == NULL) return 0;
+                d->line_spans = q;
+                d->line_span_cap = cap;
+            }
+            d->line_spans[d->line_span_count++] = (u32)span;
+            l->span_count++;
+            if (*end != '+') break;
+            p = end + 1;
+        }
+    }
+    return 1;
+}
+
+static void dbg_free(DbgInfo *d) {
+    for (u32 i = 0; i < d->file_count; i++) free(d->files[i]);
+    free(d->files);
+    free(d->seg_start);
+    free(d->spans);
+    free(d->lines);
+    free(d->line_spans);
+}
+
+static int dbg_load(DbgInfo *d, const char *path) {
+    memset(d, 0, sizeof(*d));
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", path);
+        return 0;
+    }
+    char buf[4096];
+    int ok = 1;
+    while (ok && fgets(buf, sizeof(buf), f)) {
+        buf[strcspn(buf, "\r\n")] = '\0';
+        char *tab = strchr(buf, '\t');
+        if (tab == NULL) continue;
+        *tab = '\0';
+        ok = dbg_record(d, buf, tab + 1);
+    }
+    fclose(f);
+    if (!ok) {
+        printf("Erreur : mémoire insuffisante pour %s\n", path);
+        dbg_free(d);
+    }
+    return ok;
+}
+
+// --- Rapport lcov ---
+
+static const DbgLine *sort_base;
+
+static int by_file_line(const void *a, const void *b) {
+    const DbgLine *x = &sort_base[*(const u32 *)a], *y = &sort_base[*(const u32 *)b];
+    if (x->file != y->file) return x->file < y->file ? -1 : 1;
+    if (x->line != y->line) return x->line < y->line ? -1 : 1;
+    return 0;
+}
+
+// Compteurs d'un fichier source
+typedef struct {
+    u32 lines, lines_hit, branches, branches_hit;
+} LcovTotals;
+
+// Une ligne source (tous ses records) : DA et BRDA. 'seen' évite de compter
+// deux fois une instruction citée par plusieurs records de la ligne.
+static void lcov_line(const Coverage *c, Memory *mem, const OpcodeEntry *ops, const DbgInfo *d,
+                      const u32 *order, u32 count, u32 *seen, u32 stamp, LcovTotals *t, FILE *out) {
+    u32 number = d->lines[order[0]].line;
+    int code = 0, hit = 0;
+    // Branches de la ligne, dans l'ordre des adresses rencontrées
+    u16 branches[64];
+    int branch_count = 0;
+    for (u32 i = 0; i < count; i++) {
+        const DbgLine *l = &d->lines[order[i]];
+        for (u32 k = 0; k < l->span_count; k++) {
+            u32 id = d->line_spans[l->first_span + k];
+            if (id >= d->span_count) continue;
+            const DbgSpan *s = &d->spans[id];
+            if (s->seg < 0 || s->data || (u32)s->seg >= d->seg_count || d->seg_start[s->seg] < 0) continue;
+            long address = d->seg_start[s->seg] + s->start, end = address + s->size;
+            // Instructions successives du span (décodées dans le programme chargé)
+            while (address < end && address <= 0xFFFF) {
+                DecodedInsn insn;
+                disasm_decode(ops, mem, (u16)address, &insn);
+                if (insn.entry && seen[address] != stamp) {
+                    seen[address] = stamp;
+                    code = 1;
+                    if (cov_test(c->executed, (u16)address)) hit = 1;
+                    if (c->branch[insn.bytes[0]] && branch_count < 64) branches[branch_count++] = (u16)address;
+                }
+                address += insn.entry ? insn.length : 1;
+            }
+        }
+    }
+    if (!code) return;
+    fprintf(out, "DA:%u,%d\n", number, hit);
+    t->lines++;
+    t->lines_hit += hit;
+    for (int b = 0; b < branch_count; b++) {
+        u16 a = branches[b];
+        if (!cov_test(c->executed, a)) {
+            fprintf(out, "BRDA:%u,%d,0,-\nBRDA:%u,%d,1,-\n", number, b, number, b);
+        } else {
+            int taken = cov_test(c->taken, a), not_taken = cov_test(c->not_taken, a);
+            fprintf(out, "BRDA:%u,%d,0,%d\nBRDA:%u,%d,1,%d\n", number, b, taken, number, b, not_taken);
+            t->branches_hit += taken + not_taken;
+        }
+        t->branches += 2;
+    }
+}
+
+int cov_write_lcov(const Coverage *c, Memory *mem, const char *dbg_path, FILE *out) {
+    DbgInfo d;
+    if (!dbg_load(&d, dbg_path)) return 0;
+    u32 *order = malloc((d.line_count ? d.line_count : 1) * sizeof(u32));
+    u32 *seen = calloc(MAX_MEMORY, sizeof(u32));
+    if (order == NULL || seen == NULL) {
+        printf("Erreur : mémoire insuffisante pour %s\n", dbg_path);
+        free(order);
+        free(seen);
+        dbg_free(&d);
+        return 0;
+    }
+    for (u32 i = 0; i < d.line_count; i++) order[i] = i;
+    sort_base = d.lines;
+    qsort(order, d.line_count, sizeof(u32), by_file_line);
+
+    const OpcodeEntry *ops = cpu_machine(c->variant)->ops;
+    fprintf(out, "TN:\n");
+    u32 stamp = 0;
+    for (u32 i = 0; i < d.line_count;) {
+        u32 file = d.lines[order[i]].file;
+        const char *name = file < d.file_count && d.files[file] ? d.files[file] : "?";
+        fprintf(out, "SF:%s\n", name);
+        LcovTotals t = { 0, 0, 0, 0 };
+        while (i < d.line_count && d.lines[order[i]].file == file) {
+            u32 n = 1;
+            while (i + n < d.line_count && d.lines[order[i + n]].file == file
+                   && d.lines[order[i + n]].line == d.lines[order[i]].line) n++;
+            lcov_line(c, mem, ops, &d, order + i, n, seen, ++stamp, &t, out);
+            i += n;
+        }
+        if (t.branches) fprintf(out, "BRF:%u\nBRH:%u\n", t.branches, t.branches_hit);
+        fprintf(out, "LF:%u\nLH:%u\nend_of_record\n", t.lines, t.lines_hit);
+    }
+    free(order);
+    free(seen);
+    dbg_free(&d);
+    return 1;
+}
@@ -0,0 +1,216 @@
+#include "device.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && defined(__ELF__)
+#define DEVICE_ASM_SWITCH 1
+#else
+#define DEVICE_ASM_SWITCH 0
+#include <ucontext.h>
+#endif
+
+#if DEVICE_ASM_SWITCH
+// Sauve les registres préservés (System V) sur la pile courante, range le
+// pointeur de pile dans *save et repart de la pile 'load'. Le premier
+// passage sur une pile neuve « revient » dans device_trampoline, qui appelle
+// r13(r12).
+void device_switch(void **save, void *load);
+void device_trampoline(void);
+__asm__(
+    ".text\n"
+    ".globl device_switch\n"
+    ".hidden device_switch\n"
+    ".type device_switch, @function\n"
+    "device_switch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size device_switch, .-device_switch\n"
+    ".globl device_trampoline\n"
+    ".hidden device_trampoline\n"
+    ".type device_trampoline, @function\n"
+    "device_trampoline:\n"
+    "    movq %r12, %rdi\n"
+    "    callq *%r13\n"
+    "    ud2\n"
+    ".size device_trampoline, .-device_trampoline\n");
+#endif
+
+// Boucle d'exécution -> coroutine
+static inline void switch_to_device(Device *dev) {
+#if DEVICE_ASM_SWITCH
+    device_switch(&dev->host_sp, dev->sp);
+#else
+    ucontext_t *uc = (ucontext_t *)dev->uctx;
+    swapcontext(&uc[0], &uc[1]);
+#endif
+}
+
+// Coroutine -> boucle d'exécution
+static inline void switch_to_host(Device *dev) {
+#if DEVICE_ASM_SWITCH
+    device_switch(&dev->sp, dev->host_sp);
+#else
+    ucontext_t *uc = (ucontext_t *)dev->uctx;
+    swapcontext(&uc[1], &uc[0]);
+#endif
+}
+
+// Premier code exécuté sur la pile du périphérique
+static void device_main(Device *dev) {
+    dev->body(dev);
+    // Corps terminé : plus jamais repris
+    dev->done = 1;
+    sched_cancel(dev->sched, dev->event);
+    switch_to_host(dev);
+    abort();
+}
+
+#if !DEVICE_ASM_SWITCH
+// makecontext ne transmet que des int : le pointeur est coupé en deux
+static void device_entry(unsigned int lo, unsigned int hi) {
+    device_main((Device *)(((uintptr_t)hi << 32) | lo));
+}
+#endif
+
+// Événement de l'ordonnanceur : l'échéance est atteinte
+static void device_resume(void *ctx, u64 now) {
+    Device *dev = (Device *)ctx;
+    if (dev->stack == NULL || dev->done) return;
+    dev->now = now;
+    dev->resumes++;
+    dev->running = 1;
+    switch_to_device(dev);
+    dev->running = 0;
+}
+
+int device_start(Device *dev, const char *name, CPU *cpu, Scheduler *sched, DeviceBody body, void *ctx) {
+    memset(dev, 0, sizeof(*dev));
+    dev->name = name;
+    dev->cpu = cpu;
+    dev->sched = sched;
+    dev->body = body;
+    dev->ctx = ctx;
+    dev->event = sched_add(sched, device_resume, dev);
+    if (dev->event < 0) {
+        printf("Erreur : ordonnanceur plein (peripherique %s)\n", name);
+        return 0;
+    }
+
+    // Pile + page de garde en bas : un débordement fait une erreur franche
+    long page = sysconf(_SC_PAGESIZE);
+    dev->stack_size = DEVICE_STACK_SIZE + page;
+    dev->stack = mmap(NULL, dev->stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (dev->stack == MAP_FAILED) {
+        dev->stack = NULL;
+        printf("Erreur : pile du peripherique %s impossible a allouer\n", name);
+        return 0;
+    }
+    mprotect(dev->stack, page, PROT_NONE);
+
+#if DEVICE_ASM_SWITCH
+    // Cadre initial lu par device_switch : r15..rbp puis l'adresse de retour
+    // (device_trampoline), pile alignée sur 16 octets à l'entrée du trampoline
+    void **sp = (void **)(((uintptr_t)(dev->stack + dev->stack_size)) & ~(uintptr_t)15);
+    *--sp = (void *)device_trampoline;
+    *--sp = NULL;               // rbp
+    *--sp = NULL;               // rbx
+    *--sp = dev;                // r12
+    *--sp = (void *)device_main; // r13
+    *--sp = NULL;               // r14
+    *--sp = NULL;               // r15
+    dev->sp = sp;
+#else
+    ucontext_t *uc = calloc(2, sizeof(ucontext_t));
+    if (uc == NULL) {
+        device_stop(dev);
+        return 0;
+    }
+    dev->uctx = uc;
+    getcontext(&uc[1]);
+    uc[1].uc_stack.ss_sp = dev->stack + page;
+    uc[1].uc_stack.ss_size = DEVICE_STACK_SIZE;
+    uc[1].uc_link = NULL;
+    uintptr_t p = (uintptr_t)dev;
+    makecontext(&uc[1], (void (*)(void))device_entry, 2, (unsigned int)p, (unsigned int)(p >> 32));
+#endif
+
+    // Jusqu'à la première attente
+    dev->target = cpu->cycles;
+    device_resume(dev, cpu->cycles);
+    return 1;
+}
+
+void device_stop(Device *dev) {
+    if (dev->event >= 0 && dev->sched) sched_cancel(dev->sched, dev->event);
+    if (dev->stack) munmap(dev->stack, dev->stack_size);
+    free(dev->uctx);
+    dev->stack = NULL;
+    dev->uctx = NULL;
+}
+
+void device_wait_until(Device *dev, u64 cycle) {
+    dev->target = cycle;
+    if (cycle <= dev->cpu->cycles) { // Déjà passé : on continue
+        dev->now = dev->cpu->cycles;
+        return;
+    }
+    sched_set(dev->sched, dev->event, cycle);
+    switch_to_host(dev);
+}
+
+void device_wait(Device *dev, u64 cycles) {
+    device_wait_until(dev, dev->target + cycles);
+}
+
+void device_wake(Device *dev) {
+    if (dev->running || dev->done) return;
+    dev->target = dev->cpu->cycles;
+    sched_set(dev->sched, dev->event, dev->cpu->cycles);
+}
+
+// --- Mesure du changement de contexte ---
+
+static void ping_body(Device *dev) {
+    for (;;) device_wait_until(dev, SCHED_NEVER);
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double device_switch_cost(int rounds) {
+    static Memory mem;
+    static CPU cpu;
+    static Scheduler sched;
+    static Device dev;
+    mem_init(&mem);
+    cpu_reset(&cpu, &mem);
+    sched_init(&sched);
+    if (!device_start(&dev, "ping", &cpu, &sched, ping_body, NULL)) return 0.0;
+    // Reprise directe (sans passer par l'ordonnanceur) : le coût mesuré est
+    // celui des deux changements de pile et de sched_set
+    double t0 = seconds();
+    for (int i = 0; i < rounds; i++) device_resume(&dev, cpu.cycles);
+    double t = seconds() - t0;
+    device_stop(&dev);
+    return t / rounds * 1e9;
+}
@@ -0,0 +1,290 @@
+#include "disasm.h"
+#include "addressing.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- Décodage ---
+
+// Le désassembleur retrouve le format de l'opérande à partir de la fonction
+// d'adressage de la table : il n'y a donc qu'une seule source de vérité.
+static const struct {
+    AddrModeFunc func;
+    u8 mode;
+    u8 length;
+} mode_formats[] = {
+    { addr_implied,             DIS_IMPLIED,             1 },
+    { addr_accumulator,         DIS_ACCUMULATOR,         1 },
+    { addr_immediate,           DIS_IMMEDIATE,           2 },
+    { addr_zero_page,           DIS_ZERO_PAGE,           2 },
+    { addr_zero_page_x,         DIS_ZERO_PAGE_X,         2 },
+    { addr_zero_page_y,         DIS_ZERO_PAGE_Y,         2 },
+    { addr_absolute,            DIS_ABSOLUTE,            3 },
+    { addr_absolute_x,          DIS_ABSOLUTE_X,          3 },
+    { addr_absolute_y,          DIS_ABSOLUTE_Y,          3 },
+    { addr_indirect,            DIS_INDIRECT,            3 },
+    { addr_indirect_fixed,      DIS_INDIRECT,            3 },
+    { addr_indirect_x,          DIS_INDIRECT_X,          2 },
+    { addr_indirect_y,          DIS_INDIRECT_Y,          2 },
+    { addr_indirect_zp,         DIS_INDIRECT_ZP,         2 },
+    { addr_absolute_indirect_x, DIS_ABSOLUTE_INDIRECT_X, 3 },
+    { addr_relative,            DIS_RELATIVE,            2 },
+    { addr_zero_page_relative,  DIS_ZERO_PAGE_RELATIVE,  3 },
+};
+#define MODE_FORMAT_COUNT (int)(sizeof(mode_formats) / sizeof(mode_formats[0]))
+
+void disasm_decode(const OpcodeEntry *ops, Memory *mem, u16 address, DecodedInsn *out) {
+    u8 opcode = mem_peek(mem, address);
+    const OpcodeEntry *entry = &ops[opcode];
+
+    out->address = address;
+    out->bytes[0] = opcode;
+    out->operand = 0;
+    out->target = 0;
+    out->entry = entry->instruction ? entry : NULL;
+    out->mode = DIS_UNKNOWN;
+    out->length = 1;
+
+    if (out->entry == NULL) return;
+    for (int i = 0; i < MODE_FORMAT_COUNT; i++) {
+        if (mode_formats[i].func == entry->addrmode) {
+            out->mode = mode_formats[i].mode;
+            out->length = mode_formats[i].length;
+            break;
+        }
+    }
+    // "ASL A", "INC A"... sont rangés en implied dans la table
+    size_t n = strlen(entry->name);
+    if (out->mode == DIS_IMPLIED && n > 2 && strcmp(entry->name + n - 2, " A") == 0) {
+        out->mode = DIS_ACCUMULATOR;
+    }
+
+    for (int i = 1; i < out->length; i++) {
+        out->bytes[i] = mem_peek(mem, (u16)(address + i));
+    }
+    if (out->length == 2) out->operand = out->bytes[1];
+    if (out->length == 3) out->operand = out->bytes[1] | (out->bytes[2] << 8);
+
+    if (out->mode == DIS_RELATIVE) {
+        out->target = (u16)(address + 2 + (s8)out->bytes[1]);
+    } else if (out->mode == DIS_ZERO_PAGE_RELATIVE) {
+        // BBR/BBS : opérande = adresse en page 0, cible = branchement
+        out->operand = out->bytes[1];
+        out->target = (u16)(address + 3 + (s8)out->bytes[2]);
+    } else {
+        out->target = out->operand;
+    }
+}
+
+// --- Cache ---
+
+DisasmCache *disasm_create(Memory *mem, CpuVariant variant) {
+    DisasmCache *cache = calloc(1, sizeof(DisasmCache));
+    if (cache == NULL) {
+        printf("Erreur : mémoire insuffisante pour le cache du désassembleur\n");
+        return NULL;
+    }
+    cache->mem = mem;
+    cache->ops = cpu_machine(variant)->ops;
+    cache->watch = -1;
+    return cache;
+}
+
+void disasm_free(DisasmCache *cache) {
+    if (cache == NULL) return;
+    if (cache->watch >= 0) mem_remove_watch(cache->mem, cache->watch);
+    free(cache);
+}
+
+const DecodedInsn *disasm_get(DisasmCache *cache, u16 address) {
+    if (cache->valid[address]) {
+        cache->hits++;
+        return &cache->insns[address];
+    }
+    cache->misses++;
+    DecodedInsn *insn = &cache->insns[address];
+    disasm_decode(cache->ops, cache->mem, address, insn);
+    disasm_format(insn, cache->symbols, insn->text, sizeof(insn->text));
+    cache->valid[address] = 1;
+    return &cache->insns[address];
+}
+
+void disasm_invalidate(DisasmCache *cache, u16 address) {
+    // Une instruction fait au plus 3 octets : elle peut commencer jusqu'à 2 octets avant
+    cache->valid[address] = 0;
+    cache->valid[(u16)(address - 1)] = 0;
+    cache->valid[(u16)(address - 2)] = 0;
+}
+
+static void disasm_on_write(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)pc; (void)value; (void)kind;
+    disasm_invalidate((DisasmCache *)ctx, address);
+}
+
+int disasm_track_writes(DisasmCache *cache) {
+    if (cache->watch < 0) {
+        cache->watch = mem_add_watch(cache->mem, 0x0000, 0xFFFF, MEM_WATCH_WRITE, disasm_on_write, cache);
+    }
+    return cache->watch >= 0;
+}
+
+// --- Formatage ---
+
+// Écrit l'adresse sous forme de label si elle en a un, sinon en hexadécimal
+static int format_address(char *buf, int size, const SymbolTable *symbols, u16 address, int zp) {
+    if (symbols && symbols->names[address]) {
+        return snprintf(buf, size, "%s", symbols->names[address]);
+    }
+    return zp ? snprintf(buf, size, "$%02X", address) : snprintf(buf, size, "$%04X", address);
+}
+
+int disasm_format(const DecodedInsn *insn, const SymbolTable *symbols, char *buf, int size) {
+    if (insn->entry == NULL) {
+        return snprintf(buf, size, ".byte $%02X", insn->bytes[0]);
+    }
+
+    // Mnémonique = premier mot du nom de la table ("LDA ZP,X" -> "LDA")
+    const char *name = insn->entry->name;
+    int n = 0;
+    while (name[n] && name[n] != ' ' && n < 7) n++;
+    int len = snprintf(buf, size, "%.*s", n, name);
+    if (len >= size) return len;
+
+    char addr[64];
+    int zp = insn->length == 2;
+    switch (insn->mode) {
+    case DIS_IMPLIED:
+        return len;
+    case DIS_ACCUMULATOR:
+        return len + snprintf(buf + len, size - len, " A");
+    case DIS_IMMEDIATE:
+        return len + snprintf(buf + len, size - len, " #$%02X", insn->operand);
+    default:
+        break;
+    }
+
+    if (insn->mode == DIS_ZERO_PAGE_RELATIVE) {
+        char target[64];
+        format_address(addr, sizeof(addr), symbols, insn->operand, 1);
+        format_address(target, sizeof(target), symbols, insn->target, 0);
+        return len + snprintf(buf + len, size - len, " %s,%s", addr, target);
+    }
+    format_address(addr, sizeof(addr), symbols, insn->target, zp && insn->mode != DIS_RELATIVE);
+    switch (insn->mode) {
+    case DIS_ZERO_PAGE_X: case DIS_ABSOLUTE_X:
+        return len + snprintf(buf + len, size - len, " %s,X", addr);
+    case DIS_ZERO_PAGE_Y: case DIS_ABSOLUTE_Y:
+        return len + snprintf(buf + len, size - len, " %s,Y", addr);
+    case DIS_INDIRECT: case DIS_INDIRECT_ZP:
+        return len + snprintf(buf + len, size - len, " (%s)", addr);
+    case DIS_INDIRECT_X: case DIS_ABSOLUTE_INDIRECT_X:
+        return len + snprintf(buf + len, size - len, " (%s,X)", addr);
+    case DIS_INDIRECT_Y:
+        return len + snprintf(buf + len, size - len, " (%s),Y", addr);
+    default:
+        return len + snprintf(buf + len, size - len, " %s", addr);
+    }
+}
+
+void disasm_listing(DisasmCache *cache, u16 start, u16 end, FILE *out) {
+    unsigned int address = start;
+    while (address <= end) {
+        const DecodedInsn *insn = disasm_get(cache, (u16)address);
+        if (cache->symbols && cache->symbols->names[address]) {
+            fprintf(out, "%s:\n", cache->symbols->names[address]);
+        }
+        const char *text = insn->text;
+        switch (insn->length) {
+        case 1:
+            fprintf(out, "  %04X  %02X        %s\n", (unsigned)address, insn->bytes[0], text);
+            break;
+        case 2:
+            fprintf(out, "  %04X  %02X %02X     %s\n", (unsigned)address, insn->bytes[0], insn->bytes[1], text);
+            break;
+        default:
+            fprintf(out, "  %04X  %02X %02X %02X  %s\n", (unsigned)address, insn->bytes[0],
+                    insn->bytes[1], insn->bytes[2], text);
+            break;
+        }
+        address += insn->length;
+    }
+}
+
+// --- Symboles ---
+
+void symbols_init(SymbolTable *symbols) {
+    memset(symbols, 0, sizeof(*symbols));
+}
+
+void symbols_free(SymbolTable *symbols) {
+    for (int i = 0; i < MAX_MEMORY; i++) {
+        free(symbols->names[i]);
+        symbols->names[i] = NULL;
+    }
+    symbols->count = 0;
+}
+
+int symbols_add(SymbolTable *symbols, u16 address, const char *name) {
+    // Le premier label défini pour une adresse est gardé
+    if (symbols->names[address]) return 0;
+    symbols->names[address] = strdup(name);
+    if (symbols->names[address] == NULL) return 0;
+    symbols->count++;
+    return 1;
+}
+
+// "al C:1234 .nom" ou "al 001234 .nom" (format VICE, ld65 -Ln)
+static int parse_vice_line(SymbolTable *symbols, const char *line) {
+    const char *p = line + 3;
+    if (p[0] && p[1] == ':') p += 2;
+    char *end;
+    unsigned long address = strtoul(p, &end, 16);
+    if (end == p || address > 0xFFFF) return 0;
+    while (*end == ' ' || *end == '\t') end++;
+    if (*end == '.') end++;
+
+    char name[128];
+    int n = 0;
+    while (end[n] && end[n] != '\n' && end[n] != '\r' && end[n] != ' ' && n < (int)sizeof(name) - 1) {
+        name[n] = end[n];
+        n++;
+    }
+    name[n] = '\0';
+    return n > 0 && symbols_add(symbols, (u16)address, name);
+}
+
+// "sym id=0,name="start",...,val=0x8000,...,type=lab" (fichier --dbgfile de ld65)
+static int parse_dbg_line(SymbolTable *symbols, const char *line) {
+    if (strstr(line, "type=lab") == NULL) return 0; // On ignore les constantes (equ)
+    const char *name = strstr(line, "name=\"");
+    const char *val = strstr(line, "val=0x");
+    if (name == NULL || val == NULL) return 0;
+    name += 6;
+    const char *quote = strchr(name, '"');
+    if (quote == NULL || quote - name >= 128) return 0;
+
+    unsigned long address = strtoul(val + 6, NULL, 16);
+    if (address > 0xFFFF) return 0;
+    char buf[128];
+    memcpy(buf, name, quote - name);
+    buf[quote - name] = '\0';
+    return symbols_add(symbols, (u16)address, buf);
+}
+
+int symbols_load(SymbolTable *symbols, const char *filename) {
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", filename);
+        return -1;
+    }
+    char line[1024];
+    int added = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "al ", 3) == 0) {
+            added += parse_vice_line(symbols, line);
+        } else if (strncmp(line, "sym", 3) == 0 && (line[3] == '\t' || line[3] == ' ')) {
+            added += parse_dbg_line(symbols, line);
+        }
+    }
+    fclose(f);
+    return added;
+}
@@ -0,0 +1,216 @@
+#include "emu6502.h"
+#include "cpu.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct Emu6502 {
+    CPU cpu;
+    Memory mem;
+    CpuVariant variant;
+    int halted;
+    u64 instructions;
+    StatsInstance *stats; // NULL si non suivie
+};
+
+uint32_t emu6502_version(void) {
+    return EMU6502_VERSION;
+}
+
+// --- Instances ---
+
+Emu6502 *emu6502_create(Emu6502Variant variant) {
+    static const CpuVariant variants[] = { CPU_NMOS, CPU_65C02, CPU_2A03 };
+    if ((unsigned)variant >= sizeof(variants) / sizeof(variants[0])) return NULL;
+
+    // Le CPU est aligné sur une ligne de cache (voir cpu.h)
+    size_t size = (sizeof(Emu6502) + 63) & ~(size_t)63;
+    Emu6502 *emu = aligned_alloc(64, size);
+    if (emu == NULL) return NULL;
+    memset(emu, 0, size);
+    emu->variant = variants[variant];
+    mem_init(&emu->mem);
+    cpu_reset_variant(&emu->cpu, &emu->mem, emu->variant);
+    return emu;
+}
+
+void emu6502_destroy(Emu6502 *emu) {
+    if (emu) stats_unregister(emu->stats);
+    free(emu);
+}
+
+// --- Mémoire et bus ---
+
+uint8_t *emu6502_memory(Emu6502 *emu) {
+    return emu->mem.data;
+}
+
+int emu6502_load(Emu6502 *emu, uint16_t address, const void *data, size_t size) {
+    if ((size_t)address + size > MAX_MEMORY) return -1;
+    mem_load_bytes(&emu->mem, address, data, (u32)size);
+    return 0;
+}
+
+uint8_t emu6502_read(Emu6502 *emu, uint16_t address) {
+    return mem_read(&emu->mem, address);
+}
+
+void emu6502_write(Emu6502 *emu, uint16_t address, uint8_t value) {
+    mem_write(&emu->mem, address, value);
+}
+
+void emu6502_map(Emu6502 *emu, uint8_t first_page, uint8_t last_page,
+                 Emu6502ReadFunc read, Emu6502WriteFunc write, void *ctx) {
+    mem_map_io(&emu->mem, first_page, last_page, read, write, ctx);
+}
+
+void emu6502_unmap(Emu6502 *emu, uint8_t first_page, uint8_t last_page) {
+    mem_unmap_io(&emu->mem, first_page, last_page);
+}
+
+// --- Exécution ---
+
+void emu6502_reset(Emu6502 *emu) {
+    cpu_reset_variant(&emu->cpu, &emu->mem, emu->variant);
+    emu->halted = 0;
+}
+
+uint64_t emu6502_run(Emu6502 *emu, uint64_t cycles) {
+    CPU *cpu = &emu->cpu;
+    u64 start = cpu->cycles;
+    u64 until = start + cycles;
+    // Les compteurs d'interruptions et d'accès aux périphériques vont à
+    // l'instance qui tourne sur ce thread
+    if (emu->stats) stats_current = &emu->stats->local;
+    // cpu_step quitte le programme sur un opcode non implémenté : une
+    // bibliothèque ne doit pas le faire, cpu_run s'arrête juste avant.
+    emu->instructions += cpu_run(cpu, until);
+    emu->halted = cpu->cycles < until;
+    if (emu->stats) {
+        emu->stats->local.instructions = emu->instructions;
+        stats_publish(emu->stats, cpu);
+    }
+    return cpu->cycles - start;
+}
+
+uint64_t emu6502_instructions(const Emu6502 *emu) {
+    return emu->instructions;
+}
+
+int emu6502_halted(const Emu6502 *emu) {
+    return emu->halted;
+}
+
+void emu6502_get_regs(const Emu6502 *emu, Emu6502Regs *regs) {
+    const CPU *cpu = &emu->cpu;
+    regs->a = cpu->A;
+    regs->x = cpu->X;
+    regs->y = cpu->Y;
+    regs->sp = cpu->SP;
+    regs->p = cpu->P;
+    regs->pc = cpu->PC;
+    regs->cycles = cpu->cycles;
+}
+
+void emu6502_set_regs(Emu6502 *emu, const Emu6502Regs *regs) {
+    CPU *cpu = &emu->cpu;
+    cpu->A = regs->a;
+    cpu->X = regs->x;
+    cpu->Y = regs->y;
+    cpu->SP = regs->sp;
+    cpu->P = regs->p;
+    cpu->PC = regs->pc;
+    cpu->cycles = regs->cycles;
+}
+
+// --- Interruptions ---
+
+void emu6502_set_irq(Emu6502 *emu, unsigned line, int level) {
+    if (line < 8) cpu_set_irq(&emu->cpu, (u8)(1 << line), level);
+}
+
+void emu6502_set_nmi(Emu6502 *emu, unsigned line, int level) {
+    if (line < 7) cpu_set_nmi(&emu->cpu, (u8)(1 << line), level);
+}
+
+void emu6502_nmi(Emu6502 *emu) {
+    cpu_nmi(&emu->cpu);
+}
+
+// --- Snapshots ---
+// Format (petit-boutiste) : "E65S", version, variante, A X Y SP P, PC (2),
+// cycles (8), lignes IRQ, IRQ en attente, NMI en attente, lignes NMI,
+// décision d'IRQ retardée (CLI/SEI/PLP), puis la RAM. La version 1 (sans
+// les deux derniers octets) est encore relue.
+
+#define SNAPSHOT_MAGIC "E65S"
+#define SNAPSHOT_FORMAT 2
+#define SNAPSHOT_HEADER 26
+#define SNAPSHOT_HEADER_V1 24
+
+size_t emu6502_snapshot_size(void) {
+    return SNAPSHOT_HEADER + MAX_MEMORY;
+}
+
+int emu6502_snapshot(const Emu6502 *emu, void *buffer, size_t size) {
+    if (size < emu6502_snapshot_size()) return -1;
+    const CPU *cpu = &emu->cpu;
+    u8 *p = (u8 *)buffer;
+    memcpy(p, SNAPSHOT_MAGIC, 4);
+    p[4] = SNAPSHOT_FORMAT;
+    p[5] = (u8)emu->variant;
+    p[6] = cpu->A; p[7] = cpu->X; p[8] = cpu->Y; p[9] = cpu->SP; p[10] = cpu->P;
+    p[11] = cpu->PC & 0xFF;
+    p[12] = cpu->PC >> 8;
+    for (int i = 0; i < 8; i++) p[13 + i] = (u8)(cpu->cycles >> (8 * i));
+    p[21] = cpu->irq_lines;
+    p[22] = (cpu->events & CPU_EVENT_IRQ) != 0;
+    p[23] = (cpu->events & CPU_EVENT_NMI) != 0;
+    p[24] = cpu->nmi_lines;
+    p[25] = ((cpu->events & CPU_EVENT_I_DELAY) ? 1 : 0) | ((cpu->events & CPU_EVENT_WAIT) ? 2 : 0)
+          | ((cpu->events & CPU_EVENT_STOP) ? 4 : 0);
+    memcpy(p + SNAPSHOT_HEADER, emu->mem.data, MAX_MEMORY);
+    return 0;
+}
+
+int emu6502_restore(Emu6502 *emu, const void *buffer, size_t size) {
+    const u8 *p = (const u8 *)buffer;
+    if (size < SNAPSHOT_HEADER_V1 || memcmp(p, SNAPSHOT_MAGIC, 4) != 0) return -1;
+    size_t header = p[4] == 1 ? SNAPSHOT_HEADER_V1 : SNAPSHOT_HEADER;
+    if ((p[4] != 1 && p[4] != SNAPSHOT_FORMAT) || size < header + MAX_MEMORY || p[5] != (u8)emu->variant) {
+        return -1;
+    }
+    CPU *cpu = &emu->cpu;
+    cpu->A = p[6]; cpu->X = p[7]; cpu->Y = p[8]; cpu->SP = p[9]; cpu->P = p[10];
+    cpu->PC = p[11] | (p[12] << 8);
+    cpu->cycles = 0;
+    for (int i = 0; i < 8; i++) cpu->cycles |= (u64)p[13 + i] << (8 * i);
+    cpu->irq_lines = p[21];
+    cpu->events = (p[22] ? CPU_EVENT_IRQ : 0) | (p[23] ? CPU_EVENT_NMI : 0);
+    cpu->nmi_lines = 0;
+    if (header == SNAPSHOT_HEADER) {
+        cpu->nmi_lines = p[24];
+        if (p[25] & 1) cpu->events |= CPU_EVENT_I_DELAY;
+        if (p[25] & 2) cpu->events |= CPU_EVENT_WAIT;
+        if (p[25] & 4) cpu->events |= CPU_EVENT_STOP;
+    }
+    mem_load_bytes(&emu->mem, 0x0000, p + header, MAX_MEMORY);
+    emu->halted = 0;
+    return 0;
+}
+
+// --- Statistiques ---
+
+int emu6502_stats_enable(Emu6502 *emu, const char *name) {
+    if (emu->stats) return 0;
+    emu->stats = stats_register(name);
+    return emu->stats ? 0 : -1;
+}
+
+int emu6502_stats_export(const char *target, double interval) {
+    return stats_export_start(target, interval) ? 0 : -1;
+}
+
+void emu6502_stats_stop(void) {
+    stats_export_stop();
+}
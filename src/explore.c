@@ -0,0 +1,431 @@
+#include "explore.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BRANCH_DECISION -1 // run_branch : point de décision atteint
+
+// État figé en point de décision. Ses pages sont lues par les branches
+// (mem_fork) et par les états figés plus profonds : il vit tant qu'il reste
+// une tâche ou un descendant.
+typedef struct ExploreNode {
+    CPU cpu;
+    Memory *mem;
+    struct ExploreNode *parent;
+    int refs;                     // Tâches en attente + états enfants (atomique)
+    u64 id;                       // Unique (l'adresse peut être réutilisée)
+    int depth;                    // Entrées déjà choisies
+    u8 inputs[EXPLORE_MAX_DEPTH];
+} ExploreNode;
+
+typedef struct {
+    ExploreNode *node;
+    int choice;
+} Task;
+
+struct Explorer;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    Task *tasks;          // File [head, tail) : le propriétaire prend en queue, un voleur en tête
+    size_t head, tail, capacity;
+    Memory **pool;        // Mémoires libres (réutilisées sans remise à zéro)
+    int pool_count, pool_capacity;
+    Memory *last_mem;     // Dernière branche terminée, encore fork de l'état last_node
+    u64 last_node;
+    u64 nodes;            // États figés par ce thread (identifiants)
+    u64 done;             // Tâches terminées pas encore retirées de ex->pending
+    ExploreStats stats;
+    u32 rng;
+    int id;
+    struct Explorer *ex;
+} __attribute__((aligned(64))) Worker; // Alignés sur une ligne de cache : pas de faux partage entre threads
+
+typedef struct Explorer {
+    const ExploreConfig *cfg;
+    Worker *workers;
+    int count;
+    u64 pending;          // Tâches poussées et pas encore terminées (atomique)
+    u64 *seen;            // Hash des états déjà développés (0 : case libre)
+    u64 seen_mask;
+    pthread_mutex_t leaf_lock;
+} Explorer;
+
+// Identifiant unique d'un état figé, sans compteur partagé entre threads
+static u64 node_id(Worker *w) {
+    return ++w->nodes * (u64)w->ex->count + (u64)w->id;
+}
+
+// --- Mémoires ---
+
+static Memory *mem_acquire(Worker *w) {
+    if (w->pool_count > 0) return w->pool[--w->pool_count];
+    return malloc(sizeof(Memory));
+}
+
+// Mémoire d'une branche partant de 'node'. Les tâches d'un même état se
+// suivent dans la file : la mémoire de la branche précédente est réutilisée
+// en n'annulant que ses pages écrites.
+static Memory *branch_memory(Worker *w, const ExploreNode *node) {
+    if (w->pool_count > 0 && w->pool[w->pool_count - 1] == w->last_mem && w->last_node == node->id) {
+        Memory *mem = w->pool[--w->pool_count];
+        mem_refork(mem, node->mem);
+        return mem;
+    }
+    Memory *mem = mem_acquire(w);
+    if (mem) mem_fork(mem, node->mem);
+    return mem;
+}
+
+static void mem_release(Worker *w, Memory *mem) {
+    if (w->pool_count == w->pool_capacity) {
+        int capacity = w->pool_capacity ? w->pool_capacity * 2 : 64;
+        Memory **pool = realloc(w->pool, capacity * sizeof(Memory *));
+        if (pool == NULL) {
+            free(mem);
+            return;
+        }
+        w->pool = pool;
+        w->pool_capacity = capacity;
+    }
+    w->pool[w->pool_count++] = mem;
+}
+
+static void node_release(Worker *w, ExploreNode *node) {
+    while (node && __atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        ExploreNode *parent = node->parent;
+        mem_release(w, node->mem);
+        free(node);
+        node = parent;
+    }
+}
+
+// --- Files à vol de travail ---
+
+static int push_task(Worker *w, Task t) {
+    pthread_mutex_lock(&w->lock);
+    if (w->tail == w->capacity) {
+        if (w->head > 0) { // Place libérée en tête par les voleurs
+            memmove(w->tasks, w->tasks + w->head, (w->tail - w->head) * sizeof(Task));
+            w->tail -= w->head;
+            w->head = 0;
+        } else {
+            size_t capacity = w->capacity ? w->capacity * 2 : 1024;
+            Task *tasks = realloc(w->tasks, capacity * sizeof(Task));
+            if (tasks == NULL) {
+                pthread_mutex_unlock(&w->lock);
+                return 0;
+            }
+            w->tasks = tasks;
+            w->capacity = capacity;
+        }
+    }
+    w->tasks[w->tail++] = t;
+    pthread_mutex_unlock(&w->lock);
+    return 1;
+}
+
+// Le propriétaire prend la tâche la plus récente : exploration en profondeur,
+// peu d'états figés vivants à la fois
+static int pop_task(Worker *w, Task *t) {
+    int ok = 0;
+    pthread_mutex_lock(&w->lock);
+    if (w->tail > w->head) {
+        *t = w->tasks[--w->tail];
+        ok = 1;
+    }
+    if (w->tail == w->head) w->tail = w->head = 0;
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+// Un voleur prend la plus ancienne : la plus proche de la racine, donc le plus
+// gros sous-arbre
+static int steal_task(Worker *w, Task *t) {
+    Explorer *ex = w->ex;
+    w->rng = w->rng * 1664525u + 1013904223u;
+    int start = (int)(w->rng >> 16) % ex->count;
+    for (int k = 0; k < ex->count; k++) {
+        Worker *victim = &ex->workers[(start + k) % ex->count];
+        if (victim == w) continue;
+        pthread_mutex_lock(&victim->lock);
+        int ok = victim->tail > victim->head;
+        if (ok) *t = victim->tasks[victim->head++];
+        pthread_mutex_unlock(&victim->lock);
+        if (ok) {
+            w->stats.steals++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// --- États déjà vus ---
+
+static inline u64 mix(u64 h) {
+    h *= 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+}
+
+// Empreinte de l'état (registres sans les cycles, mémoire) et profondeur :
+// O(1), la mémoire de la branche tient son empreinte à jour à chaque écriture
+static u64 state_hash(const CPU *cpu, int depth) {
+    u64 h = mix(cpu_fingerprint(cpu) ^ (u64)depth);
+    return h ? h : 1;
+}
+
+// Vrai si l'état est nouveau (table pleine : considéré comme nouveau)
+static int seen_insert(Explorer *ex, u64 h) {
+    for (u64 i = h & ex->seen_mask, probes = 0; probes <= ex->seen_mask; i = (i + 1) & ex->seen_mask, probes++) {
+        u64 cur = __atomic_load_n(&ex->seen[i], __ATOMIC_RELAXED);
+        if (cur == 0) {
+            u64 expected = 0;
+            if (__atomic_compare_exchange_n(&ex->seen[i], &expected, h, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                return 1;
+            }
+            cur = expected;
+        }
+        if (cur == h) return 0;
+    }
+    return 1;
+}
+
+// --- Exécution ---
+
+// Jusqu'au prochain point de décision ou à la fin de la suite
+static int run_branch(const ExploreConfig *cfg, CPU *cpu, u64 *instructions) {
+    u64 limit = cpu->cycles + cfg->max_cycles;
+    for (;;) {
+        u16 pc = cpu->PC;
+        cpu_step(cpu);
+        (*instructions)++;
+        if (cpu->PC == cfg->decision_pc) return BRANCH_DECISION;
+        if (cpu->PC == cfg->stop_pc) return EXPLORE_STOP;
+        if (cpu->PC == pc) {
+            return cpu->ops[mem_peek(cpu->mem, pc)].instruction == NULL ? EXPLORE_HALT : EXPLORE_TRAP;
+        }
+        if (cpu->cycles >= limit) return EXPLORE_BUDGET;
+    }
+}
+
+static void report_leaf(Explorer *ex, Worker *w, const CPU *cpu, const u8 *inputs, int count, int end) {
+    w->stats.leaves++;
+    if (ex->cfg->leaf == NULL) return;
+    pthread_mutex_lock(&ex->leaf_lock);
+    ex->cfg->leaf(ex->cfg->ctx, cpu, inputs, count, end == BRANCH_DECISION ? EXPLORE_WAITING : (ExploreEnd)end);
+    pthread_mutex_unlock(&ex->leaf_lock);
+}
+
+// Fige l'état en point de décision et pousse une tâche par valeur d'entrée
+static void expand(Worker *w, ExploreNode *node) {
+    const ExploreConfig *cfg = w->ex->cfg;
+    node->refs = cfg->choices;
+    w->stats.forks++;
+    __atomic_add_fetch(&w->ex->pending, (u64)cfg->choices, __ATOMIC_ACQ_REL);
+    // Poussées à l'envers : la valeur 0 est prise en premier
+    for (int c = cfg->choices - 1; c >= 0; c--) {
+        if (!push_task(w, (Task){ node, c })) {
+            printf("Erreur : mémoire insuffisante pour les tâches d'exploration\n");
+            abort();
+        }
+    }
+}
+
+static void run_task(Worker *w, Task t) {
+    Explorer *ex = w->ex;
+    const ExploreConfig *cfg = ex->cfg;
+    ExploreNode *parent = t.node;
+
+    Memory *mem = branch_memory(w, parent);
+    if (mem == NULL) {
+        printf("Erreur : mémoire insuffisante pour l'exploration\n");
+        abort();
+    }
+    w->last_mem = NULL;
+    CPU cpu = parent->cpu;
+    cpu.mem = mem;
+    mem->pc = &cpu.op_pc;
+    mem_write(mem, cfg->input_address, (u8)t.choice);
+    int end = run_branch(cfg, &cpu, &w->stats.instructions);
+    w->stats.branches++;
+
+    u8 inputs[EXPLORE_MAX_DEPTH];
+    int depth = parent->depth + 1;
+    memcpy(inputs, parent->inputs, parent->depth);
+    inputs[parent->depth] = (u8)t.choice;
+    for (int page = 0; page < 256; page++) {
+        if (mem_page_private(mem, (u8)page)) w->stats.pages_copied++;
+    }
+
+    if (end == BRANCH_DECISION && depth < cfg->depth) {
+        if (cfg->dedup && !seen_insert(ex, state_hash(&cpu, depth))) {
+            w->stats.pruned++;
+            mem_release(w, mem);
+            w->last_mem = mem;
+            w->last_node = parent->id;
+        } else {
+            ExploreNode *node = aligned_alloc(64, sizeof(ExploreNode));
+            if (node == NULL) {
+                printf("Erreur : mémoire insuffisante pour l'exploration\n");
+                abort();
+            }
+            node->cpu = cpu;
+            node->mem = mem;
+            node->parent = parent;
+            node->depth = depth;
+            node->id = node_id(w);
+            memcpy(node->inputs, inputs, depth);
+            __atomic_add_fetch(&parent->refs, 1, __ATOMIC_ACQ_REL);
+            expand(w, node);
+        }
+    } else {
+        report_leaf(ex, w, &cpu, inputs, depth, end);
+        mem_release(w, mem);
+        w->last_mem = mem;
+        w->last_node = parent->id;
+    }
+    node_release(w, parent);
+    w->done++;
+}
+
+// Retire de ex->pending les tâches terminées : une fois par file vidée, pas à
+// chaque tâche (pending surestimé entre-temps, jamais sous-estimé)
+static void flush_done(Worker *w) {
+    if (w->done) {
+        __atomic_sub_fetch(&w->ex->pending, w->done, __ATOMIC_ACQ_REL);
+        w->done = 0;
+    }
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    Task t;
+    for (;;) {
+        if (pop_task(w, &t)) {
+            run_task(w, t);
+            continue;
+        }
+        flush_done(w);
+        if (steal_task(w, &t)) {
+            run_task(w, t);
+        } else if (__atomic_load_n(&w->ex->pending, __ATOMIC_ACQUIRE) == 0) {
+            break;
+        } else {
+            // Rien à voler pour l'instant : une autre branche va en pousser
+            nanosleep(&(struct timespec){ 0, 20000 }, NULL);
+        }
+    }
+    return NULL;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int explore_run(const ExploreConfig *cfg, const CPU *cpu, ExploreStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (cfg->choices < 1 || cfg->choices > 256 || cfg->depth < 1 || cfg->depth > EXPLORE_MAX_DEPTH) {
+        printf("Erreur : exploration de 1 a %d entrees de 1 a 256 valeurs\n", EXPLORE_MAX_DEPTH);
+        return 0;
+    }
+    const Memory *src = cpu->mem;
+    for (int page = 0; page < 256; page++) {
+        if ((src->page_flags[page] & ~(MEM_PAGE_ROM | MEM_PAGE_COW)) || src->code_write) {
+            printf("Erreur : exploration impossible avec des peripheriques, watchpoints ou blocs predecodes (page $%02X)\n",
+                   page);
+            return 0;
+        }
+    }
+
+    Explorer ex;
+    memset(&ex, 0, sizeof(ex));
+    ex.cfg = cfg;
+    ex.count = cfg->threads > 0 ? cfg->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (ex.count < 1) ex.count = 1;
+    int bits = cfg->table_bits > 0 ? cfg->table_bits : 20;
+    ex.seen_mask = (1ULL << bits) - 1;
+    ex.seen = cfg->dedup ? calloc(ex.seen_mask + 1, sizeof(u64)) : NULL;
+    ex.workers = aligned_alloc(64, ex.count * sizeof(Worker));
+    if ((cfg->dedup && ex.seen == NULL) || ex.workers == NULL) {
+        printf("Erreur : mémoire insuffisante pour l'exploration\n");
+        free(ex.seen);
+        free(ex.workers);
+        return 0;
+    }
+    memset(ex.workers, 0, ex.count * sizeof(Worker));
+    pthread_mutex_init(&ex.leaf_lock, NULL);
+    for (int i = 0; i < ex.count; i++) {
+        Worker *w = &ex.workers[i];
+        pthread_mutex_init(&w->lock, NULL);
+        w->ex = &ex;
+        w->id = i;
+        w->rng = 0x9E3779B9u * (u32)(i + 1);
+    }
+
+    double t0 = now_seconds();
+    // Racine : de l'état donné jusqu'au premier point de décision (sans entrée)
+    Worker *main_worker = &ex.workers[0];
+    ExploreNode *root = aligned_alloc(64, sizeof(ExploreNode));
+    Memory *mem = mem_acquire(main_worker);
+    if (root == NULL || mem == NULL) {
+        printf("Erreur : mémoire insuffisante pour l'exploration\n");
+        free(root);
+        free(mem);
+        free(ex.seen);
+        free(ex.workers);
+        return 0;
+    }
+    mem_copy(mem, src);
+    mem_set_hashing(mem, cfg->dedup); // Les branches héritent du réglage (mem_fork)
+    memset(root, 0, sizeof(*root));
+    root->id = node_id(main_worker);
+    root->cpu = *cpu;
+    root->cpu.mem = mem;
+    mem->pc = &root->cpu.op_pc;
+    root->mem = mem;
+    int end = cpu->PC == cfg->decision_pc ? BRANCH_DECISION
+                                          : run_branch(cfg, &root->cpu, &main_worker->stats.instructions);
+    if (end == BRANCH_DECISION) {
+        expand(main_worker, root);
+        for (int i = 0; i < ex.count; i++) {
+            if (pthread_create(&ex.workers[i].thread, NULL, worker_main, &ex.workers[i]) != 0) {
+                ex.workers[i].thread = 0;
+                if (i == 0) worker_main(&ex.workers[0]); // Au moins un thread
+            }
+        }
+        for (int i = 0; i < ex.count; i++) {
+            if (ex.workers[i].thread) pthread_join(ex.workers[i].thread, NULL);
+        }
+    } else {
+        report_leaf(&ex, main_worker, &root->cpu, root->inputs, 0, end);
+        mem_release(main_worker, mem);
+        free(root);
+    }
+    stats->seconds = now_seconds() - t0;
+
+    stats->threads = ex.count;
+    for (int i = 0; i < ex.count; i++) {
+        Worker *w = &ex.workers[i];
+        stats->branches += w->stats.branches;
+        stats->forks += w->stats.forks;
+        stats->leaves += w->stats.leaves;
+        stats->pruned += w->stats.pruned;
+        stats->instructions += w->stats.instructions;
+        stats->pages_copied += w->stats.pages_copied;
+        stats->steals += w->stats.steals;
+        for (int k = 0; k < w->pool_count; k++) free(w->pool[k]);
+        free(w->pool);
+        free(w->tasks);
+        pthread_mutex_destroy(&w->lock);
+    }
+    pthread_mutex_destroy(&ex.leaf_lock);
+    free(ex.seen);
+    free(ex.workers);
+    return 1;
+}
@@ -0,0 +1,413 @@
+#include "framebuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Police intégrée : ASCII $20-$7E, police 8x8 du domaine public
+// (font8x8_basic), bit 0 à gauche : retournée par fb_attach
+static const u8 builtin_font[95][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+    { 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 }, // !
+    { 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+    { 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 }, // #
+    { 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 }, // $
+    { 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 }, // %
+    { 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 }, // &
+    { 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+    { 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 }, // (
+    { 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 }, // )
+    { 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 }, // *
+    { 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 }, // +
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ,
+    { 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 }, // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // .
+    { 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 }, // /
+    { 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 }, // 0
+    { 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 }, // 1
+    { 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 }, // 2
+    { 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 }, // 3
+    { 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 }, // 4
+    { 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 }, // 5
+    { 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 }, // 6
+    { 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 }, // 7
+    { 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 }, // 8
+    { 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 }, // 9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // :
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // ;
+    { 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 }, // <
+    { 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 }, // =
+    { 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 }, // >
+    { 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 }, // ?
+    { 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 }, // @
+    { 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 }, // A
+    { 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 }, // B
+    { 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 }, // C
+    { 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 }, // D
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 }, // E
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 }, // F
+    { 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 }, // G
+    { 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 }, // H
+    { 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // I
+    { 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 }, // J
+    { 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 }, // K
+    { 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 }, // L
+    { 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 }, // M
+    { 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 }, // N
+    { 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 }, // O
+    { 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 }, // P
+    { 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 }, // Q
+    { 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 }, // R
+    { 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 }, // S
+    { 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // T
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 }, // U
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // V
+    { 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 }, // W
+    { 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 }, // X
+    { 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 }, // Y
+    { 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 }, // Z
+    { 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 }, // [
+    { 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 }, // '\'
+    { 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 }, // ]
+    { 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 }, // ^
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF }, // _
+    { 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 }, // `
+    { 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 }, // a
+    { 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 }, // b
+    { 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 }, // c
+    { 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 }, // d
+    { 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // e
+    { 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 }, // f
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // g
+    { 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 }, // h
+    { 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // i
+    { 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E }, // j
+    { 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 }, // k
+    { 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // l
+    { 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 }, // m
+    { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // n
+    { 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 }, // o
+    { 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F }, // p
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 }, // q
+    { 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 }, // r
+    { 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 }, // s
+    { 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 }, // t
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 }, // u
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // v
+    { 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 }, // w
+    { 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 }, // x
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // y
+    { 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 }, // z
+    { 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 }, // {
+    { 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 }, // |
+    { 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 }, // }
+    { 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ~
+};
+
+int fb_mode_from_name(const char *name) {
+    if (strcmp(name, "text") == 0) return FB_TEXT;
+    if (strcmp(name, "mono") == 0) return FB_MONO;
+    if (strcmp(name, "rgb332") == 0) return FB_RGB332;
+    return -1;
+}
+
+// Pixels RGB d'un octet : 8 pixels noirs ou blancs (bit 7 à gauche), ou un
+// pixel RRRGGGBB. Une copie par octet de l'écran.
+static u8 bits_rgb[256][24];
+static u8 rgb332[256][3];
+
+static void init_tables(void) {
+    if (bits_rgb[1][21]) return;
+    for (int v = 0; v < 256; v++) {
+        for (int b = 0; b < 8; b++) memset(bits_rgb[v] + 3 * b, (v >> (7 - b)) & 1 ? 0xFF : 0x00, 3);
+        rgb332[v][0] = (u8)((v >> 5) * 255 / 7);
+        rgb332[v][1] = (u8)(((v >> 2) & 7) * 255 / 7);
+        rgb332[v][2] = (u8)((v & 3) * 255 / 3);
+    }
+}
+
+// Écriture dans une page de l'écran (déjà faite dans la RAM)
+static void fb_write(void *ctx, u16 address, u8 value) {
+    (void)value;
+    Framebuffer *fb = (Framebuffer *)ctx;
+    u32 offset = (u16)(address - fb->base);
+    if (offset >= fb->size) return; // Dans une page de l'écran, hors de l'écran
+    fb->dirty[offset / fb->stride] = 1;
+    fb->dirty_any = 1;
+    fb->writes++;
+}
+
+int fb_attach(Framebuffer *fb, Memory *mem, u16 base, FbMode mode, int width, int height) {
+    memset(fb, 0, sizeof(*fb));
+    int pixel_width = mode == FB_TEXT ? width * 8 : width;
+    if (width <= 0 || height <= 0 || pixel_width > FB_MAX_WIDTH || height > MAX_MEMORY
+        || (mode == FB_MONO && width % 8)) {
+        printf("Erreur : taille d'ecran invalide %dx%d%s\n", width, height,
+               mode == FB_MONO ? " (largeur multiple de 8)" : "");
+        return 0;
+    }
+    fb->mode = mode;
+    fb->base = base;
+    fb->stride = mode == FB_MONO ? width / 8 : width;
+    fb->lines = height;
+    fb->line_height = mode == FB_TEXT ? 8 : 1;
+    fb->width = pixel_width;
+    fb->height = height * fb->line_height;
+    fb->size = (u32)fb->stride * (u32)fb->lines;
+    if (base + fb->size > MAX_MEMORY) {
+        printf("Erreur : l'ecran ($%04X, %u octets) depasse $FFFF\n", base, fb->size);
+        return 0;
+    }
+    int first = base >> 8, last = (base + fb->size - 1) >> 8;
+    for (int page = first; page <= last; page++) {
+        if (mem->io[page].read || mem->io[page].write) {
+            printf("Erreur : la page $%02X de l'ecran est deja prise (peripherique ou mapper)\n", page);
+            return 0;
+        }
+    }
+    init_tables();
+    fb->pixels = calloc((size_t)fb->height, 1 + 3 * (size_t)fb->width); // Filtres PNG à 0
+    fb->dirty = calloc((size_t)fb->lines, 1);
+    if (fb->pixels == NULL || fb->dirty == NULL) {
+        printf("Erreur : memoire insuffisante pour l'ecran\n");
+        fb_detach(fb);
+        return 0;
+    }
+    // Police intégrée, remise dans le sens d'un chargen
+    u8 font[128 * 8] = { 0 };
+    for (int c = 0; c < 95; c++) {
+        for (int y = 0; y < 8; y++) {
+            u8 bits = builtin_font[c][y], reversed = 0;
+            for (int b = 0; b < 8; b++) reversed |= (u8)(((bits >> b) & 1) << (7 - b));
+            font[(0x20 + c) * 8 + y] = reversed;
+        }
+    }
+    fb_set_font(fb, font, 128);
+    fb->mem = mem;
+    mem_trap_writes(mem, (u8)first, (u8)last, fb_write, fb);
+    return 1;
+}
+
+void fb_detach(Framebuffer *fb) {
+    if (fb->mem) mem_trap_writes(fb->mem, fb->base >> 8, (u8)((fb->base + fb->size - 1) >> 8), NULL, NULL);
+    free(fb->pixels);
+    free(fb->dirty);
+    fb->pixels = NULL;
+    fb->dirty = NULL;
+    fb->mem = NULL;
+}
+
+void fb_set_font(Framebuffer *fb, const u8 *font, int glyph_count) {
+    if (glyph_count > 256) glyph_count = 256;
+    memset(fb->glyphs, 0, sizeof(fb->glyphs));
+    memcpy(fb->glyphs, font, (size_t)glyph_count * 8);
+    if (glyph_count <= 128) {
+        for (int i = 0; i < 128 * 8; i++) fb->glyphs[128 * 8 + i] = (u8)~fb->glyphs[i];
+    }
+    fb_invalidate(fb);
+}
+
+int fb_load_font(Framebuffer *fb, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", path);
+        return 0;
+    }
+    u8 font[256 * 8];
+    size_t n = fread(font, 1, sizeof(font), f);
+    fclose(f);
+    if (n < 8) {
+        printf("Erreur : %s n'est pas une police 8x8 (8 octets par glyphe)\n", path);
+        return 0;
+    }
+    fb_set_font(fb, font, (int)(n / 8));
+    return 1;
+}
+
+void fb_invalidate(Framebuffer *fb) {
+    if (fb->dirty == NULL) return;
+    memset(fb->dirty, 1, (size_t)fb->lines);
+    fb->dirty_any = 1;
+}
+
+// --- Rendu ---
+
+static void render_line(Framebuffer *fb, int line) {
+    size_t row_bytes = 1 + 3 * (size_t)fb->width;
+    u16 address = (u16)(fb->base + line * fb->stride);
+    for (int y = 0; y < fb->line_height; y++) {
+        u8 *out = fb->pixels + (size_t)(line * fb->line_height + y) * row_bytes + 1;
+        const u8 *glyph_row = fb->glyphs + y;
+        for (int i = 0; i < fb->stride; i++) {
+            u8 v = mem_peek(fb->mem, (u16)(address + i));
+            switch (fb->mode) {
+            case FB_TEXT:
+                memcpy(out, bits_rgb[glyph_row[v * 8]], 24);
+                out += 24;
+                break;
+            case FB_MONO:
+                memcpy(out, bits_rgb[v], 24);
+                out += 24;
+                break;
+            case FB_RGB332:
+                memcpy(out, rgb332[v], 3);
+                out += 3;
+                break;
+            }
+        }
+    }
+}
+
+int fb_render(Framebuffer *fb) {
+    if (!fb->dirty_any) return 0;
+    int count = 0;
+    for (int line = 0; line < fb->lines; line++) {
+        if (!fb->dirty[line]) continue;
+        fb->dirty[line] = 0;
+        render_line(fb, line);
+        count++;
+    }
+    fb->dirty_any = 0;
+    fb->lines_rendered += count;
+    fb->renders++;
+    return count;
+}
+
+// --- Fichiers ---
+
+int fb_write_ppm(const Framebuffer *fb, FILE *out) {
+    fprintf(out, "P6\n%d %d\n255\n", fb->width, fb->height);
+    size_t row_bytes = 1 + 3 * (size_t)fb->width;
+    for (int y = 0; y < fb->height; y++) {
+        if (fwrite(fb->pixels + y * row_bytes + 1, 1, row_bytes - 1, out) != row_bytes - 1) return 0;
+    }
+    return 1;
+}
+
+int fb_write_text(const Framebuffer *fb, FILE *out) {
+    if (fb->mode != FB_TEXT) {
+        printf("Erreur : capture texte d'un ecran graphique\n");
+        return 0;
+    }
+    for (int line = 0; line < fb->lines; line++) {
+        for (int i = 0; i < fb->stride; i++) {
+            u8 c = mem_peek(fb->mem, (u16)(fb->base + line * fb->stride + i)) & 0x7F;
+            fputc(c >= 0x20 && c < 0x7F ? c : '.', out);
+        }
+        fputc('\n', out);
+    }
+    return 1;
+}
+
+// PNG : CRC-32 des chunks, Adler-32 du flux zlib
+static u32 crc_table[256];
+
+static u32 crc32_update(u32 crc, const u8 *p, size_t n) {
+    if (crc_table[1] == 0) {
+        for (u32 i = 0; i < 256; i++) {
+            u32 c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[i] = c;
+        }
+    }
+    crc = ~crc;
+    while (n--) crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static u32 adler32_update(u32 adler, const u8 *p, size_t n) {
+    u32 a = adler & 0xFFFF, b = adler >> 16;
+    while (n > 0) {
+        size_t chunk = n < 5552 ? n : 5552; // Pas de débordement de b avant le modulo
+        n -= chunk;
+        while (chunk--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
+
+static void put_be32(u8 *p, u32 v) {
+    p[0] = (u8)(v >> 24);
+    p[1] = (u8)(v >> 16);
+    p[2] = (u8)(v >> 8);
+    p[3] = (u8)v;
+}
+
+// Morceau de chunk : écrit et ajouté au CRC
+static int chunk_part(FILE *out, u32 *crc, const u8 *data, size_t n) {
+    *crc = crc32_update(*crc, data, n);
+    return fwrite(data, 1, n, out) == n;
+}
+
+static int chunk_begin(FILE *out, u32 *crc, const char *type, u32 length) {
+    u8 head[4];
+    put_be32(head, length);
+    *crc = 0;
+    return fwrite(head, 1, 4, out) == 4 && chunk_part(out, crc, (const u8 *)type, 4);
+}
+
+static int chunk_end(FILE *out, u32 crc) {
+    u8 tail[4];
+    put_be32(tail, crc);
+    return fwrite(tail, 1, 4, out) == 4;
+}
+
+// Les lignes de l'image (filtre 0 + RGB) forment directement les données
+// zlib : blocs deflate "stored" de 65535 octets au plus, sans compression
+int fb_write_png(const Framebuffer *fb, FILE *out) {
+    static const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    size_t raw = (size_t)fb->height * (1 + 3 * (size_t)fb->width);
+    size_t blocks = (raw + 65534) / 65535;
+    u32 crc;
+    u8 ihdr[13] = { 0 };
+    put_be32(ihdr, (u32)fb->width);
+    put_be32(ihdr + 4, (u32)fb->height);
+    ihdr[8] = 8; // Bits par composante
+    ihdr[9] = 2; // RGB
+    if (fwrite(signature, 1, 8, out) != 8 || !chunk_begin(out, &crc, "IHDR", 13)
+        || !chunk_part(out, &crc, ihdr, 13) || !chunk_end(out, crc)) {
+        return 0;
+    }
+
+    static const u8 zlib_header[2] = { 0x78, 0x01 };
+    if (!chunk_begin(out, &crc, "IDAT", (u32)(2 + 5 * blocks + raw + 4))
+        || !chunk_part(out, &crc, zlib_header, 2)) {
+        return 0;
+    }
+    u32 adler = 1;
+    for (size_t done = 0; done < raw;) {
+        size_t n = raw - done < 65535 ? raw - done : 65535;
+        u8 head[5] = { done + n == raw ? 1 : 0, (u8)n, (u8)(n >> 8), (u8)~n, (u8)(~n >> 8) };
+        if (!chunk_part(out, &crc, head, 5) || !chunk_part(out, &crc, fb->pixels + done, n)) return 0;
+        adler = adler32_update(adler, fb->pixels + done, n);
+        done += n;
+    }
+    u8 trailer[4];
+    put_be32(trailer, adler);
+    return chunk_part(out, &crc, trailer, 4) && chunk_end(out, crc)
+        && chunk_begin(out, &crc, "IEND", 0) && chunk_end(out, crc);
+}
+
+int fb_save(Framebuffer *fb, const char *path) {
+    fb_render(fb);
+    const char *ext = strrchr(path, '.');
+    int text = ext && strcmp(ext, ".txt") == 0;
+    if (text && fb->mode != FB_TEXT) {
+        printf("Erreur : capture texte (%s) d'un ecran graphique\n", path);
+        return 0;
+    }
+    FILE *out = fopen(path, "wb");
+    if (out == NULL) {
+        printf("Erreur : Impossible de creer le fichier %s\n", path);
+        return 0;
+    }
+    int ok;
+    if (ext && strcmp(ext, ".ppm") == 0) ok = fb_write_ppm(fb, out);
+    else if (text) ok = fb_write_text(fb, out);
+    else ok = fb_write_png(fb, out);
+    if (fclose(out) != 0) ok = 0;
+    if (!ok) printf("Erreur : ecriture de %s\n", path);
+    return ok;
+}
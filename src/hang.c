@@ -0,0 +1,43 @@
+#include "hang.h"
+
+// Le repère devient l'état courant
+static void move_mark(HangDetector *h, const CPU *cpu, u64 print) {
+    h->mark = print;
+    h->mark_cycles = cpu->cycles;
+    h->mark_pc = cpu->PC;
+    h->steps = 0;
+    if (h->power < HANG_MAX_POWER) h->power *= 2;
+}
+
+void hang_init(HangDetector *h, const CPU *cpu) {
+    h->power = 1;
+    h->last_pc = cpu->PC;
+    h->self_valid = 0;
+    h->period_cycles = 0;
+    h->period_steps = 0;
+    move_mark(h, cpu, cpu_fingerprint(cpu));
+}
+
+int hang_check_self(HangDetector *h, const CPU *cpu) {
+    u64 print = cpu_fingerprint(cpu);
+    if (h->self_valid && print == h->self_print) {
+        h->period_cycles = cpu->cycles - h->self_cycles;
+        h->period_steps = 1;
+        return 1;
+    }
+    h->self_print = print;
+    h->self_cycles = cpu->cycles;
+    h->self_valid = 1;
+    return 0;
+}
+
+int hang_check_mark(HangDetector *h, const CPU *cpu) {
+    u64 print = cpu_fingerprint(cpu);
+    if (cpu->PC == h->mark_pc && print == h->mark) {
+        h->period_cycles = cpu->cycles - h->mark_cycles;
+        h->period_steps = h->steps;
+        return 1;
+    }
+    if (h->steps >= h->power) move_mark(h, cpu, print);
+    return 0;
+}
@@ -0,0 +1,244 @@
+#include "hostcall.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// --- Mémoire invitée ---
+
+u16 hostcall_word(Memory *mem, u16 address) {
+    return (u16)(mem_peek(mem, address) | mem_peek(mem, (u16)(address + 1)) << 8);
+}
+
+u8 *hostcall_view(Memory *mem, u16 address, u32 len, int writing) {
+    if (len == 0 || address + len > MAX_MEMORY) return NULL;
+    int first = address >> 8, last = (int)((address + len - 1) >> 8);
+    u8 slow = writing ? MEM_SLOW_WRITE : MEM_SLOW_READ;
+    u8 *base = mem->page[first];
+    for (int page = first; page <= last; page++) {
+        if ((mem->page_flags[page] & slow) || mem->page[page] != base + (page - first) * 256) return NULL;
+    }
+    return base + (address & 0xFF);
+}
+
+const u8 *hostcall_source(HostCall *hc, u16 address, u32 len) {
+    Memory *mem = hc->cpu->mem;
+    const u8 *view = hostcall_view(mem, address, len, 0);
+    if (view) {
+        hc->bytes_direct += len;
+        return view;
+    }
+    for (u32 i = 0; i < len; i++) hc->bounce[i] = mem_read(mem, (u16)(address + i));
+    hc->bytes_copied += len;
+    return hc->bounce;
+}
+
+// Vue directe : les octets sont retirés de l'empreinte ici et remis par
+// hostcall_commit, qu'ils aient changé ou non
+u8 *hostcall_target(HostCall *hc, u16 address, u32 len) {
+    Memory *mem = hc->cpu->mem;
+    u8 *view = hostcall_view(mem, address, len, 1);
+    if (view == NULL) return hc->bounce;
+    for (u32 i = 0; i < len && mem->hashing; i++) mem->hash ^= mem_byte_hash((u16)(address + i), view[i]);
+    return view;
+}
+
+void hostcall_commit(HostCall *hc, u16 address, u32 len, u32 written, u8 *target) {
+    Memory *mem = hc->cpu->mem;
+    if (target == hc->bounce) {
+        for (u32 i = 0; i < written; i++) mem_write(mem, (u16)(address + i), target[i]);
+        hc->bytes_copied += written;
+        return;
+    }
+    for (u32 i = 0; i < len && mem->hashing; i++) mem->hash ^= mem_byte_hash((u16)(address + i), target[i]);
+    hc->bytes_direct += written;
+}
+
+// Chaîne terminée par 0 (size octets au plus, 0 compris)
+static int guest_string(Memory *mem, u16 address, char *out, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        out[i] = (char)mem_peek(mem, (u16)(address + i));
+        if (out[i] == '\0') return 1;
+    }
+    return 0;
+}
+
+static int guest_file(const HostCall *hc, u8 handle) {
+    return handle < HOSTCALL_MAX_FILES ? hc->fds[handle] : -1;
+}
+
+// --- Services intégrés ---
+
+static long hc_exit(HostCall *hc, CPU *cpu, void *ctx) {
+    (void)ctx;
+    hc->exited = 1;
+    hc->exit_code = cpu->X;
+    return 0;
+}
+
+static long hc_write(HostCall *hc, CPU *cpu, void *ctx) {
+    (void)ctx;
+    u16 block = hostcall_block(cpu);
+    int fd = guest_file(hc, mem_peek(cpu->mem, block));
+    u16 address = hostcall_word(cpu->mem, (u16)(block + 1));
+    u16 len = hostcall_word(cpu->mem, (u16)(block + 3));
+    if (fd < 0) return -EBADF;
+    if (address + len > MAX_MEMORY) return -EFAULT;
+    const u8 *src = hostcall_source(hc, address, len);
+    if (fd == STDOUT_FILENO || fd == STDERR_FILENO) fflush(stdout); // Après les messages de l'émulateur
+    long done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, src + done, len - (size_t)done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return done ? done : -errno;
+        done += n;
+    }
+    return done;
+}
+
+// Au plus len octets de fd vers la mémoire invitée (plusieurs read jusqu'à
+// la fin du fichier si 'fill')
+static long read_into(HostCall *hc, int fd, u16 address, u16 len, int fill) {
+    u8 *dst = hostcall_target(hc, address, len);
+    long done = 0;
+    int error = 0;
+    while (done < len) {
+        ssize_t n = read(fd, dst + done, len - (size_t)done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) error = errno;
+        if (n <= 0) break;
+        done += n;
+        if (!fill) break;
+    }
+    hostcall_commit(hc, address, len, (u32)done, dst);
+    return done == 0 && error ? -error : done;
+}
+
+static long hc_read(HostCall *hc, CPU *cpu, void *ctx) {
+    (void)ctx;
+    u16 block = hostcall_block(cpu);
+    int fd = guest_file(hc, mem_peek(cpu->mem, block));
+    u16 address = hostcall_word(cpu->mem, (u16)(block + 1));
+    u16 len = hostcall_word(cpu->mem, (u16)(block + 3));
+    if (fd < 0) return -EBADF;
+    if (address + len > MAX_MEMORY) return -EFAULT;
+    return read_into(hc, fd, address, len, 0);
+}
+
+static long hc_open(HostCall *hc, CPU *cpu, void *ctx) {
+    (void)ctx;
+    static const int flags[3] = { O_RDONLY, O_WRONLY | O_CREAT | O_TRUNC, O_WRONLY | O_CREAT | O_APPEND };
+    u16 block = hostcall_block(cpu);
+    char path[256];
+    u8 mode = mem_peek(cpu->mem, (u16)(block + 2));
+    if (!guest_string(cpu->mem, hostcall_word(cpu->mem, block), path, sizeof(path))) return -ENAMETOOLONG;
+    if (mode > 2) return -EINVAL;
+    int handle = 3;
+    while (handle < HOSTCALL_MAX_FILES && hc->fds[handle] >= 0) handle++;
+    if (handle == HOSTCALL_MAX_FILES) return -EMFILE;
+    int fd = open(path, flags[mode], 0644);
+    if (fd < 0) return -errno;
+    hc->fds[handle] = fd;
+    return handle;
+}
+
+static long hc_close(HostCall *hc, CPU *cpu, void *ctx) {
+    (void)ctx;
+    int fd = guest_file(hc, cpu->X);
+    if (fd < 0) return -EBADF;
+    if (cpu->X > STDERR_FILENO) close(fd); // Les fichiers standard restent ouverts pour l'émulateur
+    hc->fds[cpu->X] = -1;
+    return 0;
+}
+
+static long hc_load(HostCall *hc, CPU *cpu, void *ctx) {
+    (void)ctx;
+    u16 block = hostcall_block(cpu);
+    char path[256];
+    u16 address = hostcall_word(cpu->mem, (u16)(block + 2));
+    u16 max = hostcall_word(cpu->mem, (u16)(block + 4));
+    if (!guest_string(cpu->mem, hostcall_word(cpu->mem, block), path, sizeof(path))) return -ENAMETOOLONG;
+    if (address + max > MAX_MEMORY) return -EFAULT;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -errno;
+    long r = read_into(hc, fd, address, max, 1);
+    close(fd);
+    return r;
+}
+
+static long hc_time(HostCall *hc, CPU *cpu, void *ctx) {
+    (void)ctx;
+    u16 block = hostcall_block(cpu);
+    if (block + 16 > MAX_MEMORY) return -EFAULT;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    u64 values[2] = { (u64)ts.tv_sec * 1000000 + (u64)ts.tv_nsec / 1000, cpu->cycles };
+    u8 *dst = hostcall_target(hc, block, 16);
+    for (int i = 0; i < 16; i++) dst[i] = (u8)(values[i / 8] >> (8 * (i % 8)));
+    hostcall_commit(hc, block, 16, 16, dst);
+    return 0;
+}
+
+// --- Porte ---
+
+void hostcall_attach(HostCall *hc, Memory *mem, u8 page, CPU *cpu) {
+    memset(hc, 0, sizeof(*hc));
+    hc->cpu = cpu;
+    for (int i = 0; i < HOSTCALL_MAX_FILES; i++) hc->fds[i] = i <= STDERR_FILENO ? i : -1;
+    hostcall_register(hc, HC_EXIT, hc_exit, NULL);
+    hostcall_register(hc, HC_WRITE, hc_write, NULL);
+    hostcall_register(hc, HC_READ, hc_read, NULL);
+    hostcall_register(hc, HC_OPEN, hc_open, NULL);
+    hostcall_register(hc, HC_CLOSE, hc_close, NULL);
+    hostcall_register(hc, HC_LOAD, hc_load, NULL);
+    hostcall_register(hc, HC_TIME, hc_time, NULL);
+    mem_map_io(mem, page, page, hostcall_read, hostcall_write, hc);
+}
+
+void hostcall_close_all(HostCall *hc) {
+    for (int i = STDERR_FILENO + 1; i < HOSTCALL_MAX_FILES; i++) {
+        if (hc->fds[i] >= 0) close(hc->fds[i]);
+        hc->fds[i] = -1;
+    }
+}
+
+void hostcall_register(HostCall *hc, u8 service, HostCallFunc fn, void *ctx) {
+    hc->services[service] = fn;
+    hc->service_ctx[service] = ctx;
+}
+
+u8 hostcall_read(void *ctx, u16 address) {
+    HostCall *hc = (HostCall *)ctx;
+    switch (address & 0x07) {
+    case HC_RESULT_LO: return (u8)hc->result;
+    case HC_RESULT_HI: return (u8)(hc->result >> 8);
+    case HC_ERRNO: return hc->error;
+    default: return 0;
+    }
+}
+
+// Le service s'exécute pendant l'écriture : l'instruction (STA, STX...) a
+// déjà lu ses registres, elle n'en modifie plus aucun
+void hostcall_write(void *ctx, u16 address, u8 value) {
+    HostCall *hc = (HostCall *)ctx;
+    if ((address & 0x07) != HC_CALL) return;
+    CPU *cpu = hc->cpu;
+    hc->calls++;
+    HostCallFunc fn = hc->services[value];
+    long r = fn ? fn(hc, cpu, hc->service_ctx[value]) : -ENOSYS;
+    if (r < 0) {
+        hc->result = 0;
+        hc->error = (u8)-r;
+        cpu->A = hc->error;
+        cpu->X = 0;
+        cpu->P |= FLAG_C;
+    } else {
+        hc->result = (u16)r;
+        hc->error = 0;
+        cpu->A = (u8)r;
+        cpu->X = (u8)(r >> 8);
+        cpu->P &= ~FLAG_C;
+    }
+}
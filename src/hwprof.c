@@ -0,0 +1,238 @@
+#include "hwprof.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HWPROF_HAVE_TSC 1
+#else
+#define HWPROF_HAVE_TSC 0
+#endif
+
+#define CALIBRATION_RUNS 2000
+
+static const char *event_names[HWPROF_EVENT_COUNT] = { "cycles", "instructions", "branch-misses", "L1d-misses" };
+
+static int open_event(u32 type, u64 config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0; // Le groupe est activé d'un coup
+    attr.exclude_kernel = 1;   // Le read() des mesures n'est compté que côté utilisateur
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static int available(const HwProfile *p, int e) {
+    return p->slot[e] >= 0 || (e == HWPROF_CYCLES && p->tsc);
+}
+
+static inline void read_group(const HwProfile *p, u64 *values) {
+    u64 buf[1 + HWPROF_EVENT_COUNT];
+    if (p->group < 0 || read(p->group, buf, sizeof(buf)) < (ssize_t)((1 + p->nr) * sizeof(u64))) return;
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) {
+        if (p->slot[e] >= 0) values[e] = buf[1 + p->slot[e]];
+    }
+}
+
+static inline u64 read_tsc(void) {
+#if HWPROF_HAVE_TSC
+    _mm_lfence();
+    u64 t = __rdtsc();
+    _mm_lfence();
+    return t;
+#else
+    return 0;
+#endif
+}
+
+// Le TSC est lu au plus près de l'instruction, à l'intérieur des lectures du groupe
+static inline void snap_begin(const HwProfile *p, u64 *values) {
+    read_group(p, values);
+    if (p->tsc) values[HWPROF_CYCLES] = read_tsc();
+}
+
+static inline void snap_end(const HwProfile *p, u64 *values) {
+    if (p->tsc) values[HWPROF_CYCLES] = read_tsc();
+    read_group(p, values);
+}
+
+// Intervalle jusqu'au prochain échantillon : uniforme dans [1, 2 x période - 1]
+static u32 next_gap(HwProfile *p) {
+    p->rng ^= p->rng << 13;
+    p->rng ^= p->rng >> 17;
+    p->rng ^= p->rng << 5;
+    return 1 + p->rng % (2 * p->period - 1);
+}
+
+int hwprof_open(HwProfile *p, u32 period) {
+    static const struct { u32 type; u64 config; } events[HWPROF_EVENT_COUNT] = {
+        [HWPROF_CYCLES]        = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        [HWPROF_INSTRUCTIONS]  = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        [HWPROF_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        [HWPROF_L1D_MISSES]    = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                   | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    };
+    memset(p, 0, sizeof(*p));
+    p->group = -1;
+    int error = 0;
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) {
+        p->fd[e] = open_event(events[e].type, events[e].config, p->group);
+        p->slot[e] = -1;
+        if (p->fd[e] < 0) {
+            if (!error) error = errno;
+            continue;
+        }
+        if (p->group < 0) p->group = p->fd[e];
+        p->slot[e] = p->nr++;
+    }
+    p->tsc = p->slot[HWPROF_CYCLES] < 0 && HWPROF_HAVE_TSC;
+    if (p->group < 0 && !p->tsc) {
+        printf("Erreur : compteurs materiels indisponibles (perf_event_open : %s, voir /proc/sys/kernel/perf_event_paranoid)\n",
+               strerror(error));
+        return 0;
+    }
+    if (p->group >= 0) {
+        ioctl(p->group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(p->group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    p->period = period ? period : 1;
+    p->rng = 0x9E3779B9u;
+    p->countdown = next_gap(p);
+
+    // Étalonnage : coût moyen d'une mesure sans instruction entre les deux lectures
+    double sum[HWPROF_EVENT_COUNT] = { 0 };
+    for (int i = 0; i < CALIBRATION_RUNS + CALIBRATION_RUNS / 10; i++) {
+        u64 before[HWPROF_EVENT_COUNT] = { 0 }, after[HWPROF_EVENT_COUNT] = { 0 };
+        snap_begin(p, before);
+        snap_end(p, after);
+        if (i < CALIBRATION_RUNS / 10) continue; // Chauffe
+        for (int e = 0; e < HWPROF_EVENT_COUNT; e++) sum[e] += (double)(after[e] - before[e]);
+    }
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) p->baseline[e] = sum[e] / CALIBRATION_RUNS;
+    return 1;
+}
+
+void hwprof_close(HwProfile *p) {
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) {
+        if (p->slot[e] >= 0) close(p->fd[e]);
+        p->slot[e] = -1;
+    }
+    p->group = -1;
+}
+
+void hwprof_sample(HwProfile *p, CPU *cpu) {
+    HwprofOpcode *op = &p->ops[mem_peek(cpu->mem, cpu->PC)];
+    u64 before[HWPROF_EVENT_COUNT] = { 0 }, after[HWPROF_EVENT_COUNT] = { 0 };
+    snap_begin(p, before);
+    cpu_step(cpu);
+    snap_end(p, after);
+
+    op->count++;
+    op->samples++;
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) {
+        op->sum[e] += (double)(after[e] - before[e]) - p->baseline[e];
+    }
+    p->samples++;
+    p->countdown = next_gap(p);
+}
+
+// --- Rapport ---
+
+// Coût total estimé (moyenne échantillonnée x exécutions) et exécutions couvertes
+typedef struct {
+    const char *name;
+    u64 count, measured; // measured : exécutions des opcodes échantillonnés
+    double cost[HWPROF_EVENT_COUNT];
+} HwprofLine;
+
+static void add_opcode(HwprofLine *line, const HwprofOpcode *op) {
+    line->count += op->count;
+    if (op->samples == 0) return;
+    line->measured += op->count;
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) line->cost[e] += op->sum[e] / op->samples * op->count;
+}
+
+static void print_line(const HwProfile *p, const HwprofLine *line, const HwprofLine *total, int indent,
+                       const char *label, FILE *out) {
+    double share = total->cost[HWPROF_CYCLES] > 0 ? 100.0 * line->cost[HWPROF_CYCLES] / total->cost[HWPROF_CYCLES] : 0.0;
+    fprintf(out, "%*s%-*s %11llu %6.1f%%", indent, "", 30 - indent, label, (unsigned long long)line->count, share);
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) {
+        if (!available(p, e) || line->measured == 0) {
+            fprintf(out, " %12s", "-");
+        } else {
+            fprintf(out, " %12.3f", line->cost[e] / line->measured);
+        }
+    }
+    fprintf(out, "\n");
+}
+
+static int by_cost(const void *a, const void *b) {
+    double ca = ((const HwprofLine *)a)->cost[HWPROF_CYCLES], cb = ((const HwprofLine *)b)->cost[HWPROF_CYCLES];
+    return (ca < cb) - (ca > cb);
+}
+
+void hwprof_report(const HwProfile *p, CpuVariant variant, FILE *out) {
+    const MachineDesc *machine = cpu_machine(variant);
+    HwprofLine total = { "Total", 0, 0, { 0 } };
+    for (int op = 0; op < 256; op++) add_opcode(&total, &p->ops[op]);
+
+    fprintf(out, "\n=== Profil materiel par opcode (--hwprof) ===\n");
+    fprintf(out, "Echantillons : %llu sur %llu instructions emulees (1 sur %u en moyenne)\n",
+            (unsigned long long)p->samples, (unsigned long long)total.count, p->period);
+    fprintf(out, "Compteurs :");
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) {
+        if (e == HWPROF_CYCLES && p->tsc) fprintf(out, " cycles (TSC, compteur materiel indisponible)");
+        else fprintf(out, " %s%s", event_names[e], available(p, e) ? "" : " (indisponible)");
+        fprintf(out, "%s", e + 1 < HWPROF_EVENT_COUNT ? "," : "\n");
+    }
+    fprintf(out, "Mesure a vide deduite :");
+    for (int e = 0; e < HWPROF_EVENT_COUNT; e++) {
+        if (available(p, e)) fprintf(out, " %s %.1f", event_names[e], p->baseline[e]);
+    }
+    fprintf(out, "\nValeurs par instruction emulee, temps = part des cycles hote estimes\n");
+    fprintf(out, "%-30s %11s %7s %12s %12s %12s %12s\n", "", "executions", "temps", "cycles/i",
+            "instr/i", "br-miss/i", "L1d-miss/i");
+    print_line(p, &total, &total, 0, "Total", out);
+
+    // Regroupement par handler (plusieurs modes d'adressage par handler)
+    HwprofLine handlers[256];
+    int count = 0;
+    for (int op = 0; op < 256; op++) {
+        const char *name = machine->symbols[op].instruction;
+        if (name == NULL || p->ops[op].count == 0) continue;
+        int h = 0;
+        while (h < count && strcmp(handlers[h].name, name) != 0) h++;
+        if (h == count) handlers[count++] = (HwprofLine){ name, 0, 0, { 0 } };
+        add_opcode(&handlers[h], &p->ops[op]);
+    }
+    qsort(handlers, count, sizeof(HwprofLine), by_cost);
+
+    for (int h = 0; h < count; h++) {
+        print_line(p, &handlers[h], &total, 2, handlers[h].name, out);
+        HwprofLine opcodes[256];
+        char labels[256][40];
+        int n = 0;
+        for (int op = 0; op < 256; op++) {
+            const char *name = machine->symbols[op].instruction;
+            if (name == NULL || p->ops[op].count == 0 || strcmp(name, handlers[h].name) != 0) continue;
+            // "B1 LDA (ZP),Y indirect_y" (mode sans le préfixe addr_)
+            snprintf(labels[n], sizeof(labels[n]), "%02X %-10s %s", op, machine->ops[op].name,
+                     machine->symbols[op].addrmode + 5);
+            opcodes[n] = (HwprofLine){ labels[n], 0, 0, { 0 } };
+            add_opcode(&opcodes[n], &p->ops[op]);
+            n++;
+        }
+        qsort(opcodes, n, sizeof(HwprofLine), by_cost);
+        for (int i = 0; i < n; i++) {
+            print_line(p, &opcodes[i], &total, 4, opcodes[i].name, out);
+        }
+    }
+}
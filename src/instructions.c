@@ -1,40 +1,41 @@
 #include "instructions.h"
 #include <stdio.h>
 // LDA : Charge une valeur dans A
-void ins_LDA(CPU *cpu) {
-    cpu->A = cpu->fetched; // La valeur a été calculée par l'adressage
+void ins_LDA(CPU *cpu, u16 addr) {
+    cpu->A = mem_read(cpu->mem, addr); // L'adresse a été calculée par l'adressage
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
 }
 
 // LDX : Charge une valeur dans X
-void ins_LDX(CPU *cpu) {
-    cpu->X = cpu->fetched;
+void ins_LDX(CPU *cpu, u16 addr) {
+    cpu->X = mem_read(cpu->mem, addr);
     cpu_set_flag(cpu, FLAG_Z, cpu->X == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->X & 0x80) != 0);
 }
 
 // STA : Stocke A en mémoire
-void ins_STA(CPU *cpu) {
-    // Pour STA, on n'a pas besoin de 'fetched' (lecture),
-    // on utilise l'adresse calculée 'addr_abs'
-    mem_write(cpu->mem, cpu->addr_abs, cpu->A);
+void ins_STA(CPU *cpu, u16 addr) {
+    // Pas de lecture pour STA : on écrit à l'adresse calculée
+    mem_write(cpu->mem, addr, cpu->A);
 }
 
 // NOP : Ne rien faire
-void ins_NOP(CPU *cpu) {
-    (void)cpu; // Evite le warning
+void ins_NOP(CPU *cpu, u16 addr) {
+    (void)cpu; (void)addr; // Evite le warning
 }
 
 // --- Transferts ---
 
-void ins_TAX(CPU *cpu) {
+void ins_TAX(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->X = cpu->A;
     cpu_set_flag(cpu, FLAG_Z, cpu->X == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->X & 0x80) != 0);
 }
 
-void ins_TXA(CPU *cpu) {
+void ins_TXA(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->A = cpu->X;
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
@@ -42,7 +43,8 @@ void ins_TXA(CPU *cpu) {
 
 // --- Incréments ---
 
-void ins_INX(CPU *cpu) {
+void ins_INX(CPU *cpu, u16 addr) {
+    (void)addr;
     //printf("[DEBUG] INX appelé ! X passe de %d à %d\n", cpu->X, cpu->X + 1);
 
     cpu->X++;
@@ -50,49 +52,52 @@ void ins_INX(CPU *cpu) {
     cpu_set_flag(cpu, FLAG_N, (cpu->X & 0x80) != 0);
 }
 
-void ins_DEX(CPU *cpu) {
+void ins_DEX(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->X--;
     cpu_set_flag(cpu, FLAG_Z, cpu->X == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->X & 0x80) != 0);
 }
 
 // --- Branchements ---
-// Pour ces instructions, addr_abs a déjà été calculée par addr_relative
+// Pour ces instructions, addr est la cible calculée par addr_relative
 
-void ins_BEQ(CPU *cpu) {
+void ins_BEQ(CPU *cpu, u16 addr) {
     if (cpu_get_flag(cpu, FLAG_Z)) {
-        cpu->PC = cpu->addr_abs; // On saute !
+        cpu->PC = addr; // On saute !
         cpu->cycles++; // Un cycle de plus car on a pris le saut
     }
 }
 
-void ins_BNE(CPU *cpu) {
+void ins_BNE(CPU *cpu, u16 addr) {
     // DEBUG : Si on est à l'adresse 36BC (le blocage)
     if (cpu->PC == 0x36C0) { // PC a avancé après D0 FE
         //printf("[BNE DEBUT] P = 0x%02X (Flag Z = %d)\n", cpu->P, cpu_get_flag(cpu, FLAG_Z));
     }
 
     if (!cpu_get_flag(cpu, FLAG_Z)) {
-        cpu->PC = cpu->addr_abs;
+        cpu->PC = addr;
         cpu->cycles++;
     }
 }
 
 // --- Contrôle ---
 
-void ins_JMP(CPU *cpu) {
-    // Pour JMP, addr_abs a été calculée par addr_absolute
-    cpu->PC = cpu->addr_abs;
+void ins_JMP(CPU *cpu, u16 addr) {
+    // Pour JMP, addr a été calculée par addr_absolute
+    cpu->PC = addr;
 }
 
 // --- Instructions Pile ---
 
 // PHA : Push Accumulator
-void ins_PHA(CPU *cpu) {
+void ins_PHA(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu_push_byte(cpu, cpu->A);
 }
 
-void ins_PLA(CPU *cpu) {
+void ins_PLA(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->A = cpu_pull_byte(cpu);
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
@@ -101,17 +106,18 @@ void ins_PLA(CPU *cpu) {
 // --- Instructions Sous-Programmes ---
 
 // JSR : Jump to SubRoutine (Appel de fonction)
-void ins_JSR(CPU *cpu) {
-    // addr_abs a été calculée par addr_absolute
+void ins_JSR(CPU *cpu, u16 addr) {
+    // addr a été calculée par addr_absolute
     // On doit pousser PC-1 sur la pile (standard 6502)
     cpu_push_word(cpu, cpu->PC - 1);
     
     // Sauter à l'adresse
-    cpu->PC = cpu->addr_abs;
+    cpu->PC = addr;
 }
 
 // RTS : ReTurn from Subroutine (Retour de fonction)
-void ins_RTS(CPU *cpu) {
+void ins_RTS(CPU *cpu, u16 addr) {
+    (void)addr;
     // Retirer l'adresse de la pile
     u16 return_addr = cpu_pull_word(cpu);
     
@@ -119,83 +125,147 @@ void ins_RTS(CPU *cpu) {
     cpu->PC = return_addr + 1;
 }
 // --- Arithmétique ---
+// Le cœur binaire est commun ; le mode décimal dépend de la variante :
+// NMOS (Z binaire, N/V intermédiaires), 65C02 (N/Z du résultat BCD, +1 cycle),
+// 2A03 (pas de mode décimal du tout).
 
-void ins_ADC(CPU *cpu) {
-    u8 value = cpu->fetched;
+static void adc_binary(CPU *cpu, u8 value) {
     u16 sum = (u16)cpu->A + (u16)value + (u16)cpu_get_flag(cpu, FLAG_C);
 
     // Mise à jour des flags
     cpu_set_flag(cpu, FLAG_C, sum > 0xFF);       // Carry si résultat > 255
     cpu_set_flag(cpu, FLAG_Z, (sum & 0x00FF) == 0); // Zero
     cpu_set_flag(cpu, FLAG_N, sum & 0x80);       // Négatif (bit 7)
-    
+
     // Overflow (V) : Si le signe du résultat est incorrect par rapport aux opérandes
     // Formule complexe simplifiée : V = (A ^ resultat) & (valeur ^ resultat) & 0x80
-cpu_set_flag(cpu, FLAG_V, ((~(cpu->A ^ value) & (cpu->A ^ sum) & 0x80) != 0));
+    cpu_set_flag(cpu, FLAG_V, ((~(cpu->A ^ value) & (cpu->A ^ sum) & 0x80) != 0));
     cpu->A = sum & 0xFF; // On garde l'octet bas
 }
-void ins_SBC(CPU *cpu) {
-    u8 value = cpu->fetched;
+
+static void sbc_binary(CPU *cpu, u8 value) {
+    u16 sub = (u16)cpu->A - (u16)value - (1 - (u16)cpu_get_flag(cpu, FLAG_C));
+    cpu_set_flag(cpu, FLAG_C, sub < 0x100);
+    cpu_set_flag(cpu, FLAG_Z, (sub & 0x00FF) == 0);
+    cpu_set_flag(cpu, FLAG_N, sub & 0x80);
+    cpu_set_flag(cpu, FLAG_V, ((cpu->A ^ value) & (cpu->A ^ sub) & 0x80));
+    cpu->A = sub & 0xFF;
+}
+
+// Addition BCD, avant la correction finale des dizaines.
+// Retourne la somme intermédiaire (utilisée pour N et V).
+static int adc_decimal_partial(CPU *cpu, u8 value) {
+    int lo = (cpu->A & 0x0F) + (value & 0x0F) + cpu_get_flag(cpu, FLAG_C);
+    if (lo > 0x09) lo = ((lo + 0x06) & 0x0F) + 0x10;
+    return (cpu->A & 0xF0) + (value & 0xF0) + lo;
+}
+
+// Applique la correction des dizaines, met à jour V et C, et range le résultat dans A
+static void adc_decimal_finish(CPU *cpu, u8 value, int sum) {
+    cpu_set_flag(cpu, FLAG_V, (~(cpu->A ^ value) & (cpu->A ^ sum) & 0x80) != 0);
+    if (sum > 0x9F) sum += 0x60;
+    cpu_set_flag(cpu, FLAG_C, sum > 0xFF);
+    cpu->A = sum & 0xFF;
+}
+
+// Soustraction BCD : résultat seulement (les flags sont ceux du binaire sur NMOS)
+static u8 sbc_decimal_nmos(CPU *cpu, u8 value) {
+    int c = cpu_get_flag(cpu, FLAG_C);
+    int lo = (cpu->A & 0x0F) - (value & 0x0F) + c - 1;
+    if (lo < 0) lo = ((lo - 0x06) & 0x0F) - 0x10;
+    int diff = (cpu->A & 0xF0) - (value & 0xF0) + lo;
+    if (diff < 0) diff -= 0x60;
+    return diff & 0xFF;
+}
+
+// ADC (NMOS)
+void ins_ADC(CPU *cpu, u16 addr) {
+    u8 value = mem_read(cpu->mem, addr);
+
+    // Vérifie si le mode Décimal (BCD) est actif
+    if (cpu_get_flag(cpu, FLAG_D)) {
+        int sum = adc_decimal_partial(cpu, value);
+        // Sur NMOS, Z vient de l'addition binaire et N du résultat intermédiaire
+        cpu_set_flag(cpu, FLAG_Z, ((cpu->A + value + cpu_get_flag(cpu, FLAG_C)) & 0xFF) == 0);
+        cpu_set_flag(cpu, FLAG_N, sum & 0x80);
+        adc_decimal_finish(cpu, value, sum);
+    } else {
+        adc_binary(cpu, value);
+    }
+}
+
+// SBC (NMOS)
+void ins_SBC(CPU *cpu, u16 addr) {
+    u8 value = mem_read(cpu->mem, addr);
 
     // Vérifie si le mode Décimal (BCD) est actif
     if (cpu_get_flag(cpu, FLAG_D)) {
-        // Soustraction BCD (Decimal)
-        // Algorithme simplifié mais efficace pour passer les tests
-        int diff = (cpu->A & 0x0F) - (value & 0x0F) - (1 - cpu_get_flag(cpu, FLAG_C));
-        if (diff < 0) diff -= 6;
-        int al = diff;
-        diff = (cpu->A >> 4) - (value >> 4) + (al >> 4); // Ajoute la retenue négative
-        if (diff < 0) diff -= 6;
-        
-        // Mise à jour des flags
-        cpu_set_flag(cpu, FLAG_Z, ((cpu->A - value - (1 - cpu_get_flag(cpu, FLAG_C))) & 0xFF) == 0);
-        cpu_set_flag(cpu, FLAG_N, diff & 0x80);
-        cpu_set_flag(cpu, FLAG_C, diff <= 0); // Carry inversé
-        
-        cpu->A = ((diff << 4) | (al & 0x0F)) & 0xFF;
-        
-        // En BCD, le flag V n'est pas défini de la même manière, on le met souvent à 0 ou on le laisse
-        cpu_set_flag(cpu, FLAG_V, 0); 
+        // Soustraction BCD (Decimal) : les flags sont ceux de la soustraction binaire
+        u8 result = sbc_decimal_nmos(cpu, value);
+        sbc_binary(cpu, value);
+        cpu->A = result;
+    } else {
+        sbc_binary(cpu, value);
+    }
+}
+
+// ADC / SBC du 2A03 : le flag D existe mais n'a aucun effet
+void ins_ADC_BIN(CPU *cpu, u16 addr) {
+    adc_binary(cpu, mem_read(cpu->mem, addr));
+}
+
+void ins_SBC_BIN(CPU *cpu, u16 addr) {
+    sbc_binary(cpu, mem_read(cpu->mem, addr));
+}
+
+// ADC du 65C02 : N et Z reflètent le résultat BCD, et le mode décimal coûte un cycle
+void ins_ADC_CMOS(CPU *cpu, u16 addr) {
+    u8 value = mem_read(cpu->mem, addr);
+
+    if (cpu_get_flag(cpu, FLAG_D)) {
+        adc_decimal_finish(cpu, value, adc_decimal_partial(cpu, value));
+        cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
+        cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
+        cpu->cycles++;
+    } else {
+        adc_binary(cpu, value);
+    }
+}
+
+// SBC du 65C02 : C et V du binaire, N et Z du résultat BCD
+void ins_SBC_CMOS(CPU *cpu, u16 addr) {
+    u8 value = mem_read(cpu->mem, addr);
+
+    if (cpu_get_flag(cpu, FLAG_D)) {
+        int c = cpu_get_flag(cpu, FLAG_C);
+        int lo = (cpu->A & 0x0F) - (value & 0x0F) + c - 1;
+        int diff = cpu->A - value + c - 1;
+        if (diff < 0) diff -= 0x60;
+        if (lo < 0) diff -= 0x06;
+
+        sbc_binary(cpu, value);
+        cpu->A = diff & 0xFF;
+        cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
+        cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
+        cpu->cycles++;
     } else {
-        // Soustraction Binaire (Ton code normal)
-        u16 sub = (u16)cpu->A - (u16)value - (1 - (u16)cpu_get_flag(cpu, FLAG_C));
-        cpu_set_flag(cpu, FLAG_C, sub < 0x100);
-        cpu_set_flag(cpu, FLAG_Z, (sub & 0x00FF) == 0);
-        cpu_set_flag(cpu, FLAG_N, sub & 0x80);
-        cpu_set_flag(cpu, FLAG_V, ((cpu->A ^ value) & (cpu->A ^ sub) & 0x80));
-        cpu->A = sub & 0xFF;
+        sbc_binary(cpu, value);
     }
 }
 
 // --- Comparaison ---
 // Compare un registre avec une valeur. Le registre n'est pas modifié.
 // Flags : Z (égalité), C (Registre >= Valeur), N (Signe du résultat)
-void ins_CMP(CPU *cpu) {
-    u8 value = cpu->fetched;
-    //u8 value = mem_read(cpu->mem, cpu->addr_abs);
+void ins_CMP(CPU *cpu, u16 addr) {
+    u8 value = mem_read(cpu->mem, addr);
     u16 result = (u16)cpu->A - (u16)value;
 
-    // --- DEBUG TEMPORAIRE ---
-    // Si A vaut 0x9A et que le résultat n'est pas zéro, il y a un bug
-    if (cpu->A == 0x9A && result != 0) {
-        printf("\n[DEBUG CMP] A: 0x%02X, Fetched: 0x%02X, Result: 0x%04X\n", 
-               cpu->A, value, result);
-        printf("Addr lue: 0x%04X\n", cpu->addr_abs);
-    }
-    // ------------------------
-
     cpu_set_flag(cpu, FLAG_C, cpu->A >= value);
     cpu_set_flag(cpu, FLAG_Z, result == 0);
     cpu_set_flag(cpu, FLAG_N, result & 0x80);
-
-     // DEBUG : Afficher si on est au point de blocage
-    if (cpu->PC == 0x36BC || cpu->PC == 0x36BD) { 
-        printf("\n[DEBUG TEST 96] PC: 0x%04X | A: 0x%02X | Fetched: 0x%02X | Addr: 0x%04X\n", 
-               cpu->PC, cpu->A, value, cpu->addr_abs);
-    }
 }
-void ins_CPX(CPU *cpu) {
-    u8 value = cpu->fetched;
+void ins_CPX(CPU *cpu, u16 addr) {
+    u8 value = mem_read(cpu->mem, addr);
     u16 result = (u16)cpu->X - (u16)value;
 
     cpu_set_flag(cpu, FLAG_C, cpu->X >= value);
@@ -203,8 +273,8 @@ void ins_CPX(CPU *cpu) {
     cpu_set_flag(cpu, FLAG_N, result & 0x80);
 }
 
-void ins_CPY(CPU *cpu) {
-    u8 value = cpu->fetched;
+void ins_CPY(CPU *cpu, u16 addr) {
+    u8 value = mem_read(cpu->mem, addr);
     u16 result = (u16)cpu->Y - (u16)value;
 
     cpu_set_flag(cpu, FLAG_C, cpu->Y >= value);
@@ -214,82 +284,91 @@ void ins_CPY(CPU *cpu) {
 
 // --- Logique ---
 
-void ins_AND(CPU *cpu) {
-    cpu->A = cpu->A & cpu->fetched;
+void ins_AND(CPU *cpu, u16 addr) {
+    cpu->A = cpu->A & mem_read(cpu->mem, addr);
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
 }
 
-void ins_ORA(CPU *cpu) {
-    cpu->A = cpu->A | cpu->fetched;
+void ins_ORA(CPU *cpu, u16 addr) {
+    cpu->A = cpu->A | mem_read(cpu->mem, addr);
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
 }
 
-void ins_EOR(CPU *cpu) {
-    cpu->A = cpu->A ^ cpu->fetched;
+void ins_EOR(CPU *cpu, u16 addr) {
+    cpu->A = cpu->A ^ mem_read(cpu->mem, addr);
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
 }
 
 // --- Drapeaux (Flags) ---
 
-void ins_CLC(CPU *cpu) { cpu_set_flag(cpu, FLAG_C, 0); } // Clear Carry
-void ins_SEC(CPU *cpu) { cpu_set_flag(cpu, FLAG_C, 1); } // Set Carry
-void ins_CLD(CPU *cpu) { cpu_set_flag(cpu, FLAG_D, 0); } // Clear Decimal
-void ins_SED(CPU *cpu) { cpu_set_flag(cpu, FLAG_D, 1); } // Set Decimal
-void ins_CLI(CPU *cpu) { cpu_set_flag(cpu, FLAG_I, 0); } // Clear Interrupt
-void ins_SEI(CPU *cpu) { cpu_set_flag(cpu, FLAG_I, 1); } // Set Interrupt
-void ins_CLV(CPU *cpu) { cpu_set_flag(cpu, FLAG_V, 0); } // Clear Overflow
+void ins_CLC(CPU *cpu, u16 addr) { (void)addr; cpu_set_flag(cpu, FLAG_C, 0); } // Clear Carry
+void ins_SEC(CPU *cpu, u16 addr) { (void)addr; cpu_set_flag(cpu, FLAG_C, 1); } // Set Carry
+void ins_CLD(CPU *cpu, u16 addr) { (void)addr; cpu_set_flag(cpu, FLAG_D, 0); } // Clear Decimal
+void ins_SED(CPU *cpu, u16 addr) { (void)addr; cpu_set_flag(cpu, FLAG_D, 1); } // Set Decimal
+// I change après la scrutation des interruptions : effet retardé d'une instruction
+static inline void set_i_delayed(CPU *cpu, u8 p) {
+    if ((p ^ cpu->P) & FLAG_I) cpu->events |= CPU_EVENT_I_DELAY;
+    cpu->P = p;
+}
+
+void ins_CLI(CPU *cpu, u16 addr) { (void)addr; set_i_delayed(cpu, cpu->P & ~FLAG_I); } // Clear Interrupt
+void ins_SEI(CPU *cpu, u16 addr) { (void)addr; set_i_delayed(cpu, cpu->P | FLAG_I); } // Set Interrupt
+void ins_CLV(CPU *cpu, u16 addr) { (void)addr; cpu_set_flag(cpu, FLAG_V, 0); } // Clear Overflow
 
 // --- Registre Y ---
 
-void ins_LDY(CPU *cpu) {
-    cpu->Y = cpu->fetched;
+void ins_LDY(CPU *cpu, u16 addr) {
+    cpu->Y = mem_read(cpu->mem, addr);
     cpu_set_flag(cpu, FLAG_Z, cpu->Y == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->Y & 0x80) != 0);
 }
 
-void ins_STY(CPU *cpu) {
-    mem_write(cpu->mem, cpu->addr_abs, cpu->Y);
+void ins_STY(CPU *cpu, u16 addr) {
+    mem_write(cpu->mem, addr, cpu->Y);
 }
 
-void ins_INY(CPU *cpu) {
+void ins_INY(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->Y++;
     cpu_set_flag(cpu, FLAG_Z, cpu->Y == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->Y & 0x80) != 0);
 }
 
-void ins_DEY(CPU *cpu) {
+void ins_DEY(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->Y--;
     cpu_set_flag(cpu, FLAG_Z, cpu->Y == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->Y & 0x80) != 0);
 }
 
 // --- Mémoire INC/DEC ---
-// C'est spécial : on lit la valeur, on modifie, et on réécrit dans addr_abs
+// C'est spécial : on lit la valeur, on modifie, et on réécrit à la même adresse
 
-void ins_INC(CPU *cpu) {
-    u8 val = cpu->fetched;
+void ins_INC(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
     val++;
     cpu_set_flag(cpu, FLAG_Z, val == 0);
     cpu_set_flag(cpu, FLAG_N, (val & 0x80) != 0);
     
     // Réécrire en mémoire
-    mem_write(cpu->mem, cpu->addr_abs, val);
+    mem_write(cpu->mem, addr, val);
 }
 
-void ins_DEC(CPU *cpu) {
-    u8 val = cpu->fetched;
+void ins_DEC(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
     val--;
     cpu_set_flag(cpu, FLAG_Z, val == 0);
     cpu_set_flag(cpu, FLAG_N, (val & 0x80) != 0);
     
-    mem_write(cpu->mem, cpu->addr_abs, val);
+    mem_write(cpu->mem, addr, val);
 }
 
 // --- Bits (Shifts) ---// 1. ASL Accumulator (pour le registre A)
-void ins_ASL_ACC(CPU *cpu) {
+void ins_ASL_ACC(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu_set_flag(cpu, FLAG_C, (cpu->A & 0x80) != 0);
     cpu->A = cpu->A << 1;
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
@@ -297,17 +376,18 @@ void ins_ASL_ACC(CPU *cpu) {
 }
 
 // 2. ASL Mémoire (pour une adresse)
-void ins_ASL(CPU *cpu) {
-    u8 val = cpu->fetched;
+void ins_ASL(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
     cpu_set_flag(cpu, FLAG_C, (val & 0x80) != 0);
     val = val << 1;
     cpu_set_flag(cpu, FLAG_Z, val == 0);
     cpu_set_flag(cpu, FLAG_N, (val & 0x80) != 0);
-    mem_write(cpu->mem, cpu->addr_abs, val);
+    mem_write(cpu->mem, addr, val);
 }
 
 // 3. LSR Accumulator
-void ins_LSR_ACC(CPU *cpu) {
+void ins_LSR_ACC(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu_set_flag(cpu, FLAG_C, (cpu->A & 0x01) != 0); 
     cpu->A = cpu->A >> 1;
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
@@ -315,17 +395,18 @@ void ins_LSR_ACC(CPU *cpu) {
 }
 
 // 4. LSR Mémoire
-void ins_LSR(CPU *cpu) {
-    u8 val = cpu->fetched;
+void ins_LSR(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
     cpu_set_flag(cpu, FLAG_C, (val & 0x01) != 0);
     val = val >> 1;
     cpu_set_flag(cpu, FLAG_Z, val == 0);
     cpu_set_flag(cpu, FLAG_N, 0);
-    mem_write(cpu->mem, cpu->addr_abs, val);
+    mem_write(cpu->mem, addr, val);
 }
 
 // BRK : Interruption logicielle (Opcode 0x00)
-void ins_BRK(CPU *cpu) {
+void ins_BRK(CPU *cpu, u16 addr) {
+(void)addr;
 u16 pc_to_save = cpu->PC + 1;
 cpu_push_byte(cpu, (pc_to_save >> 8) & 0xFF);
 cpu_push_byte(cpu, pc_to_save & 0xFF);
@@ -336,7 +417,8 @@ u16 hi = mem_read(cpu->mem, 0xFFFF);
 cpu->PC = (hi << 8) | lo;
 }
 
-void ins_RTI(CPU *cpu) {
+void ins_RTI(CPU *cpu, u16 addr) {
+(void)addr;
 u8 status = cpu_pull_byte(cpu);
 cpu->P = (status & 0xEF) | 0x20;
 u8 lo = cpu_pull_byte(cpu);
@@ -344,25 +426,29 @@ u8 hi = cpu_pull_byte(cpu);
 cpu->PC = (hi << 8) | lo;
 }
 
-void ins_TXS(CPU *cpu) {
+void ins_TXS(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->SP = cpu->X;
 }
 
-void ins_TSX(CPU *cpu) {
+void ins_TSX(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->X = cpu->SP;
     cpu_set_flag(cpu, FLAG_Z, cpu->X == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->X & 0x80) != 0);
 }
 
 // TYA : Transfer Y to Accumulator
-void ins_TYA(CPU *cpu) {
+void ins_TYA(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->A = cpu->Y;
     cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
 }
 
 // TAY : Transfer Accumulator to Y
-void ins_TAY(CPU *cpu) {
+void ins_TAY(CPU *cpu, u16 addr) {
+    (void)addr;
     cpu->Y = cpu->A;
     cpu_set_flag(cpu, FLAG_Z, cpu->Y == 0);
     cpu_set_flag(cpu, FLAG_N, (cpu->Y & 0x80) != 0);
@@ -371,66 +457,68 @@ void ins_TAY(CPU *cpu) {
 // --- Branchements Conditionnels (Suite) ---
 
 // BPL (10) : Branch if Plus (N == 0)
-void ins_BPL(CPU *cpu) {
+void ins_BPL(CPU *cpu, u16 addr) {
     if (!cpu_get_flag(cpu, FLAG_N)) {
-        cpu->PC = cpu->addr_abs;
+        cpu->PC = addr;
         cpu->cycles++;
     }
 }
 
 // BMI (30) : Branch if Minus (N == 1)
-void ins_BMI(CPU *cpu) {
+void ins_BMI(CPU *cpu, u16 addr) {
     if (cpu_get_flag(cpu, FLAG_N)) {
-        cpu->PC = cpu->addr_abs;
+        cpu->PC = addr;
         cpu->cycles++;
     }
 }
 
 // BCS (B0) : Branch if Carry Set (C == 1)
-void ins_BCS(CPU *cpu) {
+void ins_BCS(CPU *cpu, u16 addr) {
     if (cpu_get_flag(cpu, FLAG_C)) {
-        cpu->PC = cpu->addr_abs;
+        cpu->PC = addr;
         cpu->cycles++;
     }
 }
 
 // BCC (90) : Branch if Carry Clear (C == 0)
-void ins_BCC(CPU *cpu) {
+void ins_BCC(CPU *cpu, u16 addr) {
     if (!cpu_get_flag(cpu, FLAG_C)) {
-        cpu->PC = cpu->addr_abs;
+        cpu->PC = addr;
         cpu->cycles++;
     }
 }
 
 // BVS (70) : Branch if Overflow Set (V == 1)
-void ins_BVS(CPU *cpu) {
+void ins_BVS(CPU *cpu, u16 addr) {
     if (cpu_get_flag(cpu, FLAG_V)) {
-        cpu->PC = cpu->addr_abs;
+        cpu->PC = addr;
         cpu->cycles++;
     }
 }
 
 // BVC (50) : Branch if Overflow Clear (V == 0)
-void ins_BVC(CPU *cpu) {
+void ins_BVC(CPU *cpu, u16 addr) {
     if (!cpu_get_flag(cpu, FLAG_V)) {
-        cpu->PC = cpu->addr_abs;
+        cpu->PC = addr;
         cpu->cycles++;
     }
 }
 
 // PLP : Pull Processor Status (Restaure les flags depuis la pile)
-void ins_PLP(CPU *cpu) {
+void ins_PLP(CPU *cpu, u16 addr) {
+(void)addr;
 u8 val = cpu_pull_byte(cpu);
-cpu->P = (val & 0xEF) | 0x20;
+set_i_delayed(cpu, (val & 0xEF) | 0x20);
 }
 // PHP : Push Processor Status (Sauvegarde les flags sur la pile)
-void ins_PHP(CPU *cpu) {
+void ins_PHP(CPU *cpu, u16 addr) {
+(void)addr;
 cpu_push_byte(cpu, cpu->P | 0x30);
 }
 
 // --- BIT (Bit Test) ---
-void ins_BIT(CPU *cpu) {
-    u8 val = cpu->fetched;
+void ins_BIT(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
     
     // Le test BIT met à jour N et V selon les bits 7 et 6 de la mémoire lue
     cpu_set_flag(cpu, FLAG_N, (val & 0x80) != 0); // Bit 7 -> N
@@ -442,7 +530,8 @@ void ins_BIT(CPU *cpu) {
 
 // --- ROL (Rotate Left) ---
 // Décalage à gauche, le bit 7 va dans Carry, Carry va dans le bit 0
-void ins_ROL_ACC(CPU *cpu) {
+void ins_ROL_ACC(CPU *cpu, u16 addr) {
+    (void)addr;
     u8 val = cpu->A;
     u8 new_carry = (val & 0x80) != 0;
     val = (val << 1) | cpu_get_flag(cpu, FLAG_C); // Insère l'ancien carry
@@ -453,20 +542,21 @@ void ins_ROL_ACC(CPU *cpu) {
     cpu->A = val;
 }
 
-void ins_ROL(CPU *cpu) {
-    u8 val = cpu->fetched;
+void ins_ROL(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
     u8 new_carry = (val & 0x80) != 0;
     val = (val << 1) | cpu_get_flag(cpu, FLAG_C);
     
     cpu_set_flag(cpu, FLAG_C, new_carry);
     cpu_set_flag(cpu, FLAG_Z, val == 0);
     cpu_set_flag(cpu, FLAG_N, (val & 0x80) != 0);
-    mem_write(cpu->mem, cpu->addr_abs, val);
+    mem_write(cpu->mem, addr, val);
 }
 
 // --- ROR (Rotate Right) ---
 // Décalage à droite, le bit 0 va dans Carry, Carry va dans le bit 7
-void ins_ROR_ACC(CPU *cpu) {
+void ins_ROR_ACC(CPU *cpu, u16 addr) {
+    (void)addr;
     u8 val = cpu->A;
     u8 new_carry = val & 0x01;
     val = (val >> 1) | (cpu_get_flag(cpu, FLAG_C) << 7); // Insère l'ancien carry au bit 7
@@ -477,16 +567,131 @@ void ins_ROR_ACC(CPU *cpu) {
     cpu->A = val;
 }
 // STX : Store X Register
-void ins_STX(CPU *cpu) {
-    mem_write(cpu->mem, cpu->addr_abs, cpu->X);
+void ins_STX(CPU *cpu, u16 addr) {
+    mem_write(cpu->mem, addr, cpu->X);
 }
-void ins_ROR(CPU *cpu) {
-    u8 val = cpu->fetched;
+void ins_ROR(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
     u8 new_carry = val & 0x01;
     val = (val >> 1) | (cpu_get_flag(cpu, FLAG_C) << 7);
     
     cpu_set_flag(cpu, FLAG_C, new_carry);
     cpu_set_flag(cpu, FLAG_Z, val == 0);
     cpu_set_flag(cpu, FLAG_N, (val & 0x80) != 0);
-    mem_write(cpu->mem, cpu->addr_abs, val);
-}
\ No newline at end of file
+    mem_write(cpu->mem, addr, val);
+}
+
+// --- Variantes 65C02 ---
+
+// BRK du 65C02 : identique, mais le mode décimal est effacé
+void ins_BRK_CMOS(CPU *cpu, u16 addr) {
+    ins_BRK(cpu, addr);
+    cpu_set_flag(cpu, FLAG_D, 0);
+}
+
+// BRA : Branch Always
+void ins_BRA(CPU *cpu, u16 addr) {
+    cpu->PC = addr;
+    cpu->cycles++;
+}
+
+void ins_PHX(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu_push_byte(cpu, cpu->X);
+}
+
+void ins_PLX(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu->X = cpu_pull_byte(cpu);
+    cpu_set_flag(cpu, FLAG_Z, cpu->X == 0);
+    cpu_set_flag(cpu, FLAG_N, (cpu->X & 0x80) != 0);
+}
+
+void ins_PHY(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu_push_byte(cpu, cpu->Y);
+}
+
+void ins_PLY(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu->Y = cpu_pull_byte(cpu);
+    cpu_set_flag(cpu, FLAG_Z, cpu->Y == 0);
+    cpu_set_flag(cpu, FLAG_N, (cpu->Y & 0x80) != 0);
+}
+
+// STZ : Store Zero
+void ins_STZ(CPU *cpu, u16 addr) {
+    mem_write(cpu->mem, addr, 0);
+}
+
+void ins_INC_ACC(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu->A++;
+    cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
+    cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
+}
+
+void ins_DEC_ACC(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu->A--;
+    cpu_set_flag(cpu, FLAG_Z, cpu->A == 0);
+    cpu_set_flag(cpu, FLAG_N, (cpu->A & 0x80) != 0);
+}
+
+// TSB : Z = (A AND M) == 0, puis M = M OR A
+void ins_TSB(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
+    cpu_set_flag(cpu, FLAG_Z, (cpu->A & val) == 0);
+    mem_write(cpu->mem, addr, val | cpu->A);
+}
+
+// TRB : Z = (A AND M) == 0, puis M = M AND NOT A
+void ins_TRB(CPU *cpu, u16 addr) {
+    u8 val = mem_read(cpu->mem, addr);
+    cpu_set_flag(cpu, FLAG_Z, (cpu->A & val) == 0);
+    mem_write(cpu->mem, addr, val & ~cpu->A);
+}
+
+// BIT #imm : contrairement aux autres modes, N et V ne sont pas touchés
+void ins_BIT_IMM(CPU *cpu, u16 addr) {
+    cpu_set_flag(cpu, FLAG_Z, (cpu->A & mem_read(cpu->mem, addr)) == 0);
+}
+
+// WAI et STP : PC passe l'instruction, l'attente se fait dans
+// cpu_service_events (une interruption empile l'adresse qui suit WAI)
+void ins_WAI(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu->events |= CPU_EVENT_WAIT;
+}
+
+void ins_STP(CPU *cpu, u16 addr) {
+    (void)addr;
+    cpu->events |= CPU_EVENT_STOP;
+}
+
+// Branchement de BBR/BBS : l'offset est le dernier octet de l'instruction
+static inline void zp_branch(CPU *cpu, int taken) {
+    if (taken) {
+        cpu->PC += (s8)mem_read(cpu->mem, cpu->PC - 1);
+        cpu->cycles++;
+    }
+}
+
+#define DEFINE_BIT_OPS(n)                                                                        \
+    void ins_RMB##n(CPU *cpu, u16 addr) {                                                        \
+        mem_write(cpu->mem, addr, mem_read(cpu->mem, addr) & ~(1 << n));                         \
+    }                                                                                            \
+    void ins_SMB##n(CPU *cpu, u16 addr) {                                                        \
+        mem_write(cpu->mem, addr, mem_read(cpu->mem, addr) | (1 << n));                          \
+    }                                                                                            \
+    void ins_BBR##n(CPU *cpu, u16 addr) { zp_branch(cpu, !(mem_read(cpu->mem, addr) & (1 << n))); } \
+    void ins_BBS##n(CPU *cpu, u16 addr) { zp_branch(cpu, (mem_read(cpu->mem, addr) & (1 << n)) != 0); }
+
+DEFINE_BIT_OPS(0)
+DEFINE_BIT_OPS(1)
+DEFINE_BIT_OPS(2)
+DEFINE_BIT_OPS(3)
+DEFINE_BIT_OPS(4)
+DEFINE_BIT_OPS(5)
+DEFINE_BIT_OPS(6)
+DEFINE_BIT_OPS(7)
@@ -0,0 +1,117 @@
+#include "irqlat.h"
+#include <string.h>
+
+void irqlat_init(IrqLatency *l) {
+    memset(l, 0, sizeof(*l));
+    for (int s = 0; s < IRQLAT_SOURCES; s++) {
+        l->irq[s].min = UINT64_MAX;
+        l->nmi[s].min = UINT64_MAX;
+    }
+}
+
+static int bucket(u64 latency) {
+    if (latency < IRQLAT_EXACT) return (int)latency;
+    // [2^k, 2^(k+1)) -> IRQLAT_EXACT + k - IRQLAT_EXACT_BITS
+    return IRQLAT_EXACT + (63 - __builtin_clzll(latency)) - IRQLAT_EXACT_BITS;
+}
+
+static void record(IrqLatencyStats *st, u64 latency) {
+    st->count++;
+    st->sum += latency;
+    if (latency < st->min) st->min = latency;
+    if (latency > st->max) st->max = latency;
+    st->hist[bucket(latency)]++;
+}
+
+void irqlat_irq_lines(IrqLatency *l, u8 rose, u8 fell, u64 when) {
+    for (int s = 0; s < IRQLAT_SOURCES; s++) {
+        u8 bit = (u8)(1 << s);
+        if (fell & bit & l->irq_waiting) l->irq[s].dropped++;
+        if (rose & bit) l->irq_since[s] = when;
+    }
+    l->irq_waiting = (u8)((l->irq_waiting & ~fell) | rose);
+}
+
+void irqlat_nmi_rise(IrqLatency *l, u8 rose, int edge, u64 when) {
+    if (!edge || l->nmi_waiting) { // Pas de front, ou fondu dans la NMI en attente
+        for (int s = 0; s < IRQLAT_SOURCES; s++) {
+            if (rose & (1 << s)) l->nmi[s].dropped++;
+        }
+        return;
+    }
+    l->nmi_waiting = rose;
+    l->nmi_since = when;
+}
+
+void irqlat_irq_taken(IrqLatency *l, u8 lines, u64 now) {
+    u8 served = l->irq_waiting & lines;
+    for (int s = 0; s < IRQLAT_SOURCES; s++) {
+        if (served & (1 << s)) record(&l->irq[s], now - l->irq_since[s]);
+    }
+    l->irq_waiting &= ~served;
+}
+
+void irqlat_nmi_taken(IrqLatency *l, u64 now) {
+    for (int s = 0; s < IRQLAT_SOURCES; s++) {
+        if (l->nmi_waiting & (1 << s)) record(&l->nmi[s], now - l->nmi_since);
+    }
+    l->nmi_waiting = 0;
+}
+
+// --- Rapport ---
+
+static void report_source(const char *kind, int s, const IrqLatencyStats *st, FILE *out) {
+    if (st->count == 0 && st->dropped == 0) return;
+    const char *note = strcmp(kind, "NMI") == 0 && (1 << s) == CPU_NMI_PULSE ? " (impulsion)" : "";
+    if (st->count == 0) {
+        fprintf(out, "%s %d%-13s %10s %10llu\n", kind, s, note, "0", (unsigned long long)st->dropped);
+        return;
+    }
+    fprintf(out, "%s %d%-13s %10llu %10llu %8llu %9.1f %8llu\n", kind, s, note, (unsigned long long)st->count,
+            (unsigned long long)st->dropped, (unsigned long long)st->min, (double)st->sum / st->count,
+            (unsigned long long)st->max);
+}
+
+static void report_histogram(const char *kind, int s, const IrqLatencyStats *st, FILE *out) {
+    if (st->count == 0) return;
+    u64 peak = 0;
+    for (int b = 0; b < IRQLAT_BUCKETS; b++) {
+        if (st->hist[b] > peak) peak = st->hist[b];
+    }
+    fprintf(out, "\n%s %d : latence (cycles) -> interruptions\n", kind, s);
+    for (int b = 0; b < IRQLAT_BUCKETS; b++) {
+        if (st->hist[b] == 0) continue;
+        char range[48];
+        if (b < IRQLAT_EXACT) {
+            snprintf(range, sizeof(range), "%d", b);
+        } else {
+            int shift = b - IRQLAT_EXACT + IRQLAT_EXACT_BITS;
+            u64 first = 1ULL << shift;
+            snprintf(range, sizeof(range), "%llu-%llu", (unsigned long long)first,
+                     (unsigned long long)(first + (first - 1)));
+        }
+        int bar = (int)(st->hist[b] * 40 / peak);
+        fprintf(out, "  %12s %12llu  %.*s\n", range, (unsigned long long)st->hist[b], bar > 0 ? bar : 1,
+                "########################################");
+    }
+}
+
+void irqlat_report(const IrqLatency *l, FILE *out) {
+    fprintf(out, "\n=== Latence des interruptions (cycles, de la montee de la ligne au handler) ===\n");
+    fprintf(out, "%-18s %10s %10s %8s %9s %8s\n", "source", "servies", "perdues", "min", "moyenne", "max");
+    int any = 0;
+    for (int s = 0; s < IRQLAT_SOURCES; s++) {
+        report_source("IRQ", s, &l->irq[s], out);
+        any |= l->irq[s].count || l->irq[s].dropped;
+    }
+    for (int s = 0; s < IRQLAT_SOURCES; s++) {
+        report_source("NMI", s, &l->nmi[s], out);
+        any |= l->nmi[s].count || l->nmi[s].dropped;
+    }
+    if (!any) {
+        fprintf(out, "(aucune interruption)\n");
+        return;
+    }
+    for (int s = 0; s < IRQLAT_SOURCES; s++) report_histogram("IRQ", s, &l->irq[s], out);
+    for (int s = 0; s < IRQLAT_SOURCES; s++) report_histogram("NMI", s, &l->nmi[s], out);
+}
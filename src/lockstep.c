@@ -0,0 +1,174 @@
+#include "lockstep.h"
+#include "blockcache.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- Moteurs ---
+
+// Référence : une instruction par appel
+static int engine_reference(CPU *cpu, void *ctx) {
+    (void)ctx;
+    cpu_step(cpu);
+    return 1;
+}
+
+// Blocs prédécodés : un bloc par appel (préchargés depuis la carte statique)
+static void *engine_block_create(CPU *cpu, const CodeMap *cm) {
+    BlockCache *bc = block_create(cpu);
+    if (bc && cm) block_preload(bc, cm);
+    return bc;
+}
+
+static void engine_block_destroy(void *ctx) {
+    block_free((BlockCache *)ctx);
+}
+
+static int engine_block(CPU *cpu, void *ctx) {
+    (void)cpu;
+    return block_exec((BlockCache *)ctx, UINT64_MAX);
+}
+
+static const Engine engines[] = {
+    { "reference", engine_reference, NULL, NULL },
+    { "block", engine_block, engine_block_create, engine_block_destroy },
+};
+#define ENGINE_COUNT (int)(sizeof(engines) / sizeof(engines[0]))
+
+const Engine *lockstep_find_engine(const char *name) {
+    for (int i = 0; i < ENGINE_COUNT; i++) {
+        if (strcmp(engines[i].name, name) == 0) return &engines[i];
+    }
+    return NULL;
+}
+
+void lockstep_list_engines(FILE *out) {
+    for (int i = 0; i < ENGINE_COUNT; i++) {
+        fprintf(out, "  %s\n", engines[i].name);
+    }
+}
+
+// --- Journal des écritures ---
+// Chaque écriture est mélangée dans un hash FNV-1a 64 bits : l'ordre, l'adresse
+// et la valeur comptent, mais la comparaison reste O(1) par frontière.
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+static void log_write(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)pc; (void)kind;
+    WriteLog *log = (WriteLog *)ctx;
+    u64 h = log->hash;
+    h = (h ^ (address & 0xFF)) * FNV_PRIME;
+    h = (h ^ (address >> 8)) * FNV_PRIME;
+    h = (h ^ value) * FNV_PRIME;
+    log->hash = h;
+    log->count++;
+}
+
+static void lockstep_setup(CPU *cpu, Memory *mem, WriteLog *log, const Memory *image, u16 pc, CpuVariant variant) {
+    mem_init(mem);
+    mem_load_bytes(mem, 0x0000, image->data, MAX_MEMORY);
+    log->hash = FNV_OFFSET;
+    log->count = 0;
+    mem_add_watch(mem, 0x0000, 0xFFFF, MEM_WATCH_WRITE, log_write, log);
+    cpu_reset_variant(cpu, mem, variant);
+    cpu->PC = pc;
+}
+
+int lockstep_init(Lockstep *ls, const Memory *image, u16 pc, CpuVariant variant, const Engine *engine,
+                  const CodeMap *cm) {
+    ls->engine = engine;
+    ls->engine_ctx = NULL;
+    ls->ref_mem = malloc(sizeof(Memory));
+    ls->test_mem = malloc(sizeof(Memory));
+    if (ls->ref_mem == NULL || ls->test_mem == NULL) {
+        printf("Erreur : mémoire insuffisante pour le mode différentiel\n");
+        lockstep_free(ls);
+        return 0;
+    }
+    lockstep_setup(&ls->ref, ls->ref_mem, &ls->ref_log, image, pc, variant);
+    lockstep_setup(&ls->test, ls->test_mem, &ls->test_log, image, pc, variant);
+    if (engine->create) {
+        ls->engine_ctx = engine->create(&ls->test, cm);
+        if (ls->engine_ctx == NULL) {
+            lockstep_free(ls);
+            return 0;
+        }
+    }
+    ls->instructions = 0;
+    return 1;
+}
+
+void lockstep_free(Lockstep *ls) {
+    if (ls->engine_ctx) ls->engine->destroy(ls->engine_ctx);
+    ls->engine_ctx = NULL;
+    free(ls->ref_mem);
+    free(ls->test_mem);
+    ls->ref_mem = NULL;
+    ls->test_mem = NULL;
+}
+
+// Compare l'état architectural visible des deux machines
+static int lockstep_same_state(const Lockstep *ls) {
+    const CPU *a = &ls->ref, *b = &ls->test;
+    return a->A == b->A && a->X == b->X && a->Y == b->Y && a->SP == b->SP
+        && a->PC == b->PC && a->P == b->P && a->cycles == b->cycles
+        && ls->ref_log.hash == ls->test_log.hash
+        && ls->ref_log.count == ls->test_log.count;
+}
+
+int lockstep_step(Lockstep *ls) {
+    // Le moteur testé avance d'une frontière, la référence le rattrape
+    int n = ls->engine->step(&ls->test, ls->engine_ctx);
+    for (int i = 0; i < n; i++) {
+        cpu_step(&ls->ref);
+    }
+    ls->instructions += n;
+    return lockstep_same_state(ls);
+}
+
+static void print_flags(FILE *out, u8 p) {
+    const char *names = "NV-BDIZC";
+    for (int i = 7; i >= 0; i--) {
+        fputc((p >> i) & 1 ? names[7 - i] : '.', out);
+    }
+}
+
+void lockstep_report(const Lockstep *ls, FILE *out) {
+    const CPU *a = &ls->ref, *b = &ls->test;
+    fprintf(out, "\n=== Divergence apres %llu instructions (moteur : %s) ===\n",
+            (unsigned long long)ls->instructions, ls->engine->name);
+    fprintf(out, "             %-18s %-18s\n", "reference", ls->engine->name);
+    fprintf(out, "%s PC      : 0x%04X             0x%04X\n", a->PC != b->PC ? "*" : " ", a->PC, b->PC);
+    fprintf(out, "%s A       : 0x%02X               0x%02X\n", a->A != b->A ? "*" : " ", a->A, b->A);
+    fprintf(out, "%s X       : 0x%02X               0x%02X\n", a->X != b->X ? "*" : " ", a->X, b->X);
+    fprintf(out, "%s Y       : 0x%02X               0x%02X\n", a->Y != b->Y ? "*" : " ", a->Y, b->Y);
+    fprintf(out, "%s SP      : 0x%02X               0x%02X\n", a->SP != b->SP ? "*" : " ", a->SP, b->SP);
+    fprintf(out, "%s P       : ", a->P != b->P ? "*" : " ");
+    print_flags(out, a->P);
+    fprintf(out, "           ");
+    print_flags(out, b->P);
+    fprintf(out, "\n");
+    fprintf(out, "%s Cycles  : %-18llu %-18llu\n", a->cycles != b->cycles ? "*" : " ",
+            (unsigned long long)a->cycles, (unsigned long long)b->cycles);
+    fprintf(out, "%s Ecrits  : %-18llu %-18llu\n",
+            ls->ref_log.count != ls->test_log.count ? "*" : " ",
+            (unsigned long long)ls->ref_log.count, (unsigned long long)ls->test_log.count);
+    fprintf(out, "%s Hash    : %016llx   %016llx\n",
+            ls->ref_log.hash != ls->test_log.hash ? "*" : " ",
+            (unsigned long long)ls->ref_log.hash, (unsigned long long)ls->test_log.hash);
+
+    // Le hash ne dit pas où : on compare les deux mémoires octet par octet
+    int shown = 0, total = 0;
+    for (int addr = 0; addr < MAX_MEMORY; addr++) {
+        if (mem_peek(ls->ref_mem, addr) != mem_peek(ls->test_mem, addr)) {
+            if (shown < 16) {
+                fprintf(out, "* mem[0x%04X] : 0x%02X               0x%02X\n",
+                        addr, mem_peek(ls->ref_mem, addr), mem_peek(ls->test_mem, addr));
+                shown++;
+            }
+            total++;
+        }
+    }
+    fprintf(out, "Octets de memoire differents : %d\n", total);
+}
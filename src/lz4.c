@@ -0,0 +1,117 @@
+#include "lz4.h"
+#include <string.h>
+
+// Une séquence : jeton (longueur des littéraux sur 4 bits, longueur de la
+// copie - 4 sur 4 bits), suite de la longueur des littéraux (octets de 255),
+// littéraux, distance (16 bits), suite de la longueur de la copie. La
+// dernière séquence n'a que des littéraux.
+#define MIN_MATCH 4
+#define LAST_LITERALS 5 // Les 5 derniers octets sont toujours des littéraux
+#define MF_LIMIT 12     // Pas de copie commençant dans les 12 derniers octets
+#define MAX_DISTANCE 65535
+#define HASH_BITS 12
+
+static inline u32 read32(const u8 *p) {
+    u32 v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline u32 hash4(u32 v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Longueur au-delà de 15 : octets de 255 puis le reste
+static u8 *put_length(u8 *op, u32 len) {
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = (u8)len;
+    return op;
+}
+
+// Écrit une séquence ; NULL si elle ne tient pas avant end
+static u8 *put_sequence(u8 *op, u8 *end, const u8 *lit, u32 lit_len, u32 distance, u32 match_len) {
+    if (op + 1 + lit_len / 255 + 1 + lit_len + 2 + match_len / 255 + 1 > end) return NULL;
+    u8 *token = op++;
+    u32 ml = match_len ? match_len - MIN_MATCH : 0;
+    *token = (u8)((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15) op = put_length(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (match_len == 0) return op; // Dernière séquence
+    *op++ = (u8)(distance & 0xFF);
+    *op++ = (u8)(distance >> 8);
+    *token |= (u8)(ml >= 15 ? 15 : ml);
+    if (ml >= 15) op = put_length(op, ml - 15);
+    return op;
+}
+
+int lz4_compress(const u8 *src, int n, u8 *dst, int cap) {
+    u32 table[1 << HASH_BITS]; // Position + 1 (0 : vide)
+    memset(table, 0, sizeof(table));
+    u8 *op = dst, *end = dst + cap;
+    int anchor = 0, ip = 0;
+    u32 misses = 0;
+
+    while (ip + MF_LIMIT < n) {
+        u32 seq = read32(src + ip);
+        u32 h = hash4(seq);
+        int ref = (int)table[h] - 1;
+        table[h] = (u32)ip + 1;
+        if (ref < 0 || ip - ref > MAX_DISTANCE || read32(src + ref) != seq) {
+            // Données peu compressibles : on avance de plus en plus vite
+            ip += 1 + (int)(misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+        int len = MIN_MATCH;
+        while (ip + len < n - LAST_LITERALS && src[ref + len] == src[ip + len]) len++;
+        op = put_sequence(op, end, src + anchor, (u32)(ip - anchor), (u32)(ip - ref), (u32)len);
+        if (op == NULL) return -1;
+        ip += len;
+        anchor = ip;
+        if (ip - 2 >= 0 && ip + MF_LIMIT < n) table[hash4(read32(src + ip - 2))] = (u32)(ip - 2) + 1;
+    }
+    op = put_sequence(op, end, src + anchor, (u32)(n - anchor), 0, 0);
+    return op ? (int)(op - dst) : -1;
+}
+
+// Longueur étendue ; -1 si le bloc s'arrête au milieu
+static int get_length(const u8 **ip, const u8 *end, u32 *len) {
+    u8 b;
+    do {
+        if (*ip >= end) return -1;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+int lz4_decompress(const u8 *src, int n, u8 *dst, int cap) {
+    const u8 *ip = src, *iend = src + n;
+    u8 *op = dst, *oend = dst + cap;
+    while (ip < iend) {
+        u8 token = *ip++;
+        u32 lit = token >> 4;
+        if (lit == 15 && get_length(&ip, iend, &lit) < 0) return -1;
+        if ((u32)(iend - ip) < lit || (u32)(oend - op) < lit) return -1;
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) break; // Dernière séquence : littéraux seuls
+        if (iend - ip < 2) return -1;
+        u32 distance = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (distance == 0 || distance > (u32)(op - dst)) return -1;
+        u32 len = token & 15;
+        if (len == 15 && get_length(&ip, iend, &len) < 0) return -1;
+        len += MIN_MATCH;
+        if ((u32)(oend - op) < len) return -1;
+        // Distance plus courte que la copie : la source chevauche la
+        // destination (répétition d'un motif), copie octet par octet
+        const u8 *match = op - distance;
+        if (distance >= len) memcpy(op, match, len);
+        else for (u32 i = 0; i < len; i++) op[i] = match[i];
+        op += len;
+    }
+    return (int)(op - dst);
+}
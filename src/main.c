@@ -1,8 +1,28 @@
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include "types.h"
 #include "memory.h"
 #include "cpu.h"
+#include "lockstep.h"
+#include "sched.h"
+#include "via.h"
+#include "acia.h"
+#include "pace.h"
+#include "stats.h"
+#include "codemap.h"
+#include "blockcache.h"
+#include "hwprof.h"
+#include "coverage.h"
+#include "irqlat.h"
+#include "framebuffer.h"
+#include "hostcall.h"
+#include "mapper.h"
+#include "hang.h"
+#include "trace.h"
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 void run_builtin_test() {
     printf("=== Mode Test Interne ===\n");
@@ -36,38 +56,621 @@ void run_builtin_test() {
     printf("X final : %d (Attendu : 5)\n", cpu.X);
 }
 
+// Callback des watchpoints : affiche chaque accès surveillé
+static void print_watch(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)ctx;
+    char k = (kind == MEM_WATCH_READ) ? 'R' : (kind == MEM_WATCH_WRITE) ? 'W' : 'X';
+    printf("[WATCH] PC: 0x%04X | %c 0x%04X = 0x%02X\n", pc, k, address, value);
+}
+
+// --trace-file : les écritures de l'instruction en cours vont dans la trace
+static void trace_watch(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)pc; (void)kind;
+    trace_write((TraceWriter *)ctx, address, value);
+}
+
+// Analyse "--watch=DEBUT[-FIN][:rwx]" (adresses en hexadécimal, ex: --watch=0210:w)
+static int parse_watch(Memory *mem, const char *spec) {
+    char *end;
+    unsigned long start = strtoul(spec, &end, 16);
+    unsigned long stop = start;
+    if (*end == '-') stop = strtoul(end + 1, &end, 16);
+
+    u8 kinds = 0;
+    if (*end == ':') {
+        for (end++; *end; end++) {
+            if (*end == 'r') kinds |= MEM_WATCH_READ;
+            else if (*end == 'w') kinds |= MEM_WATCH_WRITE;
+            else if (*end == 'x') kinds |= MEM_WATCH_EXEC;
+            else break;
+        }
+    } else if (*end == '\0') {
+        kinds = MEM_WATCH_WRITE; // Par défaut : on surveille les écritures
+    }
+
+    if (*end != '\0' || kinds == 0 || start > 0xFFFF || stop > 0xFFFF) {
+        printf("Erreur : watchpoint invalide '%s'\n", spec);
+        return 0;
+    }
+    if (mem_add_watch(mem, (u16)start, (u16)stop, kinds, print_watch, NULL) < 0) {
+        printf("Erreur : trop de watchpoints (max %d)\n", MAX_WATCHPOINTS);
+        return 0;
+    }
+    return 1;
+}
+
+// Carte statique du code : relue depuis le cache (--cfg-cache, sinon
+// "<rom>.cfg" écrit par cfg6502) s'il correspond à l'image, à la variante et
+// aux points d'entrée (vecteurs + adresse de départ), sinon recalculée. Elle
+// n'est écrite qu'avec --cfg-cache ("" : "<rom>.cfg").
+static int prepare_codemap(CodeMap *cm, const char *rom, const char *cache, const Memory *mem,
+                           CpuVariant variant, long start_pc) {
+    char path[1024];
+    if (cache && *cache) {
+        snprintf(path, sizeof(path), "%s", cache);
+    } else {
+        codemap_cache_path(rom, path, sizeof(path));
+    }
+    u16 entry = (u16)start_pc;
+    int extra = start_pc >= 0 ? 1 : 0;
+    if (codemap_load(cm, path, mem, variant, &entry, extra) == 1) {
+        printf("Carte du code : %d blocs (cache %s)\n", cm->block_count, path);
+        return 1;
+    }
+    if (codemap_analyze(cm, mem, variant, &entry, extra) < 0) return 0;
+    printf("Analyse statique : %d blocs, %d points d'entree", cm->block_count, cm->entry_count);
+    if (cache && codemap_save(cm, path)) printf(" -> %s", path);
+    printf("\n");
+    return 1;
+}
+
+// Piège de succès du test fonctionnel (JMP sur lui-même, $0200 = $F0) et
+// numéro du test en cours
+#define SUCCESS_PC 0x3469
+#define TEST_NUMBER 0x0200
+// Moteur à blocs avec détection des boucles : cycles au plus par appel
+#define HANG_BLOCK_CYCLES 4096
+
+// Vrai si l'instruction en PC saute sur elle-même (JMP *, branche de
+// décalage -2) : piège de fin des programmes de test
+static int at_self_loop(const CPU *cpu) {
+    u8 op = mem_peek(cpu->mem, cpu->PC);
+    if (op == 0x4C) {
+        return (mem_peek(cpu->mem, (u16)(cpu->PC + 1)) | mem_peek(cpu->mem, (u16)(cpu->PC + 2)) << 8) == cpu->PC;
+    }
+    // Branches conditionnelles (xxx10000) et BRA du 65C02
+    return ((op & 0x1F) == 0x10 || op == 0x80) && mem_peek(cpu->mem, (u16)(cpu->PC + 1)) == 0xFE;
+}
+
+// Mode différentiel : référence et moteur optimisé en lock-step, jusqu'au
+// piège de succès, à un autre piège (branche prise sur elle-même) ou à
+// max_cycles (0 : pas de limite)
+static int run_diff(const Memory *mem, CpuVariant variant, const char *engine_name, const CodeMap *cm,
+                    u64 max_cycles) {
+    const Engine *engine = lockstep_find_engine(engine_name);
+    if (engine == NULL) {
+        printf("Erreur : moteur inconnu '%s'. Moteurs disponibles :\n", engine_name);
+        lockstep_list_engines(stdout);
+        return 1;
+    }
+
+    Lockstep ls;
+    if (!lockstep_init(&ls, mem, 0x0400, variant, engine, cm)) return 1;
+
+    printf("Execution differentielle (reference / %s)...\n", engine->name);
+    int ok = 1, capped = 0;
+    while (ls.ref.PC != SUCCESS_PC) {
+        if (max_cycles && ls.ref.cycles > max_cycles) {
+            capped = 1;
+            break;
+        }
+        u16 pc = ls.ref.PC;
+        if (!lockstep_step(&ls)) {
+            lockstep_report(&ls, stdout);
+            ok = 0;
+            break;
+        }
+        if (ls.ref.PC == pc && at_self_loop(&ls.ref)) {
+            printf("Piege en 0x%04X (hors succes) : comparaison arretee\n", pc);
+            break;
+        }
+    }
+    if (ok && capped) {
+        printf("Limite de %llu cycles atteinte (--cycles) : programme non termine\n", (unsigned long long)max_cycles);
+    }
+    if (ok) {
+        printf("Aucune divergence sur %llu instructions (%llu ecritures, hash %016llx)\n",
+               (unsigned long long)ls.instructions, (unsigned long long)ls.ref_log.count,
+               (unsigned long long)ls.ref_log.hash);
+    }
+    lockstep_free(&ls);
+    return ok ? 0 : 2;
+}
+
+// Lignes IRQ des périphériques (une par bit de cpu->irq_lines)
+#define IRQ_VIA  (1 << 0)
+#define IRQ_ACIA (1 << 1)
+
+// Options de la carte émulée
+typedef struct {
+    int via_page, acia_page;      // -1 : absent
+    int hostcall_page;            // --hostcall : porte vers l'hôte, -1 : absente
+    const char *acia_in, *acia_out; // NULL : entrée/sortie standard
+    u64 cpu_hz;
+} BoardConfig;
+
+static int parse_page(const char *spec, int *page) {
+    char *end;
+    unsigned long value = strtoul(spec, &end, 16);
+    if (end == spec || *end != '\0' || value > 0xFF) {
+        printf("Erreur : page invalide '%s' (attendu : 00 a FF)\n", spec);
+        return 0;
+    }
+    *page = (int)value;
+    return 1;
+}
+
+// L'ACIA passe l'entrée standard en non bloquant : rendue à la sortie,
+// quel que soit le chemin (return de main ou exit)
+static Acia *attached_acia;
+
+static void detach_acia(void) {
+    acia_detach(attached_acia);
+}
+
+// Mappe les périphériques demandés et les relie à l'ordonnanceur
+static int attach_devices(const BoardConfig *board, Memory *mem, CPU *cpu, Scheduler *sched,
+                          Via *via, Acia *acia, HostCall *hostcall) {
+    if (board->via_page >= 0) {
+        via_attach(via, mem, (u8)board->via_page, cpu, sched, IRQ_VIA);
+    }
+    if (board->acia_page >= 0) {
+        int rx = board->acia_in ? open(board->acia_in, O_RDONLY) : STDIN_FILENO;
+        int tx = board->acia_out ? open(board->acia_out, O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO;
+        if (rx < 0 || tx < 0) {
+            printf("Erreur : impossible d'ouvrir l'entree/sortie de l'ACIA\n");
+            return 0;
+        }
+        acia_attach(acia, mem, (u8)board->acia_page, cpu, sched, IRQ_ACIA, rx, tx, board->cpu_hz);
+        attached_acia = acia;
+        atexit(detach_acia);
+    }
+    if (board->hostcall_page >= 0) {
+        hostcall_attach(hostcall, mem, (u8)board->hostcall_page, cpu);
+    }
+    return 1;
+}
+
+// Écran en mémoire (--fb) et ses captures (--fb-shot, --fb-out)
+#define MAX_FB_SHOTS 64
+
+typedef struct {
+    int enabled;
+    u16 base;
+    FbMode mode;
+    int width, height;
+    const char *font;    // NULL : police intégrée
+    const char *path;    // Capture ; "-CYCLE" inséré avant l'extension pour --fb-shot
+    u64 shots[MAX_FB_SHOTS];
+    int shot_count;
+} FbConfig;
+
+typedef struct {
+    Framebuffer fb;
+    const FbConfig *config;
+    Scheduler *sched;
+    int event;
+    int next;   // Prochaine capture de config->shots
+    int failed;
+} FbShots;
+
+// "--fb=ADRESSE,MODE,LxH" (ex: --fb=0400,text,40x25 ou --fb=2000,mono,320x200)
+static int parse_fb(const char *spec, FbConfig *fc) {
+    unsigned int base;
+    char mode[16];
+    int width, height, end = 0;
+    if (sscanf(spec, "%x,%15[^,],%dx%d%n", &base, mode, &width, &height, &end) != 4 || spec[end] != '\0'
+        || base > 0xFFFF || fb_mode_from_name(mode) < 0) {
+        printf("Erreur : ecran invalide '%s' (attendu : ADRESSE,text|mono|rgb332,LxH)\n", spec);
+        return 0;
+    }
+    fc->enabled = 1;
+    fc->base = (u16)base;
+    fc->mode = (FbMode)fb_mode_from_name(mode);
+    fc->width = width;
+    fc->height = height;
+    return 1;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+    return x < y ? -1 : x > y;
+}
+
+// "--fb-shot=CYCLE[,CYCLE...]" : cycles triés
+static int parse_fb_shots(const char *spec, FbConfig *fc) {
+    const char *p = spec;
+    while (*p) {
+        char *end;
+        u64 cycle = strtoull(p, &end, 10);
+        if (end == p || (*end != ',' && *end != '\0') || fc->shot_count == MAX_FB_SHOTS) {
+            printf("Erreur : captures invalides '%s' (cycles separes par des virgules, %d au plus)\n", spec,
+                   MAX_FB_SHOTS);
+            return 0;
+        }
+        fc->shots[fc->shot_count++] = cycle;
+        p = *end ? end + 1 : end;
+    }
+    qsort(fc->shots, (size_t)fc->shot_count, sizeof(u64), compare_u64);
+    return 1;
+}
+
+// Chemin de la capture du cycle 'cycle' : ecran.png -> ecran-1000000.png
+static void fb_shot_path(const char *path, u64 cycle, char *out, size_t size) {
+    const char *slash = strrchr(path, '/');
+    const char *ext = strrchr(path, '.');
+    if (ext == NULL || (slash && ext < slash)) ext = path + strlen(path);
+    snprintf(out, size, "%.*s-%llu%s", (int)(ext - path), path, (unsigned long long)cycle, ext);
+}
+
+// Les captures échues au même point (premier cycle d'instruction atteint)
+// donnent la même image
+static void fb_shot_event(void *ctx, u64 now) {
+    FbShots *s = (FbShots *)ctx;
+    const FbConfig *fc = s->config;
+    while (s->next < fc->shot_count && fc->shots[s->next] <= now) {
+        char path[1024];
+        fb_shot_path(fc->path, fc->shots[s->next], path, sizeof(path));
+        if (!fb_save(&s->fb, path)) s->failed = 1;
+        s->next++;
+    }
+    if (s->next < fc->shot_count) sched_set(s->sched, s->event, fc->shots[s->next]);
+}
+
+static int attach_fb(const FbConfig *fc, Memory *mem, Scheduler *sched, FbShots *s) {
+    if (!fb_attach(&s->fb, mem, fc->base, fc->mode, fc->width, fc->height)) return 0;
+    if (fc->font && !fb_load_font(&s->fb, fc->font)) return 0;
+    s->config = fc;
+    s->sched = sched;
+    s->next = 0;
+    s->failed = 0;
+    if (fc->shot_count) {
+        s->event = sched_add(sched, fb_shot_event, s);
+        if (s->event < 0) {
+            printf("Erreur : trop d'evenements dans l'ordonnanceur\n");
+            return 0;
+        }
+        sched_set(sched, s->event, fc->shots[0]);
+    }
+    return 1;
+}
+
+// Publication périodique des statistiques (en cycles émulés)
+#define STATS_PUBLISH_CYCLES 1000000
+
+typedef struct {
+    StatsInstance *inst;
+    CPU *cpu;
+    Scheduler *sched;
+    int event;
+} StatsHook;
+
+static void publish_stats(void *ctx, u64 now) {
+    StatsHook *hook = (StatsHook *)ctx;
+    stats_publish(hook->inst, hook->cpu);
+    sched_set(hook->sched, hook->event, now + STATS_PUBLISH_CYCLES);
+}
+
+// Ctrl-C en mode cadencé, avec --stats ou sans limite de cycles : on
+// s'arrête proprement pour afficher et exporter les statistiques
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_sigint(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
 int main(int argc, char **argv) {
-    if (argc > 1) {
+    const char *rom = NULL;
+    const char *diff_engine = NULL;
+    int use_blocks = 0; // --engine=block
+    const char *cfg_cache = NULL; // --cfg-cache : fichier de la carte statique
+    CpuVariant variant = CPU_NMOS;
+    int trace = 0;
+    const char *trace_path = NULL; // --trace-file : trace binaire compressée
+    const char *coverage_path = NULL; // --coverage : bitmaps fusionnés dans le fichier
+    int irq_latency = 0; // --irq-latency : histogramme par source à la fin
+    const char *watches[MAX_WATCHPOINTS];
+    int watch_count = 0;
+    BoardConfig board = { -1, -1, -1, NULL, NULL, 1000000 };
+    long load_address = 0x0000;
+    long start_pc = 0x0400; // -1 : vecteur de reset
+    u64 max_cycles = 10000000; // Sans --cycles : illimité si les boucles infinies sont détectées
+    int cycles_given = 0;
+    double clock_mhz = 0.0; // 0 : vitesse maximale
+    u64 slice_us = 0;
+    const char *stats_target = NULL;
+    double stats_interval = 1.0;
+    u32 hwprof_period = 0; // --hwprof : une instruction mesurée sur N en moyenne
+    int start_given = 0;
+    const char *c64_roms = NULL; // --c64=basic,kernal,chargen
+    static FbConfig fb_config = { .path = "ecran.png" };
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--watch=", 8) == 0) {
+            if (watch_count == MAX_WATCHPOINTS) {
+                printf("Erreur : trop de watchpoints (max %d)\n", MAX_WATCHPOINTS);
+                return 1;
+            }
+            watches[watch_count++] = argv[i] + 8;
+        } else if (strncmp(argv[i], "--cpu=", 6) == 0) {
+            int v = cpu_variant_from_name(argv[i] + 6);
+            if (v < 0) {
+                printf("Erreur : variante inconnue '%s' (nmos, 65c02, 2a03)\n", argv[i] + 6);
+                return 1;
+            }
+            variant = (CpuVariant)v;
+        } else if (strncmp(argv[i], "--via=", 6) == 0) {
+            if (!parse_page(argv[i] + 6, &board.via_page)) return 1;
+        } else if (strncmp(argv[i], "--acia=", 7) == 0) {
+            if (!parse_page(argv[i] + 7, &board.acia_page)) return 1;
+        } else if (strncmp(argv[i], "--hostcall=", 11) == 0) {
+            if (!parse_page(argv[i] + 11, &board.hostcall_page)) return 1;
+        } else if (strncmp(argv[i], "--acia-in=", 10) == 0) {
+            board.acia_in = argv[i] + 10;
+        } else if (strncmp(argv[i], "--acia-out=", 11) == 0) {
+            board.acia_out = argv[i] + 11;
+        } else if (strncmp(argv[i], "--fb=", 5) == 0) {
+            if (!parse_fb(argv[i] + 5, &fb_config)) return 1;
+        } else if (strncmp(argv[i], "--fb-font=", 10) == 0) {
+            fb_config.font = argv[i] + 10;
+        } else if (strncmp(argv[i], "--fb-shot=", 10) == 0) {
+            if (!parse_fb_shots(argv[i] + 10, &fb_config)) return 1;
+        } else if (strncmp(argv[i], "--fb-out=", 9) == 0) {
+            fb_config.path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--hz=", 5) == 0) {
+            board.cpu_hz = strtoull(argv[i] + 5, NULL, 10);
+            if (board.cpu_hz == 0) board.cpu_hz = 1000000;
+        } else if (strncmp(argv[i], "--load=", 7) == 0) {
+            load_address = strtol(argv[i] + 7, NULL, 16) & 0xFFFF;
+        } else if (strncmp(argv[i], "--start=", 8) == 0) {
+            start_pc = strcmp(argv[i] + 8, "reset") == 0 ? -1 : strtol(argv[i] + 8, NULL, 16) & 0xFFFF;
+            start_given = 1;
+        } else if (strncmp(argv[i], "--c64=", 6) == 0) {
+            c64_roms = argv[i] + 6;
+        } else if (strncmp(argv[i], "--cycles=", 9) == 0) {
+            max_cycles = strtoull(argv[i] + 9, NULL, 10); // 0 : pas de limite
+            cycles_given = 1;
+        } else if (strncmp(argv[i], "--clock=", 8) == 0) {
+            clock_mhz = strtod(argv[i] + 8, NULL);
+            if (clock_mhz <= 0.0) {
+                printf("Erreur : frequence invalide '%s' (en MHz, ex: 1.79)\n", argv[i] + 8);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--slice=", 8) == 0) {
+            slice_us = strtoull(argv[i] + 8, NULL, 10);
+        } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+            stats_target = argv[i] + 8;
+        } else if (strncmp(argv[i], "--stats-interval=", 17) == 0) {
+            stats_interval = strtod(argv[i] + 17, NULL);
+        } else if (strcmp(argv[i], "--cfg-cache") == 0) {
+            cfg_cache = ""; // "<rom>.cfg", une fois la ROM connue
+        } else if (strncmp(argv[i], "--cfg-cache=", 12) == 0) {
+            cfg_cache = argv[i] + 12;
+        } else if (strncmp(argv[i], "--engine=", 9) == 0) {
+            if (strcmp(argv[i] + 9, "block") == 0) {
+                use_blocks = 1;
+            } else if (strcmp(argv[i] + 9, "reference") != 0) {
+                printf("Erreur : moteur inconnu '%s' (reference, block)\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--hwprof") == 0) {
+            hwprof_period = 100;
+        } else if (strncmp(argv[i], "--hwprof=", 9) == 0) {
+            hwprof_period = (u32)strtoul(argv[i] + 9, NULL, 10);
+            if (hwprof_period == 0) hwprof_period = 1;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace = 1;
+        } else if (strncmp(argv[i], "--trace-file=", 13) == 0) {
+            trace_path = argv[i] + 13;
+        } else if (strcmp(argv[i], "--irq-latency") == 0) {
+            irq_latency = 1;
+        } else if (strncmp(argv[i], "--coverage=", 11) == 0) {
+            coverage_path = argv[i] + 11;
+        } else if (strcmp(argv[i], "--diff") == 0) {
+            diff_engine = "reference";
+        } else if (strncmp(argv[i], "--diff=", 7) == 0) {
+            diff_engine = argv[i] + 7;
+        } else {
+            rom = argv[i];
+        }
+    }
+
+    if (rom) {
         printf("=== Emulateur 6502 ===\n");
-        printf("Chargement du fichier : %s\n\n", argv[1]);
+        printf("Chargement du fichier : %s\n\n", rom);
 
         Memory mem;
         mem_init(&mem);
 
-        if (!mem_load(&mem, argv[1], 0x0000)) {
+        // Cartouche iNES ou ROM du C64 : banques dans un pool, départ au
+        // vecteur de reset sauf --start
+        static Mapper mapper;
+        Mapper *banks = NULL;
+        if (mapper_is_ines(rom)) {
+            if (!mapper_load_ines(&mapper, &mem, rom)) return 1;
+            banks = &mapper;
+            printf("Cartouche iNES : mapper %s, %u banques de PRG ROM (16 Ko)\n",
+                   mapper_name(banks), banks->prg_banks);
+        } else if (!mem_load(&mem, rom, (u16)load_address)) {
+            return 1;
+        }
+        if (c64_roms && !banks) {
+            char paths[3][512];
+            if (sscanf(c64_roms, "%511[^,],%511[^,],%511s", paths[0], paths[1], paths[2]) != 3) {
+                printf("Erreur : --c64=basic,kernal,chargen attendu\n");
+                return 1;
+            }
+            if (!mapper_load_c64(&mapper, &mem, paths[0], paths[1], paths[2])) return 1;
+            banks = &mapper;
+        }
+        if (banks && !start_given) start_pc = -1;
+        for (int i = 0; i < watch_count; i++) {
+            if (!parse_watch(&mem, watches[i])) return 1;
+        }
+        // Le moteur à blocs part de la carte statique : tout le code connu est
+        // prédécodé avant la première instruction
+        static CodeMap codemap;
+        int diff_blocks = diff_engine && strcmp(diff_engine, "block") == 0;
+        if ((use_blocks || diff_blocks) && !prepare_codemap(&codemap, rom, cfg_cache, &mem, variant, start_pc)) {
             return 1;
         }
+        if (diff_engine) {
+            if (banks) {
+                printf("Erreur : --diff ne prend pas en charge les banques (mapper %s)\n", mapper_name(banks));
+                return 1;
+            }
+            return run_diff(&mem, variant, diff_engine, diff_blocks ? &codemap : NULL, cycles_given ? max_cycles : 0);
+        }
 
         CPU cpu;
+        static Scheduler sched;
+        static Via via;
+        static Acia acia;
+        static HostCall hostcall;
+        static Pacer pacer;
+
+        // Mode cadencé : la même fréquence sert au calcul des débits de l'ACIA
+        if (clock_mhz > 0.0) board.cpu_hz = (u64)(clock_mhz * 1e6);
+        // Sans périphérique ni mapper, l'état de la machine est tout entier
+        // dans cpu_fingerprint : un état qui revient est une boucle infinie.
+        // Un périphérique peut sortir le CPU d'une attente, un registre de
+        // mapper n'est pas dans l'empreinte : pas de détection.
+        int detect_hang = board.via_page < 0 && board.acia_page < 0 && board.hostcall_page < 0 && !banks;
+        if (detect_hang && !cycles_given) max_cycles = 0;
+        // Sans --cycles, le run va jusqu'à la dernière capture : l'écran peut
+        // changer au fil d'une boucle détectée
+        if (fb_config.shot_count && !cycles_given) {
+            max_cycles = fb_config.shots[fb_config.shot_count - 1];
+            detect_hang = 0;
+        }
+        if (clock_mhz > 0.0 || stats_target || !max_cycles || board.acia_page >= 0) {
+            signal(SIGINT, on_sigint);
+            signal(SIGTERM, on_sigint);
+        }
         
         // 1. Initialisation (UNE SEULE FOIS)
-        cpu_reset(&cpu, &mem);
+        cpu_reset_variant(&cpu, &mem, variant);
+        static IrqLatency latency;
+        if (irq_latency) {
+            irqlat_init(&latency);
+            cpu.latency = &latency;
+        }
+        sched_init(&sched);
+        if (!attach_devices(&board, &mem, &cpu, &sched, &via, &acia, &hostcall)) return 1;
+        static FbShots screen;
+        if (fb_config.enabled && !attach_fb(&fb_config, &mem, &sched, &screen)) return 1;
+
+        // Statistiques : instance nommée d'après la ROM et le PID
+        static StatsHook stats = { NULL, NULL, NULL, -1 };
+        if (stats_target) {
+            char name[48];
+            const char *base = strrchr(rom, '/');
+            snprintf(name, sizeof(name), "%s:%d", base ? base + 1 : rom, (int)getpid());
+            stats.inst = stats_register(name);
+            stats.cpu = &cpu;
+            stats.sched = &sched;
+            stats.event = sched_add(&sched, publish_stats, &stats);
+            if (stats.inst == NULL || stats.event < 0 || !stats_export_start(stats_target, stats_interval)) {
+                return 1;
+            }
+            sched_set(&sched, stats.event, STATS_PUBLISH_CYCLES);
+        }
+        StatCounters *counters = stats_current;
+
+        BlockCache *blocks = NULL;
+        if (use_blocks) {
+            blocks = block_create(&cpu);
+            if (blocks == NULL) return 1;
+            printf("Blocs predecodes au chargement : %d\n", block_preload(blocks, &codemap));
+        }
+        // Le profil matériel mesure l'interpréteur de référence, instruction par instruction
+        static HwProfile hwprof_state;
+        HwProfile *hwprof = NULL;
+        if (hwprof_period) {
+            if (blocks) printf("Note : --hwprof mesure l'interpreteur de reference (--engine=block ignore)\n");
+            if (!hwprof_open(&hwprof_state, hwprof_period)) return 1;
+            hwprof = &hwprof_state;
+        }
+        // Couverture : instruction par instruction, comme le profil
+        static Coverage coverage_state;
+        Coverage *coverage = NULL;
+        if (coverage_path) {
+            if (blocks) printf("Note : --coverage utilise l'interpreteur de reference (--engine=block ignore)\n");
+            if (hwprof) printf("Note : --coverage et --hwprof : le profil est ignore\n");
+            cov_init(&coverage_state, variant);
+            coverage = &coverage_state;
+        }
         
-        // 2. Forçage du démarrage (UNE SEULE FOIS)
+        // 2. Forçage du démarrage (UNE SEULE FOIS), sauf --start=reset
         //printf("Forcage du demarrage a 0x0400...\n");
-        cpu.PC = 0x0400; 
+        if (start_pc >= 0) cpu.PC = (u16)start_pc;
+        static HangDetector hang;
+        if (detect_hang) {
+            mem_set_hashing(&mem, 1); // Empreinte tenue à jour seulement ici
+            hang_init(&hang, &cpu);
+        }
+        // Trace binaire : une entrée par instruction (le moteur à blocs est
+        // remplacé par l'interpréteur, comme avec --trace)
+        static TraceWriter tracer_state;
+        TraceWriter *tracer = NULL;
+        if (trace_path) {
+            if (!trace_create(&tracer_state, trace_path)) return 1;
+            if (mem_add_watch(&mem, 0x0000, 0xFFFF, MEM_WATCH_WRITE, trace_watch, &tracer_state) < 0) {
+                printf("Erreur : trop de watchpoints (max %d)\n", MAX_WATCHPOINTS);
+                return 1;
+            }
+            tracer = &tracer_state;
+        }
 
         printf("Execution...\n");
+        fflush(stdout); // L'ACIA écrit directement sur le descripteur
+        if (clock_mhz > 0.0) pace_init(&pacer, clock_mhz * 1e6, slice_us, cpu.cycles);
         
         // 3. Boucle d'exécution
         while (1) {
-
-           
-            cpu_step(&cpu);
+            if (trace) {
+                printf("TRACE PC: 0x%04X A: 0x%02X X: 0x%02X Y: 0x%02X P: 0x%02X SP: 0x%02X\n",
+                       cpu.PC, cpu.A, cpu.X, cpu.Y, cpu.P, cpu.SP);
+            }
+            if (tracer) trace_step(tracer, &cpu);
+            if (coverage) {
+                cov_step(coverage, &cpu);
+                counters->instructions++;
+            } else if (hwprof) {
+                hwprof_step(hwprof, &cpu);
+                counters->instructions++;
+            } else if (blocks && !trace && !tracer) {
+                // Le bloc s'arrête à la prochaine échéance (les périphériques
+                // restent au cycle près) ou à la limite de cycles
+                u64 until = sched.next;
+                if (max_cycles && max_cycles + 1 < until) until = max_cycles + 1;
+                // Tranches courtes pour la détection (un pas = un appel)
+                if (detect_hang && cpu.cycles + HANG_BLOCK_CYCLES < until) until = cpu.cycles + HANG_BLOCK_CYCLES;
+                counters->instructions += block_exec(blocks, until);
+            } else {
+                cpu_step(&cpu);
+                counters->instructions++;
+            }
+            sched_poll(&sched, cpu.cycles);
+            if (clock_mhz > 0.0 && pace_due(&pacer, cpu.cycles)) {
+                pace_wait(&pacer, cpu.cycles);
+            }
+            if (stop_requested || hostcall.exited) break;
 // Détection du succès ou de l'échec
             // 1. Détection du SUCCÈS
-            // Si le PC arrive à l'adresse 0x37A3, le test est fini et réussi
-            if (cpu.PC == 0x37A3) {
+            // Si le PC arrive à l'adresse de succès, le test est fini et réussi
+            if (cpu.PC == SUCCESS_PC) {
                 printf("\n========================================\n");
                 printf("   TEST SUITE PASSED WITH SUCCESS !\n");
                 printf("   (Le programme a bouclé sur l'adresse de succès)\n");
@@ -75,15 +678,19 @@ int main(int argc, char **argv) {
                 break; // IMPORTANT : Arrête la boucle ici !
             }
             
-            // Sécurité
-                        // Sécurité Timeout
-            // Sécurité Timeout
-            if (cpu.cycles > 10000000) {
-                printf("\nTimeout ! Le CPU semble bloque.\n");
-                printf("Adresse de blocage : 0x%04X\n", cpu.PC);
+            // 2. Détection de l'ÉCHEC : état déjà vu (piège du test), ou limite de cycles
+            int hung = detect_hang && hang_check(&hang, &cpu);
+            if (hung || (max_cycles && cpu.cycles > max_cycles)) {
+                if (hung) {
+                    printf("\nBoucle infinie detectee : etat repete toutes les %llu cycles (%u pas).\n",
+                           (unsigned long long)hang.period_cycles, hang.period_steps);
+                } else {
+                    printf("\nLimite de cycles atteinte ! Le CPU semble bloque.\n");
+                }
+                printf("Adresse de blocage : 0x%04X (cycle %llu)\n", cpu.PC, (unsigned long long)cpu.cycles);
                 
-                // Lire le numéro du test en cours (adresse standard $0210 pour ce test ROM)
-                u8 test_num = mem_read(&mem, 0x0210);
+                // Lire le numéro du test en cours (adresse $0200 pour ce test ROM)
+                u8 test_num = mem_peek(&mem, TEST_NUMBER);
                 printf("Numero du test en cours : %d\n", test_num);
                 
                 // Afficher l'etat des registres
@@ -95,6 +702,64 @@ printf("\n");
                 break;
             }
         }
+        if (clock_mhz > 0.0) pace_report(&pacer, cpu.cycles, stdout);
+        if (tracer) {
+            u64 steps = tracer->total_steps;
+            if (!trace_finish(tracer)) return 1;
+            printf("Trace : %llu instructions, %llu octets (%.2f par instruction, %llu avant compression) -> %s\n",
+                   (unsigned long long)steps, (unsigned long long)tracer->file_bytes,
+                   steps ? (double)tracer->file_bytes / steps : 0.0, (unsigned long long)tracer->raw_bytes,
+                   trace_path);
+        }
+        if (irq_latency) irqlat_report(&latency, stdout);
+        if (fb_config.enabled) {
+            // Sans --fb-shot : une capture de l'écran final
+            if (!fb_config.shot_count && !fb_save(&screen.fb, fb_config.path)) screen.failed = 1;
+            printf("Ecran : %llu ecritures, %llu lignes redessinees en %llu rendus",
+                   (unsigned long long)screen.fb.writes, (unsigned long long)screen.fb.lines_rendered,
+                   (unsigned long long)screen.fb.renders);
+            if (fb_config.shot_count) printf(", %d captures sur %d", screen.next, fb_config.shot_count);
+            printf("\n");
+            if (screen.failed) return 1;
+        }
+        if (coverage) {
+            CovSummary s;
+            cov_summary(coverage, &s);
+            if (!cov_save(coverage, coverage_path)) return 1;
+            printf("Couverture : %u instructions, %u branches (%u dans les deux sens) -> %s\n",
+                   s.instructions, s.branches, s.both_ways, coverage_path);
+        }
+        if (hwprof) {
+            hwprof_report(hwprof, variant, stdout);
+            hwprof_close(hwprof);
+        }
+        if (blocks) {
+            printf("Blocs : %llu predecodes, %llu construits a l'execution, %llu invalides\n",
+                   (unsigned long long)blocks->preloaded,
+                   (unsigned long long)(blocks->built - blocks->preloaded),
+                   (unsigned long long)blocks->invalidated);
+            printf("Cache : %llu hits, %llu misses\n",
+                   (unsigned long long)counters->cache_hits, (unsigned long long)counters->cache_misses);
+            block_free(blocks);
+        }
+        if (banks) {
+            printf("Mapper %s : %llu changements de banque, %llu ecritures de registre\n", mapper_name(banks),
+                   (unsigned long long)banks->switches, (unsigned long long)banks->register_writes);
+        }
+        if (stats.inst) {
+            stats_publish(stats.inst, &cpu);
+            stats_export_stop();
+        }
+        if (board.hostcall_page >= 0) {
+            hostcall_close_all(&hostcall);
+            printf("Appels hote : %llu, %llu octets sans copie, %llu copies\n", (unsigned long long)hostcall.calls,
+                   (unsigned long long)hostcall.bytes_direct, (unsigned long long)hostcall.bytes_copied);
+            if (hostcall.exited) {
+                printf("Sortie demandee par le programme (cycle %llu) : code %d\n",
+                       (unsigned long long)cpu.cycles, hostcall.exit_code);
+                return hostcall.exit_code;
+            }
+        }
         
     } else {
         run_builtin_test();
@@ -0,0 +1,271 @@
+#include "mapper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Rend visibles 'count' pages de 'read' à partir de first_page. Ne compte que
+// les changements effectifs : réécrire la banque courante ne coûte rien et
+// n'invalide aucun bloc.
+static void map(Mapper *m, u8 first_page, int count, u8 *read, u8 *write) {
+    Memory *mem = m->mem;
+    if (mem->page[first_page] == read && mem->write_page[first_page] == write) return;
+    mem_map_pages(mem, first_page, count, read, write);
+    m->switches++;
+}
+
+static void unmap(Mapper *m, u8 first_page, int count) {
+    u8 *ram = &m->mem->data[first_page << 8];
+    map(m, first_page, count, ram, ram);
+}
+
+// Fichier entier en mémoire (NULL en cas d'erreur, message affiché)
+static u8 *read_file(const char *filename, long *size) {
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", filename);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    u8 *data = malloc(*size > 0 ? *size : 1);
+    if (data == NULL || fread(data, 1, *size, f) != (size_t)*size) {
+        printf("Erreur : lecture de %s impossible\n", filename);
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+// --- iNES ---
+
+// Banque de 16 Ko n (modulo le nombre de banques) en $8000 (slot 0) ou $C000 (slot 1)
+static void map_prg16(Mapper *m, int slot, u32 bank) {
+    u8 *base = m->rom + (bank % m->prg_banks) * INES_PRG_BANK;
+    map(m, slot ? 0xC0 : 0x80, INES_PRG_BANK / 256, base, NULL);
+}
+
+// MMC1 : $8000 contrôle, $A000 CHR 0, $C000 CHR 1, $E000 PRG
+static void mmc1_update(Mapper *m) {
+    u32 bank = m->prg & 0x0F;
+    switch ((m->control >> 2) & 3) {
+    case 0: case 1: // 32 Ko (bit 0 ignoré)
+        map_prg16(m, 0, bank & ~1u);
+        map_prg16(m, 1, bank | 1);
+        break;
+    case 2: // Première banque fixe en $8000
+        map_prg16(m, 0, 0);
+        map_prg16(m, 1, bank);
+        break;
+    default: // Dernière banque fixe en $C000
+        map_prg16(m, 0, bank);
+        map_prg16(m, 1, m->prg_banks - 1);
+        break;
+    }
+}
+
+static void mmc1_write(Mapper *m, u16 address, u8 value) {
+    if (value & 0x80) { // Remise à zéro du registre à décalage
+        m->shift = 0;
+        m->shift_count = 0;
+        m->control |= 0x0C;
+        mmc1_update(m);
+        return;
+    }
+    m->shift |= (value & 1) << m->shift_count;
+    if (++m->shift_count < 5) return;
+    // Cinquième écriture : l'adresse choisit le registre
+    switch ((address >> 13) & 3) {
+    case 0: m->control = m->shift; break;
+    case 1: m->chr0 = m->shift; break;
+    case 2: m->chr1 = m->shift; break;
+    default: m->prg = m->shift; break;
+    }
+    m->shift = 0;
+    m->shift_count = 0;
+    mmc1_update(m);
+}
+
+// Écriture en $8000-$FFFF (déjà ignorée par la ROM) : registres du mapper
+static void ines_write(void *ctx, u16 address, u8 value) {
+    Mapper *m = (Mapper *)ctx;
+    m->register_writes++;
+    switch (m->kind) {
+    case MAPPER_MMC1:
+        mmc1_write(m, address, value);
+        break;
+    case MAPPER_UXROM:
+        map_prg16(m, 0, value);
+        break;
+    case MAPPER_AXROM: // 32 Ko, bit 4 : miroir (sans PPU, ignoré)
+        map_prg16(m, 0, (value & 7) * 2);
+        map_prg16(m, 1, (value & 7) * 2 + 1);
+        break;
+    }
+}
+
+int mapper_is_ines(const char *filename) {
+    u8 magic[4];
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) return 0;
+    int ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, "NES\x1A", 4) == 0;
+    fclose(f);
+    return ok;
+}
+
+int mapper_load_ines(Mapper *m, Memory *mem, const char *filename) {
+    memset(m, 0, sizeof(*m));
+    m->mem = mem;
+    long size;
+    u8 *file = read_file(filename, &size);
+    if (file == NULL) return 0;
+    if (size < INES_HEADER_SIZE || memcmp(file, "NES\x1A", 4) != 0) {
+        printf("Erreur : %s n'est pas une ROM iNES\n", filename);
+        free(file);
+        return 0;
+    }
+    const u8 *h = file;
+    int kind = h[6] >> 4;
+    // Octets 12-15 non nuls hors NES 2.0 : en-tête d'ancien outil, quartet haut faux
+    int nes2 = (h[7] & 0x0C) == 0x08;
+    if (nes2 || (h[12] | h[13] | h[14] | h[15]) == 0) kind |= h[7] & 0xF0;
+    long trainer = (h[6] & 0x04) ? 512 : 0;
+    m->prg_banks = h[4];
+    m->rom_size = m->prg_banks * INES_PRG_BANK;
+    m->mirroring = h[6] & 1;
+    m->kind = kind;
+
+    if (kind != MAPPER_NROM && kind != MAPPER_MMC1 && kind != MAPPER_UXROM && kind != MAPPER_AXROM) {
+        printf("Erreur : mapper iNES %d non pris en charge (0 NROM, 1 MMC1, 2 UxROM, 7 AxROM)\n", kind);
+        free(file);
+        return 0;
+    }
+    if (m->prg_banks == 0 || INES_HEADER_SIZE + trainer + (long)m->rom_size > size
+        || (kind == MAPPER_AXROM && m->prg_banks < 2)) {
+        printf("Erreur : %s est tronque ou sans PRG ROM\n", filename);
+        free(file);
+        return 0;
+    }
+    m->rom = malloc(m->rom_size);
+    m->ram_size = (h[8] ? h[8] : 1) * INES_PRG_RAM;
+    m->ram = calloc(1, m->ram_size);
+    if (m->rom == NULL || m->ram == NULL) {
+        printf("Erreur : mémoire insuffisante pour la ROM\n");
+        free(file);
+        mapper_free(m);
+        return 0;
+    }
+    memcpy(m->rom, file + INES_HEADER_SIZE + trainer, m->rom_size);
+    if (trainer) memcpy(m->ram + 0x1000, file + INES_HEADER_SIZE, 512); // $7000
+    free(file);
+
+    // RAM de 2 Ko répétée en $0800, $1000 et $1800. Le code prédécodé est
+    // indexé par adresse : une écriture par un miroir n'invalide pas l'original.
+    for (int page = 0x08; page < 0x20; page += 8) map(m, (u8)page, 8, mem->data, mem->data);
+    map(m, 0x60, INES_PRG_RAM / 256, m->ram, m->ram); // Première banque de PRG RAM
+
+    // Banques au reset : la dernière banque est toujours en $C000
+    m->control = 0x0C;
+    if (kind == MAPPER_AXROM) {
+        map_prg16(m, 0, 0);
+        map_prg16(m, 1, 1);
+    } else {
+        map_prg16(m, 0, 0);
+        map_prg16(m, 1, m->prg_banks - 1);
+    }
+    if (kind != MAPPER_NROM) mem_trap_writes(mem, 0x80, 0xFF, ines_write, m);
+    m->switches = 0;
+    return 1;
+}
+
+// --- C64 ---
+
+#define C64_BASIC   0x0000 // Position dans le pool de ROM
+#define C64_KERNAL  0x2000
+#define C64_CHARGEN 0x4000
+#define C64_ROM_SIZE 0x5000
+
+// Lignes LORAM (bit 0), HIRAM (bit 1) et CHAREN (bit 2) du port $01 : une
+// broche en entrée ($00 bit à 0) est tirée à 1
+static void c64_update(Mapper *m) {
+    Memory *mem = m->mem;
+    u8 lines = (mem->data[0x01] | ~mem->data[0x00]) & 7;
+    int loram = lines & 1, hiram = lines & 2, charen = lines & 4;
+
+    if (loram && hiram) map(m, 0xA0, 32, m->rom + C64_BASIC, &mem->data[0xA000]);
+    else unmap(m, 0xA0, 32);
+    if (hiram) map(m, 0xE0, 32, m->rom + C64_KERNAL, &mem->data[0xE000]);
+    else unmap(m, 0xE0, 32);
+    if ((loram || hiram) && !charen) map(m, 0xD0, 16, m->rom + C64_CHARGEN, &mem->data[0xD000]);
+    else unmap(m, 0xD0, 16); // RAM, ou zone d'E/S
+}
+
+// Écriture en page 0 (déjà faite dans la RAM) : seuls $00 et $01 comptent
+static void c64_write(void *ctx, u16 address, u8 value) {
+    (void)value;
+    Mapper *m = (Mapper *)ctx;
+    if (address > 0x0001) return;
+    m->register_writes++;
+    c64_update(m);
+}
+
+static int load_rom_part(Mapper *m, const char *filename, u32 offset, long expected) {
+    long size;
+    u8 *data = read_file(filename, &size);
+    if (data == NULL) return 0;
+    if (size != expected) {
+        printf("Erreur : %s fait %ld octets (attendu : %ld)\n", filename, size, expected);
+        free(data);
+        return 0;
+    }
+    memcpy(m->rom + offset, data, size);
+    free(data);
+    return 1;
+}
+
+int mapper_load_c64(Mapper *m, Memory *mem, const char *basic, const char *kernal, const char *chargen) {
+    memset(m, 0, sizeof(*m));
+    m->mem = mem;
+    m->kind = MAPPER_C64;
+    m->rom_size = C64_ROM_SIZE;
+    m->rom = malloc(C64_ROM_SIZE);
+    if (m->rom == NULL) {
+        printf("Erreur : mémoire insuffisante pour les ROM\n");
+        return 0;
+    }
+    if (!load_rom_part(m, basic, C64_BASIC, 0x2000) || !load_rom_part(m, kernal, C64_KERNAL, 0x2000)
+        || !load_rom_part(m, chargen, C64_CHARGEN, 0x1000)) {
+        mapper_free(m);
+        return 0;
+    }
+    // Valeurs du KERNAL au reset : ROM et E/S visibles
+    mem_write(mem, 0x00, 0x2F);
+    mem_write(mem, 0x01, 0x37);
+    c64_update(m);
+    mem_trap_writes(mem, 0x00, 0x00, c64_write, m);
+    m->switches = 0;
+    return 1;
+}
+
+void mapper_free(Mapper *m) {
+    if (m->mem) {
+        mem_unmap_pages(m->mem, 0, 256);
+        if (m->kind == MAPPER_C64) mem_trap_writes(m->mem, 0x00, 0x00, NULL, NULL);
+        else if (m->kind != MAPPER_NROM) mem_trap_writes(m->mem, 0x80, 0xFF, NULL, NULL);
+    }
+    free(m->rom);
+    free(m->ram);
+    memset(m, 0, sizeof(*m));
+}
+
+const char *mapper_name(const Mapper *m) {
+    switch (m->kind) {
+    case MAPPER_NROM:  return "NROM";
+    case MAPPER_MMC1:  return "MMC1";
+    case MAPPER_UXROM: return "UxROM";
+    case MAPPER_AXROM: return "AxROM";
+    case MAPPER_C64:   return "C64";
+    default:           return "?";
+    }
+}
@@ -1,20 +1,253 @@
 #include "memory.h"
+#include "stats.h"
+#include <stddef.h>
 #include <string.h> // Pour memset
 
 // Initialise la mémoire à 0
 void mem_init(Memory *mem) {
     memset(mem->data, 0, sizeof(mem->data));
+    memset(mem->page_flags, 0, sizeof(mem->page_flags));
+    memset(mem->io, 0, sizeof(mem->io));
+    mem->pc = NULL;
+    mem->watch_count = 0;
+    mem->code_write = NULL;
+    mem->code_remap = NULL;
+    mem->code_ctx = NULL;
+    memset(mem->write_page, 0, sizeof(mem->write_page));
+    mem->hash = 0;
+    mem->hashing = 0;
+    mem_unmap_pages(mem, 0, 256);
 }
 
-// Lit un octet à une adresse donnée
-u8 mem_read(Memory *mem, u16 address) {
-    // L'adresse ne peut pas dépasser 0xFFFF car u16 va jusqu'à 65535
-    return mem->data[address];
+// --- Empreinte ---
+
+// Contribution d'une page (256 octets vus en page << 8) à l'empreinte
+static u64 page_hash(int page, const u8 *bytes) {
+    u64 h = 0;
+    for (int i = 0; i < 256; i++) h ^= mem_byte_hash((u16)(page << 8 | i), bytes[i]);
+    return h;
+}
+
+void mem_rehash(Memory *mem) {
+    if (!mem->hashing) return;
+    u64 h = 0;
+    for (int page = 0; page < 256; page++) {
+        if (mem->write_page[page]) h ^= page_hash(page, mem->write_page[page]);
+    }
+    mem->hash = h;
+}
+
+void mem_set_hashing(Memory *mem, int on) {
+    mem->hashing = on;
+    mem->hash = 0;
+    mem_rehash(mem);
+}
+
+void mem_load_bytes(Memory *mem, u16 address, const void *bytes, u32 size) {
+    if ((u32)address + size > MAX_MEMORY) size = MAX_MEMORY - address;
+    memcpy(&mem->data[address], bytes, size);
+    mem_rehash(mem);
+}
+
+// --- Watchpoints ---
+
+// Recalcule les drapeaux de page à partir des périphériques et des watchpoints
+static void mem_update_page_flags(Memory *mem) {
+    for (int page = 0; page < 256; page++) {
+        const IoHandler *io = &mem->io[page];
+        mem->page_flags[page] = (mem->page_flags[page] & (MEM_PAGE_CODE | MEM_PAGE_ROM | MEM_PAGE_COW))
+                              | (io->read ? MEM_PAGE_IO : io->write ? MEM_PAGE_WRITE_TRAP : 0);
+    }
+    for (int i = 0; i < mem->watch_count; i++) {
+        Watchpoint *w = &mem->watches[i];
+        for (int page = w->start >> 8; page <= (w->end >> 8); page++) {
+            mem->page_flags[page] |= w->kinds;
+        }
+    }
+}
+
+int mem_add_watch(Memory *mem, u16 start, u16 end, u8 kinds, WatchFunc callback, void *ctx) {
+    if (mem->watch_count >= MAX_WATCHPOINTS || start > end) {
+        return -1;
+    }
+    Watchpoint *w = &mem->watches[mem->watch_count];
+    w->start = start;
+    w->end = end;
+    w->kinds = kinds;
+    w->callback = callback;
+    w->ctx = ctx;
+    mem->watch_count++;
+    mem_update_page_flags(mem);
+    return mem->watch_count - 1;
+}
+
+void mem_remove_watch(Memory *mem, int index) {
+    if (index < 0 || index >= mem->watch_count) return;
+    // On décale les suivants (les index des watchpoints suivants diminuent de 1)
+    for (int i = index; i < mem->watch_count - 1; i++) {
+        mem->watches[i] = mem->watches[i + 1];
+    }
+    mem->watch_count--;
+    mem_update_page_flags(mem);
+}
+
+// --- Périphériques (MMIO) ---
+
+void mem_map_io(Memory *mem, u8 first_page, u8 last_page, IoReadFunc read, IoWriteFunc write, void *ctx) {
+    for (int page = first_page; page <= last_page; page++) {
+        mem->io[page].read = read;
+        mem->io[page].write = write;
+        mem->io[page].ctx = ctx;
+    }
+    mem_update_page_flags(mem);
+}
+
+void mem_unmap_io(Memory *mem, u8 first_page, u8 last_page) {
+    for (int page = first_page; page <= last_page; page++) {
+        memset(&mem->io[page], 0, sizeof(IoHandler));
+    }
+    mem_update_page_flags(mem);
+}
+
+void mem_mark_code(Memory *mem, u8 page, int on) {
+    if (on) mem->page_flags[page] |= MEM_PAGE_CODE; else mem->page_flags[page] &= ~MEM_PAGE_CODE;
+}
+
+// --- Banques ---
+
+void mem_map_pages(Memory *mem, u8 first_page, int count, u8 *read, u8 *write) {
+    for (int i = 0; i < count && first_page + i < 256; i++) {
+        int page = first_page + i;
+        // L'empreinte suit la cible des écritures
+        if (mem->hashing && mem->write_page[page]) mem->hash ^= page_hash(page, mem->write_page[page]);
+        if (mem->hashing && write) mem->hash ^= page_hash(page, write + i * 256);
+        mem->page[page] = read + i * 256;
+        mem->write_page[page] = write ? write + i * 256 : NULL;
+        mem->page_flags[page] &= ~MEM_PAGE_COW;
+        if (read == write) mem->page_flags[page] &= ~MEM_PAGE_ROM;
+        else mem->page_flags[page] |= MEM_PAGE_ROM;
+        // Seul le code de cette page est à refaire
+        if ((mem->page_flags[page] & MEM_PAGE_CODE) && mem->code_remap) {
+            mem->code_remap(mem->code_ctx, (u8)page);
+        }
+    }
+}
+
+void mem_unmap_pages(Memory *mem, u8 first_page, int count) {
+    mem_map_pages(mem, first_page, count, &mem->data[first_page << 8], &mem->data[first_page << 8]);
+}
+
+void mem_trap_writes(Memory *mem, u8 first_page, u8 last_page, IoWriteFunc write, void *ctx) {
+    for (int page = first_page; page <= last_page; page++) {
+        mem->io[page].read = NULL;
+        mem->io[page].write = write;
+        mem->io[page].ctx = ctx;
+    }
+    mem_update_page_flags(mem);
+}
+
+void mem_copy(Memory *dst, const Memory *src) {
+    memcpy(dst, src, sizeof(Memory));
+    const u8 *begin = src->data, *end = src->data + MAX_MEMORY;
+    for (int page = 0; page < 256; page++) {
+        if (src->page[page] >= begin && src->page[page] < end) {
+            dst->page[page] = dst->data + (src->page[page] - begin);
+        }
+        if (src->write_page[page] >= begin && src->write_page[page] < end) {
+            dst->write_page[page] = dst->data + (src->write_page[page] - begin);
+        }
+    }
+}
+
+void mem_fork(Memory *dst, const Memory *src) {
+    // Tout sauf data
+    memcpy(&dst->page_flags, &src->page_flags, sizeof(Memory) - offsetof(Memory, page_flags));
+    const u8 *begin = src->data, *end = src->data + MAX_MEMORY;
+    for (int page = 0; page < 256; page++) {
+        const u8 *w = src->write_page[page];
+        // RAM de src (ou déjà partagée par src) : partagée à son tour
+        if ((src->page_flags[page] & MEM_PAGE_COW) || (w >= begin && w < end)) {
+            dst->page_flags[page] |= MEM_PAGE_COW;
+        }
+    }
+}
+
+void mem_refork(Memory *dst, const Memory *src) {
+    for (int page = 0; page < 256; page++) {
+        if (dst->write_page[page] == &dst->data[page << 8] && dst->write_page[page] != src->write_page[page]) {
+            dst->page[page] = src->page[page];
+            dst->write_page[page] = src->write_page[page];
+            dst->page_flags[page] |= MEM_PAGE_COW;
+        }
+    }
+    // Seules les pages recopiées ont pu être écrites
+    dst->hash = src->hash;
+}
+
+// Première écriture dans une page partagée : elle devient privée
+static void mem_unshare(Memory *mem, int page) {
+    u8 *own = &mem->data[page << 8];
+    u8 *shared = mem->write_page[page];
+    memcpy(own, shared, 256);
+    if (mem->page[page] == shared) mem->page[page] = own;
+    mem->write_page[page] = own;
+    mem->page_flags[page] &= ~MEM_PAGE_COW;
+}
+
+// Appelle les callbacks des watchpoints concernés par cet accès
+static void mem_notify(Memory *mem, u16 address, u8 value, u8 kind) {
+    u16 pc = mem->pc ? *mem->pc : 0;
+    for (int i = 0; i < mem->watch_count; i++) {
+        Watchpoint *w = &mem->watches[i];
+        if ((w->kinds & kind) && address >= w->start && address <= w->end) {
+            w->callback(w->ctx, pc, address, value, kind);
+        }
+    }
+}
+
+u8 mem_read_slow(Memory *mem, u16 address) {
+    IoHandler *io = &mem->io[address >> 8];
+    u8 value;
+    if (io->read) {
+        stats_current->mmio_reads++;
+        value = io->read(io->ctx, address);
+    } else {
+        value = mem->page[address >> 8][address & 0xFF];
+    }
+    if (mem->page_flags[address >> 8] & MEM_WATCH_READ) {
+        mem_notify(mem, address, value, MEM_WATCH_READ);
+    }
+    return value;
+}
+
+void mem_write_slow(Memory *mem, u16 address, u8 value) {
+    IoHandler *io = &mem->io[address >> 8];
+    if (mem->page_flags[address >> 8] & MEM_PAGE_COW) mem_unshare(mem, address >> 8);
+    u8 flags = mem->page_flags[address >> 8];
+    if (io->read) {
+        stats_current->mmio_writes++;
+        if (io->write) io->write(io->ctx, address, value);
+    } else {
+        u8 *target = (flags & MEM_PAGE_ROM) ? mem->write_page[address >> 8] : mem->page[address >> 8];
+        if (target) { // ROM : RAM sous la ROM, ou écriture ignorée
+            mem_hash_update(mem, address, target[address & 0xFF], value);
+            target[address & 0xFF] = value;
+        }
+        if (io->write) { // Registre de mapper : peut changer les pages
+            stats_current->mmio_writes++;
+            io->write(io->ctx, address, value);
+        }
+    }
+    if (mem->page_flags[address >> 8] & MEM_WATCH_WRITE) {
+        mem_notify(mem, address, value, MEM_WATCH_WRITE);
+    }
+    if ((mem->page_flags[address >> 8] & MEM_PAGE_CODE) && mem->code_write) {
+        mem->code_write(mem->code_ctx, address);
+    }
 }
 
-// Écrit un octet à une adresse donnée
-void mem_write(Memory *mem, u16 address, u8 value) {
-    mem->data[address] = value;
+void mem_exec_slow(Memory *mem, u16 address) {
+    mem_notify(mem, address, mem_peek(mem, address), MEM_WATCH_EXEC);
 }
 
 #include <stdio.h>
@@ -43,5 +276,6 @@ int mem_load(Memory *mem, const char *filename, u16 offset) {
     fread(&mem->data[offset], 1, size, f);
     
     fclose(f);
+    mem_rehash(mem);
     return (int)size;
 }
\ No newline at end of file
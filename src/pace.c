@@ -0,0 +1,95 @@
+#include "pace.h"
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+static u64 host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Temps hôte auquel le cycle 'cycles' doit être atteint
+static u64 pace_deadline(const Pacer *p, u64 cycles) {
+    return p->origin_ns + (u64)((double)(cycles - p->origin_cycles) * 1e9 / p->hz);
+}
+
+void pace_init(Pacer *p, double hz, u64 slice_us, u64 now_cycles) {
+    memset(p, 0, sizeof(*p));
+    p->hz = hz;
+    p->slice_ns = (slice_us ? slice_us : 1000) * 1000;
+    p->slice_cycles = (u64)(hz * p->slice_ns / 1e9);
+    if (p->slice_cycles == 0) p->slice_cycles = 1;
+    p->max_lag_ns = 100 * 1000000ull; // 100 ms
+    p->origin_ns = host_ns();
+    p->origin_cycles = now_cycles;
+    p->slice_end = now_cycles + p->slice_cycles;
+    p->start_ns = p->origin_ns;
+    p->start_cycles = now_cycles;
+    p->last_wake_ns = p->origin_ns;
+    p->jitter_min_ns = INT64_MAX;
+    p->jitter_max_ns = INT64_MIN;
+}
+
+void pace_wait(Pacer *p, u64 now_cycles) {
+    u64 now = host_ns();
+    u64 deadline = pace_deadline(p, now_cycles);
+    p->slices++;
+    p->busy_ns += now - p->last_wake_ns;
+
+    if (now >= deadline) {
+        // En retard : pas de sommeil, la tranche suivante part tout de suite
+        u64 lag = now - deadline;
+        p->overruns++;
+        if (lag > p->lag_max_ns) p->lag_max_ns = lag;
+        if (lag > p->max_lag_ns) {
+            p->origin_ns = now;
+            p->origin_cycles = now_cycles;
+            p->resyncs++;
+        }
+        p->last_wake_ns = now;
+    } else {
+        struct timespec ts;
+        ts.tv_sec = deadline / 1000000000ull;
+        ts.tv_nsec = deadline % 1000000000ull;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+        u64 woke = host_ns();
+        s64 jitter = (s64)(woke - deadline);
+        if (jitter < p->jitter_min_ns) p->jitter_min_ns = jitter;
+        if (jitter > p->jitter_max_ns) p->jitter_max_ns = jitter;
+        p->jitter_sum += (double)jitter;
+        p->jitter_sq += (double)jitter * jitter;
+        p->sleeps++;
+        p->last_wake_ns = woke;
+    }
+    // La tranche suivante se cale sur la grille (l'instruction qui a franchi
+    // la frontière a pu la dépasser de quelques cycles)
+    p->slice_end = now_cycles + p->slice_cycles - (now_cycles - p->origin_cycles) % p->slice_cycles;
+}
+
+double pace_effective_hz(const Pacer *p, u64 now_cycles) {
+    u64 elapsed = host_ns() - p->start_ns;
+    return elapsed ? (double)(now_cycles - p->start_cycles) * 1e9 / elapsed : 0.0;
+}
+
+void pace_report(const Pacer *p, u64 now_cycles, FILE *out) {
+    u64 elapsed = host_ns() - p->start_ns;
+    fprintf(out, "=== Cadencement ===\n");
+    fprintf(out, "Cible      : %.4f MHz, tranches de %llu us (%llu cycles)\n",
+            p->hz / 1e6, (unsigned long long)(p->slice_ns / 1000), (unsigned long long)p->slice_cycles);
+    fprintf(out, "Effectif   : %.4f MHz sur %.3f s\n", pace_effective_hz(p, now_cycles) / 1e6, elapsed / 1e9);
+    fprintf(out, "Tranches   : %llu, depassements : %llu (%.2f %%), resynchronisations : %llu\n",
+            (unsigned long long)p->slices, (unsigned long long)p->overruns,
+            p->slices ? 100.0 * p->overruns / p->slices : 0.0, (unsigned long long)p->resyncs);
+    fprintf(out, "Charge     : %.1f %% du temps hote passe a emuler, retard max %.3f ms\n",
+            elapsed ? 100.0 * p->busy_ns / elapsed : 0.0, p->lag_max_ns / 1e6);
+    if (p->sleeps) {
+        double mean = p->jitter_sum / p->sleeps;
+        double var = p->jitter_sq / p->sleeps - mean * mean;
+        fprintf(out, "Gigue      : moy %.1f us, ecart-type %.1f us, min %.1f us, max %.1f us\n",
+                mean / 1e3, sqrt(var > 0 ? var : 0) / 1e3,
+                p->jitter_min_ns / 1e3, p->jitter_max_ns / 1e3);
+    }
+}
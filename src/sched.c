@@ -0,0 +1,62 @@
+#include "sched.h"
+#include <string.h>
+
+void sched_init(Scheduler *s) {
+    memset(s, 0, sizeof(*s));
+    s->next = SCHED_NEVER;
+}
+
+static void sched_update_next(Scheduler *s) {
+    u64 next = SCHED_NEVER;
+    for (int i = 0; i < s->count; i++) {
+        if (s->events[i].deadline < next) next = s->events[i].deadline;
+    }
+    s->next = next;
+}
+
+int sched_add(Scheduler *s, SchedFunc fn, void *ctx) {
+    if (s->count >= MAX_EVENTS) return -1;
+    SchedEvent *e = &s->events[s->count];
+    e->deadline = SCHED_NEVER;
+    e->fn = fn;
+    e->ctx = ctx;
+    return s->count++;
+}
+
+void sched_set(Scheduler *s, int id, u64 deadline) {
+    s->events[id].deadline = deadline;
+    if (deadline < s->next) {
+        s->next = deadline;
+    } else {
+        sched_update_next(s);
+    }
+}
+
+void sched_cancel(Scheduler *s, int id) {
+    sched_set(s, id, SCHED_NEVER);
+}
+
+void sched_dispatch(Scheduler *s, u64 now) {
+    // Un callback peut reprogrammer son événement (ou un autre) : on boucle
+    // jusqu'à ce qu'il ne reste plus rien d'échu.
+    while (s->next <= now) {
+        for (int i = 0; i < s->count; i++) {
+            SchedEvent *e = &s->events[i];
+            if (e->deadline <= now) {
+                e->deadline = SCHED_NEVER;
+                e->fn(e->ctx, now);
+            }
+        }
+        sched_update_next(s);
+    }
+}
+
+void sched_run(Scheduler *s, CPU *cpu, u64 until) {
+    while (cpu->cycles < until) {
+        u64 target = s->next < until ? s->next : until;
+        while (cpu->cycles < target) {
+            cpu_step(cpu);
+        }
+        sched_poll(s, cpu->cycles);
+    }
+}
@@ -0,0 +1,275 @@
+#include "stats.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static StatCounters stats_discard; // Compteurs d'un thread sans instance
+__thread StatCounters *stats_current = &stats_discard;
+
+static StatsInstance instances[STATS_MAX_INSTANCES];
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static u64 host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// --- Instances ---
+
+// Valeur d'étiquette Prometheus : \, " et fin de ligne échappés. Un nom
+// de 47 caractères tient toujours en entier.
+static void escape_label(char *out, size_t size, const char *name) {
+    size_t n = 0;
+    for (const char *s = name; *s && n + 3 <= size; s++) {
+        if (*s == '\\' || *s == '"') {
+            out[n++] = '\\';
+        } else if (*s == '\n') {
+            out[n++] = '\\';
+            out[n++] = 'n';
+            continue;
+        }
+        out[n++] = *s;
+    }
+    out[n] = 0;
+}
+
+StatsInstance *stats_register(const char *name) {
+    StatsInstance *inst = NULL;
+    pthread_mutex_lock(&registry_lock);
+    for (int i = 0; i < STATS_MAX_INSTANCES; i++) {
+        if (!instances[i].used) {
+            inst = &instances[i];
+            memset(inst, 0, sizeof(*inst));
+            escape_label(inst->name, sizeof(inst->name), name);
+            inst->start_ns = inst->published_ns = host_ns();
+            inst->used = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&registry_lock);
+    if (inst) stats_current = &inst->local;
+    return inst;
+}
+
+void stats_unregister(StatsInstance *inst) {
+    if (inst == NULL) return;
+    if (stats_current == &inst->local) stats_current = &stats_discard;
+    pthread_mutex_lock(&registry_lock);
+    inst->used = 0;
+    pthread_mutex_unlock(&registry_lock);
+}
+
+void stats_publish(StatsInstance *inst, const CPU *cpu) {
+    if (cpu) inst->local.cycles = cpu->cycles;
+    u64 now = host_ns();
+    u64 prev_cycles = inst->published.cycles;
+    u64 prev_ns = inst->published_ns;
+    __atomic_store_n(&inst->seq, inst->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (now > prev_ns && inst->local.cycles >= prev_cycles) {
+        inst->mhz = (double)(inst->local.cycles - prev_cycles) * 1e3 / (now - prev_ns);
+    }
+    inst->published = inst->local;
+    inst->published_ns = now;
+    __atomic_store_n(&inst->seq, inst->seq + 1, __ATOMIC_RELEASE);
+}
+
+// Lit une copie cohérente des compteurs publiés
+static void stats_read(const StatsInstance *inst, StatCounters *out, u64 *when, double *mhz) {
+    unsigned seq;
+    do {
+        seq = __atomic_load_n(&inst->seq, __ATOMIC_ACQUIRE);
+        *out = inst->published;
+        *when = inst->published_ns;
+        *mhz = inst->mhz;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&inst->seq, __ATOMIC_RELAXED));
+}
+
+// --- Rendu Prometheus ---
+
+typedef struct {
+    const char *name, *help, *type;
+    size_t offset; // Dans StatCounters
+} Metric;
+
+static const Metric metrics[] = {
+    { "emu6502_instructions_total", "Instructions executees", "counter", offsetof(StatCounters, instructions) },
+    { "emu6502_cycles_total", "Cycles CPU emules", "counter", offsetof(StatCounters, cycles) },
+    { "emu6502_irqs_total", "IRQ prises", "counter", offsetof(StatCounters, irqs) },
+    { "emu6502_nmis_total", "NMI prises", "counter", offsetof(StatCounters, nmis) },
+    { "emu6502_mmio_reads_total", "Lectures de peripheriques", "counter", offsetof(StatCounters, mmio_reads) },
+    { "emu6502_mmio_writes_total", "Ecritures de peripheriques", "counter", offsetof(StatCounters, mmio_writes) },
+    { "emu6502_cache_hits_total", "Succes du cache de blocs", "counter", offsetof(StatCounters, cache_hits) },
+    { "emu6502_cache_misses_total", "Echecs du cache de blocs", "counter", offsetof(StatCounters, cache_misses) },
+};
+#define METRIC_COUNT (int)(sizeof(metrics) / sizeof(metrics[0]))
+
+#define APPEND(...) do { \
+        int n_ = snprintf(buf + len, len < size ? size - len : 0, __VA_ARGS__); \
+        if (n_ > 0) len += n_; \
+    } while (0)
+
+int stats_render(char *buf, int size) {
+    static StatCounters snap[STATS_MAX_INSTANCES];
+    static u64 when[STATS_MAX_INSTANCES], start[STATS_MAX_INSTANCES];
+    static double mhz[STATS_MAX_INSTANCES];
+    static char names[STATS_MAX_INSTANCES][sizeof(instances[0].name)];
+    int used[STATS_MAX_INSTANCES];
+    int len = 0;
+
+    pthread_mutex_lock(&registry_lock);
+    for (int i = 0; i < STATS_MAX_INSTANCES; i++) {
+        used[i] = instances[i].used;
+        if (!used[i]) continue;
+        stats_read(&instances[i], &snap[i], &when[i], &mhz[i]);
+        start[i] = instances[i].start_ns;
+        memcpy(names[i], instances[i].name, sizeof(names[i]));
+    }
+
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        APPEND("# HELP %s %s\n# TYPE %s %s\n", metrics[m].name, metrics[m].help, metrics[m].name, metrics[m].type);
+        for (int i = 0; i < STATS_MAX_INSTANCES; i++) {
+            if (!used[i]) continue;
+            u64 value = *(const u64 *)((const char *)&snap[i] + metrics[m].offset);
+            APPEND("%s{instance=\"%s\"} %llu\n", metrics[m].name, names[i], (unsigned long long)value);
+        }
+    }
+
+    APPEND("# HELP emu6502_effective_mhz Frequence emulee entre les deux dernieres publications\n"
+           "# TYPE emu6502_effective_mhz gauge\n");
+    for (int i = 0; i < STATS_MAX_INSTANCES; i++) {
+        if (!used[i]) continue;
+        APPEND("emu6502_effective_mhz{instance=\"%s\"} %.4f\n", names[i], mhz[i]);
+    }
+    APPEND("# HELP emu6502_average_mhz Frequence emulee moyenne depuis le demarrage\n"
+           "# TYPE emu6502_average_mhz gauge\n");
+    for (int i = 0; i < STATS_MAX_INSTANCES; i++) {
+        if (!used[i]) continue;
+        double mhz = when[i] > start[i] ? (double)snap[i].cycles * 1e3 / (when[i] - start[i]) : 0.0;
+        APPEND("emu6502_average_mhz{instance=\"%s\"} %.4f\n", names[i], mhz);
+    }
+    pthread_mutex_unlock(&registry_lock);
+    return len;
+}
+
+// --- Export ---
+
+static struct {
+    pthread_t thread;
+    int running;
+    int stop_pipe[2];   // Réveille le thread pour l'arrêter
+    int listen_fd;      // Mode socket
+    char path[108];
+    int is_socket;
+    int interval_ms;
+    char buf[64 * 1024];
+} exporter = { .listen_fd = -1, .stop_pipe = { -1, -1 } };
+
+// Écrit le fichier sous un nom temporaire puis le renomme : un lecteur ne voit
+// jamais un fichier à moitié écrit
+static void export_file(void) {
+    char tmp[128];
+    int len = stats_render(exporter.buf, sizeof(exporter.buf));
+    if (len > (int)sizeof(exporter.buf)) len = sizeof(exporter.buf);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", exporter.path);
+    FILE *f = fopen(tmp, "w");
+    if (f == NULL) return;
+    fwrite(exporter.buf, 1, len, f);
+    fclose(f);
+    rename(tmp, exporter.path);
+}
+
+static void export_client(int fd) {
+    int len = stats_render(exporter.buf, sizeof(exporter.buf));
+    if (len > (int)sizeof(exporter.buf)) len = sizeof(exporter.buf);
+    for (int off = 0; off < len; ) {
+        ssize_t n = write(fd, exporter.buf + off, len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        off += n;
+    }
+    close(fd);
+}
+
+static void *export_thread(void *arg) {
+    (void)arg;
+    struct pollfd fds[2];
+    fds[0].fd = exporter.stop_pipe[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = exporter.listen_fd;
+    fds[1].events = POLLIN;
+    int nfds = exporter.is_socket ? 2 : 1;
+
+    for (;;) {
+        int r = poll(fds, nfds, exporter.is_socket ? -1 : exporter.interval_ms);
+        if (r < 0 && errno != EINTR) break;
+        if (fds[0].revents) break;
+        if (exporter.is_socket) {
+            if (fds[1].revents & POLLIN) {
+                int client = accept(exporter.listen_fd, NULL, NULL);
+                if (client >= 0) export_client(client);
+            }
+        } else {
+            export_file();
+        }
+    }
+    return NULL;
+}
+
+int stats_export_start(const char *target, double interval) {
+    if (exporter.running) return 1;
+    exporter.interval_ms = interval > 0 ? (int)(interval * 1000) : 1000;
+    exporter.is_socket = strncmp(target, "unix:", 5) == 0;
+    snprintf(exporter.path, sizeof(exporter.path), "%s", exporter.is_socket ? target + 5 : target);
+
+    if (exporter.is_socket) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", exporter.path);
+        unlink(exporter.path);
+        exporter.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (exporter.listen_fd < 0 || bind(exporter.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+            || listen(exporter.listen_fd, 8) < 0) {
+            printf("Erreur : impossible d'ouvrir la socket %s\n", exporter.path);
+            if (exporter.listen_fd >= 0) close(exporter.listen_fd);
+            exporter.listen_fd = -1;
+            return 0;
+        }
+    }
+    if (pipe(exporter.stop_pipe) < 0) return 0;
+    if (pthread_create(&exporter.thread, NULL, export_thread, NULL) != 0) {
+        printf("Erreur : impossible de demarrer le thread d'export\n");
+        return 0;
+    }
+    exporter.running = 1;
+    return 1;
+}
+
+void stats_export_stop(void) {
+    if (!exporter.running) return;
+    if (write(exporter.stop_pipe[1], "", 1) < 0) {
+        // Le thread sera quand même arrêté à la fin du processus
+    }
+    pthread_join(exporter.thread, NULL);
+    close(exporter.stop_pipe[0]);
+    close(exporter.stop_pipe[1]);
+    if (exporter.is_socket) {
+        close(exporter.listen_fd);
+        unlink(exporter.path);
+        exporter.listen_fd = -1;
+    } else {
+        export_file(); // Dernier état
+    }
+    exporter.running = 0;
+}
@@ -0,0 +1,460 @@
+#include "trace.h"
+#include "lz4.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_MAGIC "E65T"
+#define CHUNK_MAGIC "E65K"
+#define INDEX_MAGIC "E65I"
+#define TRACE_FORMAT 1
+#define TRACE_HEADER 32
+#define CHUNK_HEADER 40
+#define INDEX_RECORD 32
+
+#define OP_WRITE 0x80
+#define OP_WRITE_ZP 0x81
+#define OP_WRITE_STACK 0x82
+
+static void put16(u8 *p, u16 v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+static void put32(u8 *p, u32 v) { for (int i = 0; i < 4; i++) p[i] = (u8)(v >> (8 * i)); }
+static void put64(u8 *p, u64 v) { for (int i = 0; i < 8; i++) p[i] = (u8)(v >> (8 * i)); }
+static u16 get16(const u8 *p) { return p[0] | (p[1] << 8); }
+static u32 get32(const u8 *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24); }
+static u64 get64(const u8 *p) { return get32(p) | ((u64)get32(p + 4) << 32); }
+
+// --- Écriture ---
+
+// Au moins n octets libres dans le paquet en cours
+static int reserve(TraceWriter *w, u32 n) {
+    if (w->raw_size + n <= w->raw_cap) return 1;
+    u32 cap = w->raw_cap ? w->raw_cap * 2 : 1 << 18;
+    while (cap < w->raw_size + n) cap *= 2;
+    u8 *raw = realloc(w->raw, cap);
+    if (raw == NULL) {
+        w->error = 1;
+        return 0;
+    }
+    w->raw = raw;
+    w->raw_cap = cap;
+    return 1;
+}
+
+static void write_header(TraceWriter *w, u64 index_offset) {
+    u8 h[TRACE_HEADER] = { 0 };
+    memcpy(h, TRACE_MAGIC, 4);
+    h[4] = TRACE_FORMAT;
+    put32(h + 8, TRACE_CHUNK_STEPS);
+    put64(h + 12, index_offset);
+    put64(h + 20, w->total_steps);
+    if (fwrite(h, 1, TRACE_HEADER, w->f) != TRACE_HEADER) w->error = 1;
+}
+
+int trace_create(TraceWriter *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+    w->path = path;
+    w->f = fopen(path, "wb");
+    if (w->f == NULL) {
+        printf("Erreur : Impossible d'écrire le fichier %s\n", path);
+        return 0;
+    }
+    write_header(w, 0);
+    w->file_bytes = TRACE_HEADER;
+    return !w->error;
+}
+
+// Compresse le paquet en cours et l'ajoute au fichier et à l'index
+static void flush_chunk(TraceWriter *w) {
+    if (w->steps == 0 || w->error) return;
+    u32 bound = LZ4_BOUND(w->raw_size);
+    if (bound > w->packed_cap) {
+        free(w->packed);
+        w->packed = malloc(bound);
+        w->packed_cap = w->packed ? bound : 0;
+        if (w->packed == NULL) {
+            w->error = 1;
+            return;
+        }
+    }
+    int packed = lz4_compress(w->raw, (int)w->raw_size, w->packed, (int)bound);
+    int stored = packed < 0 || (u32)packed >= w->raw_size; // Incompressible : gardé tel quel
+    u32 size = stored ? w->raw_size : (u32)packed;
+
+    if (w->chunk_count == w->chunk_cap) {
+        u32 cap = w->chunk_cap ? w->chunk_cap * 2 : 256;
+        TraceChunkInfo *chunks = realloc(w->chunks, cap * sizeof(TraceChunkInfo));
+        if (chunks == NULL) {
+            w->error = 1;
+            return;
+        }
+        w->chunks = chunks;
+        w->chunk_cap = cap;
+    }
+    TraceChunkInfo *c = &w->chunks[w->chunk_count++];
+    c->offset = w->file_bytes;
+    c->first_index = w->first.index;
+    c->first_cycles = w->first.cycles;
+    c->steps = w->steps;
+
+    u8 h[CHUNK_HEADER];
+    memcpy(h, CHUNK_MAGIC, 4);
+    put32(h + 4, size);
+    put32(h + 8, w->raw_size);
+    put32(h + 12, w->steps);
+    h[16] = (u8)stored;
+    h[17] = w->first.A;
+    h[18] = w->first.X;
+    h[19] = w->first.Y;
+    h[20] = w->first.SP;
+    h[21] = w->first.P;
+    put16(h + 22, w->first.PC);
+    put64(h + 24, w->first.index);
+    put64(h + 32, w->first.cycles);
+    if (fwrite(h, 1, CHUNK_HEADER, w->f) != CHUNK_HEADER
+        || fwrite(stored ? w->raw : w->packed, 1, size, w->f) != size) {
+        w->error = 1;
+    }
+    w->file_bytes += CHUNK_HEADER + size;
+    w->raw_bytes += w->raw_size;
+    w->raw_size = 0;
+    w->steps = 0;
+}
+
+void trace_step(TraceWriter *w, const CPU *cpu) {
+    if (w->steps == TRACE_CHUNK_STEPS) flush_chunk(w);
+    if (w->error || !reserve(w, 16)) return;
+
+    TraceEntry s;
+    s.index = w->total_steps;
+    s.cycles = cpu->cycles;
+    s.PC = cpu->PC;
+    s.A = cpu->A;
+    s.X = cpu->X;
+    s.Y = cpu->Y;
+    s.SP = cpu->SP;
+    s.P = cpu->P;
+    // Le paquet part de l'état complet de sa première entrée (dans son en-tête)
+    if (w->steps == 0) w->first = w->prev = s;
+    const TraceEntry *p = &w->prev;
+
+    u8 *op = w->raw + w->raw_size;
+    u8 *tag = op++;
+    u16 pc_delta = (u16)(s.PC - p->PC);
+    *tag = pc_delta >= 1 && pc_delta <= 3 ? (u8)pc_delta : 0;
+    if (s.A != p->A) { *tag |= 1 << 2; *op++ = s.A; }
+    if (s.X != p->X) { *tag |= 1 << 3; *op++ = s.X; }
+    if (s.Y != p->Y) { *tag |= 1 << 4; *op++ = s.Y; }
+    if (s.SP != p->SP) { *tag |= 1 << 5; *op++ = s.SP; }
+    if (s.P != p->P) { *tag |= 1 << 6; *op++ = s.P; }
+    if ((*tag & 3) == 0) {
+        put16(op, s.PC);
+        op += 2;
+    }
+    for (u64 d = s.cycles - p->cycles;; d >>= 7) { // LEB128
+        if (d < 0x80) {
+            *op++ = (u8)d;
+            break;
+        }
+        *op++ = (u8)(d | 0x80);
+    }
+    w->raw_size = (u32)(op - w->raw);
+    w->prev = s;
+    w->steps++;
+    w->total_steps++;
+}
+
+void trace_write(TraceWriter *w, u16 address, u8 value) {
+    if (w->steps == 0 || w->error || !reserve(w, 4)) return;
+    u8 *op = w->raw + w->raw_size;
+    if (address < 0x0100) {
+        *op++ = OP_WRITE_ZP;
+        *op++ = (u8)address;
+    } else if ((address >> 8) == 0x01) {
+        *op++ = OP_WRITE_STACK;
+        *op++ = (u8)address;
+    } else {
+        *op++ = OP_WRITE;
+        put16(op, address);
+        op += 2;
+    }
+    *op++ = value;
+    w->raw_size = (u32)(op - w->raw);
+}
+
+int trace_finish(TraceWriter *w) {
+    flush_chunk(w);
+    u64 index_offset = w->file_bytes;
+    u8 h[8];
+    memcpy(h, INDEX_MAGIC, 4);
+    put32(h + 4, w->chunk_count);
+    if (fwrite(h, 1, 8, w->f) != 8) w->error = 1;
+    for (u32 i = 0; i < w->chunk_count && !w->error; i++) {
+        const TraceChunkInfo *c = &w->chunks[i];
+        u8 rec[INDEX_RECORD] = { 0 };
+        put64(rec, c->offset);
+        put64(rec + 8, c->first_index);
+        put64(rec + 16, c->first_cycles);
+        put32(rec + 24, c->steps);
+        if (fwrite(rec, 1, INDEX_RECORD, w->f) != INDEX_RECORD) w->error = 1;
+    }
+    w->file_bytes += 8 + (u64)w->chunk_count * INDEX_RECORD;
+    // L'en-tête n'est complet qu'une fois l'index écrit
+    if (fseek(w->f, 0, SEEK_SET) != 0) w->error = 1;
+    else write_header(w, index_offset);
+    if (fclose(w->f) != 0) w->error = 1;
+    if (w->error) printf("Erreur : écriture incomplète de %s\n", w->path);
+    free(w->raw);
+    free(w->packed);
+    free(w->chunks);
+    w->f = NULL;
+    w->raw = w->packed = NULL;
+    w->chunks = NULL;
+    return !w->error;
+}
+
+// --- Lecture ---
+
+static int add_chunk(TraceReader *r, u32 *cap, const TraceChunkInfo *c) {
+    if (r->chunk_count == *cap) {
+        *cap = *cap ? *cap * 2 : 256;
+        TraceChunkInfo *chunks = realloc(r->chunks, *cap * sizeof(TraceChunkInfo));
+        if (chunks == NULL) return 0;
+        r->chunks = chunks;
+    }
+    r->chunks[r->chunk_count++] = *c;
+    return 1;
+}
+
+static int read_index(TraceReader *r, u64 offset) {
+    u8 h[8];
+    if (fseek(r->f, (long)offset, SEEK_SET) != 0 || fread(h, 1, 8, r->f) != 8 || memcmp(h, INDEX_MAGIC, 4) != 0) {
+        return 0;
+    }
+    u32 count = get32(h + 4), cap = 0;
+    for (u32 i = 0; i < count; i++) {
+        u8 rec[INDEX_RECORD];
+        if (fread(rec, 1, INDEX_RECORD, r->f) != INDEX_RECORD) return 0;
+        TraceChunkInfo c = { get64(rec), get64(rec + 8), get64(rec + 16), get32(rec + 24) };
+        if (!add_chunk(r, &cap, &c)) return 0;
+    }
+    return 1;
+}
+
+// Trace interrompue : on suit les en-têtes des paquets complets
+static int rebuild_index(TraceReader *r) {
+    fseek(r->f, 0, SEEK_END);
+    u64 size = (u64)ftell(r->f), offset = TRACE_HEADER;
+    u32 cap = 0;
+    r->chunk_count = 0;
+    while (offset + CHUNK_HEADER <= size) {
+        u8 h[CHUNK_HEADER];
+        if (fseek(r->f, (long)offset, SEEK_SET) != 0 || fread(h, 1, CHUNK_HEADER, r->f) != CHUNK_HEADER
+            || memcmp(h, CHUNK_MAGIC, 4) != 0 || offset + CHUNK_HEADER + get32(h + 4) > size) {
+            break;
+        }
+        TraceChunkInfo c = { offset, get64(h + 24), get64(h + 32), get32(h + 12) };
+        if (!add_chunk(r, &cap, &c)) return 0;
+        offset += CHUNK_HEADER + get32(h + 4);
+    }
+    return 1;
+}
+
+int trace_open(TraceReader *r, const char *path) {
+    memset(r, 0, sizeof(*r));
+    r->f = fopen(path, "rb");
+    if (r->f == NULL) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", path);
+        return 0;
+    }
+    u8 h[TRACE_HEADER];
+    if (fread(h, 1, TRACE_HEADER, r->f) != TRACE_HEADER || memcmp(h, TRACE_MAGIC, 4) != 0
+        || h[4] != TRACE_FORMAT) {
+        printf("Erreur : %s n'est pas une trace (format %d attendu)\n", path, TRACE_FORMAT);
+        trace_close(r);
+        return 0;
+    }
+    u64 index_offset = get64(h + 12);
+    r->indexed = index_offset != 0 && read_index(r, index_offset);
+    if (!r->indexed && !rebuild_index(r)) {
+        printf("Erreur : mémoire insuffisante pour l'index de %s\n", path);
+        trace_close(r);
+        return 0;
+    }
+    for (u32 i = 0; i < r->chunk_count; i++) r->steps += r->chunks[i].steps;
+    r->chunk = r->chunk_count;
+    return 1;
+}
+
+void trace_close(TraceReader *r) {
+    if (r->f) fclose(r->f);
+    free(r->chunks);
+    free(r->raw);
+    free(r->packed);
+    memset(r, 0, sizeof(*r));
+}
+
+static int grow(u8 **buf, u32 *cap, u32 size) {
+    if (size <= *cap) return 1;
+    free(*buf);
+    *buf = malloc(size);
+    *cap = *buf ? size : 0;
+    return *buf != NULL;
+}
+
+// Lit et décode le paquet i ; la lecture repart de sa première entrée
+static int load_chunk(TraceReader *r, u32 i) {
+    const TraceChunkInfo *c = &r->chunks[i];
+    u8 h[CHUNK_HEADER];
+    r->chunk = r->chunk_count;
+    if (fseek(r->f, (long)c->offset, SEEK_SET) != 0 || fread(h, 1, CHUNK_HEADER, r->f) != CHUNK_HEADER
+        || memcmp(h, CHUNK_MAGIC, 4) != 0) {
+        return 0;
+    }
+    u32 size = get32(h + 4), raw_size = get32(h + 8);
+    if (!grow(&r->packed, &r->packed_cap, size ? size : 1) || !grow(&r->raw, &r->raw_cap, raw_size ? raw_size : 1)
+        || fread(r->packed, 1, size, r->f) != size) {
+        return 0;
+    }
+    if (h[16] & 1) {
+        if (size != raw_size) return 0;
+        memcpy(r->raw, r->packed, size);
+    } else if (lz4_decompress(r->packed, (int)size, r->raw, (int)raw_size) != (int)raw_size) {
+        return 0;
+    }
+    r->raw_size = raw_size;
+    r->pos = 0;
+    memset(&r->cur, 0, sizeof(r->cur));
+    r->cur.A = h[17];
+    r->cur.X = h[18];
+    r->cur.Y = h[19];
+    r->cur.SP = h[20];
+    r->cur.P = h[21];
+    r->cur.PC = get16(h + 22);
+    r->cur.index = get64(h + 24);
+    r->cur.cycles = get64(h + 32);
+    r->next_index = r->cur.index;
+    r->chunk = i;
+    return 1;
+}
+
+int trace_next(TraceReader *r, TraceEntry *e) {
+    // Paquet épuisé : le suivant (le premier si aucun n'est chargé)
+    while (r->chunk >= r->chunk_count || r->pos >= r->raw_size) {
+        u32 next = r->chunk < r->chunk_count ? r->chunk + 1 : 0;
+        if (next >= r->chunk_count || (r->chunk >= r->chunk_count && r->next_index > 0)) return 0;
+        if (!load_chunk(r, next)) return -1;
+    }
+    const u8 *p = r->raw + r->pos, *end = r->raw + r->raw_size;
+    TraceEntry *s = &r->cur;
+    u8 tag = *p++;
+    if (tag & 0x80) return -1; // Une écriture sans entrée
+    #define NEED(n) do { if (end - p < (n)) return -1; } while (0)
+    if (tag & (1 << 2)) { NEED(1); s->A = *p++; }
+    if (tag & (1 << 3)) { NEED(1); s->X = *p++; }
+    if (tag & (1 << 4)) { NEED(1); s->Y = *p++; }
+    if (tag & (1 << 5)) { NEED(1); s->SP = *p++; }
+    if (tag & (1 << 6)) { NEED(1); s->P = *p++; }
+    if (tag & 3) {
+        s->PC = (u16)(s->PC + (tag & 3));
+    } else {
+        NEED(2);
+        s->PC = get16(p);
+        p += 2;
+    }
+    u64 delta = 0;
+    for (int shift = 0;; shift += 7) {
+        NEED(1);
+        u8 b = *p++;
+        delta |= (u64)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+        if (shift > 56) return -1;
+    }
+    s->cycles += delta;
+    s->index = r->next_index++;
+    *e = *s;
+    e->write_count = 0;
+
+    // Écritures de cette instruction, jusqu'au pas suivant
+    while (p < end && (*p & 0x80)) {
+        u16 address;
+        if (*p == OP_WRITE) {
+            NEED(4);
+            address = get16(p + 1);
+            p += 3;
+        } else if (*p == OP_WRITE_ZP || *p == OP_WRITE_STACK) {
+            NEED(3);
+            address = (u16)((*p == OP_WRITE_STACK ? 0x0100 : 0) | p[1]);
+            p += 2;
+        } else {
+            return -1;
+        }
+        if (e->write_count < TRACE_MAX_WRITES) {
+            e->write_address[e->write_count] = address;
+            e->write_value[e->write_count] = *p;
+        }
+        e->write_count++;
+        p++;
+    }
+    #undef NEED
+    r->pos = (u32)(p - r->raw);
+    return 1;
+}
+
+// Dernier paquet dont la première entrée vérifie first <= cible
+static u32 find_chunk(const TraceReader *r, u64 target, int by_cycle) {
+    u32 lo = 0, hi = r->chunk_count;
+    while (hi - lo > 1) {
+        u32 mid = (lo + hi) / 2;
+        u64 first = by_cycle ? r->chunks[mid].first_cycles : r->chunks[mid].first_index;
+        if (first <= target) lo = mid; else hi = mid;
+    }
+    return lo;
+}
+
+int trace_seek(TraceReader *r, u64 index) {
+    if (index >= r->steps) return 0;
+    if (!load_chunk(r, find_chunk(r, index, 0))) return 0;
+    TraceEntry e;
+    while (r->next_index < index) {
+        if (trace_next(r, &e) != 1) return 0;
+    }
+    return 1;
+}
+
+int trace_seek_cycle(TraceReader *r, u64 cycle) {
+    if (r->chunk_count == 0 || !load_chunk(r, find_chunk(r, cycle, 1))) return 0;
+    for (;;) {
+        // État avant l'entrée, pour y revenir
+        u32 chunk = r->chunk, pos = r->pos;
+        TraceEntry cur = r->cur, e;
+        u64 next_index = r->next_index;
+        if (trace_next(r, &e) != 1) return 0;
+        if (e.cycles >= cycle) {
+            if (r->chunk != chunk && !load_chunk(r, chunk)) return 0;
+            r->pos = pos;
+            r->cur = cur;
+            r->next_index = next_index;
+            return 1;
+        }
+    }
+}
+
+void trace_print(const TraceEntry *e, FILE *out) {
+    fprintf(out, "%10llu %12llu PC: 0x%04X A: 0x%02X X: 0x%02X Y: 0x%02X P: 0x%02X SP: 0x%02X",
+            (unsigned long long)e->index, (unsigned long long)e->cycles, e->PC, e->A, e->X, e->Y, e->P, e->SP);
+    int shown = e->write_count < TRACE_MAX_WRITES ? e->write_count : TRACE_MAX_WRITES;
+    for (int i = 0; i < shown; i++) fprintf(out, " [$%04X]=$%02X", e->write_address[i], e->write_value[i]);
+    if (shown < e->write_count) fprintf(out, " (+%d)", e->write_count - shown);
+    fputc('\n', out);
+}
+
+int trace_equal(const TraceEntry *a, const TraceEntry *b) {
+    if (a->cycles != b->cycles || a->PC != b->PC || a->A != b->A || a->X != b->X || a->Y != b->Y
+        || a->P != b->P || a->SP != b->SP || a->write_count != b->write_count) {
+        return 0;
+    }
+    int n = a->write_count < TRACE_MAX_WRITES ? a->write_count : TRACE_MAX_WRITES;
+    for (int i = 0; i < n; i++) {
+        if (a->write_address[i] != b->write_address[i] || a->write_value[i] != b->write_value[i]) return 0;
+    }
+    return 1;
+}
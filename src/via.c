@@ -0,0 +1,203 @@
+#include "via.h"
+#include <string.h>
+
+// Met à jour le bit 7 de IFR et la ligne IRQ ('when' : cycle du changement)
+static void via_update_irq(Via *via, u64 when) {
+    u8 active = via->ifr & via->ier & 0x7F;
+    if (active) via->ifr |= 0x80; else via->ifr &= 0x7F;
+    cpu_set_irq_at(via->cpu, via->irq_source, active != 0, when);
+}
+
+// Les timers lèvent leur drapeau au cycle d'expiration, même si l'événement
+// est traité à la fin de l'instruction en cours
+static void via_set_flag(Via *via, u8 flag, u64 when) {
+    via->ifr |= flag;
+    via_update_irq(via, when);
+}
+
+static void via_clear_flag(Via *via, u8 flag) {
+    via->ifr &= ~flag;
+    via_update_irq(via, via->cpu->cycles);
+}
+
+// --- Timer 1 ---
+// Chargé avec N au cycle w : IRQ à w + N + 1, puis toutes les N + 2 en mode continu (ACR bit 6)
+
+static void via_t1_event(void *ctx, u64 now) {
+    Via *via = (Via *)ctx;
+    via_set_flag(via, VIA_INT_T1, via->t1_expire);
+    if (via->acr & 0x40) {
+        u64 period = (u64)via->t1_latch + 2;
+        while (via->t1_expire <= now) via->t1_expire += period;
+        sched_set(via->sched, via->ev_t1, via->t1_expire);
+    } else {
+        via->t1_running = 0; // One-shot : une seule IRQ jusqu'au prochain chargement
+    }
+}
+
+static u16 via_t1_value(Via *via, u64 now) {
+    if (now < via->t1_expire) {
+        return (u16)(via->t1_expire - now - 1);
+    }
+    u64 late = now - via->t1_expire;
+    if (via->acr & 0x40) {
+        u64 k = late % ((u64)via->t1_latch + 2);
+        return k == 0 ? 0xFFFF : (u16)(via->t1_latch - (k - 1));
+    }
+    return (u16)(0xFFFF - late);
+}
+
+static void via_t1_start(Via *via, u64 now) {
+    via->t1_expire = now + via->t1_latch + 1;
+    via->t1_running = 1;
+    via_clear_flag(via, VIA_INT_T1);
+    sched_set(via->sched, via->ev_t1, via->t1_expire);
+}
+
+// --- Timer 2 ---
+
+static void via_t2_event(void *ctx, u64 now) {
+    (void)now;
+    Via *via = (Via *)ctx;
+    via->t2_running = 0;
+    via_set_flag(via, VIA_INT_T2, via->t2_loaded + via->t2_start + 1);
+}
+
+static u16 via_t2_value(Via *via, u64 now) {
+    return (u16)(via->t2_start - (now - via->t2_loaded));
+}
+
+// --- Registre à décalage ---
+// Modes gérés (ACR bits 2-4) : 2 = entrée sous phi2, 4 = sortie libre au rythme de T2,
+// 5 = sortie sous contrôle de T2, 6 = sortie sous phi2. Les modes à horloge externe sont inactifs.
+
+static u64 via_sr_byte_cycles(Via *via) {
+    u8 mode = (via->acr >> 2) & 7;
+    if (mode == 2 || mode == 6) return 16;       // CB1 = phi2 / 2 : 2 cycles par bit
+    return ((u64)via->t2_latch_lo + 2) * 2 * 8;  // Un demi-cycle de CB1 par expiration de T2
+}
+
+static void via_sr_start(Via *via, u64 now) {
+    u8 mode = (via->acr >> 2) & 7;
+    via_clear_flag(via, VIA_INT_SR);
+    if (mode == 2 || mode == 4 || mode == 5 || mode == 6) {
+        sched_set(via->sched, via->ev_sr, now + via_sr_byte_cycles(via));
+    } else {
+        sched_cancel(via->sched, via->ev_sr);
+    }
+}
+
+static void via_sr_event(void *ctx, u64 now) {
+    Via *via = (Via *)ctx;
+    u8 mode = (via->acr >> 2) & 7;
+    if (mode == 2) {
+        via->sr = via->sr_in;
+    } else if (via->sr_out) {
+        via->sr_out(via->sr_ctx, via->sr);
+    }
+    if (mode == 4) {
+        // Sortie libre : on recommence sans interruption
+        sched_set(via->sched, via->ev_sr, now + via_sr_byte_cycles(via));
+    } else {
+        via_set_flag(via, VIA_INT_SR, now);
+    }
+}
+
+// --- Accès aux registres ---
+
+u8 via_read(void *ctx, u16 address) {
+    Via *via = (Via *)ctx;
+    u64 now = via->cpu->cycles;
+    switch (address & 0x0F) {
+    case VIA_ORB:
+        return (via->orb & via->ddrb) | (via->port_in[1] & ~via->ddrb);
+    case VIA_ORA:
+    case VIA_ORA_NH:
+        return (via->ora & via->ddra) | (via->port_in[0] & ~via->ddra);
+    case VIA_DDRB: return via->ddrb;
+    case VIA_DDRA: return via->ddra;
+    case VIA_T1CL:
+        via_clear_flag(via, VIA_INT_T1);
+        return via_t1_value(via, now) & 0xFF;
+    case VIA_T1CH: return via_t1_value(via, now) >> 8;
+    case VIA_T1LL: return via->t1_latch & 0xFF;
+    case VIA_T1LH: return via->t1_latch >> 8;
+    case VIA_T2CL:
+        via_clear_flag(via, VIA_INT_T2);
+        return via_t2_value(via, now) & 0xFF;
+    case VIA_T2CH: return via_t2_value(via, now) >> 8;
+    case VIA_SR: {
+        u8 value = via->sr;
+        via_sr_start(via, now);
+        return value;
+    }
+    case VIA_ACR: return via->acr;
+    case VIA_PCR: return via->pcr;
+    case VIA_IFR: return via->ifr;
+    default:      return via->ier | 0x80; // VIA_IER
+    }
+}
+
+void via_write(void *ctx, u16 address, u8 value) {
+    Via *via = (Via *)ctx;
+    u64 now = via->cpu->cycles;
+    switch (address & 0x0F) {
+    case VIA_ORB:  via->orb = value; break;
+    case VIA_ORA:
+    case VIA_ORA_NH: via->ora = value; break;
+    case VIA_DDRB: via->ddrb = value; break;
+    case VIA_DDRA: via->ddra = value; break;
+    case VIA_T1CL:
+    case VIA_T1LL:
+        via->t1_latch = (via->t1_latch & 0xFF00) | value;
+        break;
+    case VIA_T1CH:
+        via->t1_latch = (via->t1_latch & 0x00FF) | (value << 8);
+        via_t1_start(via, now);
+        break;
+    case VIA_T1LH:
+        via->t1_latch = (via->t1_latch & 0x00FF) | (value << 8);
+        via_clear_flag(via, VIA_INT_T1);
+        break;
+    case VIA_T2CL:
+        via->t2_latch_lo = value;
+        break;
+    case VIA_T2CH:
+        via->t2_start = via->t2_latch_lo | (value << 8);
+        via->t2_loaded = now;
+        via->t2_running = 1;
+        via_clear_flag(via, VIA_INT_T2);
+        sched_set(via->sched, via->ev_t2, now + via->t2_start + 1);
+        break;
+    case VIA_SR:
+        via->sr = value;
+        via_sr_start(via, now);
+        break;
+    case VIA_ACR:
+        via->acr = value;
+        break;
+    case VIA_PCR:
+        via->pcr = value;
+        break;
+    case VIA_IFR:
+        via_clear_flag(via, value & 0x7F); // Écrire 1 efface le drapeau
+        break;
+    default: // VIA_IER : bit 7 = 1 pour activer, 0 pour désactiver
+        if (value & 0x80) via->ier |= value & 0x7F; else via->ier &= ~value;
+        via_update_irq(via, now);
+        break;
+    }
+}
+
+void via_attach(Via *via, Memory *mem, u8 page, CPU *cpu, Scheduler *sched, u8 irq_source) {
+    memset(via, 0, sizeof(*via));
+    via->cpu = cpu;
+    via->sched = sched;
+    via->irq_source = irq_source;
+    via->port_in[0] = 0xFF; // Entrées au repos (pull-up)
+    via->port_in[1] = 0xFF;
+    via->ev_t1 = sched_add(sched, via_t1_event, via);
+    via->ev_t2 = sched_add(sched, via_t2_event, via);
+    via->ev_sr = sched_add(sched, via_sr_event, via);
+    mem_map_io(mem, page, page, via_read, via_write, via);
+}
@@ -0,0 +1,36 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// --- Tests de comportement (make test) ---
+// Chaque tests/test_*.c est un programme : CHECK note les échecs sans
+// s'arrêter, check_done affiche le bilan et donne le code de sortie.
+
+static int check_count, check_failures;
+
+#define CHECK(cond) do {                                                        \
+    check_count++;                                                              \
+    if (!(cond)) {                                                              \
+        printf("%s:%d: echec : %s\n", __FILE__, __LINE__, #cond);               \
+        check_failures++;                                                       \
+    }                                                                           \
+} while (0)
+
+// Comme CHECK, valeurs affichées en hexadécimal en cas d'échec
+#define CHECK_EQ(actual, expected) do {                                         \
+    unsigned long long check_a = (unsigned long long)(actual);                  \
+    unsigned long long check_e = (unsigned long long)(expected);                \
+    check_count++;                                                              \
+    if (check_a != check_e) {                                                   \
+        printf("%s:%d: echec : %s = 0x%llX, attendu 0x%llX\n", __FILE__,        \
+               __LINE__, #actual, check_a, check_e);                            \
+        check_failures++;                                                       \
+    }                                                                           \
+} while (0)
+
+static inline int check_done(const char *name) {
+    printf("%-16s : %d verifications, %d echec(s)\n", name, check_count, check_failures);
+    return check_failures ? 1 : 0;
+}
+#endif
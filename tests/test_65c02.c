@@ -0,0 +1,143 @@
+#include <string.h>
+#include "check.h"
+#include "cpu.h"
+#include "disasm.h"
+#include "blockcache.h"
+
+// 65C02 : table complète (les opcodes non définis sont des NOP de la bonne
+// longueur et durée), RMB/SMB, BBR/BBS, WAI et STP, sur le cœur de
+// référence, le moteur à blocs et le désassembleur.
+
+static Memory mem;
+static CPU cpu;
+
+static void setup(const u8 *code, int size) {
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, code, size);
+    cpu_reset_variant(&cpu, &mem, CPU_65C02);
+    cpu.PC = 0x0200;
+}
+
+// Exécute une instruction, retourne les cycles consommés
+static u64 step(void) {
+    u64 c = cpu.cycles;
+    cpu_step(&cpu);
+    return cpu.cycles - c;
+}
+
+static const struct { u8 op, length, cycles; } nops[] = {
+    { 0x02, 2, 2 }, { 0x22, 2, 2 }, { 0x42, 2, 2 }, { 0x62, 2, 2 }, { 0x82, 2, 2 }, { 0xC2, 2, 2 }, { 0xE2, 2, 2 },
+    { 0x44, 2, 3 }, { 0x54, 2, 4 }, { 0xD4, 2, 4 }, { 0xF4, 2, 4 },
+    { 0x5C, 3, 8 }, { 0xDC, 3, 4 }, { 0xFC, 3, 4 },
+    { 0x03, 1, 1 }, { 0x13, 1, 1 }, { 0x73, 1, 1 }, { 0xF3, 1, 1 },
+    { 0x0B, 1, 1 }, { 0x1B, 1, 1 }, { 0xBB, 1, 1 }, { 0xFB, 1, 1 },
+};
+
+// Compte jusqu'à ce que le bit 3 de X passe à 1, puis STP
+static const u8 bbr_loop[] = {
+    0xA2, 0x00,       // 0200 LDX #$00
+    0xE8,             // 0202 INX
+    0x86, 0x10,       // 0203 STX $10
+    0x3F, 0x10, 0xFA, // 0205 BBR3 $10,$0202
+    0xDB,             // 0208 STP
+};
+
+int main(void) {
+    const OpcodeEntry *ops = cpu_machine(CPU_65C02)->ops;
+    int missing = 0;
+    for (int op = 0; op < 256; op++) missing += ops[op].instruction == NULL;
+    CHECK_EQ(missing, 0);
+
+    // NOP non définis : aucun registre ni drapeau modifié
+    for (size_t i = 0; i < sizeof(nops) / sizeof(nops[0]); i++) {
+        u8 code[3] = { nops[i].op, 0x34, 0x12 };
+        setup(code, 3);
+        u8 p = cpu.P;
+        CHECK_EQ(step(), nops[i].cycles);
+        CHECK_EQ(cpu.PC, 0x0200 + nops[i].length);
+        CHECK_EQ(cpu.P, p);
+    }
+
+    // RMB5 $10 puis SMB0 $11
+    static const u8 bits[] = { 0x57, 0x10, 0x87, 0x11 };
+    setup(bits, sizeof(bits));
+    mem_write(&mem, 0x10, 0xFF);
+    CHECK_EQ(step(), 5);
+    CHECK_EQ(mem_peek(&mem, 0x10), 0xDF);
+    CHECK_EQ(step(), 5);
+    CHECK_EQ(mem_peek(&mem, 0x11), 0x01);
+    CHECK_EQ(cpu.PC, 0x0204);
+
+    // BBS7 $10 : pris (6 cycles) puis non pris (5 cycles)
+    static const u8 bbs[] = { 0xFF, 0x10, 0x10 };
+    setup(bbs, sizeof(bbs));
+    mem_write(&mem, 0x10, 0x80);
+    CHECK_EQ(step(), 6);
+    CHECK_EQ(cpu.PC, 0x0213);
+    setup(bbs, sizeof(bbs));
+    CHECK_EQ(step(), 5);
+    CHECK_EQ(cpu.PC, 0x0203);
+
+    // Boucle BBR : cœur de référence, puis STP, qui ignore même une NMI
+    setup(bbr_loop, sizeof(bbr_loop));
+    for (int i = 0; i < 25; i++) step();
+    CHECK_EQ(cpu.X, 8);
+    CHECK_EQ(cpu.PC, 0x0208);
+    CHECK_EQ(cpu.cycles, 2 + 8 * (2 + 3 + 5) + 7);
+    CHECK_EQ(step(), 3);
+    CHECK_EQ(cpu.PC, 0x0209);
+    cpu_nmi(&cpu);
+    CHECK_EQ(step(), 1);
+    CHECK_EQ(cpu.PC, 0x0209);
+
+    // La même boucle sur le moteur à blocs
+    setup(bbr_loop, sizeof(bbr_loop));
+    BlockCache *bc = block_create(&cpu);
+    CHECK(bc != NULL);
+    while (bc && cpu.cycles < 95) block_exec(bc, 95);
+    CHECK_EQ(cpu.X, 8);
+    CHECK_EQ(cpu.PC, 0x0209);
+    CHECK_EQ(cpu.cycles, 95);
+    block_free(bc);
+
+    // WAI : le temps passe sans instruction ; une IRQ masquée le réveille
+    // sans vectorisation, une IRQ autorisée est prise avec retour après WAI
+    static const u8 wai[] = { 0xCB, 0xEA };
+    setup(wai, sizeof(wai));
+    mem_write(&mem, 0xFFFE, 0x00);
+    mem_write(&mem, 0xFFFF, 0x30);
+    cpu.P |= FLAG_I;
+    CHECK_EQ(step(), 3);
+    CHECK_EQ(step(), 1);
+    CHECK_EQ(cpu.PC, 0x0201);
+    cpu_set_irq(&cpu, 1, 1);
+    CHECK_EQ(step(), 2); // NOP
+    CHECK_EQ(cpu.PC, 0x0202);
+    setup(wai, sizeof(wai));
+    mem_write(&mem, 0xFFFE, 0x00);
+    mem_write(&mem, 0xFFFF, 0x30);
+    cpu.P &= ~FLAG_I;
+    step();
+    step();
+    cpu_set_irq(&cpu, 1, 1);
+    CHECK_EQ(step(), 7);
+    CHECK_EQ(cpu.PC, 0x3000);
+    CHECK_EQ(mem_peek(&mem, 0x01FD), 0x02);
+    CHECK_EQ(mem_peek(&mem, 0x01FC), 0x01);
+
+    // Désassemblage de BBR3 et d'un NOP à deux octets
+    setup(bbr_loop, sizeof(bbr_loop));
+    DecodedInsn insn;
+    char text[40];
+    disasm_decode(ops, &mem, 0x0205, &insn);
+    disasm_format(&insn, NULL, text, sizeof(text));
+    CHECK_EQ(insn.length, 3);
+    CHECK(strcmp(text, "BBR3 $10,$0202") == 0);
+    mem_write(&mem, 0x0300, 0x44);
+    disasm_decode(ops, &mem, 0x0300, &insn);
+    CHECK_EQ(insn.length, 2);
+
+    // Les autres variantes gardent leurs trous
+    CHECK(cpu_machine(CPU_NMOS)->ops[0xCB].instruction == NULL);
+    return check_done("65c02");
+}
@@ -0,0 +1,108 @@
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "check.h"
+#include "cpu.h"
+#include "sched.h"
+#include "acia.h"
+#include "via.h"
+
+// Registres d'E/S : une écriture (STA/STX/STY, indexée ou non) ne doit pas
+// lire le registre au passage. Une lecture parasite de DATA ou STATUS
+// effacerait RDRF ou le bit IRQ de l'ACIA, une lecture de T1C-L effacerait
+// le drapeau T1 du VIA. L'entrée de l'ACIA retrouve ses drapeaux au détachement.
+
+#define VIA_PAGE  0xC0
+#define ACIA_PAGE 0xD0
+
+enum { IRQ_VIA = 1 << 0, IRQ_ACIA = 1 << 1 };
+
+static const u8 setup_program[] = {
+    0x78,             // 0200 SEI
+    0xA9, 0x09,       // 0201 LDA #$09     ; DTR, IRQ de réception autorisée
+    0x8D, 0x02, 0xD0, // 0203 STA $D002
+    0xA9, 0xC0,       // 0206 LDA #$C0     ; IER : T1
+    0x8D, 0x0E, 0xC0, // 0208 STA $C00E
+    0xA9, 0x10,       // 020B LDA #$10
+    0x8D, 0x04, 0xC0, // 020D STA $C004    ; T1 = $0010, one-shot
+    0xA9, 0x00,       // 0210 LDA #$00
+    0x8D, 0x05, 0xC0, // 0212 STA $C005
+    0x4C, 0x15, 0x02, // 0215 JMP $0215
+};
+
+static const u8 store_program[] = {
+    0x8D, 0x00, 0xD0, // 0300 STA $D000    ; émission
+    0x8D, 0x01, 0xD0, // 0303 STA $D001    ; reset logiciel
+    0x8E, 0x00, 0xD0, // 0306 STX $D000
+    0x8C, 0x04, 0xC0, // 0309 STY $C004    ; latch T1 bas
+    0x9D, 0x00, 0xC0, // 030C STA $C000,X  ; X = 4 : T1C-L
+    0x99, 0xFC, 0xCF, // 030F STA $CFFC,Y  ; Y = 8 : $D004 = DATA
+    0x91, 0x80,       // 0312 STA ($80),Y  ; $D000
+    0xAD, 0x01, 0xD0, // 0314 LDA $D001    ; lecture de l'état
+    0xAE, 0x00, 0xD0, // 0317 LDX $D000    ; lecture de l'octet reçu
+    0xAC, 0x04, 0xC0, // 031A LDY $C004    ; acquitte T1
+    0xAD, 0x01, 0xD0, // 031D LDA $D001    ; acquitte l'IRQ de l'ACIA
+};
+
+int main(void) {
+    static Memory mem;
+    CPU cpu;
+    Scheduler sched;
+    Via via;
+    Acia acia;
+    int fds[2];
+
+    CHECK(pipe(fds) == 0);
+    CHECK(write(fds[1], "A", 1) == 1);
+
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, setup_program, sizeof(setup_program));
+    mem_load_bytes(&mem, 0x0300, store_program, sizeof(store_program));
+    mem_write(&mem, 0x0080, 0xF8); // ($80) = $CFF8, + Y = $D000
+    mem_write(&mem, 0x0081, 0xCF);
+    cpu_reset(&cpu, &mem);
+    sched_init(&sched);
+    via_attach(&via, &mem, VIA_PAGE, &cpu, &sched, IRQ_VIA);
+    acia_attach(&acia, &mem, ACIA_PAGE, &cpu, &sched, IRQ_ACIA, fds[0], -1, 1000000);
+    CHECK(fcntl(fds[0], F_GETFL) & O_NONBLOCK);
+
+    // Un octet reçu (RDRF, IRQ) et T1 expiré, IRQ masquées par SEI
+    cpu.PC = 0x0200;
+    sched_run(&sched, &cpu, 2000);
+    CHECK_EQ(acia.status & (ACIA_ST_RDRF | ACIA_ST_IRQ), ACIA_ST_RDRF | ACIA_ST_IRQ);
+    CHECK_EQ(via.ifr, 0x80 | VIA_INT_T1);
+    CHECK_EQ(cpu.irq_lines, IRQ_VIA | IRQ_ACIA);
+
+    // Les écritures laissent les drapeaux en place
+    cpu.PC = 0x0300;
+    cpu.A = 0x55;
+    cpu.X = 0x04;
+    cpu.Y = 0x08;
+    for (int i = 0; i < 7; i++) cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0314);
+    CHECK_EQ(acia.status & (ACIA_ST_RDRF | ACIA_ST_IRQ), ACIA_ST_RDRF | ACIA_ST_IRQ);
+    CHECK_EQ(acia.rx_data, 'A');
+    CHECK_EQ(via.ifr, 0x80 | VIA_INT_T1);
+    CHECK_EQ(cpu.irq_lines, IRQ_VIA | IRQ_ACIA);
+    CHECK_EQ(via.t1_latch & 0xFF, 0x55); // STA $C000,X a bien écrit le latch
+
+    // Les vraies lectures acquittent (l'IRQ de réception reste levée tant
+    // que l'octet n'est pas lu)
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.A & (ACIA_ST_RDRF | ACIA_ST_IRQ), ACIA_ST_RDRF | ACIA_ST_IRQ);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.X, 'A');
+    CHECK_EQ(acia.status & ACIA_ST_RDRF, 0);
+    cpu_step(&cpu);
+    CHECK_EQ(via.ifr, 0);
+    CHECK_EQ(cpu.irq_lines, IRQ_ACIA);
+    cpu_step(&cpu);
+    CHECK_EQ(acia.status & ACIA_ST_IRQ, 0);
+    CHECK_EQ(cpu.irq_lines, 0);
+
+    acia_detach(&acia);
+    CHECK(!(fcntl(fds[0], F_GETFL) & O_NONBLOCK));
+    close(fds[0]);
+    close(fds[1]);
+    return check_done("acia_via");
+}
@@ -0,0 +1,84 @@
+#include <string.h>
+#include "check.h"
+#include "aot.h"
+#include "codemap.h"
+
+// Code traduit par rec6502 (tests/aot_events.bin, voir le Makefile) : une
+// interruption levée au milieu d'un bloc, par une écriture sur un
+// périphérique ou déjà en attente au moment d'un CLI, est prise après la
+// même instruction qu'avec l'interpréteur.
+//
+//   FF00 CLI
+//   FF01 LDX #$00
+//   FF03 STA $C000    ; lève l'IRQ
+//   FF06 INX
+//   FF07 INX
+//   FF08 JMP $FF08
+//   FF20 STX $10      ; IRQ : X au moment de l'interruption
+//   FF22 STA $C001    ; acquitte
+//   FF25 RTI
+
+#define IO_PAGE 0xC0
+
+static u8 io_read(void *ctx, u16 address) {
+    (void)ctx;
+    (void)address;
+    return 0;
+}
+
+static void io_write(void *ctx, u16 address, u8 value) {
+    (void)value;
+    cpu_set_irq((CPU *)ctx, 1, (address & 1) == 0);
+}
+
+typedef struct {
+    CPU cpu;
+    u8 saved_x;
+    u64 mem_hash;
+} Result;
+
+static void run(int aot, int irq_pending, Result *res) {
+    static Memory mem;
+    static CPU cpu;
+    mem_init(&mem);
+    CHECK(mem_load(&mem, aot_image.rom, aot_image.base));
+    cpu_reset_variant(&cpu, &mem, (CpuVariant)aot_image.variant);
+    cpu.PC = aot_image.start;
+    // Avant toute écriture : aot_create vérifie que la mémoire est l'image traduite
+    AotRuntime *rt = aot ? aot_create(&cpu, &aot_image) : NULL;
+    CHECK(!aot || rt != NULL);
+    mem_map_io(&mem, IO_PAGE, IO_PAGE, io_read, io_write, &cpu);
+    mem_write(&mem, 0x0010, 0xFF);
+    if (irq_pending) cpu_set_irq(&cpu, 1, 1);
+
+    if (rt) {
+        CHECK(aot_run(rt, 200));
+        CHECK(rt->calls > 0);
+        aot_free(rt);
+    } else {
+        cpu_run(&cpu, 200);
+    }
+    res->cpu = cpu;
+    res->saved_x = mem_peek(&mem, 0x0010);
+    res->mem_hash = codemap_hash(&mem);
+}
+
+static void compare(int irq_pending) {
+    Result ref, native;
+    run(0, irq_pending, &ref);
+    run(1, irq_pending, &native);
+    CHECK_EQ(ref.saved_x, 0x00); // IRQ prise juste après STA $C000
+    CHECK_EQ(native.saved_x, ref.saved_x);
+    CHECK_EQ(native.cpu.PC, ref.cpu.PC);
+    CHECK_EQ(native.cpu.X, ref.cpu.X);
+    CHECK_EQ(native.cpu.P, ref.cpu.P);
+    CHECK_EQ(native.cpu.SP, ref.cpu.SP);
+    CHECK_EQ(native.cpu.cycles, ref.cpu.cycles);
+    CHECK_EQ(native.mem_hash, ref.mem_hash);
+}
+
+int main(void) {
+    compare(0);
+    compare(1);
+    return check_done("aot");
+}
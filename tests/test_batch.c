@@ -0,0 +1,188 @@
+#include <string.h>
+#include "check.h"
+#include "batch.h"
+
+// Mode batch : après N instructions, chaque lane a exactement l'état et la
+// mémoire d'un cœur scalaire lancé sur la même entrée. Les écritures ne
+// recopient que les pages touchées ; l'image partagée reste intacte, y
+// compris à l'initialisation (vecteur de reset non lu). Une IRQ ou une NMI
+// en attente sur une lane est prise comme par le cœur scalaire (retard de
+// CLI compris) ; un opcode non implémenté n'arrête que sa lane.
+
+#define STEPS 5000
+
+static const u8 program[] = {
+    0xA5, 0x10,       // 0200 LDA $10      (entrée propre à chaque lane)
+    0x85, 0x11,       // 0202 STA $11
+    0xA2, 0x08,       // 0204 LDX #$08
+    0xA0, 0x00,       // 0206 LDY #$00
+    0x0A,             // 0208 ASL A
+    0x90, 0x01,       // 0209 BCC +1
+    0xC8,             // 020B INY
+    0xCA,             // 020C DEX
+    0xD0, 0xF9,       // 020D BNE $0208
+    0x8C, 0x00, 0x30, // 020F STY $3000    (page recopiée)
+    0xAD, 0x00, 0x30, // 0212 LDA $3000    (lue dans la copie de chaque lane)
+    0xC9, 0x04,       // 0215 CMP #$04
+    0x6A,             // 0217 ROR A
+    0x4D, 0x00, 0x40, // 0218 EOR $4000    (lue dans l'image partagée)
+    0x45, 0x11,       // 021B EOR $11
+    0xAA,             // 021D TAX
+    0xE8,             // 021E INX
+    0x8A,             // 021F TXA
+    0x4A,             // 0220 LSR A
+    0x38,             // 0221 SEC
+    0x2A,             // 0222 ROL A
+    0xE4, 0x11,       // 0223 CPX $11
+    0x88,             // 0225 DEY
+    0x98,             // 0226 TYA
+    0x25, 0x11,       // 0227 AND $11
+    0x05, 0x10,       // 0229 ORA $10
+    0xE6, 0x10,       // 022B INC $10
+    0x4C, 0x00, 0x02, // 022D JMP $0200
+};
+
+static void setup(Memory *mem) {
+    mem_init(mem);
+    mem_load_bytes(mem, 0x0200, program, sizeof(program));
+    mem_write(mem, 0x4000, 0x5A);
+}
+
+static u8 input(int lane) {
+    return (u8)(lane * 37 + 1);
+}
+
+static const u8 irq_program[] = {
+    0x58,             // 0200 CLI
+    0xE8,             // 0201 INX
+    0x4C, 0x01, 0x02, // 0202 JMP $0201
+};
+
+static const u8 irq_handler[] = {
+    0xE6, 0x20,       // 0300 INC $20
+    0xC8,             // 0302 INY
+    0x4C, 0x02, 0x03, // 0303 JMP $0302
+};
+
+static int vector_reads;
+
+static void on_vector_read(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)ctx; (void)pc; (void)address; (void)value; (void)kind;
+    vector_reads++;
+}
+
+static void irq_setup(Memory *mem) {
+    static const u8 vectors[] = { 0x00, 0x03, 0x00, 0x02, 0x00, 0x03 };
+    mem_init(mem);
+    mem_load_bytes(mem, 0x0200, irq_program, sizeof(irq_program));
+    mem_load_bytes(mem, 0x0300, irq_handler, sizeof(irq_handler));
+    mem_load_bytes(mem, 0xFFFA, vectors, sizeof(vectors));
+}
+
+// IRQ sur la lane 7, NMI sur la lane 9 (prise malgré I), opcode non
+// implémenté en $0201 sur la lane 3 ; les autres tournent en vectoriel
+static void test_events(void) {
+    static Memory image, mem;
+    static BatchCPU b;
+    irq_setup(&image);
+    mem_add_watch(&image, 0xFFFC, 0xFFFD, MEM_WATCH_READ, on_vector_read, NULL);
+    const u16 *image_pc = image.pc;
+    vector_reads = 0;
+    batch_init(&b, &image, BATCH_LANES, 0x0200);
+    CHECK_EQ(vector_reads, 0);
+    CHECK(image.pc == image_pc);
+    CHECK_EQ(b.A[0], 0);
+    CHECK_EQ(b.SP[0], 0xFD);
+    CHECK_EQ(b.P[0], 0x24);
+
+    CHECK(cpu_machine(CPU_NMOS)->ops[0x02].instruction == NULL);
+    batch_poke(&b, 3, 0x0201, 0x02);
+    batch_set_irq(&b, 7, 1, 1);
+    batch_set_nmi(&b, 9, 2, 1);
+    CHECK_EQ(b.pending, 1u << 7 | 1u << 9);
+    batch_run(&b, 200);
+    CHECK_EQ(b.halted, 1u << 3);
+    CHECK_EQ(b.active[3], 0);
+    CHECK_EQ(b.PC[3], 0x0201);
+    CHECK_EQ(b.instructions[3], 1);
+
+    for (int l = 0; l < BATCH_LANES; l++) {
+        if (l == 3) continue;
+        irq_setup(&mem);
+        CPU cpu;
+        cpu_reset(&cpu, &mem);
+        cpu.PC = 0x0200;
+        if (l == 7) cpu_set_irq(&cpu, 1, 1);
+        if (l == 9) cpu_set_nmi(&cpu, 2, 1);
+        for (int i = 0; i < 200; i++) cpu_step(&cpu);
+
+        CHECK_EQ(b.instructions[l], 200);
+        CHECK_EQ(b.PC[l], cpu.PC);
+        CHECK_EQ(b.X[l], cpu.X);
+        CHECK_EQ(b.Y[l], cpu.Y);
+        CHECK_EQ(b.SP[l], cpu.SP);
+        CHECK_EQ(b.P[l], cpu.P);
+        CHECK_EQ(b.cycles[l], cpu.cycles);
+        CHECK_EQ(b.events[l], cpu.events);
+        CHECK_EQ(batch_peek(&b, l, 0x20), mem_peek(&mem, 0x20));
+        CHECK_EQ(batch_peek(&b, l, 0x01FB), mem_peek(&mem, 0x01FB));
+        CHECK_EQ(batch_peek(&b, l, 0x20), l == 7 || l == 9);
+    }
+    // IRQ prise après l'instruction qui suit CLI, NMI avant CLI
+    CHECK_EQ(batch_peek(&b, 7, 0x01FC), 0x02);
+    CHECK_EQ(batch_peek(&b, 9, 0x01FC), 0x00);
+    CHECK(b.vector_steps > 0);
+    CHECK_EQ(vector_reads, 0);
+    batch_free(&b);
+}
+
+int main(void) {
+    static Memory image, mem;
+    static BatchCPU b;
+    setup(&image);
+
+    batch_init(&b, &image, BATCH_LANES, 0x0200);
+    for (int l = 0; l < BATCH_LANES; l++) batch_poke(&b, l, 0x10, input(l));
+    // Code modifié dans une seule lane : elle sort du groupe sur cette page
+    batch_poke(&b, 5, 0x0216, 0x80);
+    batch_run(&b, STEPS);
+
+    for (int l = 0; l < BATCH_LANES; l++) {
+        setup(&mem);
+        mem_write(&mem, 0x10, input(l));
+        if (l == 5) mem_write(&mem, 0x0216, 0x80);
+        CPU cpu;
+        cpu_reset(&cpu, &mem);
+        cpu.PC = 0x0200;
+        for (int i = 0; i < STEPS; i++) cpu_step(&cpu);
+
+        CHECK_EQ(b.instructions[l], STEPS);
+        CHECK_EQ(b.PC[l], cpu.PC);
+        CHECK_EQ(b.A[l], cpu.A);
+        CHECK_EQ(b.X[l], cpu.X);
+        CHECK_EQ(b.Y[l], cpu.Y);
+        CHECK_EQ(b.SP[l], cpu.SP);
+        CHECK_EQ(b.P[l], cpu.P);
+        CHECK_EQ(b.cycles[l], cpu.cycles);
+        CHECK_EQ(batch_peek(&b, l, 0x10), mem_peek(&mem, 0x10));
+        CHECK_EQ(batch_peek(&b, l, 0x11), mem_peek(&mem, 0x11));
+        CHECK_EQ(batch_peek(&b, l, 0x3000), mem_peek(&mem, 0x3000));
+
+        // Pages écrites recopiées, les autres toujours partagées
+        CHECK(mem_page_private(b.mem[l], 0x00));
+        CHECK(mem_page_private(b.mem[l], 0x30));
+        CHECK(!mem_page_private(b.mem[l], 0x40));
+        CHECK_EQ(mem_page_private(b.mem[l], 0x02), l == 5);
+    }
+
+    CHECK(b.vector_steps > 0);
+    CHECK_EQ(b.written[0x30], (1u << BATCH_LANES) - 1);
+    CHECK_EQ(b.written[0x40], 0);
+    CHECK_EQ(b.written[0x02], 1u << 5);
+    CHECK_EQ(mem_peek(&image, 0x10), 0);
+    CHECK_EQ(mem_peek(&image, 0x3000), 0);
+    CHECK_EQ(mem_peek(&image, 0x0216), 0x04);
+    batch_free(&b);
+    test_events();
+    return check_done("batch");
+}
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "codemap.h"
+
+// Cache de la carte statique : relu seulement pour la même image, la même
+// variante et les mêmes points d'entrée.
+
+static const u8 main_code[] = {
+    0xA2, 0x00,       // 0400 LDX #$00
+    0xE8,             // 0402 INX
+    0xD0, 0xFD,       // 0403 BNE $0402
+    0x20, 0x00, 0x05, // 0405 JSR $0500
+    0x4C, 0x08, 0x04, // 0408 JMP $0408
+};
+
+static const u8 other_code[] = {
+    0xA9, 0x01,       // 0600 LDA #$01
+    0x60,             // 0602 RTS
+};
+
+int main(void) {
+    static Memory mem;
+    static CodeMap cm, cached;
+    char path[] = "/tmp/test_codemap_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0400, main_code, sizeof(main_code));
+    mem_load_bytes(&mem, 0x0600, other_code, sizeof(other_code));
+    mem_write(&mem, 0x0500, 0x60); // RTS
+    mem_write(&mem, 0xFFFC, 0x00); // RESET = $0400
+    mem_write(&mem, 0xFFFD, 0x04);
+    codemap_init(&cm);
+    codemap_init(&cached);
+
+    u16 entry = 0x0400, other = 0x0600;
+    CHECK(codemap_analyze(&cm, &mem, CPU_NMOS, &entry, 1) > 0);
+    CHECK(codemap_block_at(&cm, 0x0600) == NULL);
+    CHECK(codemap_save(&cm, path));
+
+    // Même clé : la carte relue est identique
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_NMOS, &entry, 1), 1);
+    CHECK_EQ(cached.block_count, cm.block_count);
+    CHECK_EQ(cached.entry_count, cm.entry_count);
+    CHECK(memcmp(cached.map, cm.map, sizeof(cm.map)) == 0);
+    CHECK(cached.block_count == cm.block_count
+          && memcmp(cached.blocks, cm.blocks, cm.block_count * sizeof(CodeBlock)) == 0);
+
+    // $0400 est déjà le vecteur RESET : mêmes entrées sans point supplémentaire
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_NMOS, NULL, 0), 1);
+    // Un autre point d'entrée, ou un de plus : périmé
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_NMOS, &other, 1), 0);
+    u16 both[2] = { 0x0400, 0x0600 };
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_NMOS, both, 2), 0);
+    // Autre variante
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_65C02, &entry, 1), 0);
+    // Image modifiée
+    mem_write(&mem, 0x0401, 0x10);
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_NMOS, &entry, 1), 0);
+    mem_write(&mem, 0x0401, 0x00);
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_NMOS, &entry, 1), 1);
+
+    // Fichier absent ou invalide
+    CHECK_EQ(codemap_load(&cached, "/tmp/test_codemap_absent", &mem, CPU_NMOS, &entry, 1), 0);
+    FILE *f = fopen(path, "r+b");
+    CHECK(f != NULL);
+    if (f) {
+        fputc('X', f);
+        fclose(f);
+    }
+    CHECK_EQ(codemap_load(&cached, path, &mem, CPU_NMOS, &entry, 1), -1);
+
+    unlink(path);
+    codemap_free(&cm);
+    codemap_free(&cached);
+    return check_done("codemap");
+}
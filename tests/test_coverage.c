@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "coverage.h"
+
+// Couverture : bitmaps d'un run (instructions, sens des branches), fusion de
+// deux runs par le fichier, et rapport lcov complet à partir d'un fichier de
+// debug de ld65 écrit à la main.
+
+static const u8 program[] = {
+    0xA2, 0x03,       // 0200 LDX #$03      ligne 10
+    0xCA,             // 0202 DEX           ligne 11
+    0xD0, 0xFD,       // 0203 BNE $0202     ligne 12 (deux sens)
+    0xA5, 0x10,       // 0205 LDA $10       ligne 13
+    0xF0, 0x02,       // 0207 BEQ $020B     ligne 14
+    0x30, 0x03,       // 0209 BMI $020E     ligne 15
+    0x4C, 0x0B, 0x02, // 020B JMP $020B     ligne 16
+    0x4C, 0x0E, 0x02, // 020E JMP $020E     ligne 17
+    0x01, 0x02,       // 0211 .byte 1, 2    ligne 18 (données)
+};
+
+// Spans : (début, taille) dans le segment CODE chargé en $0200
+static const char dbg[] =
+    "version\tmajor=2,minor=0\n"
+    "file\tid=0,name=\"prog.s\",size=300,mtime=0x00000000,mod=0\n"
+    "seg\tid=0,name=\"CODE\",start=0x000200,size=0x0013,addrsize=absolute,type=rw,oname=\"prog.bin\",ooffs=0\n"
+    "span\tid=0,seg=0,start=0,size=2\n"
+    "span\tid=1,seg=0,start=2,size=1\n"
+    "span\tid=2,seg=0,start=3,size=2\n"
+    "span\tid=3,seg=0,start=5,size=2\n"
+    "span\tid=4,seg=0,start=7,size=2\n"
+    "span\tid=5,seg=0,start=9,size=2\n"
+    "span\tid=6,seg=0,start=11,size=3\n"
+    "span\tid=7,seg=0,start=14,size=3\n"
+    "span\tid=8,seg=0,start=17,size=2,type=1\n"
+    "line\tid=0,file=0,line=10,span=0\n"
+    "line\tid=1,file=0,line=11,span=1\n"
+    "line\tid=2,file=0,line=12,span=2\n"
+    "line\tid=3,file=0,line=13,span=3\n"
+    "line\tid=4,file=0,line=14,span=4\n"
+    "line\tid=5,file=0,line=15,span=5\n"
+    "line\tid=6,file=0,line=16,span=6\n"
+    "line\tid=7,file=0,line=17,span=7\n"
+    "line\tid=8,file=0,line=18,span=8\n"
+    "line\tid=9,file=0,line=3\n"; // Ligne sans octet produit
+
+// $10 = 0 : BEQ prise, BMI jamais exécutée, arrêt en $020B
+static const char lcov_zero[] =
+    "TN:\n"
+    "SF:prog.s\n"
+    "DA:10,1\n"
+    "DA:11,1\n"
+    "DA:12,1\n"
+    "BRDA:12,0,0,1\n"
+    "BRDA:12,0,1,1\n"
+    "DA:13,1\n"
+    "DA:14,1\n"
+    "BRDA:14,0,0,1\n"
+    "BRDA:14,0,1,0\n"
+    "DA:15,0\n"
+    "BRDA:15,0,0,-\n"
+    "BRDA:15,0,1,-\n"
+    "DA:16,1\n"
+    "DA:17,0\n"
+    "BRF:6\n"
+    "BRH:3\n"
+    "LF:8\n"
+    "LH:6\n"
+    "end_of_record\n";
+
+static Memory mem;
+
+static void run(Coverage *cov, u8 input) {
+    CPU cpu, ref;
+    static Memory ref_mem;
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    mem_write(&mem, 0x0010, input);
+    mem_copy(&ref_mem, &mem);
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    cpu_reset(&ref, &ref_mem);
+    ref.PC = 0x0200;
+    cov_init(cov, CPU_NMOS);
+    for (int i = 0; i < 20; i++) {
+        cov_step(cov, &cpu);
+        cpu_step(&ref);
+    }
+    // Même exécution qu'avec cpu_step
+    CHECK_EQ(cpu.PC, ref.PC);
+    CHECK_EQ(cpu.cycles, ref.cycles);
+    CHECK_EQ(cpu.P, ref.P);
+}
+
+static char *lcov_text(const Coverage *cov, const char *dbg_path) {
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    CHECK(out != NULL);
+    if (out == NULL) return NULL;
+    CHECK(cov_write_lcov(cov, &mem, dbg_path, out));
+    fclose(out);
+    return text;
+}
+
+int main(void) {
+    char dbg_path[] = "/tmp/test_cov_dbg_XXXXXX";
+    char cov_path[] = "/tmp/test_cov_XXXXXX";
+    close(mkstemp(dbg_path));
+    close(mkstemp(cov_path));
+    unlink(cov_path); // cov_save crée le fichier
+    FILE *f = fopen(dbg_path, "w");
+    CHECK(f != NULL);
+    if (f == NULL) return check_done("coverage");
+    fputs(dbg, f);
+    fclose(f);
+
+    static Coverage zero, negative, loaded;
+    run(&zero, 0x00);
+    static const u16 executed[] = { 0x0200, 0x0202, 0x0203, 0x0205, 0x0207, 0x020B };
+    for (size_t i = 0; i < sizeof(executed) / sizeof(executed[0]); i++) CHECK(cov_test(zero.executed, executed[i]));
+    CHECK(!cov_test(zero.executed, 0x0201)); // Opérande
+    CHECK(!cov_test(zero.executed, 0x0209));
+    CHECK(cov_test(zero.taken, 0x0203) && cov_test(zero.not_taken, 0x0203));
+    CHECK(cov_test(zero.taken, 0x0207) && !cov_test(zero.not_taken, 0x0207));
+    CovSummary s;
+    cov_summary(&zero, &s);
+    CHECK_EQ(s.instructions, 6);
+    CHECK_EQ(s.branches, 2);
+    CHECK_EQ(s.both_ways, 1);
+
+    char *text = lcov_text(&zero, dbg_path);
+    CHECK(text != NULL && strcmp(text, lcov_zero) == 0);
+    if (text && strcmp(text, lcov_zero) != 0) printf("%s", text);
+    free(text);
+
+    // $10 = $80 : BEQ non prise, BMI prise. Deux runs dans le même fichier.
+    run(&negative, 0x80);
+    CHECK(cov_save(&zero, cov_path));
+    CHECK(cov_save(&negative, cov_path));
+    CHECK(cov_load(&loaded, cov_path));
+    cov_summary(&loaded, &s);
+    CHECK_EQ(s.instructions, 8);
+    CHECK_EQ(s.branches, 3);
+    CHECK_EQ(s.both_ways, 2);
+    CHECK(cov_test(loaded.taken, 0x0209) && !cov_test(loaded.not_taken, 0x0209));
+    text = lcov_text(&loaded, dbg_path);
+    CHECK(text && strstr(text, "DA:15,1\nBRDA:15,0,0,1\nBRDA:15,0,1,0\n") != NULL);
+    CHECK(text && strstr(text, "BRDA:14,0,0,1\nBRDA:14,0,1,1\n") != NULL);
+    CHECK(text && strstr(text, "BRF:6\nBRH:5\nLF:8\nLH:8\n") != NULL);
+    CHECK(text && strstr(text, "DA:18") == NULL && strstr(text, "DA:3,") == NULL);
+    free(text);
+
+    // Autre variante : ni fusion en mémoire, ni dans le fichier
+    static Coverage cmos;
+    cov_init(&cmos, CPU_65C02);
+    CHECK(!cov_merge(&cmos, &zero));
+    CHECK(!cov_save(&cmos, cov_path));
+    CHECK(cov_load(&loaded, cov_path));
+    cov_summary(&loaded, &s);
+    CHECK_EQ(s.instructions, 8);
+
+    unlink(dbg_path);
+    unlink(cov_path);
+    return check_done("coverage");
+}
@@ -0,0 +1,156 @@
+#include <string.h>
+#include "check.h"
+#include "device.h"
+
+// Périphériques en coroutines : reprise au premier bord d'instruction qui
+// atteint l'échéance, attentes périodiques sans dérive, variables locales
+// conservées sur la pile du périphérique, réveil depuis un handler d'E/S et
+// fin du corps.
+
+#define WAITS 5
+#define PERIOD 100
+
+typedef struct {
+    u64 resumed[WAITS + 1], targets[WAITS + 1];
+    int count;
+    int past_ok; // device_wait_until sur un cycle passé ne suspend pas
+} Trace;
+
+static void periodic_body(Device *dev) {
+    Trace *t = (Trace *)dev->ctx;
+    u64 local = 0x1122334455667788ULL; // Sur la pile de la coroutine
+    for (int i = 0; i < WAITS; i++) {
+        device_wait(dev, PERIOD);
+        t->resumed[t->count] = device_now(dev);
+        t->targets[t->count] = dev->target;
+        t->count++;
+        local ^= (u64)i << (8 * i);
+    }
+    u64 before = device_now(dev);
+    device_wait_until(dev, before - 1);
+    t->past_ok = device_now(dev) == before && local == (0x1122334455667788ULL ^ 0x0403020100ULL);
+}
+
+// Boucle comme celle de l'émulateur : une instruction, puis l'ordonnanceur
+static void run(CPU *cpu, Scheduler *sched, u64 cycles) {
+    while (cpu->cycles < cycles) {
+        cpu_step(cpu);
+        sched_poll(sched, cpu->cycles);
+    }
+}
+
+static void test_periodic(void) {
+    static const u8 program[] = {
+        0xEA,             // 0200 NOP
+        0xEE, 0x00, 0x30, // 0201 INC $3000   (6 cycles)
+        0x4C, 0x00, 0x02, // 0204 JMP $0200
+    };
+    static Memory mem;
+    static Device dev;
+    CPU cpu;
+    Scheduler sched;
+    Trace t;
+    memset(&t, 0, sizeof(t));
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    cpu.cycles = 0;
+    sched_init(&sched);
+
+    CHECK(device_start(&dev, "periodique", &cpu, &sched, periodic_body, &t));
+    CHECK_EQ(t.count, 0); // Le corps attend déjà sa première échéance
+    CHECK_EQ(dev.resumes, 1);
+    run(&cpu, &sched, 10000);
+
+    CHECK_EQ(t.count, WAITS);
+    for (int i = 0; i < WAITS; i++) {
+        // Échéances à k x PERIOD exactement, reprise moins d'une instruction après
+        CHECK_EQ(t.targets[i], (u64)(i + 1) * PERIOD);
+        CHECK(t.resumed[i] >= t.targets[i] && t.resumed[i] < t.targets[i] + 6);
+    }
+    CHECK(t.past_ok);
+    CHECK(dev.done);
+    CHECK_EQ(dev.resumes, WAITS + 1);
+    device_stop(&dev);
+}
+
+// Réveil : le corps attend une écriture en $D000, puis lève l'IRQ 10 cycles après
+typedef struct {
+    Device *dev;
+    u64 written, woken, raised;
+    int wakes;
+} Doorbell;
+
+static void doorbell_body(Device *dev) {
+    Doorbell *d = (Doorbell *)dev->ctx;
+    for (;;) {
+        device_wait_until(dev, SCHED_NEVER);
+        d->woken = device_now(dev);
+        d->wakes++;
+        device_wait(dev, 10);
+        d->raised = device_now(dev);
+        cpu_set_irq(dev->cpu, 1, 1);
+    }
+}
+
+static u8 doorbell_read(void *ctx, u16 address) {
+    (void)ctx;
+    (void)address;
+    return 0;
+}
+
+static void doorbell_write(void *ctx, u16 address, u8 value) {
+    (void)address;
+    (void)value;
+    Doorbell *d = (Doorbell *)ctx;
+    d->written = d->dev->cpu->cycles;
+    device_wake(d->dev);
+}
+
+static void test_wake(void) {
+    static const u8 program[] = {
+        0x78,             // 0200 SEI
+        0xA2, 0x00,       // 0201 LDX #$00
+        0xE8,             // 0203 INX
+        0xE0, 0x20,       // 0204 CPX #$20
+        0xD0, 0xFB,       // 0206 BNE $0203
+        0x8D, 0x00, 0xD0, // 0208 STA $D000
+        0x4C, 0x0B, 0x02, // 020B JMP $020B
+    };
+    static Memory mem;
+    static Device dev;
+    CPU cpu;
+    Scheduler sched;
+    Doorbell d;
+    memset(&d, 0, sizeof(d));
+    d.dev = &dev;
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    sched_init(&sched);
+    mem_map_io(&mem, 0xD0, 0xD0, doorbell_read, doorbell_write, &d);
+
+    CHECK(device_start(&dev, "sonnette", &cpu, &sched, doorbell_body, &d));
+    run(&cpu, &sched, cpu.cycles + 1000);
+    // Repris au bord de l'instruction STA, pas avant l'écriture
+    CHECK_EQ(d.wakes, 1);
+    CHECK(d.written != 0);
+    CHECK(d.woken >= d.written && d.woken <= d.written + 4);
+    // device_wait part de l'échéance du réveil (l'écriture), pas de la reprise
+    CHECK_EQ(d.raised - d.written, 10);
+    CHECK_EQ(cpu.irq_lines, 1);
+    CHECK(!dev.done);
+
+    // Sans nouvelle écriture, le corps reste suspendu
+    run(&cpu, &sched, cpu.cycles + 1000);
+    CHECK_EQ(d.wakes, 1);
+    device_stop(&dev);
+}
+
+int main(void) {
+    test_periodic();
+    test_wake();
+    return check_done("device");
+}
@@ -0,0 +1,165 @@
+#include <string.h>
+#include "check.h"
+#include "explore.h"
+
+// Exploration : chaque suite d'entrées est essayée, les feuilles rapportent
+// la bonne fin et le bon état, l'élagage ne retire que des états déjà vus et
+// le résultat ne dépend pas du nombre de threads. La mémoire source n'est pas
+// modifiée.
+//
+// Entrée en $10 à chaque passage en $0200 ; 3 part en $0280 (stop_pc), les
+// autres valeurs ajoutent leur bit 0 à $11. Après une entrée, 0 et 2 donnent
+// le même état : la seconde branche est élaguée.
+
+static const u8 program[] = {
+    0xA5, 0x10,       // 0200 LDA $10      (point de décision)
+    0xC9, 0x03,       // 0202 CMP #$03
+    0xF0, 0x7A,       // 0204 BEQ $0280
+    0x29, 0x01,       // 0206 AND #$01
+    0x18,             // 0208 CLC
+    0x65, 0x11,       // 0209 ADC $11
+    0x85, 0x11,       // 020B STA $11
+    0xA9, 0x00,       // 020D LDA #$00
+    0x85, 0x10,       // 020F STA $10
+    0x4C, 0x00, 0x02, // 0211 JMP $0200
+};
+
+static const u8 stop[] = {
+    0x4C, 0x80, 0x02, // 0280 JMP $0280
+};
+
+typedef struct {
+    int leaves;
+    int ends[EXPLORE_BUDGET + 1];
+    int seen[4][4]; // Suites de deux entrées rapportées
+    int bad;        // Feuilles dont l'état ne correspond pas aux entrées
+} Leaves;
+
+static void on_leaf(void *ctx, const CPU *cpu, const u8 *inputs, int count, ExploreEnd end) {
+    Leaves *l = (Leaves *)ctx;
+    l->leaves++;
+    l->ends[end]++;
+    int sum = 0;
+    for (int i = 0; i < count; i++) {
+        if (inputs[i] != 3) sum += inputs[i] & 1;
+    }
+    if (mem_peek(cpu->mem, 0x11) != sum) l->bad++;
+    switch (end) {
+    case EXPLORE_STOP:
+    case EXPLORE_TRAP:
+        if (inputs[count - 1] != 3 || cpu->PC != 0x0280) l->bad++;
+        break;
+    case EXPLORE_WAITING:
+        if (count != 2 || inputs[1] == 3 || cpu->PC != 0x0200) l->bad++;
+        break;
+    default:
+        break;
+    }
+    if (count == 2) l->seen[inputs[0]][inputs[1]]++;
+}
+
+static void setup(Memory *mem, CPU *cpu) {
+    mem_init(mem);
+    mem_load_bytes(mem, 0x0200, program, sizeof(program));
+    mem_load_bytes(mem, 0x0280, stop, sizeof(stop));
+    cpu_reset(cpu, mem);
+    cpu->PC = 0x0200;
+}
+
+static int explore(const CPU *cpu, long stop_pc, u64 max_cycles, int threads, int dedup, Leaves *l,
+                   ExploreStats *st) {
+    memset(l, 0, sizeof(*l));
+    ExploreConfig cfg = { 0x0200, 0x0010, 4, 2, stop_pc, max_cycles, threads, dedup, 10, on_leaf, l };
+    return explore_run(&cfg, cpu, st);
+}
+
+static void test_full(const CPU *cpu) {
+    Leaves l;
+    ExploreStats st;
+    CHECK(explore(cpu, 0x0280, 1000, 1, 0, &l, &st));
+    // 4 premières branches ; 0, 1 et 2 attendent une seconde entrée
+    CHECK_EQ(st.branches, 4 + 3 * 4);
+    CHECK_EQ(st.forks, 1 + 3);
+    CHECK_EQ(st.pruned, 0);
+    CHECK_EQ(st.leaves, 13);
+    CHECK_EQ(l.leaves, 13);
+    CHECK_EQ(l.ends[EXPLORE_STOP], 1 + 3);
+    CHECK_EQ(l.ends[EXPLORE_WAITING], 9);
+    CHECK_EQ(l.bad, 0);
+    for (int a = 0; a < 3; a++) {
+        for (int b = 0; b < 4; b++) CHECK_EQ(l.seen[a][b], 1);
+    }
+    CHECK_EQ(l.seen[3][0], 0); // 3 s'arrête après une entrée
+}
+
+static void test_dedup(const CPU *cpu, int threads) {
+    Leaves l;
+    ExploreStats st;
+    CHECK(explore(cpu, 0x0280, 1000, threads, 1, &l, &st));
+    CHECK_EQ(st.threads, threads);
+    CHECK_EQ(st.pruned, 1);
+    CHECK_EQ(st.branches, 4 + 2 * 4);
+    CHECK_EQ(st.leaves, 9);
+    CHECK_EQ(l.ends[EXPLORE_STOP], 1 + 2);
+    CHECK_EQ(l.ends[EXPLORE_WAITING], 6);
+    CHECK_EQ(l.bad, 0);
+    // Une seule des suites commençant par 0 ou 2 est développée, 1 toujours
+    int zero = l.seen[0][0] + l.seen[0][1] + l.seen[0][2] + l.seen[0][3];
+    int two = l.seen[2][0] + l.seen[2][1] + l.seen[2][2] + l.seen[2][3];
+    CHECK_EQ(zero + two, 4);
+    CHECK(zero == 0 || two == 0);
+    for (int b = 0; b < 4; b++) CHECK_EQ(l.seen[1][b], 1);
+}
+
+static void test_ends(const CPU *cpu) {
+    Leaves l;
+    ExploreStats st;
+    // Sans stop_pc : JMP $0280 boucle sur lui-même
+    CHECK(explore(cpu, -1, 1000, 2, 1, &l, &st));
+    CHECK_EQ(l.ends[EXPLORE_TRAP], 3);
+    CHECK_EQ(l.ends[EXPLORE_STOP], 0);
+    CHECK_EQ(l.bad, 0);
+    // 10 cycles : 3 arrive en $0280 en 8 cycles, les autres épuisent le budget
+    CHECK(explore(cpu, 0x0280, 10, 1, 1, &l, &st));
+    CHECK_EQ(st.branches, 4);
+    CHECK_EQ(l.ends[EXPLORE_STOP], 1);
+    CHECK_EQ(l.ends[EXPLORE_BUDGET], 3);
+}
+
+static u8 io_read(void *ctx, u16 address) {
+    (void)ctx;
+    (void)address;
+    return 0;
+}
+
+static void io_write(void *ctx, u16 address, u8 value) {
+    (void)ctx;
+    (void)address;
+    (void)value;
+}
+
+int main(void) {
+    static Memory mem;
+    CPU cpu;
+    setup(&mem, &cpu);
+    CPU before = cpu;
+    mem_write(&mem, 0x0011, 0x00);
+
+    test_full(&cpu);
+    test_dedup(&cpu, 1);
+    test_dedup(&cpu, 4);
+    test_ends(&cpu);
+    // L'état de départ n'est pas touché
+    CHECK_EQ(cpu.PC, before.PC);
+    CHECK_EQ(cpu.cycles, before.cycles);
+    CHECK_EQ(mem_peek(&mem, 0x0011), 0x00);
+    CHECK_EQ(mem_peek(&mem, 0x0010), 0x00);
+
+    // Un périphérique n'est pas dupliqué par mem_fork : refusé
+    Leaves l;
+    ExploreStats st;
+    mem_map_io(&mem, 0xD0, 0xD0, io_read, io_write, NULL);
+    CHECK(!explore(&cpu, 0x0280, 1000, 1, 1, &l, &st));
+    CHECK_EQ(l.leaves, 0);
+    return check_done("explore");
+}
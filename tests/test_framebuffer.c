@@ -0,0 +1,327 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "cpu.h"
+#include "framebuffer.h"
+
+// Écran en mémoire : pixels rendus pour chaque mode (police intégrée et
+// inverse vidéo, bits mono, couleurs RRRGGGBB), seules les lignes touchées
+// par une écriture (mem_write ou instruction) sont redessinées, le rendu
+// incrémental donne l'image d'un rendu complet, et les fichiers écrits
+// (texte, PPM, PNG décodé bloc par bloc avec CRC et Adler-32) contiennent
+// exactement l'image.
+
+static Memory mem;
+
+// Pixel (x, y) de l'image : un octet de filtre par ligne puis RGB
+static const u8 *pixel(const Framebuffer *fb, int x, int y) {
+    return fb->pixels + (size_t)y * (1 + 3 * (size_t)fb->width) + 1 + 3 * (size_t)x;
+}
+
+static int is_rgb(const u8 *p, u8 r, u8 g, u8 b) {
+    return p[0] == r && p[1] == g && p[2] == b;
+}
+
+// Pixels d'une ligne sous la forme "1100..." (blanc = 1)
+static int row_is(const Framebuffer *fb, int x, int y, const char *bits) {
+    for (int i = 0; bits[i]; i++) {
+        u8 v = bits[i] == '1' ? 0xFF : 0x00;
+        if (!is_rgb(pixel(fb, x + i, y), v, v, v)) return 0;
+    }
+    return 1;
+}
+
+static void test_text(void) {
+    static Framebuffer fb;
+    mem_init(&mem);
+    CHECK(fb_attach(&fb, &mem, 0x0400, FB_TEXT, 8, 2));
+    CHECK_EQ(fb.width, 64);
+    CHECK_EQ(fb.height, 16);
+    mem_write(&mem, 0x0400, 'H');
+    mem_write(&mem, 0x0401, 'i');
+    mem_write(&mem, 0x0408, 0xC1); // 'A' en inverse vidéo
+    mem_write(&mem, 0x040F, '~');
+    CHECK_EQ(fb.writes, 4);
+    CHECK_EQ(fb_render(&fb), 2);
+    // 'H' : rangées $33 puis $3F de font8x8 (bit 0 à gauche)
+    CHECK(row_is(&fb, 0, 0, "11001100"));
+    CHECK(row_is(&fb, 0, 3, "11111100"));
+    CHECK(row_is(&fb, 0, 7, "00000000"));
+    // 'A' inversé : rangée $0C -> 00110000 -> 11001111
+    CHECK(row_is(&fb, 0, 8, "11001111"));
+    CHECK(row_is(&fb, 0, 15, "11111111"));
+    CHECK(row_is(&fb, 8, 8, "00000000")); // Code 0 : glyphe vide
+
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    CHECK(out != NULL);
+    if (out) {
+        CHECK(fb_write_text(&fb, out));
+        fclose(out);
+        CHECK(text && strcmp(text, "Hi......\nA......~\n") == 0);
+        free(text);
+    }
+
+    // Police de 256 glyphes : pas d'inverse vidéo
+    static u8 font[256 * 8];
+    font[0xC1 * 8] = 0x81;
+    fb_set_font(&fb, font, 256);
+    CHECK_EQ(fb_render(&fb), 2);
+    CHECK(row_is(&fb, 0, 8, "10000001"));
+    CHECK(row_is(&fb, 0, 0, "00000000"));
+    fb_detach(&fb);
+}
+
+static void test_dirty(void) {
+    static Framebuffer fb;
+    // Écran mono 64x16 : 8 octets par ligne, $2000-$207F
+    mem_init(&mem);
+    CHECK(!fb_attach(&fb, &mem, 0x2000, FB_MONO, 60, 16)); // Largeur non multiple de 8
+    CHECK(!fb_attach(&fb, &mem, 0xFF80, FB_MONO, 64, 32)); // Dépasse $FFFF
+    CHECK(fb_attach(&fb, &mem, 0x2000, FB_MONO, 64, 16));
+    CHECK_EQ(fb_render(&fb), 16);
+    CHECK_EQ(fb_render(&fb), 0);
+
+    mem_write(&mem, 0x2000, 0x81);
+    mem_write(&mem, 0x2007, 0x01);
+    mem_write(&mem, 0x2079, 0xF0);
+    mem_write(&mem, 0x2080, 0xFF); // Page de l'écran, hors de l'écran
+    CHECK_EQ(fb.writes, 3);
+    CHECK_EQ(fb_render(&fb), 2);
+    CHECK_EQ(fb.lines_rendered, 16 + 2);
+    CHECK(row_is(&fb, 0, 0, "10000001"));
+    CHECK(row_is(&fb, 56, 0, "00000001"));
+    CHECK(row_is(&fb, 8, 15, "11110000"));
+    CHECK(row_is(&fb, 0, 1, "00000000"));
+
+    // Écriture par une instruction : STA $2010 marque la ligne 2
+    static const u8 program[] = {
+        0xA9, 0x3C,       // 0200 LDA #$3C
+        0x8D, 0x10, 0x20, // 0202 STA $2010
+    };
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    CPU cpu;
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    cpu_step(&cpu);
+    cpu_step(&cpu);
+    CHECK_EQ(fb_render(&fb), 1);
+    CHECK(row_is(&fb, 0, 2, "00111100"));
+
+    // Les lectures ne marquent rien ; un chargement direct demande fb_invalidate
+    CHECK_EQ(mem_read(&mem, 0x2010), 0x3C);
+    u8 line[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    mem_load_bytes(&mem, 0x2018, line, sizeof(line));
+    CHECK_EQ(fb_render(&fb), 0);
+    CHECK(row_is(&fb, 0, 3, "00000000"));
+    fb_invalidate(&fb);
+    CHECK_EQ(fb_render(&fb), 16);
+    CHECK(row_is(&fb, 0, 3, "11111111"));
+
+    // Détaché : plus d'interception, la RAM reste écrite
+    u64 writes = fb.writes;
+    fb_detach(&fb);
+    mem_write(&mem, 0x2000, 0x42);
+    CHECK_EQ(fb.writes, writes);
+    CHECK_EQ(mem_peek(&mem, 0x2000), 0x42);
+}
+
+// Écritures pseudo-aléatoires entre des rendus incrémentaux : l'image finale
+// est celle d'un rendu complet
+static void test_incremental(void) {
+    static Framebuffer fb;
+    mem_init(&mem);
+    CHECK(fb_attach(&fb, &mem, 0x3000, FB_RGB332, 32, 24));
+    mem_write(&mem, 0x3000, 0xE0);
+    mem_write(&mem, 0x3001, 0x1C);
+    mem_write(&mem, 0x3002, 0x03);
+    mem_write(&mem, 0x3003, 0x49);
+    fb_render(&fb);
+    CHECK(is_rgb(pixel(&fb, 0, 0), 255, 0, 0));
+    CHECK(is_rgb(pixel(&fb, 1, 0), 0, 255, 0));
+    CHECK(is_rgb(pixel(&fb, 2, 0), 0, 0, 255));
+    CHECK(is_rgb(pixel(&fb, 3, 0), 72, 72, 85));
+
+    u32 seed = 12345;
+    int partial = 0;
+    for (int frame = 0; frame < 50; frame++) {
+        for (int i = 0; i < 20; i++) {
+            seed = seed * 1103515245u + 12345u;
+            mem_write(&mem, (u16)(0x3000 + (seed >> 8) % (32 * 24)), (u8)(seed >> 24));
+        }
+        if (fb_render(&fb) < 24) partial++;
+    }
+    CHECK(partial > 0);
+    size_t bytes = (size_t)fb.height * (1 + 3 * (size_t)fb.width);
+    u8 *copy = malloc(bytes);
+    CHECK(copy != NULL);
+    if (copy) {
+        memcpy(copy, fb.pixels, bytes);
+        fb_invalidate(&fb);
+        CHECK_EQ(fb_render(&fb), 24);
+        CHECK(memcmp(copy, fb.pixels, bytes) == 0);
+        free(copy);
+    }
+    for (int y = 0; y < fb.height; y++) CHECK_EQ(fb.pixels[(size_t)y * (1 + 3 * 32)], 0); // Filtres PNG
+    fb_detach(&fb);
+}
+
+static u8 *read_file(const char *path, long *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    u8 *data = malloc((size_t)*size + 1);
+    if (data && fread(data, 1, (size_t)*size, f) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static u32 be32(const u8 *p) {
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+static u32 crc32(const u8 *p, size_t n) {
+    u32 crc = 0xFFFFFFFFu;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    return ~crc;
+}
+
+// PNG relu : chunks et CRC, IHDR, flux zlib de blocs "stored" décodé et
+// comparé à l'image, Adler-32, IEND
+static void check_png(const Framebuffer *fb, const u8 *data, long size) {
+    static const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    size_t raw = (size_t)fb->height * (1 + 3 * (size_t)fb->width);
+    u8 *decoded = malloc(raw);
+    CHECK(decoded != NULL);
+    if (decoded == NULL) return;
+    CHECK(size > 8 && memcmp(data, signature, 8) == 0);
+    long pos = 8;
+    int chunks = 0, ended = 0;
+    size_t got = 0;
+    while (!ended && pos + 12 <= size) {
+        u32 length = be32(data + pos);
+        const u8 *type = data + pos + 4, *body = data + pos + 8;
+        if (pos + 12 + (long)length > size) break;
+        CHECK_EQ(be32(body + length), crc32(type, length + 4));
+        if (chunks == 0) {
+            CHECK(memcmp(type, "IHDR", 4) == 0);
+            CHECK_EQ(length, 13);
+            CHECK_EQ(be32(body), fb->width);
+            CHECK_EQ(be32(body + 4), fb->height);
+            CHECK_EQ(body[8], 8);
+            CHECK_EQ(body[9], 2);
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            CHECK_EQ(body[0], 0x78);
+            CHECK_EQ((body[0] << 8 | body[1]) % 31, 0);
+            u32 p = 2;
+            int last = 0;
+            while (!last && p + 5 <= length) {
+                last = body[p] & 1;
+                CHECK_EQ(body[p] >> 1, 0); // Bloc non compressé
+                u32 n = body[p + 1] | body[p + 2] << 8;
+                CHECK_EQ(n ^ 0xFFFF, (u32)(body[p + 3] | body[p + 4] << 8));
+                p += 5;
+                if (got + n > raw || p + n > length) break;
+                memcpy(decoded + got, body + p, n);
+                got += n;
+                p += n;
+            }
+            CHECK(last);
+            u32 a = 1, b = 0;
+            for (size_t i = 0; i < got; i++) {
+                a = (a + decoded[i]) % 65521;
+                b = (b + a) % 65521;
+            }
+            CHECK_EQ(p + 4, length);
+            CHECK_EQ(be32(body + p), b << 16 | a);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            CHECK_EQ(length, 0);
+            ended = 1;
+        }
+        pos += 12 + (long)length;
+        chunks++;
+    }
+    CHECK(ended);
+    CHECK_EQ(pos, size);
+    CHECK_EQ(got, raw);
+    CHECK(memcmp(decoded, fb->pixels, raw) == 0);
+    free(decoded);
+}
+
+static void test_files(void) {
+    static Framebuffer fb;
+    char base[] = "/tmp/test_fb_XXXXXX";
+    close(mkstemp(base));
+    char path[64];
+
+    // rgb332 200x300 : 176 Ko d'image, plusieurs blocs deflate
+    mem_init(&mem);
+    CHECK(fb_attach(&fb, &mem, 0x1000, FB_RGB332, 200, 300));
+    for (u32 i = 0; i < fb.size; i++) mem_write(&mem, (u16)(0x1000 + i), (u8)(i * 7 + (i >> 8)));
+    snprintf(path, sizeof(path), "%s.png", base);
+    CHECK(fb_save(&fb, path));
+    long size = 0;
+    u8 *data = read_file(path, &size);
+    CHECK(data != NULL);
+    if (data) check_png(&fb, data, size);
+    free(data);
+    unlink(path);
+
+    // PPM : en-tête puis les pixels sans les octets de filtre
+    snprintf(path, sizeof(path), "%s.ppm", base);
+    mem_write(&mem, 0x1000, 0xFF);
+    CHECK(fb_save(&fb, path)); // Rend la ligne touchée avant d'écrire
+    CHECK(is_rgb(pixel(&fb, 0, 0), 255, 255, 255));
+    data = read_file(path, &size);
+    CHECK(data != NULL);
+    static const char header[] = "P6\n200 300\n255\n";
+    size_t h = sizeof(header) - 1;
+    CHECK_EQ(size, (long)(h + 200 * 300 * 3));
+    if (data && size == (long)(h + 200 * 300 * 3)) {
+        CHECK(memcmp(data, header, h) == 0);
+        int same = 1;
+        for (int y = 0; y < 300; y++) same &= memcmp(data + h + (size_t)y * 600, pixel(&fb, 0, y), 600) == 0;
+        CHECK(same);
+    }
+    free(data);
+    unlink(path);
+
+    // Texte : refusé pour un écran graphique, sans créer de fichier
+    snprintf(path, sizeof(path), "%s.txt", base);
+    CHECK(!fb_save(&fb, path));
+    CHECK(access(path, F_OK) != 0);
+    fb_detach(&fb);
+
+    CHECK(fb_attach(&fb, &mem, 0x0400, FB_TEXT, 4, 2));
+    mem_write(&mem, 0x0400, 'O');
+    mem_write(&mem, 0x0401, 'K');
+    CHECK(fb_save(&fb, path));
+    data = read_file(path, &size);
+    CHECK(data != NULL);
+    if (data) {
+        data[size] = 0;
+        CHECK(strcmp((char *)data, "OK..\n....\n") == 0);
+    }
+    free(data);
+    unlink(path);
+    fb_detach(&fb);
+    unlink(base);
+}
+
+int main(void) {
+    test_text();
+    test_dirty();
+    test_incremental();
+    test_files();
+    return check_done("framebuffer");
+}
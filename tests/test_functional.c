@@ -0,0 +1,39 @@
+#include <unistd.h>
+#include "check.h"
+#include "cpu.h"
+
+// Test fonctionnel de Klaus Dormann (6502_functional_test.bin, lancé en
+// $0400) : il doit finir sur le piège de succès $3469 (JMP sur lui-même)
+// avec le numéro de test $F0 en $0200. Ce sont les adresses SUCCESS_PC et
+// TEST_NUMBER de src/main.c ($37A3 et $0210 ne sont pas les bonnes).
+#define ROM "6502_functional_test.bin"
+#define SUCCESS_PC 0x3469
+#define TEST_NUMBER 0x0200
+
+int main(void) {
+    if (access(ROM, R_OK) != 0) {
+        printf("functional       : %s absent, ignore\n", ROM);
+        return 0;
+    }
+    static Memory mem;
+    mem_init(&mem);
+    CHECK(mem_load(&mem, ROM, 0) != 0);
+    CPU cpu;
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0400;
+    u16 previous = 0;
+    u64 instructions = 0;
+    // Jusqu'au premier saut sur lui-même (succès ou échec d'un test)
+    while (cpu.cycles < 200000000) {
+        previous = cpu.PC;
+        cpu_step(&cpu);
+        instructions++;
+        if (cpu.PC == previous) break;
+    }
+    CHECK_EQ(cpu.PC, SUCCESS_PC);
+    CHECK_EQ(mem_peek(&mem, TEST_NUMBER), 0xF0);
+    CHECK_EQ(mem_peek(&mem, SUCCESS_PC), 0x4C);
+    CHECK_EQ(instructions, 30646177);
+    CHECK_EQ(cpu.cycles, 95334667);
+    return check_done("functional");
+}
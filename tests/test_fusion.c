@@ -0,0 +1,222 @@
+#include <string.h>
+#include "check.h"
+#include "blockcache.h"
+
+// Superinstructions du moteur à blocs : chaque famille fusionnée (CMP/CPX/
+// CPY puis BNE/BEQ/BCC/BCS, INX/INY/DEX/DEY puis branchement, INX ; CPX ;
+// BNE, LDA ; STA, CLC ; ADC binaire et décimal) donne exactement l'état du
+// cœur de référence. L'échéance est placée à chaque cycle d'un run (jamais
+// au milieu d'une suite fusionnée), puis une IRQ est levée à cet endroit :
+// mêmes registres, cycles, mémoire (pile comprise), lectures du
+// périphérique et watchpoints d'exécution. Une comparaison lue dans une page
+// de périphérique s'arrête après sa première instruction ; un STA fusionné
+// qui réécrit l'opérande d'un CPX du bloc l'invalide.
+
+static const u8 program[] = {
+    0xA0, 0x04,       // 0200 LDY #$04
+    0xA2, 0x00,       // 0202 LDX #$00
+    0xE8,             // 0204 INX          INX ; CPX ; BNE
+    0xE0, 0x08,       // 0205 CPX #$08     (opérande réécrit en $0220)
+    0xD0, 0xFB,       // 0207 BNE $0204
+    0x88,             // 0209 DEY          DEY ; BNE
+    0xD0, 0xF6,       // 020A BNE $0202
+    0xA5, 0x10,       // 020C LDA $10      LDA zp ; STA abs
+    0x8D, 0x00, 0x30, // 020E STA $3000
+    0x18,             // 0211 CLC          CLC ; ADC imm
+    0x69, 0x37,       // 0212 ADC #$37
+    0x85, 0x10,       // 0214 STA $10
+    0xC5, 0x11,       // 0216 CMP $11      CMP zp ; BCC
+    0x90, 0x02,       // 0218 BCC $021C
+    0xE6, 0x11,       // 021A INC $11
+    0xE6, 0x12,       // 021C INC $12
+    0xA5, 0x12,       // 021E LDA $12      LDA zp ; STA dans le bloc
+    0x8D, 0x06, 0x02, // 0220 STA $0206
+    0xCD, 0x00, 0xD0, // 0223 CMP $D000    page de périphérique
+    0xF0, 0x00,       // 0226 BEQ $0228
+    0xF8,             // 0228 SED
+    0x18,             // 0229 CLC          CLC ; ADC zp décimal
+    0x65, 0x13,       // 022A ADC $13
+    0xD8,             // 022C CLD
+    0x85, 0x13,       // 022D STA $13
+    0xC8,             // 022F INY          INY ; BMI
+    0x30, 0x02,       // 0230 BMI $0234
+    0xA0, 0xF0,       // 0232 LDY #$F0
+    0xC0, 0xF8,       // 0234 CPY #$F8     CPY ; BCS
+    0xB0, 0x02,       // 0236 BCS $023A
+    0xA2, 0x03,       // 0238 LDX #$03
+    0xCA,             // 023A DEX          DEX ; BPL
+    0x10, 0xFD,       // 023B BPL $023A
+    0x4C, 0x00, 0x02, // 023D JMP $0200
+};
+
+static const u8 irq_handler[] = {
+    0xE6, 0x20,       // 0300 INC $20
+    0x4C, 0x02, 0x03, // 0302 JMP $0302
+};
+
+typedef struct {
+    Memory mem;
+    CPU cpu;
+    int reads; // Lectures du périphérique en $D000
+    int irq_on_read;
+    int execs; // Watchpoint d'exécution sur la page 2
+} Machine;
+
+static u8 io_read(void *ctx, u16 address) {
+    (void)address;
+    Machine *m = (Machine *)ctx;
+    if (m->irq_on_read) cpu_set_irq(&m->cpu, 2, 1);
+    return (u8)m->reads++;
+}
+
+static void io_write(void *ctx, u16 address, u8 value) {
+    (void)ctx;
+    (void)address;
+    (void)value;
+}
+
+static void on_exec(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)pc;
+    (void)address;
+    (void)value;
+    (void)kind;
+    ((Machine *)ctx)->execs++;
+}
+
+static void setup(Machine *m) {
+    static const u8 vectors[] = { 0x00, 0x02, 0x00, 0x02, 0x00, 0x03 };
+    memset(m, 0, sizeof(*m));
+    mem_init(&m->mem);
+    mem_load_bytes(&m->mem, 0x0200, program, sizeof(program));
+    mem_load_bytes(&m->mem, 0x0300, irq_handler, sizeof(irq_handler));
+    mem_load_bytes(&m->mem, 0xFFFA, vectors, sizeof(vectors));
+    mem_write(&m->mem, 0x0011, 0x80);
+    mem_map_io(&m->mem, 0xD0, 0xD0, io_read, io_write, m);
+    mem_add_watch(&m->mem, 0x0200, 0x02FF, MEM_WATCH_EXEC, on_exec, m);
+    cpu_reset(&m->cpu, &m->mem);
+    m->cpu.PC = 0x0200;
+    m->cpu.P &= ~FLAG_I;
+}
+
+static int same_machine(Machine *a, Machine *b) {
+    const CPU *x = &a->cpu, *y = &b->cpu;
+    if (x->A != y->A || x->X != y->X || x->Y != y->Y || x->P != y->P || x->SP != y->SP || x->PC != y->PC
+        || x->cycles != y->cycles || a->reads != b->reads || a->execs != b->execs) {
+        return 0;
+    }
+    for (u32 address = 0; address < MAX_MEMORY; address++) {
+        if ((address >> 8) == 0xD0) continue;
+        if (mem_peek(&a->mem, (u16)address) != mem_peek(&b->mem, (u16)address)) return 0;
+    }
+    return 1;
+}
+
+static void run_reference(Machine *m, u64 stop, u64 end) {
+    while (m->cpu.cycles < stop) cpu_step(&m->cpu);
+    cpu_set_irq(&m->cpu, 1, 1);
+    while (m->cpu.cycles < end) cpu_step(&m->cpu);
+}
+
+static u64 run_blocks(Machine *m, u64 stop, u64 end, int fuse) {
+    BlockCache *bc = block_create(&m->cpu);
+    CHECK(bc != NULL);
+    if (bc == NULL) return 0;
+    bc->fuse = fuse;
+    while (m->cpu.cycles < stop) block_exec(bc, stop);
+    cpu_set_irq(&m->cpu, 1, 1);
+    while (m->cpu.cycles < end) block_exec(bc, end);
+    u64 fused = bc->fused;
+    block_free(bc);
+    return fused;
+}
+
+static void test_decode(void) {
+    static Machine m;
+    setup(&m);
+    BlockCache *bc = block_create(&m.cpu);
+    CHECK(bc != NULL);
+    if (bc == NULL) return;
+    // LDY, LDX, puis INX ; CPX ; BNE (CPX ; BNE repris par INX) : deux
+    // superinstructions, cinq instructions en trois appels
+    u64 start = m.cpu.cycles;
+    CHECK_EQ(block_exec(bc, start + 100), 5);
+    CHECK_EQ(bc->fused, 2);
+    CHECK_EQ(m.cpu.PC, 0x0204);
+    CHECK_EQ(m.cpu.X, 1);
+    CHECK_EQ(m.cpu.cycles, start + 2 + 2 + 2 + 2 + 3);
+    CHECK_EQ(m.execs, 5);
+
+    // Échéance au milieu de INX ; CPX ; BNE (bloc en $0204, fusionné comme
+    // celui de $0200) : INX seul
+    start = m.cpu.cycles;
+    CHECK_EQ(block_exec(bc, start + 1), 1);
+    CHECK_EQ(bc->fused, 4);
+    CHECK_EQ(m.cpu.PC, 0x0205);
+    CHECK_EQ(m.cpu.X, 2);
+    CHECK_EQ(block_exec(bc, start + 100), 2); // CPX ; BNE, bloc en $0205
+    CHECK_EQ(m.cpu.PC, 0x0204);
+    CHECK_EQ(bc->fused, 5);
+    block_free(bc);
+
+    bc = block_create(&m.cpu);
+    if (bc == NULL) return;
+    bc->fuse = 0;
+    block_exec(bc, m.cpu.cycles + 100);
+    CHECK_EQ(bc->fused, 0);
+    block_free(bc);
+}
+
+// Comparaison lue dans une page de périphérique qui lève une IRQ : le
+// handler s'arrête après le CMP, l'IRQ est prise avant le BEQ
+static void test_slow_page(void) {
+    static Machine m;
+    setup(&m);
+    BlockCache *bc = block_create(&m.cpu);
+    CHECK(bc != NULL);
+    if (bc == NULL) return;
+    m.cpu.PC = 0x0223;
+    m.cpu.A = 0x00;
+    m.irq_on_read = 1;
+    CHECK_EQ(block_exec(bc, m.cpu.cycles + 100), 1);
+    CHECK_EQ(bc->fused, 1); // CMP ; BEQ
+    CHECK_EQ(m.cpu.PC, 0x0226);
+    CHECK_EQ(m.reads, 1);
+    CHECK(m.cpu.P & FLAG_Z); // Première lecture : 0
+    CHECK_EQ(block_exec(bc, m.cpu.cycles + 100), 1);
+    CHECK_EQ(m.cpu.PC, 0x0300);
+    u16 pushed = mem_peek(&m.mem, 0x0100 | (u8)(m.cpu.SP + 2)) | mem_peek(&m.mem, 0x0100 | (u8)(m.cpu.SP + 3)) << 8;
+    CHECK_EQ(pushed, 0x0226);
+    block_free(bc);
+}
+
+int main(void) {
+    static Machine ref, fused, plain;
+    test_decode();
+    test_slow_page();
+
+    // Échéance et IRQ à chaque cycle des 2000 premiers
+    const u64 start = 7;
+    int mismatches = 0, plain_mismatches = 0;
+    u64 superinstructions = 0;
+    for (u64 stop = start; stop < start + 2000; stop++) {
+        setup(&ref);
+        setup(&fused);
+        run_reference(&ref, stop, stop + 400);
+        superinstructions += run_blocks(&fused, stop, stop + 400, 1);
+        if (!same_machine(&ref, &fused)) mismatches++;
+        if (stop % 50 == 0) {
+            setup(&plain);
+            CHECK_EQ(run_blocks(&plain, stop, stop + 400, 0), 0);
+            if (!same_machine(&ref, &plain)) plain_mismatches++;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+    CHECK_EQ(plain_mismatches, 0);
+    CHECK(superinstructions > 2000 * 10);
+    // Le programme a bien fait son travail : IRQ prise, périphérique lu
+    CHECK_EQ(ref.cpu.PC, 0x0302);
+    CHECK_EQ(mem_peek(&ref.mem, 0x0020), 1);
+    CHECK(ref.reads > 0);
+    CHECK(mem_peek(&ref.mem, 0x0012) > 0);
+    return check_done("fusion");
+}
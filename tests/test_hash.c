@@ -0,0 +1,150 @@
+#include <string.h>
+#include "check.h"
+#include "hang.h"
+
+// Empreinte incrémentale de la mémoire et détection des boucles infinies.
+// L'empreinte tenue à jour écriture par écriture (mem_write, pile, banques)
+// doit rester égale à un recalcul complet ; coupée, elle ne bouge pas.
+
+// Empreinte recalculée depuis le contenu
+static u64 rehashed(Memory *mem) {
+    u64 kept = mem->hash;
+    mem_rehash(mem);
+    u64 fresh = mem->hash;
+    mem->hash = kept;
+    return fresh;
+}
+
+static void test_incremental(void) {
+    static Memory mem;
+    static u8 bank[2 * 256];
+    mem_init(&mem);
+
+    // Coupée par défaut : les écritures ne la touchent pas
+    mem_write(&mem, 0x1234, 0x56);
+    CHECK_EQ(mem.hash, 0);
+    mem_set_hashing(&mem, 1);
+    u64 start = mem.hash;
+    CHECK(start != 0);
+
+    mem_write(&mem, 0x0010, 0xAA);
+    CHECK(mem.hash != start);
+    CHECK_EQ(mem.hash, rehashed(&mem));
+    mem_write(&mem, 0x0010, 0x00); // Retour au même contenu : même empreinte
+    CHECK_EQ(mem.hash, start);
+
+    // Même contenu atteint dans un autre ordre
+    mem_write(&mem, 0x2000, 1);
+    mem_write(&mem, 0x3000, 2);
+    u64 first = mem.hash;
+    mem_write(&mem, 0x2000, 0);
+    mem_write(&mem, 0x3000, 0);
+    mem_write(&mem, 0x3000, 2);
+    mem_write(&mem, 0x2000, 1);
+    CHECK_EQ(mem.hash, first);
+
+    // Pile en ligne (JSR) et banques de RAM et de ROM
+    static const u8 program[] = {
+        0x20, 0x05, 0x02, // 0200 JSR $0205
+        0xEA, 0xEA,       // 0203 NOP NOP
+        0x48,             // 0205 PHA
+    };
+    CPU cpu;
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    cpu.A = 0x77;
+    cpu_step(&cpu);
+    cpu_step(&cpu);
+    CHECK_EQ(mem_peek(&mem, 0x0100 | (u8)(cpu.SP + 1)), 0x77);
+    CHECK_EQ(mem.hash, rehashed(&mem));
+
+    memset(bank, 0x42, sizeof(bank));
+    mem_map_pages(&mem, 0x80, 2, bank, bank);
+    CHECK_EQ(mem.hash, rehashed(&mem));
+    mem_write(&mem, 0x8100, 0x43);
+    CHECK_EQ(bank[256], 0x43);
+    CHECK_EQ(mem.hash, rehashed(&mem));
+    mem_map_pages(&mem, 0x80, 2, bank, NULL); // ROM : écritures ignorées
+    u64 rom = mem.hash;
+    CHECK_EQ(rom, rehashed(&mem));
+    mem_write(&mem, 0x8000, 0x99);
+    CHECK_EQ(mem.hash, rom);
+    mem_unmap_pages(&mem, 0x80, 2);
+    CHECK_EQ(mem.hash, rehashed(&mem));
+
+    // Coupée à nouveau : plus de mise à jour
+    mem_set_hashing(&mem, 0);
+    mem_write(&mem, 0x0010, 0x55);
+    CHECK_EQ(mem.hash, 0);
+}
+
+typedef struct {
+    int hung;
+    u64 steps, period_cycles;
+    u32 period_steps;
+} HangResult;
+
+static void run_hang(const u8 *program, size_t size, u64 max_steps, HangResult *r) {
+    static Memory mem;
+    static HangDetector hang;
+    CPU cpu;
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, size);
+    mem_set_hashing(&mem, 1);
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    hang_init(&hang, &cpu);
+    memset(r, 0, sizeof(*r));
+    for (r->steps = 1; r->steps <= max_steps; r->steps++) {
+        cpu_step(&cpu);
+        if (hang_check(&hang, &cpu)) {
+            r->hung = 1;
+            r->period_cycles = hang.period_cycles;
+            r->period_steps = hang.period_steps;
+            return;
+        }
+    }
+}
+
+static void test_hang(void) {
+    HangResult r;
+
+    // Piège sur place : l'état de départ (repère) revient dès le premier pas
+    static const u8 trap[] = {
+        0x4C, 0x00, 0x02, // 0200 JMP $0200
+    };
+    run_hang(trap, sizeof(trap), 100, &r);
+    CHECK(r.hung);
+    CHECK_EQ(r.steps, 1);
+    CHECK_EQ(r.period_steps, 1);
+    CHECK_EQ(r.period_cycles, 3);
+
+    // Les registres se répètent tous les deux tours, la mémoire tous les 256 :
+    // la vraie période est de 256 tours (INC 5 cycles + JMP 3)
+    static const u8 counter[] = {
+        0xE6, 0x10,       // 0200 INC $10
+        0x4C, 0x00, 0x02, // 0202 JMP $0200
+    };
+    run_hang(counter, sizeof(counter), 100000, &r);
+    CHECK(r.hung);
+    CHECK_EQ(r.period_steps, 2 * 256);
+    CHECK_EQ(r.period_cycles, 256 * 8);
+    CHECK(r.steps < 4 * 2 * 256);
+
+    // Compteur de 16 bits : pas de répétition dans les 100000 premiers pas
+    static const u8 wide[] = {
+        0xE6, 0x10,       // 0200 INC $10
+        0xD0, 0xFC,       // 0202 BNE $0200
+        0xE6, 0x11,       // 0204 INC $11
+        0x4C, 0x00, 0x02, // 0206 JMP $0200
+    };
+    run_hang(wide, sizeof(wide), 100000, &r);
+    CHECK(!r.hung);
+}
+
+int main(void) {
+    test_incremental();
+    test_hang();
+    return check_done("hash");
+}
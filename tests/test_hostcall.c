@@ -0,0 +1,246 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "check.h"
+#include "hostcall.h"
+
+// Appels hôte : chaque service appelé par un vrai STA dans la porte en
+// $F000. Résultat dans A/X avec C = 0, ou errno dans A avec C = 1 et X = 0,
+// relus aussi dans les registres de la porte. Erreurs : service inconnu,
+// fichier invalide ou fermé, plage hors de la mémoire, mode ou chemin
+// invalide, plus de fichiers libres, fichier absent. Données : fichier écrit
+// puis relu (création, ajout, fin de fichier), chargement tronqué, passage
+// par mem_read / mem_write sur une page surveillée, empreinte de la mémoire
+// tenue à jour.
+
+static Memory mem;
+static CPU cpu;
+static HostCall hc;
+
+static void setup(void) {
+    static const u8 program[] = {
+        0x8D, 0x00, 0xF0, // 0200 STA $F000
+    };
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    cpu_reset(&cpu, &mem);
+    hostcall_attach(&hc, &mem, 0xF0, &cpu);
+}
+
+// Service appelé avec X/Y = 'block' ; retourne A/X, ou -A si C = 1
+static long call(u8 service, u16 block) {
+    cpu.PC = 0x0200;
+    cpu.A = service;
+    cpu.X = (u8)block;
+    cpu.Y = (u8)(block >> 8);
+    cpu.P |= FLAG_C;
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0203);
+    if (cpu.P & FLAG_C) {
+        CHECK_EQ(cpu.X, 0);
+        CHECK_EQ(mem_read(&mem, 0xF000 + HC_ERRNO), cpu.A);
+        CHECK_EQ(mem_read(&mem, 0xF000 + HC_RESULT_LO), 0);
+        return -(long)cpu.A;
+    }
+    CHECK_EQ(mem_read(&mem, 0xF000 + HC_ERRNO), 0);
+    CHECK_EQ(mem_read(&mem, 0xF000 + HC_RESULT_LO), cpu.A);
+    CHECK_EQ(mem_read(&mem, 0xF000 + HC_RESULT_HI), cpu.X);
+    return cpu.A | cpu.X << 8;
+}
+
+static void put_word(u16 address, u16 value) {
+    mem_write(&mem, address, (u8)value);
+    mem_write(&mem, (u16)(address + 1), (u8)(value >> 8));
+}
+
+// Blocs de paramètres en $0300 (lecture, écriture), $0310 (ouverture) et
+// $0320 (chargement) ; chemin en $0400
+static long file_io(u8 service, u8 file, u16 address, u16 len) {
+    mem_write(&mem, 0x0300, file);
+    put_word(0x0301, address);
+    put_word(0x0303, len);
+    return call(service, 0x0300);
+}
+
+static long open_file(const char *path, u8 mode) {
+    mem_load_bytes(&mem, 0x0400, (const u8 *)path, strlen(path) + 1);
+    put_word(0x0310, 0x0400);
+    mem_write(&mem, 0x0312, mode);
+    return call(HC_OPEN, 0x0310);
+}
+
+static long load_file(const char *path, u16 address, u16 max) {
+    mem_load_bytes(&mem, 0x0400, (const u8 *)path, strlen(path) + 1);
+    put_word(0x0320, 0x0400);
+    put_word(0x0322, address);
+    put_word(0x0324, max);
+    return call(HC_LOAD, 0x0320);
+}
+
+static void test_errors(void) {
+    setup();
+    CHECK_EQ(call(0x80, 0x1234), -ENOSYS);
+    CHECK_EQ(hc.error, ENOSYS);
+    CHECK_EQ(file_io(HC_WRITE, 9, 0x1000, 1), -EBADF);   // Fichier libre
+    CHECK_EQ(file_io(HC_READ, 200, 0x1000, 1), -EBADF);  // Hors de la table
+    CHECK_EQ(file_io(HC_WRITE, 1, 0xFFF0, 0x20), -EFAULT);
+    int null_fd = open("/dev/null", O_RDONLY); // Pas d'attente sur l'entrée standard si la plage passait
+    hc.fds[0] = null_fd;
+    CHECK_EQ(file_io(HC_READ, 0, 0xFF00, 0x101), -EFAULT);
+    hc.fds[0] = STDIN_FILENO;
+    close(null_fd);
+    CHECK_EQ(open_file("/dev/null", 3), -EINVAL);
+    CHECK_EQ(open_file("/nonexistent/test_hostcall", 0), -ENOENT);
+    static u8 long_path[300];
+    memset(long_path, 'a', sizeof(long_path)); // Pas de 0 dans les 256 premiers octets
+    mem_load_bytes(&mem, 0x0500, long_path, sizeof(long_path));
+    put_word(0x0310, 0x0500);
+    CHECK_EQ(call(HC_OPEN, 0x0310), -ENAMETOOLONG);
+    CHECK_EQ(load_file("/nonexistent/test_hostcall", 0x1000, 1), -ENOENT);
+    CHECK_EQ(load_file("/dev/null", 0xFFF0, 0x20), -EFAULT);
+    CHECK_EQ(call(HC_TIME, 0xFFF8), -EFAULT);
+    CHECK_EQ(call(HC_CLOSE, 9), -EBADF);
+
+    // Fichiers 3 à 15, puis plus de place
+    for (int i = 3; i < HOSTCALL_MAX_FILES; i++) CHECK_EQ(open_file("/dev/null", 0), i);
+    CHECK_EQ(open_file("/dev/null", 0), -EMFILE);
+    CHECK_EQ(call(HC_CLOSE, 7), 0);
+    CHECK_EQ(open_file("/dev/null", 1), 7);
+    hostcall_close_all(&hc);
+    CHECK_EQ(hc.fds[7], -1);
+    CHECK_EQ(hc.fds[1], 1); // Les fichiers standard restent
+    CHECK_EQ(open_file("/dev/null", 0), 3);
+    hostcall_close_all(&hc);
+
+    // Seule une écriture dans HC_CALL appelle un service
+    u64 calls = hc.calls;
+    mem_write(&mem, 0xF000 + HC_RESULT_LO, HC_EXIT);
+    mem_write(&mem, 0xF008 + HC_ERRNO, HC_EXIT);
+    CHECK_EQ(hc.calls, calls);
+    CHECK(!hc.exited);
+    CHECK_EQ(calls, 29);
+}
+
+static int watch_hits;
+
+static void on_watch(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)ctx;
+    (void)pc;
+    (void)address;
+    (void)value;
+    (void)kind;
+    watch_hits++;
+}
+
+static void test_files(const char *path) {
+    setup();
+    mem_load_bytes(&mem, 0x1000, (const u8 *)"hello world!", 12);
+    CHECK_EQ(open_file(path, 1), 3);
+    CHECK_EQ(file_io(HC_WRITE, 3, 0x1000, 11), 11);
+    CHECK_EQ(hc.bytes_direct, 11);
+    CHECK_EQ(call(HC_CLOSE, 3), 0);
+    CHECK_EQ(call(HC_CLOSE, 3), -EBADF);
+    CHECK_EQ(open_file(path, 2), 3);
+    CHECK_EQ(file_io(HC_WRITE, 3, 0x100B, 1), 1);
+    CHECK_EQ(call(HC_CLOSE, 3), 0);
+
+    FILE *f = fopen(path, "rb");
+    char host[32] = { 0 };
+    CHECK(f != NULL);
+    if (f) {
+        CHECK_EQ(fread(host, 1, sizeof(host), f), 12);
+        fclose(f);
+    }
+    CHECK(strcmp(host, "hello world!") == 0);
+
+    // Relu par morceaux jusqu'à la fin du fichier
+    CHECK_EQ(open_file(path, 0), 3);
+    CHECK_EQ(file_io(HC_READ, 3, 0x2000, 5), 5);
+    CHECK_EQ(file_io(HC_READ, 3, 0x2005, 100), 7);
+    CHECK_EQ(file_io(HC_READ, 3, 0x2100, 100), 0);
+    CHECK_EQ(call(HC_CLOSE, 3), 0);
+    CHECK_EQ(mem_peek(&mem, 0x2000), 'h');
+    CHECK_EQ(mem_peek(&mem, 0x2004), 'o');
+    CHECK_EQ(mem_peek(&mem, 0x200B), '!');
+    CHECK_EQ(mem_peek(&mem, 0x200C), 0);
+    CHECK_EQ(hc.bytes_copied, 0);
+
+    // Chargement tronqué à la taille maximale, le reste non touché
+    mem_write(&mem, 0x5005, 0xEE);
+    CHECK_EQ(load_file(path, 0x5000, 5), 5);
+    CHECK_EQ(mem_peek(&mem, 0x5004), 'o');
+    CHECK_EQ(mem_peek(&mem, 0x5005), 0xEE);
+
+    // Page surveillée : octet par octet, watchpoints déclenchés
+    CHECK(mem_add_watch(&mem, 0x4000, 0x40FF, MEM_WATCH_READ | MEM_WATCH_WRITE, on_watch, NULL) >= 0);
+    watch_hits = 0;
+    CHECK_EQ(load_file(path, 0x40F8, 12), 12); // Déborde sur la page suivante
+    CHECK_EQ(hc.bytes_copied, 12);
+    CHECK_EQ(watch_hits, 8);
+    CHECK_EQ(mem_peek(&mem, 0x40F8), 'h');
+    CHECK_EQ(mem_peek(&mem, 0x4103), '!');
+    CHECK_EQ(open_file("/dev/null", 1), 3);
+    watch_hits = 0;
+    CHECK_EQ(file_io(HC_WRITE, 3, 0x40FC, 8), 8);
+    CHECK_EQ(hc.bytes_copied, 12 + 8);
+    CHECK_EQ(watch_hits, 4);
+    hostcall_close_all(&hc);
+
+    // Empreinte tenue à jour par une lecture directe
+    mem_set_hashing(&mem, 1);
+    CHECK_EQ(load_file(path, 0x6000, 0x100), 12);
+    CHECK_EQ(file_io(HC_READ, 0, 0x6000, 0), 0); // Taille nulle
+    u64 hash = mem.hash;
+    mem_rehash(&mem);
+    CHECK_EQ(hash, mem.hash);
+}
+
+static long custom(HostCall *h, CPU *c, void *ctx) {
+    (void)h;
+    ++*(int *)ctx;
+    return c->Y == 0xEE ? -EIO : (long)c->Y << 8 | 0x34;
+}
+
+static void test_time_exit(void) {
+    setup();
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    u64 now = (u64)ts.tv_sec * 1000000 + (u64)ts.tv_nsec / 1000;
+    cpu.cycles = 0x123456789ULL;
+    u64 before = cpu.cycles;
+    CHECK_EQ(call(HC_TIME, 0x0330), 0);
+    u64 us = 0, cycles = 0;
+    for (int i = 0; i < 8; i++) {
+        us |= (u64)mem_peek(&mem, (u16)(0x0330 + i)) << (8 * i);
+        cycles |= (u64)mem_peek(&mem, (u16)(0x0338 + i)) << (8 * i);
+    }
+    CHECK(us >= now && us < now + 5000000);
+    CHECK(cycles >= before && cycles <= cpu.cycles);
+
+    int count = 0;
+    hostcall_register(&hc, 0x40, custom, &count);
+    CHECK_EQ(call(0x40, 0x1200), 0x1234);
+    CHECK_EQ(hc.result, 0x1234);
+    CHECK_EQ(call(0x40, 0xEE00), -EIO);
+    CHECK_EQ(count, 2);
+    hostcall_register(&hc, 0x40, NULL, NULL);
+    CHECK_EQ(call(0x40, 0x1200), -ENOSYS);
+    CHECK_EQ(count, 2);
+
+    CHECK_EQ(call(HC_EXIT, 42), 0);
+    CHECK(hc.exited);
+    CHECK_EQ(hc.exit_code, 42);
+}
+
+int main(void) {
+    char path[] = "/tmp/test_hostcall_XXXXXX";
+    close(mkstemp(path));
+    test_errors();
+    test_files(path);
+    test_time_exit();
+    unlink(path);
+    return check_done("hostcall");
+}
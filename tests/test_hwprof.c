@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "hwprof.h"
+
+// Profil matériel : chaque instruction est comptée sur son opcode, qu'elle
+// soit échantillonnée ou non, sans changer l'exécution. Sans compteur
+// matériel (machine virtuelle, perf_event_paranoid), les cycles viennent du
+// TSC et le rapport le dit.
+
+static const u8 program[] = {
+    0xA2, 0x10,       // 0200 LDX #$10
+    0xCA,             // 0202 DEX
+    0xD0, 0xFD,       // 0203 BNE $0202
+    0x4C, 0x05, 0x02, // 0205 JMP $0205
+};
+
+#define STEPS 100
+
+static void setup(Memory *mem, CPU *cpu) {
+    mem_init(mem);
+    mem_load_bytes(mem, 0x0200, program, sizeof(program));
+    cpu_reset(cpu, mem);
+    cpu->PC = 0x0200;
+}
+
+static void profile(u32 period, const CPU *reference) {
+    static Memory mem;
+    static HwProfile p;
+    CPU cpu;
+    if (!hwprof_open(&p, period)) {
+        printf("hwprof : aucun compteur sur cet hote, test de la periode %u saute\n", period);
+        return;
+    }
+    // TSC seulement si le compteur de cycles manque
+    CHECK_EQ(p.tsc, p.slot[HWPROF_CYCLES] < 0);
+    setup(&mem, &cpu);
+    for (int i = 0; i < STEPS; i++) hwprof_step(&p, &cpu);
+
+    CHECK_EQ(cpu.PC, reference->PC);
+    CHECK_EQ(cpu.X, reference->X);
+    CHECK_EQ(cpu.P, reference->P);
+    CHECK_EQ(cpu.cycles, reference->cycles);
+
+    // 1 LDX, 16 DEX, 16 BNE (15 pris), le reste en JMP
+    CHECK_EQ(p.ops[0xA2].count, 1);
+    CHECK_EQ(p.ops[0xCA].count, 16);
+    CHECK_EQ(p.ops[0xD0].count, 16);
+    CHECK_EQ(p.ops[0x4C].count, STEPS - 33);
+    u64 samples = 0;
+    for (int op = 0; op < 256; op++) {
+        CHECK(p.ops[op].samples <= p.ops[op].count);
+        samples += p.ops[op].samples;
+    }
+    CHECK_EQ(samples, p.samples);
+    if (period == 1) CHECK_EQ(p.samples, STEPS);
+    else CHECK(p.samples > 0 && p.samples < STEPS);
+
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    CHECK(out != NULL);
+    if (out) {
+        hwprof_report(&p, CPU_NMOS, out);
+        fclose(out);
+        CHECK(strstr(text, "Echantillons") != NULL);
+        CHECK(strstr(text, "CA DEX") != NULL);
+        CHECK((strstr(text, "cycles (TSC") != NULL) == (p.tsc != 0));
+        free(text);
+    }
+    hwprof_close(&p);
+    CHECK_EQ(p.group, -1);
+}
+
+int main(void) {
+    static Memory mem;
+    CPU reference;
+    setup(&mem, &reference);
+    for (int i = 0; i < STEPS; i++) cpu_step(&reference);
+
+    profile(1, &reference);
+    profile(10, &reference);
+    return check_done("hwprof");
+}
@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "irqlat.h"
+
+// Interruptions : retard d'une instruction après CLI, SEI et PLP (pas après
+// RTI), IRQ au niveau avec sources en OU câblé, NMI sur front seulement, et
+// latences mesurées de la montée de la ligne à la première instruction du
+// handler.
+//
+// Handlers : NMI en $0300 (INC $20, RTI), IRQ en $0310 (INC $21, RTI). Le
+// programme principal est une suite de NOP.
+
+static Memory mem;
+
+static const u8 nmi_handler[] = {
+    0xE6, 0x20, // 0300 INC $20
+    0x40,       // 0302 RTI
+};
+
+static const u8 irq_handler[] = {
+    0xE6, 0x21, // 0310 INC $21
+    0x40,       // 0312 RTI
+};
+
+static void setup(CPU *cpu, const u8 *program, size_t size, int irq_enabled) {
+    static u8 nops[0x80];
+    memset(nops, 0xEA, sizeof(nops));
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, nops, sizeof(nops));
+    if (program) mem_load_bytes(&mem, 0x0200, program, size);
+    mem_load_bytes(&mem, 0x0300, nmi_handler, sizeof(nmi_handler));
+    mem_load_bytes(&mem, 0x0310, irq_handler, sizeof(irq_handler));
+    static const u8 vectors[] = { 0x00, 0x03, 0x00, 0x02, 0x10, 0x03 }; // NMI, RESET, IRQ
+    mem_load_bytes(&mem, 0xFFFA, vectors, sizeof(vectors));
+    cpu_reset(cpu, &mem);
+    cpu->PC = 0x0200;
+    if (irq_enabled) cpu->P &= ~FLAG_I; else cpu->P |= FLAG_I;
+}
+
+// Adresse de retour et P empilés par la dernière interruption
+static u16 pushed_pc(const CPU *cpu) {
+    return mem_peek(&mem, 0x0100 | (u8)(cpu->SP + 2)) | mem_peek(&mem, 0x0100 | (u8)(cpu->SP + 3)) << 8;
+}
+
+static u8 pushed_p(const CPU *cpu) {
+    return mem_peek(&mem, 0x0100 | (u8)(cpu->SP + 1));
+}
+
+static void test_cli(void) {
+    CPU cpu;
+    static const u8 program[] = { 0x58 }; // 0200 CLI
+    setup(&cpu, program, sizeof(program), 0);
+    cpu_set_irq(&cpu, 1, 1);
+    cpu_step(&cpu); // CLI
+    cpu_step(&cpu); // NOP : I était encore à 1 à la scrutation de CLI
+    CHECK_EQ(cpu.PC, 0x0202);
+    cpu_step(&cpu); // IRQ
+    CHECK_EQ(cpu.PC, 0x0310);
+    CHECK_EQ(pushed_pc(&cpu), 0x0202);
+}
+
+static void test_sei(void) {
+    CPU cpu;
+    static const u8 program[] = { 0x78 }; // 0200 SEI
+    setup(&cpu, program, sizeof(program), 1);
+    // La ligne monte pendant SEI (après la scrutation du début du pas)
+    cpu_set_irq(&cpu, 1, 1);
+    cpu_step_instruction(&cpu);
+    // La scrutation de SEI a vu I à 0 : l'IRQ est prise, P empilé avec I à 1
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0310);
+    CHECK_EQ(pushed_pc(&cpu), 0x0201);
+    CHECK(pushed_p(&cpu) & FLAG_I);
+}
+
+static void test_plp_rti(void) {
+    CPU cpu;
+    static const u8 program[] = {
+        0xA9, 0x00, // 0200 LDA #$00
+        0x48,       // 0202 PHA
+        0x28,       // 0203 PLP    (I à 0)
+    };
+    setup(&cpu, program, sizeof(program), 0);
+    cpu_set_irq(&cpu, 1, 1);
+    for (int i = 0; i < 4; i++) cpu_step(&cpu); // LDA, PHA, PLP, NOP en $0204
+    CHECK_EQ(cpu.PC, 0x0205);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0310);
+    CHECK_EQ(pushed_pc(&cpu), 0x0205);
+    // RTI remet I à 0 sans retard : la ligne toujours active redéclenche aussitôt
+    cpu_step(&cpu); // INC $21
+    cpu_step(&cpu); // RTI
+    CHECK_EQ(cpu.PC, 0x0205);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0310);
+    CHECK_EQ(mem_peek(&mem, 0x21), 1);
+}
+
+static void test_wired_or(void) {
+    CPU cpu;
+    setup(&cpu, NULL, 0, 1);
+    cpu_set_irq(&cpu, 1, 1);
+    cpu_set_irq(&cpu, 2, 1);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0310);
+    cpu_set_irq(&cpu, 1, 0); // Une source acquittée, l'autre tient la ligne
+    cpu_step(&cpu);
+    cpu_step(&cpu);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0310);
+    cpu_set_irq(&cpu, 2, 0);
+    cpu_step(&cpu);
+    cpu_step(&cpu);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0201); // Ligne au repos : le programme reprend
+    CHECK_EQ(mem_peek(&mem, 0x21), 2);
+    CHECK_EQ(cpu.events & CPU_EVENT_IRQ, 0);
+}
+
+// Pas jusqu'au retour dans le programme principal
+static void run_main(CPU *cpu, int steps) {
+    for (int i = 0; i < steps; i++) cpu_step(cpu);
+}
+
+static void test_nmi_edges(void) {
+    CPU cpu;
+    setup(&cpu, NULL, 0, 0);
+    cpu_set_nmi(&cpu, 1, 1);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0300);
+    run_main(&cpu, 3); // INC, RTI, NOP : la ligne tenue ne redéclenche pas
+    CHECK(cpu.PC >= 0x0200 && cpu.PC < 0x0280);
+    // Deuxième source pendant que la première tient la ligne : pas de front
+    cpu_set_nmi(&cpu, 2, 1);
+    cpu_set_nmi(&cpu, 1, 0);
+    cpu_nmi(&cpu); // Impulsion, ligne déjà active : sans effet
+    run_main(&cpu, 2);
+    CHECK_EQ(mem_peek(&mem, 0x20), 1);
+    // Ligne au repos puis nouvelle montée : front
+    cpu_set_nmi(&cpu, 2, 0);
+    cpu_nmi(&cpu);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0300);
+    run_main(&cpu, 2);
+    CHECK_EQ(mem_peek(&mem, 0x20), 2);
+
+    // NMI avant une IRQ en attente, même avec I à 0
+    setup(&cpu, NULL, 0, 1);
+    cpu_set_irq(&cpu, 1, 1);
+    cpu_set_nmi(&cpu, 1, 1);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0300);
+}
+
+static void test_latency(void) {
+    CPU cpu;
+    static IrqLatency lat;
+    setup(&cpu, NULL, 0, 1);
+    irqlat_init(&lat);
+    cpu.latency = &lat;
+
+    // Montée à la frontière d'instruction : 7 cycles de séquence
+    cpu_set_irq(&cpu, 1 << 0, 1);
+    cpu_step(&cpu);
+    cpu_set_irq(&cpu, 1 << 0, 0);
+    run_main(&cpu, 2);
+    // Montée au milieu du NOP précédent (un cycle plus tôt) : 8
+    cpu_step(&cpu);
+    cpu_set_irq_at(&cpu, 1 << 1, 1, cpu.cycles - 1);
+    cpu_step(&cpu);
+    cpu_set_irq(&cpu, 1 << 1, 0);
+    run_main(&cpu, 2);
+    // Retirée avant d'être servie (I à 1)
+    cpu.P |= FLAG_I;
+    cpu_set_irq(&cpu, 1 << 2, 1);
+    cpu_step(&cpu);
+    cpu_set_irq(&cpu, 1 << 2, 0);
+
+    // NMI : servie en 7, puis une montée perdue pendant que la ligne est tenue
+    cpu_set_nmi(&cpu, 1 << 0, 1);
+    cpu_set_nmi(&cpu, 1 << 1, 1);
+    cpu_step(&cpu);
+    CHECK_EQ(cpu.PC, 0x0300);
+
+    CHECK_EQ(lat.irq[0].count, 1);
+    CHECK_EQ(lat.irq[0].min, 7);
+    CHECK_EQ(lat.irq[0].max, 7);
+    CHECK_EQ(lat.irq[0].hist[7], 1);
+    CHECK_EQ(lat.irq[1].count, 1);
+    CHECK_EQ(lat.irq[1].sum, 8);
+    CHECK_EQ(lat.irq[1].hist[8], 1);
+    CHECK_EQ(lat.irq[2].count, 0);
+    CHECK_EQ(lat.irq[2].dropped, 1);
+    CHECK_EQ(lat.nmi[0].count, 1);
+    CHECK_EQ(lat.nmi[0].min, 7);
+    CHECK_EQ(lat.nmi[1].count, 0);
+    CHECK_EQ(lat.nmi[1].dropped, 1);
+
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    CHECK(out != NULL);
+    if (out) {
+        irqlat_report(&lat, out);
+        fclose(out);
+        CHECK(strstr(text, "IRQ 1") != NULL);
+        CHECK(strstr(text, "NMI 1") != NULL);
+        CHECK(strstr(text, "IRQ 3") == NULL);
+        free(text);
+    }
+}
+
+int main(void) {
+    test_cli();
+    test_sei();
+    test_plp_rti();
+    test_wired_or();
+    test_nmi_edges();
+    test_latency();
+    return check_done("interrupts");
+}
@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "emu6502.h"
+
+// API publique de libemu6502, seulement par emu6502.h (lié à la
+// bibliothèque partagée : seuls les symboles exportés sont visibles).
+// Exécution jusqu'au nombre de cycles demandé, arrêt sur un opcode non
+// implémenté sans quitter le programme, lignes IRQ en OU câblé et front
+// NMI, périphérique mappé, snapshot puis restauration : la suite de
+// l'exécution est identique, lignes d'interruption comprises.
+
+static const uint8_t program[] = {
+    0x58,             // 0200 CLI
+    0xE8,             // 0201 INX
+    0x4C, 0x01, 0x02, // 0202 JMP $0201
+};
+
+static const uint8_t handlers[] = {
+    0xE6, 0x10,       // 0400 INC $10      IRQ
+    0x40,             // 0402 RTI
+    0xE6, 0x11,       // 0403 INC $11      NMI
+    0x40,             // 0405 RTI
+};
+
+static const uint8_t vectors[] = { 0x03, 0x04, 0x00, 0x02, 0x00, 0x04 };
+
+static Emu6502 *create(Emu6502Variant variant) {
+    Emu6502 *emu = emu6502_create(variant);
+    CHECK(emu != NULL);
+    if (emu == NULL) exit(1);
+    CHECK_EQ(emu6502_load(emu, 0x0200, program, sizeof(program)), 0);
+    CHECK_EQ(emu6502_load(emu, 0x0400, handlers, sizeof(handlers)), 0);
+    CHECK_EQ(emu6502_load(emu, 0xFFFA, vectors, sizeof(vectors)), 0);
+    emu6502_reset(emu);
+    return emu;
+}
+
+static Emu6502Regs regs(Emu6502 *emu) {
+    Emu6502Regs r;
+    emu6502_get_regs(emu, &r);
+    return r;
+}
+
+static void test_run(void) {
+    Emu6502 *emu = create(EMU6502_NMOS);
+    CHECK_EQ(regs(emu).pc, 0x0200);
+    CHECK_EQ(emu6502_run(emu, 2), 2); // CLI
+    // INX ; JMP : 5 cycles par tour, 20 tours exactement
+    CHECK_EQ(emu6502_run(emu, 100), 100);
+    CHECK_EQ(emu6502_instructions(emu), 1 + 40);
+    CHECK_EQ(regs(emu).x, 20);
+    CHECK_EQ(regs(emu).cycles, 102);
+    // L'instruction en cours est terminée : INX pour 1 cycle demandé
+    CHECK_EQ(emu6502_run(emu, 1), 2);
+    CHECK(!emu6502_halted(emu));
+    CHECK_EQ(emu6502_load(emu, 0xFFF0, program, 0x11), -1);
+    emu6502_destroy(emu);
+}
+
+// $02 n'existe pas en NMOS : arrêt juste avant, sans quitter ; NOP en 65C02
+static void test_halt(void) {
+    static const uint8_t code[] = { 0xA9, 0x42, 0x02, 0x00 }; // LDA #$42 ; $02
+    for (int variant = EMU6502_NMOS; variant <= EMU6502_65C02; variant++) {
+        Emu6502 *emu = create((Emu6502Variant)variant);
+        emu6502_load(emu, 0x0300, code, sizeof(code));
+        Emu6502Regs r = regs(emu);
+        r.pc = 0x0300;
+        emu6502_set_regs(emu, &r);
+        uint64_t ran = emu6502_run(emu, 1000);
+        if (variant == EMU6502_NMOS) {
+            CHECK_EQ(ran, 2);
+            CHECK(emu6502_halted(emu));
+            CHECK_EQ(regs(emu).pc, 0x0302);
+            CHECK_EQ(emu6502_instructions(emu), 1);
+            // Toujours arrêté au même endroit, puis reparti ailleurs
+            CHECK_EQ(emu6502_run(emu, 1000), 0);
+            CHECK(emu6502_halted(emu));
+            r = regs(emu);
+            r.pc = 0x0200;
+            emu6502_set_regs(emu, &r);
+            CHECK(emu6502_run(emu, 1000) >= 1000);
+            CHECK(!emu6502_halted(emu));
+        } else {
+            CHECK(ran >= 1000);
+            CHECK(!emu6502_halted(emu));
+        }
+        CHECK_EQ(regs(emu).a, 0x42);
+        emu6502_destroy(emu);
+    }
+}
+
+static void test_interrupts(void) {
+    Emu6502 *emu = create(EMU6502_NMOS);
+    uint8_t *ram = emu6502_memory(emu);
+    emu6502_run(emu, 2);
+
+    // Deux lignes IRQ : la requête tient tant que l'une est active
+    emu6502_set_irq(emu, 0, 1);
+    emu6502_set_irq(emu, 3, 1);
+    emu6502_set_irq(emu, 0, 0);
+    emu6502_run(emu, 200);
+    CHECK(ram[0x10] > 5);
+    emu6502_set_irq(emu, 3, 0);
+    emu6502_run(emu, 20); // Fin du handler en cours
+    uint8_t taken = ram[0x10];
+    emu6502_run(emu, 200);
+    CHECK_EQ(ram[0x10], taken);
+    CHECK_EQ(regs(emu).p & 0x04, 0);
+
+    // NMI sur le front de l'ensemble des lignes
+    emu6502_set_nmi(emu, 0, 1);
+    emu6502_run(emu, 50);
+    CHECK_EQ(ram[0x11], 1);
+    emu6502_set_nmi(emu, 1, 1); // Ligne déjà active : rien
+    emu6502_run(emu, 50);
+    CHECK_EQ(ram[0x11], 1);
+    emu6502_set_nmi(emu, 0, 0);
+    emu6502_set_nmi(emu, 1, 0);
+    emu6502_set_nmi(emu, 1, 1);
+    emu6502_run(emu, 50);
+    CHECK_EQ(ram[0x11], 2);
+    emu6502_set_nmi(emu, 1, 0);
+    emu6502_nmi(emu);
+    emu6502_run(emu, 50);
+    CHECK_EQ(ram[0x11], 3);
+    CHECK_EQ(ram[0x10], taken);
+    emu6502_destroy(emu);
+}
+
+static uint8_t io_read(void *ctx, uint16_t address) {
+    ++*(int *)ctx;
+    return (uint8_t)address ^ 0x5A;
+}
+
+static void io_write(void *ctx, uint16_t address, uint8_t value) {
+    *(int *)ctx += address == 0xD001 && value == 0x77 ? 100 : 1000;
+}
+
+static void test_map(void) {
+    Emu6502 *emu = create(EMU6502_NMOS);
+    int accesses = 0;
+    emu6502_map(emu, 0xD0, 0xD0, io_read, io_write, &accesses);
+    CHECK_EQ(emu6502_read(emu, 0xD003), 0x59);
+    emu6502_write(emu, 0xD001, 0x77);
+    CHECK_EQ(accesses, 101);
+    emu6502_unmap(emu, 0xD0, 0xD0);
+    emu6502_write(emu, 0xD001, 0x77);
+    CHECK_EQ(emu6502_read(emu, 0xD001), 0x77);
+    CHECK_EQ(accesses, 101);
+    emu6502_destroy(emu);
+}
+
+// L'instance qui reprend un snapshot refait exactement la même suite
+static void test_snapshot(void) {
+    Emu6502 *emu = create(EMU6502_NMOS);
+    size_t size = emu6502_snapshot_size();
+    uint8_t *snap = malloc(size);
+    static uint8_t ram[65536];
+    CHECK(snap != NULL);
+    if (snap == NULL) return;
+    emu6502_run(emu, 300);
+    emu6502_set_irq(emu, 5, 1);
+    emu6502_run(emu, 30);
+    CHECK_EQ(emu6502_snapshot(emu, snap, size - 1), -1);
+    CHECK_EQ(emu6502_snapshot(emu, snap, size), 0);
+
+    emu6502_run(emu, 1000);
+    Emu6502Regs expected = regs(emu);
+    memcpy(ram, emu6502_memory(emu), sizeof(ram));
+    CHECK(ram[0x10] > 10);
+
+    Emu6502 *other = emu6502_create(EMU6502_NMOS);
+    CHECK_EQ(emu6502_restore(other, snap, size - 1), -1);
+    CHECK_EQ(emu6502_restore(other, snap, size), 0);
+    emu6502_run(other, 1000);
+    Emu6502Regs r = regs(other);
+    CHECK_EQ(r.a, expected.a);
+    CHECK_EQ(r.x, expected.x);
+    CHECK_EQ(r.y, expected.y);
+    CHECK_EQ(r.sp, expected.sp);
+    CHECK_EQ(r.p, expected.p);
+    CHECK_EQ(r.pc, expected.pc);
+    CHECK_EQ(r.cycles, expected.cycles);
+    CHECK(memcmp(emu6502_memory(other), ram, sizeof(ram)) == 0);
+    // La ligne IRQ 5 fait partie du snapshot : une autre ligne relâchée ne
+    // l'arrête pas, elle seule arrête les IRQ
+    emu6502_set_irq(other, 2, 1);
+    emu6502_set_irq(other, 2, 0);
+    emu6502_run(other, 20);
+    uint8_t taken = emu6502_memory(other)[0x10];
+    emu6502_run(other, 200);
+    CHECK(emu6502_memory(other)[0x10] > taken + 5);
+    emu6502_set_irq(other, 5, 0);
+    emu6502_run(other, 20);
+    taken = emu6502_memory(other)[0x10];
+    emu6502_run(other, 200);
+    CHECK_EQ(emu6502_memory(other)[0x10], taken);
+    emu6502_destroy(other);
+
+    // Autre variante, ou snapshot abîmé : refusé, instance intacte
+    other = emu6502_create(EMU6502_65C02);
+    CHECK_EQ(emu6502_restore(other, snap, size), -1);
+    CHECK_EQ(regs(other).cycles, 0);
+    emu6502_destroy(other);
+    snap[0] ^= 0xFF;
+    CHECK_EQ(emu6502_restore(emu, snap, size), -1);
+    CHECK_EQ(regs(emu).cycles, expected.cycles);
+    free(snap);
+    emu6502_destroy(emu);
+}
+
+int main(void) {
+    CHECK_EQ(emu6502_version(), EMU6502_VERSION);
+    CHECK(emu6502_create((Emu6502Variant)7) == NULL);
+    test_run();
+    test_halt();
+    test_interrupts();
+    test_map();
+    test_snapshot();
+    return check_done("lib");
+}
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "lockstep.h"
+
+// Exécution différentielle dans la variante choisie : un programme qui
+// n'existe qu'en 65C02 (STZ, TSB, PHX/PLY, INC A, BRA) tourne sur la
+// référence et sur le moteur à blocs (avec la carte de la même variante)
+// sans divergence ; le mode décimal ignoré du 2A03 atteint bien les deux
+// cœurs ; un registre modifié d'un seul côté est signalé.
+
+static const u8 cmos_program[] = {
+    0xA2, 0x05,       // 0400 LDX #$05
+    0x9C, 0x00, 0x30, // 0402 STZ $3000
+    0x64, 0x10,       // 0405 STZ $10
+    0x1A,             // 0407 INC A
+    0x04, 0x10,       // 0408 TSB $10
+    0xDA,             // 040A PHX
+    0x7A,             // 040B PLY
+    0x99, 0x00, 0x30, // 040C STA $3000,Y
+    0xCA,             // 040F DEX
+    0xF0, 0x02,       // 0410 BEQ $0414
+    0x80, 0xEE,       // 0412 BRA $0402
+    0x80, 0xFE,       // 0414 BRA $0414
+};
+
+static const u8 decimal_program[] = {
+    0xF8,             // 0400 SED
+    0x18,             // 0401 CLC
+    0xA9, 0x09,       // 0402 LDA #$09
+    0x69, 0x01,       // 0404 ADC #$01
+    0x4C, 0x06, 0x04, // 0406 JMP $0406
+};
+
+// Lock-step jusqu'à 'trap' ; retourne 0 à la première divergence
+static int run_to(Lockstep *ls, u16 trap) {
+    for (int i = 0; i < 1000 && ls->ref.PC != trap; i++) {
+        if (!lockstep_step(ls)) return 0;
+    }
+    return ls->ref.PC == trap;
+}
+
+static void test_cmos(const char *engine_name) {
+    static Memory image;
+    static CodeMap cm;
+    mem_init(&image);
+    mem_load_bytes(&image, 0x0400, cmos_program, sizeof(cmos_program));
+    codemap_init(&cm);
+    u16 entry = 0x0400;
+    CHECK(codemap_analyze(&cm, &image, CPU_65C02, &entry, 1) > 0);
+
+    Lockstep ls;
+    const Engine *engine = lockstep_find_engine(engine_name);
+    CHECK(engine != NULL);
+    if (engine == NULL || !lockstep_init(&ls, &image, 0x0400, CPU_65C02, engine, &cm)) {
+        CHECK(0);
+        codemap_free(&cm);
+        return;
+    }
+    CHECK(run_to(&ls, 0x0414));
+    CHECK_EQ(ls.instructions, 1 + 5 * 9 + 4);
+    CHECK_EQ(ls.test.PC, 0x0414);
+    CHECK_EQ(ls.ref.A, 5);
+    CHECK_EQ(ls.ref.X, 0);
+    CHECK_EQ(ls.ref.Y, 1);
+    CHECK_EQ(ls.ref.SP, ls.test.SP);
+    CHECK_EQ(ls.ref_log.count, 5 * 5);
+    CHECK_EQ(ls.test_log.hash, ls.ref_log.hash);
+    for (int i = 0; i < 2; i++) {
+        const Memory *m = i ? ls.test_mem : ls.ref_mem;
+        CHECK_EQ(mem_peek(m, 0x0010), 5);
+        CHECK_EQ(mem_peek(m, 0x3000), 0);
+        CHECK_EQ(mem_peek(m, 0x3001), 5);
+        CHECK_EQ(mem_peek(m, 0x3005), 1);
+    }
+    lockstep_free(&ls);
+    codemap_free(&cm);
+}
+
+static void test_variant_reaches_both(CpuVariant variant, u8 expected) {
+    static Memory image;
+    mem_init(&image);
+    mem_load_bytes(&image, 0x0400, decimal_program, sizeof(decimal_program));
+    Lockstep ls;
+    if (!lockstep_init(&ls, &image, 0x0400, variant, lockstep_find_engine("block"), NULL)) {
+        CHECK(0);
+        return;
+    }
+    CHECK(run_to(&ls, 0x0406));
+    CHECK_EQ(ls.ref.A, expected);
+    CHECK_EQ(ls.test.A, expected);
+    lockstep_free(&ls);
+}
+
+static void test_divergence(void) {
+    static Memory image;
+    mem_init(&image);
+    mem_load_bytes(&image, 0x0400, cmos_program, sizeof(cmos_program));
+    Lockstep ls;
+    if (!lockstep_init(&ls, &image, 0x0400, CPU_65C02, lockstep_find_engine("reference"), NULL)) {
+        CHECK(0);
+        return;
+    }
+    CHECK(lockstep_step(&ls));
+    ls.test.A = 0x80;
+    CHECK(!lockstep_step(&ls));
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    lockstep_report(&ls, out);
+    fclose(out);
+    CHECK(strstr(text, "Divergence apres 2 instructions (moteur : reference)") != NULL);
+    free(text);
+    lockstep_free(&ls);
+}
+
+int main(void) {
+    test_cmos("reference");
+    test_cmos("block");
+    test_variant_reaches_both(CPU_NMOS, 0x10);
+    test_variant_reaches_both(CPU_2A03, 0x0A);
+    test_divergence();
+    return check_done("lockstep");
+}
@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "cpu.h"
+#include "mapper.h"
+
+// Mappers : banques visibles après chaque écriture de registre (mem_write ou
+// STA du CPU), comptage des changements effectifs, miroirs de la RAM de la
+// NES et port $01 du C64. Chaque banque de PRG ROM est remplie avec son numéro.
+
+static char ines_path[] = "/tmp/test_mapper_XXXXXX";
+
+static void write_file(const char *path, const u8 *data, size_t size) {
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL);
+    if (f == NULL) return;
+    CHECK(fwrite(data, 1, size, f) == size);
+    fclose(f);
+}
+
+static void write_ines(int kind, int banks) {
+    size_t size = INES_HEADER_SIZE + (size_t)banks * INES_PRG_BANK;
+    u8 *file = calloc(1, size);
+    memcpy(file, "NES\x1A", 4);
+    file[4] = (u8)banks;
+    file[6] = (u8)((kind & 0x0F) << 4);
+    file[7] = (u8)(kind & 0xF0);
+    for (int b = 0; b < banks; b++) memset(file + INES_HEADER_SIZE + b * INES_PRG_BANK, b, INES_PRG_BANK);
+    write_file(ines_path, file, size);
+    free(file);
+}
+
+// Numéros des banques visibles en $8000 et $C000
+#define CHECK_BANKS(mem, lo, hi) do {                                           \
+    CHECK_EQ(mem_peek(mem, 0x8000), lo);                                        \
+    CHECK_EQ(mem_peek(mem, 0xBFFF), lo);                                        \
+    CHECK_EQ(mem_peek(mem, 0xC000), hi);                                        \
+    CHECK_EQ(mem_peek(mem, 0xFFFF), hi);                                        \
+} while (0)
+
+static void test_uxrom(Memory *mem) {
+    Mapper m;
+    write_ines(MAPPER_UXROM, 4);
+    mem_init(mem);
+    CHECK(mapper_load_ines(&m, mem, ines_path));
+    CHECK_EQ(m.kind, MAPPER_UXROM);
+    CHECK_BANKS(mem, 0, 3);
+    CHECK_EQ(m.switches, 0);
+
+    mem_write(mem, 0x8000, 2);
+    CHECK_BANKS(mem, 2, 3);
+    CHECK_EQ(m.switches, 1);
+    mem_write(mem, 0xFFFF, 2); // Même banque : rien ne change
+    CHECK_EQ(m.switches, 1);
+    CHECK_EQ(m.register_writes, 2);
+    mem_write(mem, 0x8000, 5); // Modulo le nombre de banques
+    CHECK_BANKS(mem, 1, 3);
+
+    // Par le CPU : STA déclenche le registre, LDA lit la nouvelle banque
+    static const u8 program[] = {
+        0xA9, 0x02,       // 0200 LDA #$02
+        0x8D, 0x00, 0x80, // 0202 STA $8000
+        0xAD, 0x00, 0x80, // 0205 LDA $8000
+    };
+    CPU cpu;
+    mem_load_bytes(mem, 0x0200, program, sizeof(program));
+    cpu_reset(&cpu, mem);
+    cpu.PC = 0x0200;
+    for (int i = 0; i < 3; i++) cpu_step(&cpu);
+    CHECK_EQ(cpu.A, 2);
+
+    // RAM de 2 Ko en miroir jusqu'à $1FFF, PRG RAM en $6000
+    mem_write(mem, 0x0005, 0x77);
+    CHECK_EQ(mem_peek(mem, 0x0805), 0x77);
+    CHECK_EQ(mem_peek(mem, 0x1805), 0x77);
+    mem_write(mem, 0x1FFF, 0x66);
+    CHECK_EQ(mem_peek(mem, 0x07FF), 0x66);
+    mem_write(mem, 0x6000, 0x55);
+    CHECK_EQ(mem_peek(mem, 0x6000), 0x55);
+    CHECK_EQ(m.ram[0], 0x55);
+    // La ROM n'est pas modifiée par les écritures de registre
+    CHECK_EQ(m.rom[2 * INES_PRG_BANK], 2);
+    mapper_free(&m);
+}
+
+// MMC1 : cinq écritures d'un bit (poids faible d'abord), l'adresse de la
+// cinquième choisit le registre
+static void mmc1_register(Memory *mem, u16 address, u8 value) {
+    for (int i = 0; i < 5; i++) mem_write(mem, address, (value >> i) & 1);
+}
+
+static void test_mmc1(Memory *mem) {
+    Mapper m;
+    write_ines(MAPPER_MMC1, 8);
+    mem_init(mem);
+    CHECK(mapper_load_ines(&m, mem, ines_path));
+    CHECK_BANKS(mem, 0, 7);
+
+    // Mode 3 au reset : banque commutable en $8000, dernière fixe en $C000
+    mem_write(mem, 0xE000, 1);
+    mem_write(mem, 0xE000, 0);
+    CHECK_BANKS(mem, 0, 7); // Registre incomplet : rien ne change
+    mem_write(mem, 0xE000, 0);
+    mem_write(mem, 0xE000, 0);
+    mem_write(mem, 0xE000, 0);
+    CHECK_BANKS(mem, 1, 7);
+    mmc1_register(mem, 0xE000, 5);
+    CHECK_BANKS(mem, 5, 7);
+
+    // Mode 2 : première banque fixe en $8000, banque commutable en $C000
+    mmc1_register(mem, 0x8000, 0x08);
+    CHECK_BANKS(mem, 0, 5);
+    // Mode 0 : 32 Ko, bit 0 ignoré
+    mmc1_register(mem, 0x8000, 0x00);
+    CHECK_BANKS(mem, 4, 5);
+
+    // Bit 7 : remise à zéro du registre à décalage et retour au mode 3
+    mem_write(mem, 0xE000, 1);
+    mem_write(mem, 0xE000, 0x80);
+    CHECK_EQ(m.shift_count, 0);
+    CHECK_BANKS(mem, 5, 7);
+    mmc1_register(mem, 0xE000, 2);
+    CHECK_BANKS(mem, 2, 7);
+    mapper_free(&m);
+}
+
+static void test_axrom(Memory *mem) {
+    Mapper m;
+    write_ines(MAPPER_AXROM, 8);
+    mem_init(mem);
+    CHECK(mapper_load_ines(&m, mem, ines_path));
+    CHECK_BANKS(mem, 0, 1);
+    mem_write(mem, 0x8000, 0x12); // Banque de 32 Ko n° 2, bit 4 (miroir) ignoré
+    CHECK_BANKS(mem, 4, 5);
+    CHECK_EQ(m.switches, 2);
+    mapper_free(&m);
+    // Les pages reviennent à la RAM interne
+    CHECK_EQ(mem_peek(mem, 0x8000), mem->data[0x8000]);
+}
+
+static void test_c64(Memory *mem) {
+    char basic[] = "/tmp/test_c64_basic_XXXXXX";
+    char kernal[] = "/tmp/test_c64_kernal_XXXXXX";
+    char chargen[] = "/tmp/test_c64_chargen_XXXXXX";
+    static u8 rom[0x2000];
+    close(mkstemp(basic));
+    close(mkstemp(kernal));
+    close(mkstemp(chargen));
+    memset(rom, 0xBA, sizeof(rom));
+    write_file(basic, rom, 0x2000);
+    memset(rom, 0xEE, sizeof(rom));
+    write_file(kernal, rom, 0x2000);
+    memset(rom, 0xC4, sizeof(rom));
+    write_file(chargen, rom, 0x1000);
+
+    Mapper m;
+    mem_init(mem);
+    // Taille invalide : refusée
+    CHECK(!mapper_load_c64(&m, mem, basic, kernal, basic));
+    mem_init(mem);
+    CHECK(mapper_load_c64(&m, mem, basic, kernal, chargen));
+    // Reset ($01 = $37) : BASIC, KERNAL et E/S (RAM ici)
+    CHECK_EQ(mem_peek(mem, 0xA000), 0xBA);
+    CHECK_EQ(mem_peek(mem, 0xE000), 0xEE);
+    CHECK_EQ(mem_peek(mem, 0xD000), 0x00);
+
+    // Écriture sous la ROM : va dans la RAM
+    mem_write(mem, 0xA000, 0x11);
+    mem_write(mem, 0xE000, 0x22);
+    CHECK_EQ(mem_peek(mem, 0xA000), 0xBA);
+
+    mem_write(mem, 0x01, 0x36); // LORAM = 0 : RAM en $A000
+    CHECK_EQ(mem_peek(mem, 0xA000), 0x11);
+    CHECK_EQ(mem_peek(mem, 0xE000), 0xEE);
+    mem_write(mem, 0x01, 0x33); // CHAREN = 0 : CHARGEN en $D000
+    CHECK_EQ(mem_peek(mem, 0xD000), 0xC4);
+    CHECK_EQ(mem_peek(mem, 0xA000), 0xBA);
+    mem_write(mem, 0x01, 0x30); // Tout en RAM
+    CHECK_EQ(mem_peek(mem, 0xA000), 0x11);
+    CHECK_EQ(mem_peek(mem, 0xE000), 0x22);
+    CHECK_EQ(mem_peek(mem, 0xD000), 0x00);
+    // Bits en entrée ($00 = 0) : tirés à 1, comme $01 = $37
+    mem_write(mem, 0x00, 0x00);
+    CHECK_EQ(mem_peek(mem, 0xA000), 0xBA);
+    CHECK_EQ(mem_peek(mem, 0xE000), 0xEE);
+    CHECK_EQ(mem_peek(mem, 0xD000), 0x00);
+    // Page 0 hors $00/$01 : pas un registre
+    u64 writes = m.register_writes;
+    mem_write(mem, 0x02, 0x30);
+    CHECK_EQ(m.register_writes, writes);
+    mapper_free(&m);
+    unlink(basic);
+    unlink(kernal);
+    unlink(chargen);
+}
+
+int main(void) {
+    static Memory mem;
+    close(mkstemp(ines_path));
+    test_uxrom(&mem);
+    test_mmc1(&mem);
+    test_axrom(&mem);
+    test_c64(&mem);
+    unlink(ines_path);
+    return check_done("mapper");
+}
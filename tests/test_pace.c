@@ -0,0 +1,143 @@
+#include <time.h>
+#include "check.h"
+#include "pace.h"
+
+// Cadencement à 1 MHz par tranches de 1 ms (1000 cycles), en temps réel.
+// Chaque tranche déborde de quelques cycles (l'instruction qui franchit la
+// frontière) et coûte 300 us de travail : les échéances restent absolues,
+// sur la grille de l'origine, sans dérive cumulée. Un arrêt de l'hôte plus
+// court que max_lag_ns est rattrapé par des tranches sans sommeil, autant
+// qu'il en faut et pas plus ; au-delà, le retard est abandonné en une seule
+// tranche (resynchronisation).
+// Le bruit de l'ordonnanceur ne peut que retarder : chaque scénario a trois
+// essais, un seul essai propre suffit (une dérive échoue à tous).
+
+#define MS 1000000ull
+#define ATTEMPTS 3
+
+// Condition temporelle d'un essai : la première qui échoue est gardée pour
+// le message final
+static const char *failed;
+#define EXPECT(cond) do {                                                       \
+    if (!(cond)) {                                                              \
+        if (ok) failed = #cond;                                                 \
+        ok = 0;                                                                 \
+    }                                                                           \
+} while (0)
+
+static u64 host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void stall(u64 ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ull), (long)(ns % 1000000000ull) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) != 0) {
+    }
+}
+
+static void busy(u64 ns) {
+    u64 end = host_ns() + ns;
+    while (host_ns() < end) {
+    }
+}
+
+// Une tranche : travail, puis fin de tranche 3 cycles après la frontière
+static u64 slice(Pacer *p, u64 work_ns) {
+    busy(work_ns);
+    u64 cycles = p->slice_end + 3;
+    pace_wait(p, cycles);
+    CHECK_EQ((p->slice_end - p->origin_cycles) % p->slice_cycles, 0);
+    // Après une resynchronisation la grille repart de 'cycles'
+    CHECK_EQ(p->slice_end - cycles, p->origin_cycles == cycles ? p->slice_cycles : p->slice_cycles - 3);
+    return cycles;
+}
+
+// Avance (négative : retard) du temps hôte sur l'échéance de 'cycles'
+static s64 offset(const Pacer *p, u64 cycles) {
+    return (s64)(host_ns() - p->origin_ns) - (s64)((cycles - p->origin_cycles) * 1000);
+}
+
+static int test_no_drift(void) {
+    int ok = 1;
+    Pacer p;
+    pace_init(&p, 1e6, 1000, 5);
+    CHECK_EQ(p.slice_cycles, 1000);
+    CHECK_EQ(p.slice_end, 1005);
+    // 60 x 300 us de travail : 18 ms de dérive si le sommeil était relatif.
+    // Plus petit écart des 10 dernières tranches : un réveil tardif isolé ne
+    // compte pas, une dérive si.
+    s64 late = INT64_MAX;
+    for (int i = 0; i < 60; i++) {
+        u64 cycles = slice(&p, 300000);
+        s64 o = offset(&p, cycles);
+        CHECK(o >= 0);
+        if (i >= 50 && o < late) late = o;
+    }
+    EXPECT(late < (s64)(3 * MS));
+    CHECK_EQ(p.slices, 60);
+    EXPECT(p.sleeps >= 30);
+    EXPECT(p.resyncs == 0);
+    CHECK(p.busy_ns >= 60 * 300000);
+    return ok;
+}
+
+static int test_catch_up(void) {
+    int ok = 1;
+    Pacer p;
+    pace_init(&p, 1e6, 1000, 0);
+    p.max_lag_ns = 20 * MS;
+    u64 cycles = 0;
+    for (int i = 0; i < 5; i++) cycles = slice(&p, 0);
+    u64 origin = p.origin_ns;
+
+    // 10 ms d'arrêt : une dizaine de tranches sans sommeil, puis le rythme reprend
+    stall(10 * MS);
+    u64 overruns = p.overruns, sleeps = p.sleeps;
+    int burst = 0;
+    while (p.sleeps == sleeps && burst < 100) {
+        cycles = slice(&p, 0);
+        burst++;
+    }
+    CHECK_EQ(p.overruns - overruns, (u64)burst - 1);
+    EXPECT(burst >= 9 && burst <= 13);
+    EXPECT(p.lag_max_ns >= 8 * MS && p.lag_max_ns < 20 * MS);
+    EXPECT(p.resyncs == 0);
+    EXPECT(p.origin_ns == origin);
+    // Tout le retard est rattrapé : toujours calé sur l'origine
+    s64 late = offset(&p, cycles);
+    CHECK(late >= 0);
+    EXPECT(late < (s64)(3 * MS));
+    if (p.resyncs) return ok;
+
+    // 50 ms d'arrêt, plus que max_lag_ns : une seule tranche en retard,
+    // nouvelle origine, puis sommeil dès la tranche suivante
+    stall(50 * MS);
+    overruns = p.overruns;
+    sleeps = p.sleeps;
+    u64 before = host_ns();
+    cycles = slice(&p, 0);
+    CHECK_EQ(p.overruns - overruns, 1);
+    CHECK_EQ(p.resyncs, 1);
+    CHECK(p.origin_ns >= before);
+    CHECK_EQ(p.origin_cycles, cycles);
+    cycles = slice(&p, 0);
+    EXPECT(p.sleeps - sleeps == 1);
+    EXPECT(p.overruns - overruns == 1);
+    late = offset(&p, cycles);
+    CHECK(late >= 0);
+    EXPECT(late < (s64)(3 * MS));
+    return ok;
+}
+
+int main(void) {
+    int (*const scenarios[])(void) = { test_no_drift, test_catch_up };
+    for (int s = 0; s < 2; s++) {
+        int ok = 0;
+        for (int attempt = 0; attempt < ATTEMPTS && !ok; attempt++) ok = scenarios[s]();
+        if (!ok) printf("scenario %d, %d essais : %s\n", s, ATTEMPTS, failed);
+        CHECK(ok);
+    }
+    return check_done("pace");
+}
@@ -0,0 +1,90 @@
+#include <string.h>
+#include "check.h"
+#include "stats.h"
+
+// Rendu Prometheus : deux instances enregistrées, chaque métrique a une
+// ligne HELP, une ligne TYPE et une ligne par instance avec la valeur
+// publiée (pas les compteurs locaux non publiés). Les noms d'instance sont
+// échappés dans l'étiquette (\, " et fin de ligne) : aucune ligne ne casse
+// le format. Une instance retirée disparaît du rendu.
+
+static char text[16384];
+
+static int count_lines(const char *prefix) {
+    int count = 0;
+    size_t n = strlen(prefix);
+    for (const char *line = text; *line; ) {
+        if (strncmp(line, prefix, n) == 0) count++;
+        const char *end = strchr(line, '\n');
+        if (end == NULL) break;
+        line = end + 1;
+    }
+    return count;
+}
+
+static int has_line(const char *line) {
+    char full[256];
+    snprintf(full, sizeof(full), "\n%s\n", line);
+    return strstr(text, full) != NULL;
+}
+
+int main(void) {
+    static CPU cpu;
+    StatsInstance *plain = stats_register("cpu0");
+    StatsInstance *odd = stats_register("a\"b\\c\nd");
+    CHECK(plain != NULL && odd != NULL);
+    if (plain == NULL || odd == NULL) return check_done("stats");
+    CHECK(stats_current == &odd->local);
+    CHECK(strcmp(odd->name, "a\\\"b\\\\c\\nd") == 0);
+
+    plain->local.instructions = 123;
+    plain->local.irqs = 4;
+    stats_publish(plain, NULL);
+    plain->local.instructions = 999; // Non publié
+    stats_current->instructions = 456;
+    stats_current->mmio_writes = 7;
+    cpu.cycles = 1000;
+    stats_publish(odd, &cpu);
+
+    int len = stats_render(text, sizeof(text));
+    CHECK(len > 0 && len < (int)sizeof(text));
+    CHECK(has_line("emu6502_instructions_total{instance=\"cpu0\"} 123"));
+    CHECK(has_line("emu6502_instructions_total{instance=\"a\\\"b\\\\c\\nd\"} 456"));
+    CHECK(has_line("emu6502_irqs_total{instance=\"cpu0\"} 4"));
+    CHECK(has_line("emu6502_mmio_writes_total{instance=\"a\\\"b\\\\c\\nd\"} 7"));
+    CHECK(has_line("emu6502_cycles_total{instance=\"a\\\"b\\\\c\\nd\"} 1000"));
+    CHECK(has_line("emu6502_cycles_total{instance=\"cpu0\"} 0"));
+    CHECK(has_line("# TYPE emu6502_cycles_total counter"));
+    CHECK(has_line("# TYPE emu6502_effective_mhz gauge"));
+
+    // 10 métriques : HELP, TYPE et une ligne par instance, rien d'autre
+    CHECK_EQ(count_lines("# HELP "), 10);
+    CHECK_EQ(count_lines("# TYPE "), 10);
+    CHECK_EQ(count_lines("emu6502_"), 20);
+    CHECK_EQ(count_lines("emu6502_average_mhz{instance=\"a\\\"b\\\\c\\nd\"} "), 1);
+    int lines = 0;
+    for (int i = 0; i < len; i++) lines += text[i] == '\n';
+    CHECK_EQ(lines, 40);
+    CHECK_EQ(text[len - 1], '\n');
+
+    stats_unregister(odd);
+    CHECK(stats_current != &odd->local);
+    stats_render(text, sizeof(text));
+    CHECK_EQ(count_lines("emu6502_"), 10);
+    CHECK(strstr(text, "a\\\"b") == NULL);
+    CHECK(has_line("emu6502_instructions_total{instance=\"cpu0\"} 123"));
+    stats_unregister(plain);
+
+    // 47 caractères à échapper tiennent en entier
+    char quotes[48];
+    memset(quotes, '"', 47);
+    quotes[47] = 0;
+    StatsInstance *full = stats_register(quotes);
+    CHECK(full != NULL);
+    if (full) {
+        CHECK_EQ(strlen(full->name), 94);
+        CHECK(strncmp(full->name + 90, "\\\"\\\"", 4) == 0);
+        stats_unregister(full);
+    }
+    return check_done("stats");
+}
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "check.h"
+#include "trace.h"
+
+// Trace binaire : ce qui est relu (à la suite, après un saut à une entrée ou
+// à un cycle, avec ou sans index) est exactement ce qui a été écrit, sur
+// plusieurs paquets. La première divergence entre deux traces est trouvée à
+// la bonne entrée, et un paquet abîmé est signalé.
+
+#define STEPS 50000 // 3 paquets pleins et un partiel
+
+static const u8 program[] = {
+    0xA2, 0x00,       // 0200 LDX #$00
+    0x8A,             // 0202 TXA
+    0x85, 0x10,       // 0203 STA $10      (page zéro)
+    0x9D, 0x00, 0x30, // 0205 STA $3000,X  (adresse complète)
+    0x20, 0x00, 0x03, // 0208 JSR $0300    (deux écritures sur la pile)
+    0xE8,             // 020B INX
+    0xD0, 0xF4,       // 020C BNE $0202
+    0xEE, 0x00, 0x31, // 020E INC $3100
+    0x4C, 0x00, 0x02, // 0211 JMP $0200
+};
+
+static const u8 routine[] = {
+    0x48,             // 0300 PHA
+    0x68,             // 0301 PLA
+    0x60,             // 0302 RTS
+};
+
+static TraceEntry expected[STEPS];
+
+typedef struct {
+    TraceWriter *w;
+    TraceEntry *cur;
+    int alter;       // Prochaine écriture modifiée dans la trace (seconde trace)
+} Recorder;
+
+static void on_write(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    (void)pc;
+    (void)kind;
+    Recorder *rec = (Recorder *)ctx;
+    TraceEntry *e = rec->cur;
+    if (e->write_count < TRACE_MAX_WRITES) {
+        e->write_address[e->write_count] = address;
+        e->write_value[e->write_count] = value;
+    }
+    e->write_count++;
+    trace_write(rec->w, address, rec->alter ? (u8)(value ^ 1) : value);
+    rec->alter = 0;
+}
+
+// Trace de STEPS instructions ; la première écriture à partir de l'entrée
+// 'altered' est changée dans la trace
+static void record(const char *path, long altered) {
+    static Memory mem;
+    static TraceWriter w;
+    CPU cpu;
+    Recorder rec = { &w, NULL, 0 };
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    mem_load_bytes(&mem, 0x0300, routine, sizeof(routine));
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    CHECK(trace_create(&w, path));
+    CHECK(mem_add_watch(&mem, 0x0000, 0xFFFF, MEM_WATCH_WRITE, on_write, &rec) >= 0);
+    for (long i = 0; i < STEPS; i++) {
+        TraceEntry *e = &expected[i];
+        memset(e, 0, sizeof(*e));
+        e->index = (u64)i;
+        e->cycles = cpu.cycles;
+        e->PC = cpu.PC;
+        e->A = cpu.A;
+        e->X = cpu.X;
+        e->Y = cpu.Y;
+        e->SP = cpu.SP;
+        e->P = cpu.P;
+        rec.cur = e;
+        if (i == altered) rec.alter = 1;
+        trace_step(&w, &cpu);
+        cpu_step(&cpu);
+    }
+    CHECK_EQ(w.total_steps, STEPS);
+    CHECK(trace_finish(&w));
+}
+
+static int same(const TraceEntry *a, const TraceEntry *b) {
+    return a->index == b->index && trace_equal(a, b);
+}
+
+static void check_reader(const char *path, int indexed) {
+    TraceReader r;
+    TraceEntry e;
+    CHECK(trace_open(&r, path));
+    CHECK_EQ(r.indexed, indexed);
+    CHECK_EQ(r.steps, STEPS);
+    CHECK_EQ(r.chunk_count, (STEPS + TRACE_CHUNK_STEPS - 1) / TRACE_CHUNK_STEPS);
+
+    // À la suite
+    long mismatches = 0, count = 0;
+    int writes = 0;
+    while (trace_next(&r, &e) == 1) {
+        if (count >= STEPS || !same(&e, &expected[count])) mismatches++;
+        writes += e.write_count;
+        count++;
+    }
+    CHECK_EQ(count, STEPS);
+    CHECK_EQ(mismatches, 0);
+    CHECK(writes > STEPS / 2);
+
+    // Sauts : début, limites de paquets, fin
+    static const u64 targets[] = { 0, 1, TRACE_CHUNK_STEPS - 1, TRACE_CHUNK_STEPS, 2 * TRACE_CHUNK_STEPS + 7,
+                                   STEPS - 1, 12345 };
+    for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+        CHECK(trace_seek(&r, targets[i]));
+        CHECK_EQ(trace_next(&r, &e), 1);
+        CHECK(same(&e, &expected[targets[i]]));
+    }
+    CHECK(!trace_seek(&r, STEPS));
+
+    // Par cycle : première entrée de cycle >= cible
+    u64 cycle = expected[TRACE_CHUNK_STEPS + 100].cycles + 1;
+    CHECK(trace_seek_cycle(&r, cycle));
+    CHECK_EQ(trace_next(&r, &e), 1);
+    CHECK(same(&e, &expected[TRACE_CHUNK_STEPS + 101]));
+    CHECK(trace_seek_cycle(&r, expected[2 * TRACE_CHUNK_STEPS].cycles));
+    CHECK_EQ(trace_next(&r, &e), 1);
+    CHECK_EQ(e.index, 2 * TRACE_CHUNK_STEPS);
+    trace_close(&r);
+}
+
+// Émulateur interrompu : pas d'index, position nulle dans l'en-tête
+static void drop_index(const char *path) {
+    FILE *f = fopen(path, "r+b");
+    CHECK(f != NULL);
+    if (f == NULL) return;
+    u8 h[20];
+    CHECK(fread(h, 1, sizeof(h), f) == sizeof(h));
+    u64 index = 0;
+    for (int i = 0; i < 8; i++) index |= (u64)h[12 + i] << (8 * i);
+    CHECK(index > 0);
+    memset(h + 12, 0, 8);
+    fseek(f, 0, SEEK_SET);
+    CHECK(fwrite(h, 1, sizeof(h), f) == sizeof(h));
+    fclose(f);
+    CHECK(truncate(path, (off_t)index) == 0);
+}
+
+static void test_diff(const char *a, const char *b, u64 altered) {
+    TraceReader ra, rb;
+    TraceEntry ea, eb;
+    while (expected[altered].write_count == 0) altered++;
+    CHECK(trace_open(&ra, a));
+    CHECK(trace_open(&rb, b));
+    u64 first = STEPS;
+    while (trace_next(&ra, &ea) == 1 && trace_next(&rb, &eb) == 1) {
+        if (!trace_equal(&ea, &eb)) {
+            first = ea.index;
+            break;
+        }
+    }
+    CHECK_EQ(first, altered);
+    trace_close(&ra);
+    trace_close(&rb);
+}
+
+// Signature du deuxième paquet abîmée : avec l'index, la lecture s'arrête en
+// erreur ; sans index, la trace reconstruite s'arrête avant ce paquet
+static void test_corrupt(const char *path, int indexed) {
+    TraceReader r;
+    TraceEntry e;
+    CHECK(trace_open(&r, path));
+    u64 offset = r.chunks[1].offset;
+    trace_close(&r);
+    FILE *f = fopen(path, "r+b");
+    CHECK(f != NULL);
+    if (f == NULL) return;
+    fseek(f, (long)offset, SEEK_SET);
+    fputc('X', f);
+    fclose(f);
+
+    CHECK(trace_open(&r, path));
+    CHECK_EQ(r.indexed, indexed);
+    CHECK_EQ(r.steps, indexed ? STEPS : TRACE_CHUNK_STEPS);
+    CHECK(trace_seek(&r, 10));
+    CHECK(!trace_seek(&r, TRACE_CHUNK_STEPS + 10));
+    CHECK(trace_seek(&r, TRACE_CHUNK_STEPS - 1));
+    CHECK_EQ(trace_next(&r, &e), 1);
+    CHECK_EQ(trace_next(&r, &e), indexed ? -1 : 0);
+    // Les paquets suivants restent lisibles par l'index
+    if (indexed) {
+        CHECK(trace_seek(&r, 2 * TRACE_CHUNK_STEPS));
+        CHECK_EQ(trace_next(&r, &e), 1);
+        CHECK_EQ(e.index, 2 * TRACE_CHUNK_STEPS);
+    }
+    trace_close(&r);
+}
+
+int main(void) {
+    char a[] = "/tmp/test_trace_a_XXXXXX";
+    char b[] = "/tmp/test_trace_b_XXXXXX";
+    close(mkstemp(a));
+    close(mkstemp(b));
+
+    const u64 altered = 2 * TRACE_CHUNK_STEPS + 321;
+    record(b, (long)altered);
+    record(a, -1);
+    check_reader(a, 1);
+    test_diff(a, b, altered);
+    drop_index(a);
+    check_reader(a, 0);
+    test_corrupt(a, 0);
+    test_corrupt(b, 1);
+
+    unlink(a);
+    unlink(b);
+    return check_done("trace");
+}
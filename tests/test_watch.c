@@ -0,0 +1,103 @@
+#include <string.h>
+#include "check.h"
+#include "cpu.h"
+
+// Watchpoints : une lecture n'est signalée que pour une vraie lecture de la
+// donnée (pas pour STA/STX/STY, JMP ou JSR), avec le PC de l'instruction.
+
+typedef struct {
+    int count;
+    u16 pc[16], address[16];
+    u8 value[16], kind[16];
+} Hits;
+
+static void record(void *ctx, u16 pc, u16 address, u8 value, u8 kind) {
+    Hits *h = (Hits *)ctx;
+    if (h->count < 16) {
+        h->pc[h->count] = pc;
+        h->address[h->count] = address;
+        h->value[h->count] = value;
+        h->kind[h->count] = kind;
+    }
+    h->count++;
+}
+
+static const u8 program[] = {
+    0xA9, 0x42,       // 0200 LDA #$42
+    0x8D, 0x00, 0x30, // 0202 STA $3000
+    0x8E, 0x01, 0x30, // 0205 STX $3001
+    0x8C, 0x02, 0x30, // 0208 STY $3002
+    0x85, 0x80,       // 020B STA $80
+    0xAD, 0x00, 0x30, // 020D LDA $3000
+    0xEE, 0x01, 0x30, // 0210 INC $3001
+    0x20, 0x00, 0x31, // 0213 JSR $3100
+    0x4C, 0x20, 0x30, // 0216 JMP $3020
+};
+
+static void run(Memory *mem, int steps) {
+    CPU cpu;
+    cpu_reset(&cpu, mem);
+    cpu.PC = 0x0200;
+    cpu.X = 0x07;
+    for (int i = 0; i < steps; i++) cpu_step(&cpu);
+}
+
+static void setup(Memory *mem) {
+    mem_init(mem);
+    mem_load_bytes(mem, 0x0200, program, sizeof(program));
+    mem_write(mem, 0x3100, 0x60); // RTS
+    mem_write(mem, 0x3020, 0xEA); // NOP
+}
+
+int main(void) {
+    static Memory mem;
+    Hits reads, writes;
+
+    // Lectures : LDA $3000 et la lecture de INC $3001 seulement
+    setup(&mem);
+    memset(&reads, 0, sizeof(reads));
+    mem_add_watch(&mem, 0x3000, 0x3002, MEM_WATCH_READ, record, &reads);
+    mem_add_watch(&mem, 0x0080, 0x0080, MEM_WATCH_READ, record, &reads);
+    run(&mem, 7);
+    CHECK_EQ(reads.count, 2);
+    CHECK_EQ(reads.pc[0], 0x020D);
+    CHECK_EQ(reads.address[0], 0x3000);
+    CHECK_EQ(reads.value[0], 0x42);
+    CHECK_EQ(reads.kind[0], MEM_WATCH_READ);
+    CHECK_EQ(reads.pc[1], 0x0210);
+    CHECK_EQ(reads.address[1], 0x3001);
+    CHECK_EQ(reads.value[1], 0x07);
+
+    // Cibles de JSR et JMP : seul le fetch de l'instruction exécutée est une lecture
+    setup(&mem);
+    memset(&reads, 0, sizeof(reads));
+    mem_add_watch(&mem, 0x3020, 0x3020, MEM_WATCH_READ, record, &reads);
+    mem_add_watch(&mem, 0x3100, 0x3100, MEM_WATCH_READ, record, &reads);
+    run(&mem, 10); // ... JSR, RTS, JMP (la cible n'est pas exécutée)
+    CHECK_EQ(reads.count, 1);
+    CHECK_EQ(reads.address[0], 0x3100);
+    CHECK_EQ(reads.pc[0], 0x3100);
+
+    // Écritures : STA, STX, STY puis l'écriture de INC
+    setup(&mem);
+    memset(&writes, 0, sizeof(writes));
+    mem_add_watch(&mem, 0x3000, 0x30FF, MEM_WATCH_WRITE, record, &writes);
+    run(&mem, 7);
+    CHECK_EQ(writes.count, 4);
+    CHECK_EQ(writes.pc[0], 0x0202);
+    CHECK_EQ(writes.pc[1], 0x0205);
+    CHECK_EQ(writes.pc[2], 0x0208);
+    CHECK_EQ(writes.pc[3], 0x0210);
+    CHECK_EQ(writes.value[3], 0x08);
+    CHECK_EQ(writes.kind[3], MEM_WATCH_WRITE);
+
+    // Exécution
+    setup(&mem);
+    memset(&reads, 0, sizeof(reads));
+    mem_add_watch(&mem, 0x0205, 0x020B, MEM_WATCH_EXEC, record, &reads);
+    run(&mem, 7);
+    CHECK_EQ(reads.count, 3);
+    CHECK_EQ(reads.address[2], 0x020B);
+    CHECK_EQ(reads.kind[2], MEM_WATCH_EXEC);
+    return check_done("watch");
+}
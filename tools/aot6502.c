@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aot.h"
+#include "codemap.h"
+
+// Exécute une ROM traduite par rec6502 (aot_image, lié à ce programme)
+// jusqu'à ce qu'elle boucle sur elle-même, avec l'interpréteur puis avec le
+// code natif, et compare les vitesses et les états finaux.
+
+#define SLICE_CYCLES 100000ull
+
+static void usage(void) {
+    printf("Usage : aot6502 [options] [rom.bin]\n");
+    printf("  --repeat=N   meilleur temps sur N executions (defaut 3)\n");
+    printf("  --cycles=N   limite de cycles (defaut 2000000000)\n");
+    printf("La ROM (par defaut celle qui a ete traduite) doit etre identique a l'image traduite.\n");
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Vrai si l'instruction à 'pc' peut sauter sur elle-même (même test que bench6502)
+static int is_trap(const Memory *mem, u16 pc) {
+    u8 op = mem_peek(mem, pc);
+    if (op == 0x4C) return (mem_peek(mem, (u16)(pc + 1)) | (mem_peek(mem, (u16)(pc + 2)) << 8)) == pc;
+    if ((op & 0x1F) == 0x10 || op == 0x80) return mem_peek(mem, (u16)(pc + 1)) == 0xFE;
+    return 0;
+}
+
+typedef struct {
+    double seconds;
+    u64 cycles;
+    u64 calls, interpreted, invalidated;
+    u64 mem_hash;
+    CPU cpu;
+    int halted; // Opcode non implémenté
+} RunResult;
+
+// Une exécution complète (native si aot != 0). Retourne 0 si erreur.
+static int run_once(const char *rom, int aot, u64 max_cycles, RunResult *res) {
+    static Memory mem;
+    static CPU cpu;
+    mem_init(&mem);
+    if (!mem_load(&mem, rom, aot_image.base)) return 0;
+    cpu_reset_variant(&cpu, &mem, (CpuVariant)aot_image.variant);
+    cpu.PC = aot_image.start;
+
+    AotRuntime *rt = NULL;
+    if (aot && (rt = aot_create(&cpu, &aot_image)) == NULL) return 0;
+
+    memset(res, 0, sizeof(*res));
+    double t0 = now_seconds();
+    for (u64 until = SLICE_CYCLES; cpu.cycles <= max_cycles; until += SLICE_CYCLES) {
+        // Échéances absolues : les deux moteurs s'arrêtent aux mêmes tranches
+        if (rt) {
+            if (!aot_run(rt, until)) break;
+        } else {
+            cpu_run(&cpu, until);
+            if (cpu.cycles < until) break; // Opcode non implémenté
+        }
+        // Une branche sur elle-même n'est un piège que si elle est prise
+        if (is_trap(&mem, cpu.PC)) {
+            u16 pc = cpu.PC;
+            cpu_run(&cpu, cpu.cycles + 1);
+            if (cpu.PC == pc) break;
+        }
+    }
+    res->seconds = now_seconds() - t0;
+    res->halted = cpu.cycles <= max_cycles && !is_trap(&mem, cpu.PC);
+    res->cycles = cpu.cycles;
+    res->cpu = cpu;
+    res->mem_hash = codemap_hash(&mem);
+    if (rt) {
+        res->calls = rt->calls;
+        res->interpreted = rt->interpreted;
+        res->invalidated = rt->invalidated;
+        aot_free(rt);
+    }
+    return 1;
+}
+
+static void print_result(const char *name, const RunResult *r) {
+    printf("%-13s %11llu cycles %7.3f s %8.2f MHz  PC $%04X", name, (unsigned long long)r->cycles,
+           r->seconds, r->cycles / r->seconds / 1e6, r->cpu.PC);
+    if (r->halted) printf(" (opcode non implemente)");
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    const char *rom = aot_image.rom;
+    int repeat = 3;
+    u64 max_cycles = 2000000000ull;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = atoi(argv[i] + 9);
+            if (repeat < 1) repeat = 1;
+        } else if (strncmp(argv[i], "--cycles=", 9) == 0) {
+            max_cycles = strtoull(argv[i] + 9, NULL, 10);
+        } else if (argv[i][0] != '-') {
+            rom = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    printf("%s : %d routines, %d blocs, %d instructions traduites, depart $%04X\n",
+           aot_image.rom, aot_image.routines, aot_image.block_count, aot_image.span_count, aot_image.start);
+    static RunResult best[2], r;
+    for (int engine = 0; engine < 2; engine++) {
+        for (int k = 0; k < repeat; k++) {
+            if (!run_once(rom, engine, max_cycles, &r)) return 1;
+            if (k == 0 || r.seconds < best[engine].seconds) best[engine] = r;
+        }
+    }
+    print_result("Interpreteur", &best[0]);
+    print_result("Natif (AOT)", &best[1]);
+    printf("Natif : %llu entrees de fonction, %llu instructions interpretees, %llu blocs invalides\n",
+           (unsigned long long)best[1].calls, (unsigned long long)best[1].interpreted,
+           (unsigned long long)best[1].invalidated);
+    printf("Gain : x%.2f\n", best[0].seconds / best[1].seconds);
+
+    const CPU *a = &best[0].cpu, *b = &best[1].cpu;
+    int same = a->PC == b->PC && a->A == b->A && a->X == b->X && a->Y == b->Y && a->SP == b->SP
+               && a->P == b->P && a->cycles == b->cycles && best[0].mem_hash == best[1].mem_hash;
+    printf("Etats finaux identiques : %s\n", same ? "oui" : "NON");
+    return same ? 0 : 1;
+}
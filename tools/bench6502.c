@@ -0,0 +1,871 @@
+// Benchmark de libemu6502 : mesure la vitesse d'émulation sur une ou plusieurs
+// charges de travail. Les charges passent par l'API publique ; les benchmarks
+// de modules (--batch-bench, --device-bench, --coverage-bench, --explore-bench,
+// --fb-bench, --hostcall-bench, --fuse-bench) utilisent les en-têtes internes,
+// la bibliothèque étant liée statiquement.
+//   FICHIER[@DEBUT] : image chargée en $0000, lancée en DEBUT (0400 par défaut)
+//                     jusqu'à ce qu'elle boucle sur elle-même (JMP * ou branche
+//                     sur elle-même, comme le test fonctionnel de Klaus Dormann)
+//   :popcount, :sort, :fib, :calls : programmes intégrés, exécutés pendant un nombre fixe de cycles
+//   --batch-bench : mode batch (16 lanes) contre 16 exécutions scalaires
+//   --device-bench : timer à IRQ en coroutine contre la même machine à états
+//   --coverage-bench : :popcount avec et sans couverture
+//   --explore-bench[=THREADS] : recherche exhaustive sur un octet d'entrée, de 1 à THREADS threads
+//   --fb-bench : écran mono 320x200 sans rendu, intercepté, rendu incrémental et complet
+//   --hostcall-bench : 1 Mo vers /dev/null par HC_WRITE, 1 octet puis 4 Ko par appel
+//   --fuse-bench : moteur à blocs sans et avec superinstructions
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "emu6502.h"
+#include "batch.h"
+#include "blockcache.h"
+#include "coverage.h"
+#include "device.h"
+#include "explore.h"
+#include "framebuffer.h"
+#include "hostcall.h"
+
+#define BUILTIN_CYCLES 20000000ull
+#define MAX_CYCLES 2000000000ull
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Compte des bits à 1 d'un octet, en boucle
+static const uint8_t prog_popcount[] = {
+    0xA0, 0x00,       // 0200 LDY #$00
+    0xA5, 0x10,       // 0202 LDA $10
+    0xA2, 0x08,       // 0204 LDX #$08
+    0x0A,             // 0206 ASL A
+    0x90, 0x01,       // 0207 BCC +1
+    0xC8,             // 0209 INY
+    0xCA,             // 020A DEX
+    0xD0, 0xF9,       // 020B BNE $0206
+    0xE6, 0x10,       // 020D INC $10
+    0x4C, 0x00, 0x02, // 020F JMP $0200
+};
+
+// Tri à bulles de 256 octets en ordre décroissant, recommencé sans fin
+static const uint8_t prog_sort[] = {
+    0xA2, 0x00,       // 0200 LDX #$00
+    0x8A,             // 0202 TXA
+    0x49, 0xFF,       // 0203 EOR #$FF
+    0x9D, 0x00, 0x10, // 0205 STA $1000,X
+    0xE8,             // 0208 INX
+    0xD0, 0xF7,       // 0209 BNE $0202
+    0xA0, 0x00,       // 020B LDY #$00   (passe : aucun échange)
+    0xA2, 0x00,       // 020D LDX #$00
+    0xBD, 0x00, 0x10, // 020F LDA $1000,X
+    0xDD, 0x01, 0x10, // 0212 CMP $1001,X
+    0x90, 0x0F,       // 0215 BCC $0226
+    0xF0, 0x0D,       // 0217 BEQ $0226
+    0x48,             // 0219 PHA
+    0xBD, 0x01, 0x10, // 021A LDA $1001,X
+    0x9D, 0x00, 0x10, // 021D STA $1000,X
+    0x68,             // 0220 PLA
+    0x9D, 0x01, 0x10, // 0221 STA $1001,X
+    0xA0, 0x01,       // 0224 LDY #$01
+    0xE8,             // 0226 INX
+    0xE0, 0xFF,       // 0227 CPX #$FF
+    0xD0, 0xE4,       // 0229 BNE $020F
+    0xC0, 0x00,       // 022B CPY #$00
+    0xD0, 0xDC,       // 022D BNE $020B
+    0x4C, 0x00, 0x02, // 022F JMP $0200
+};
+
+// Fibonacci récursif : fib(20) = 6765 feuilles, environ 22000 JSR/RTS et
+// autant de PHA/PLA par tour (pile et appels de sous-programmes)
+static const uint8_t prog_fib[] = {
+    0xA9, 0x00,       // 0200 LDA #$00
+    0x85, 0x00,       // 0202 STA $00     (résultat, 16 bits)
+    0x85, 0x01,       // 0204 STA $01
+    0xA9, 0x14,       // 0206 LDA #20
+    0x20, 0x0E, 0x02, // 0208 JSR fib
+    0x4C, 0x00, 0x02, // 020B JMP $0200
+    0xC9, 0x02,       // 020E fib: CMP #$02
+    0xB0, 0x0A,       // 0210 BCS $021C
+    0x18,             // 0212 CLC         (n < 2 : résultat += n)
+    0x65, 0x00,       // 0213 ADC $00
+    0x85, 0x00,       // 0215 STA $00
+    0x90, 0x02,       // 0217 BCC $021B
+    0xE6, 0x01,       // 0219 INC $01
+    0x60,             // 021B RTS
+    0x48,             // 021C PHA
+    0x38,             // 021D SEC
+    0xE9, 0x01,       // 021E SBC #$01
+    0x20, 0x0E, 0x02, // 0220 JSR fib     (n - 1)
+    0x68,             // 0223 PLA
+    0x38,             // 0224 SEC
+    0xE9, 0x02,       // 0225 SBC #$02
+    0x20, 0x0E, 0x02, // 0227 JSR fib     (n - 2)
+    0x60,             // 022A RTS
+};
+
+// Appels imbriqués : 16 niveaux de JSR, chacun sauvegardant A et P sur la
+// pile (presque uniquement des accès à la page 1)
+static const uint8_t prog_calls[] = {
+    0xA2, 0x10,       // 0200 LDX #16
+    0x20, 0x08, 0x02, // 0202 JSR sub
+    0x4C, 0x00, 0x02, // 0205 JMP $0200
+    0x48,             // 0208 sub: PHA
+    0x08,             // 0209 PHP
+    0xCA,             // 020A DEX
+    0xF0, 0x03,       // 020B BEQ $0210
+    0x20, 0x08, 0x02, // 020D JSR sub
+    0x28,             // 0210 PLP
+    0x68,             // 0211 PLA
+    0x60,             // 0212 RTS
+};
+
+typedef struct {
+    const char *name;
+    uint8_t image[0x10000];
+    size_t size;
+    uint16_t load, start;
+    uint64_t cycles; // 0 : jusqu'au piège
+} Workload;
+
+// Vrai si l'instruction à 'pc' peut sauter sur elle-même
+static int is_trap(Emu6502 *emu, uint16_t pc) {
+    const uint8_t *mem = emu6502_memory(emu);
+    uint8_t op = mem[pc];
+    if (op == 0x4C) return (mem[(uint16_t)(pc + 1)] | (mem[(uint16_t)(pc + 2)] << 8)) == pc;
+    // Branches conditionnelles (xxx10000) et BRA du 65C02
+    if ((op & 0x1F) == 0x10 || op == 0x80) return mem[(uint16_t)(pc + 1)] == 0xFE;
+    return 0;
+}
+
+static int workload_init(Workload *w, const char *spec) {
+    memset(w, 0, sizeof(*w));
+    w->name = spec;
+    w->start = 0x0400;
+    if (spec[0] == ':') {
+        const uint8_t *prog;
+        if (strcmp(spec, ":popcount") == 0) {
+            prog = prog_popcount;
+            w->size = sizeof(prog_popcount);
+        } else if (strcmp(spec, ":fib") == 0) {
+            prog = prog_fib;
+            w->size = sizeof(prog_fib);
+        } else if (strcmp(spec, ":calls") == 0) {
+            prog = prog_calls;
+            w->size = sizeof(prog_calls);
+        } else if (strcmp(spec, ":sort") == 0) {
+            prog = prog_sort;
+            w->size = sizeof(prog_sort);
+        } else {
+            fprintf(stderr, "Erreur : programme integre inconnu '%s' (:popcount, :sort, :fib, :calls)\n", spec);
+            return 0;
+        }
+        memcpy(w->image, prog, w->size);
+        w->load = w->start = 0x0200;
+        w->cycles = BUILTIN_CYCLES;
+        return 1;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s", spec);
+    char *at = strrchr(path, '@');
+    if (at) {
+        *at = '\0';
+        w->start = (uint16_t)strtoul(at + 1, NULL, 16);
+    }
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Erreur : Impossible d'ouvrir le fichier %s\n", path);
+        return 0;
+    }
+    w->size = fread(w->image, 1, sizeof(w->image), f);
+    fclose(f);
+    return 1;
+}
+
+// Exécute la charge de travail une fois ; retourne le temps écoulé
+static double workload_run(Emu6502 *emu, const Workload *w, uint64_t *cycles, uint64_t *instructions) {
+    Emu6502Regs regs;
+    memset(emu6502_memory(emu), 0, 0x10000);
+    emu6502_load(emu, w->load, w->image, w->size);
+    emu6502_reset(emu);
+    emu6502_get_regs(emu, &regs);
+    regs.pc = w->start;
+    emu6502_set_regs(emu, &regs);
+    uint64_t instr0 = emu6502_instructions(emu);
+
+    double t0 = now_seconds();
+    if (w->cycles) {
+        emu6502_run(emu, w->cycles);
+    } else {
+        for (;;) {
+            emu6502_run(emu, 100000);
+            emu6502_get_regs(emu, &regs);
+            if (emu6502_halted(emu) || regs.cycles > MAX_CYCLES) break;
+            // Une branche conditionnelle sur elle-même n'est un piège que si elle est prise
+            if (is_trap(emu, regs.pc)) {
+                uint16_t pc = regs.pc;
+                emu6502_run(emu, 1);
+                emu6502_get_regs(emu, &regs);
+                if (regs.pc == pc) break;
+            }
+        }
+    }
+    double t = now_seconds() - t0;
+    emu6502_get_regs(emu, &regs);
+    *cycles = regs.cycles;
+    *instructions = emu6502_instructions(emu) - instr0;
+    return t;
+}
+
+// Programme de --batch-bench : même comptage, sans fin et sur une entrée fixe
+// par lane (deux branches par tour de boucle, les lanes divergent sur BCC)
+static const u8 batch_program[] = {
+    0xA0, 0x00,       // 0200 LDY #$00
+    0xA5, 0x10,       // 0202 LDA $10      (entrée)
+    0xA2, 0x08,       // 0204 LDX #$08
+    0x0A,             // 0206 ASL A
+    0x90, 0x01,       // 0207 BCC +1
+    0xC8,             // 0209 INY
+    0xCA,             // 020A DEX
+    0xD0, 0xF9,       // 020B BNE $0206
+    0x4C, 0x02, 0x02, // 020D JMP $0202
+};
+
+// Mode batch : BATCH_LANES instances du même programme (entrée différente
+// pour chaque lane) contre autant d'exécutions scalaires successives
+static int bench_batch(void) {
+    const u64 steps = 2000000; // Instructions par instance
+
+    static Memory image;
+    mem_init(&image);
+    mem_load_bytes(&image, 0x0200, batch_program, sizeof(batch_program));
+
+    // Lanes en lock-step
+    static BatchCPU batch;
+    batch_init(&batch, &image, BATCH_LANES, 0x0200);
+    printf("=== Benchmark batch (%d lanes, %llu instructions par lane, %s) ===\n",
+           BATCH_LANES, (unsigned long long)steps, batch_uses_avx2() ? "AVX2" : "SSE2");
+    for (int l = 0; l < BATCH_LANES; l++) {
+        batch_poke(&batch, l, 0x10, (u8)(l * 37 + 1));
+    }
+    double t0 = now_seconds();
+    batch_run(&batch, steps);
+    double t_batch = now_seconds() - t0;
+
+    // Même travail sur N cœurs scalaires, l'un après l'autre
+    static Memory mem;
+    int mismatches = 0;
+    t0 = now_seconds();
+    for (int l = 0; l < BATCH_LANES; l++) {
+        mem_copy(&mem, &image);
+        mem_write(&mem, 0x10, (u8)(l * 37 + 1));
+        CPU cpu;
+        cpu_reset(&cpu, &mem);
+        cpu.PC = 0x0200;
+        for (u64 i = 0; i < steps; i++) cpu_step(&cpu);
+
+        if (cpu.A != batch.A[l] || cpu.X != batch.X[l] || cpu.Y != batch.Y[l]
+            || cpu.P != batch.P[l] || cpu.PC != batch.PC[l] || cpu.cycles != batch.cycles[l]) {
+            mismatches++;
+        }
+    }
+    double t_scalar = now_seconds() - t0;
+
+    double total = (double)steps * BATCH_LANES;
+    printf("Scalaire : %8.2f MIPS (%.3f s)\n", total / t_scalar / 1e6, t_scalar);
+    printf("Batch    : %8.2f MIPS (%.3f s), gain x%.2f\n", total / t_batch / 1e6, t_batch, t_scalar / t_batch);
+    printf("Pas vectoriels : %llu, pas scalaires : %llu\n",
+           (unsigned long long)batch.vector_steps, (unsigned long long)batch.scalar_steps);
+    printf("Etats identiques au scalaire : %s\n", mismatches ? "NON" : "oui");
+    batch_free(&batch);
+    return mismatches ? 1 : 0;
+}
+
+#define IRQ_TICK (1 << 0) // Ligne IRQ du timer de --device-bench
+
+// Benchmark des périphériques en coroutines : le même timer (IRQ toutes les
+// 'period' cycles, acquittée par une écriture en $D000) écrit comme une
+// machine à états sur l'ordonnanceur puis comme du code séquentiel. Même
+// travail émulé : la différence de temps est le coût des coroutines.
+typedef struct {
+    u64 period, ticks;
+    u64 acked; // Cycle de l'acquittement (base de la période suivante)
+    int event, pending;
+    CPU *cpu;
+    Scheduler *sched;
+    Device *dev; // NULL : version machine à états
+} Ticker;
+
+static void ticker_event(void *ctx, u64 now) {
+    (void)now;
+    Ticker *t = (Ticker *)ctx;
+    if (t->pending) { // Acquittement : on repart pour une période
+        t->pending = 0;
+        cpu_set_irq(t->cpu, IRQ_TICK, 0);
+        t->ticks++;
+        sched_set(t->sched, t->event, t->acked + t->period);
+    } else {
+        cpu_set_irq(t->cpu, IRQ_TICK, 1);
+        t->pending = 1;
+        sched_cancel(t->sched, t->event); // Jusqu'à l'acquittement
+    }
+}
+
+static void ticker_body(Device *dev) {
+    Ticker *t = (Ticker *)dev->ctx;
+    for (;;) {
+        device_wait(dev, t->period);
+        cpu_set_irq(dev->cpu, IRQ_TICK, 1);
+        device_wait_until(dev, SCHED_NEVER); // Jusqu'à l'acquittement
+        cpu_set_irq(dev->cpu, IRQ_TICK, 0);
+        t->ticks++;
+    }
+}
+
+static void ticker_ack(void *ctx, u16 address, u8 value) {
+    (void)address; (void)value;
+    Ticker *t = (Ticker *)ctx;
+    if (t->dev) {
+        device_wake(t->dev);
+    } else if (t->pending) {
+        t->acked = t->cpu->cycles;
+        sched_set(t->sched, t->event, t->cpu->cycles);
+    }
+}
+
+static u8 ticker_read(void *ctx, u16 address) {
+    (void)ctx; (void)address;
+    return 0;
+}
+
+typedef struct {
+    double seconds;
+    u64 ticks, resumes, instructions;
+    CPU cpu;
+    u8 counter; // $10, incrémenté par le handler d'IRQ
+} TickerRun;
+
+static void run_ticker(u64 period, int coroutine, u64 cycles, TickerRun *res) {
+    static const u8 program[] = {
+        0x58,             // 0200 CLI
+        0xE8,             // 0201 INX
+        0x4C, 0x01, 0x02, // 0202 JMP $0201
+    };
+    static const u8 handler[] = {
+        0x8D, 0x00, 0xD0, // 0300 STA $D000   (acquittement)
+        0xE6, 0x10,       // 0303 INC $10
+        0x40,             // 0305 RTI
+    };
+    static Memory mem;
+    static CPU cpu;
+    static Scheduler sched;
+    static Device dev;
+    static Ticker t;
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    mem_load_bytes(&mem, 0x0300, handler, sizeof(handler));
+    mem_write(&mem, 0xFFFE, 0x00);
+    mem_write(&mem, 0xFFFF, 0x03);
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    sched_init(&sched);
+    memset(&t, 0, sizeof(t));
+    t.period = period;
+    t.cpu = &cpu;
+    t.sched = &sched;
+    mem_map_io(&mem, 0xD0, 0xD0, ticker_read, ticker_ack, &t);
+    if (coroutine) {
+        t.dev = &dev;
+        device_start(&dev, "ticker", &cpu, &sched, ticker_body, &t);
+    } else {
+        t.event = sched_add(&sched, ticker_event, &t);
+        sched_set(&sched, t.event, cpu.cycles + period);
+    }
+
+    u64 instructions = 0;
+    double t0 = now_seconds();
+    // Comme la boucle principale : un accès d'E/S peut avancer l'échéance
+    while (cpu.cycles < cycles) {
+        cpu_step(&cpu);
+        instructions++;
+        sched_poll(&sched, cpu.cycles);
+    }
+    res->seconds = now_seconds() - t0;
+    res->ticks = t.ticks;
+    res->resumes = coroutine ? dev.resumes : 0;
+    res->instructions = instructions;
+    res->cpu = cpu;
+    res->counter = mem.data[0x10];
+    if (coroutine) device_stop(&dev);
+}
+
+static int bench_device(void) {
+    const u64 cycles = 20000000;
+    static const u64 periods[] = { 10000, 1000, 100 };
+    printf("=== Benchmark des peripheriques en coroutines (%llu cycles) ===\n", (unsigned long long)cycles);
+    printf("Changement de contexte (aller-retour) : %.1f ns\n", device_switch_cost(10000000));
+    printf("%8s %10s %12s %12s %9s %14s\n", "periode", "ticks", "etats (MIPS)", "coroutines", "surcout", "ns / reprise");
+    int mismatches = 0;
+    for (size_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++) {
+        TickerRun best[2], r;
+        for (int engine = 0; engine < 2; engine++) {
+            for (int k = 0; k < 3; k++) {
+                run_ticker(periods[i], engine, cycles, &r);
+                if (k == 0 || r.seconds < best[engine].seconds) best[engine] = r;
+            }
+        }
+        const CPU *a = &best[0].cpu, *b = &best[1].cpu;
+        if (best[0].ticks != best[1].ticks || a->cycles != b->cycles || a->X != b->X || a->PC != b->PC
+            || best[0].counter != best[1].counter) {
+            mismatches++;
+        }
+        double extra = best[1].seconds - best[0].seconds;
+        printf("%8llu %10llu %12.2f %12.2f %8.1f%% %14.1f\n", (unsigned long long)periods[i],
+               (unsigned long long)best[1].ticks, best[0].instructions / best[0].seconds / 1e6,
+               best[1].instructions / best[1].seconds / 1e6, 100.0 * extra / best[0].seconds,
+               best[1].resumes ? extra / best[1].resumes * 1e9 : 0.0);
+    }
+    printf("Etats identiques : %s\n", mismatches ? "NON" : "oui");
+    return mismatches ? 1 : 0;
+}
+
+// --- Couverture ---
+// :popcount avec cpu_step puis cov_step (meilleur de 3 essais chacun), états
+// finaux comparés
+static int bench_coverage(void) {
+    const u64 steps = 30000000;
+    static Memory mem;
+    static Coverage cov;
+    double best[2] = { 0.0, 0.0 };
+    CPU cpu[2];
+    printf("=== Benchmark de la couverture (%llu instructions) ===\n", (unsigned long long)steps);
+    for (int k = 0; k < 3; k++) {
+        for (int mode = 0; mode < 2; mode++) {
+            mem_init(&mem);
+            mem_load_bytes(&mem, 0x0200, prog_popcount, sizeof(prog_popcount));
+            cov_init(&cov, CPU_NMOS);
+            CPU *c = &cpu[mode];
+            cpu_reset(c, &mem);
+            c->PC = 0x0200;
+            double t0 = now_seconds();
+            if (mode) {
+                for (u64 i = 0; i < steps; i++) cov_step(&cov, c);
+            } else {
+                for (u64 i = 0; i < steps; i++) cpu_step(c);
+            }
+            double t = now_seconds() - t0;
+            if (k == 0 || t < best[mode]) best[mode] = t;
+        }
+    }
+    CovSummary s;
+    cov_summary(&cov, &s);
+    int same = cpu[0].PC == cpu[1].PC && cpu[0].A == cpu[1].A && cpu[0].X == cpu[1].X
+            && cpu[0].Y == cpu[1].Y && cpu[0].P == cpu[1].P && cpu[0].cycles == cpu[1].cycles;
+    printf("Sans couverture : %8.2f MIPS\n", steps / best[0] / 1e6);
+    printf("Avec couverture : %8.2f MIPS, surcout %.1f%% (%.2f ns par instruction)\n", steps / best[1] / 1e6,
+           100.0 * (best[1] - best[0]) / best[0], (best[1] - best[0]) / steps * 1e9);
+    printf("Couvert : %u instructions, %u branches (%u dans les deux sens)\n", s.instructions, s.branches,
+           s.both_ways);
+    printf("Etats identiques : %s\n", same ? "oui" : "NON");
+    return same && s.instructions == 10 && s.both_ways == 2 ? 0 : 1; // Tout le programme, BCC et BNE
+}
+
+// --- Exploration de l'espace des entrées ---
+// Recherche exhaustive sur un octet d'entrée lu en $10 à chaque passage en
+// $0200 : somme des bits à 1 en $11, quartets hauts des entrées en $12. Après
+// une entrée, 80 états distincts seulement (bits à 1 x quartet haut) : les
+// autres branches sont élaguées dès la deuxième entrée. Les états finaux
+// distincts sont comptés dans le rapport des feuilles : ils ne dépendent ni de
+// l'élagage ni du nombre de threads.
+#define EXPLORE_SET_BITS 20
+
+typedef struct {
+    u64 *set; // États finaux vus (hash, 0 : libre)
+    u64 distinct;
+} LeafSet;
+
+static void count_leaf(void *ctx, const CPU *cpu, const u8 *inputs, int count, ExploreEnd end) {
+    (void)inputs; (void)count; (void)end;
+    LeafSet *ls = (LeafSet *)ctx;
+    u64 h = (u64)cpu->A | (u64)cpu->X << 8 | (u64)cpu->Y << 16 | (u64)cpu->P << 24 | (u64)cpu->PC << 32
+          | (u64)mem_peek(cpu->mem, 0x11) << 48 | (u64)mem_peek(cpu->mem, 0x12) << 56;
+    h = (h * 0x9E3779B97F4A7C15ULL) | 1;
+    u64 mask = (1ULL << EXPLORE_SET_BITS) - 1;
+    for (u64 i = h & mask; ls->set[i] != h; i = (i + 1) & mask) {
+        if (ls->set[i] == 0) {
+            ls->set[i] = h;
+            ls->distinct++;
+            break;
+        }
+    }
+}
+
+static int explore_once(const CPU *cpu, int depth, int threads, int dedup, ExploreStats *st, u64 *distinct) {
+    static LeafSet ls;
+    if (ls.set == NULL) ls.set = malloc(sizeof(u64) << EXPLORE_SET_BITS);
+    if (ls.set == NULL) return 0;
+    memset(ls.set, 0, sizeof(u64) << EXPLORE_SET_BITS);
+    ls.distinct = 0;
+    ExploreConfig cfg = { 0x0200, 0x0010, 256, depth, -1, 100000, threads, dedup, 0, count_leaf, &ls };
+    if (!explore_run(&cfg, cpu, st)) return 0;
+    *distinct = ls.distinct;
+    return 1;
+}
+
+static void print_explore(const char *label, const ExploreStats *st, u64 distinct, double base) {
+    printf("%-22s %3d %9llu %9llu %9llu %8llu %8.3f s %8.2f %6.2f\n", label, st->threads,
+           (unsigned long long)st->branches, (unsigned long long)st->pruned, (unsigned long long)st->leaves,
+           (unsigned long long)distinct, st->seconds, st->instructions / st->seconds / 1e6,
+           base > 0 ? base / st->seconds : 1.0);
+}
+
+static int bench_explore(int max_threads) {
+    static const u8 program[] = {
+        0xA5, 0x10,       // 0200 LDA $10      (point de décision)
+        0xA0, 0x00,       // 0202 LDY #$00
+        0xA2, 0x08,       // 0204 LDX #$08
+        0x0A,             // 0206 ASL A
+        0x90, 0x01,       // 0207 BCC +1
+        0xC8,             // 0209 INY
+        0xCA,             // 020A DEX
+        0xD0, 0xF9,       // 020B BNE $0206
+        0x98,             // 020D TYA
+        0x18,             // 020E CLC
+        0x65, 0x11,       // 020F ADC $11
+        0x85, 0x11,       // 0211 STA $11      (somme des bits à 1)
+        0xA5, 0x12,       // 0213 LDA $12
+        0x0A,             // 0215 ASL A
+        0x69, 0x00,       // 0216 ADC #$00     (rotation)
+        0x85, 0x12,       // 0218 STA $12
+        0xA5, 0x10,       // 021A LDA $10
+        0x4A,             // 021C LSR A
+        0x4A,             // 021D LSR A
+        0x4A,             // 021E LSR A
+        0x4A,             // 021F LSR A
+        0x45, 0x12,       // 0220 EOR $12
+        0x85, 0x12,       // 0222 STA $12      (empreinte des quartets hauts)
+        0x18,             // 0224 CLC          (la retenue dépend du quartet bas)
+        0xA0, 0x00,       // 0225 LDY #$00
+        0x84, 0x10,       // 0227 STY $10      (entrée consommée)
+        0x4C, 0x00, 0x02, // 0229 JMP $0200
+    };
+    static Memory mem;
+    static CPU cpu;
+    mem_init(&mem);
+    mem_load_bytes(&mem, 0x0200, program, sizeof(program));
+    cpu_reset(&cpu, &mem);
+    cpu.PC = 0x0200;
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_threads < 1) max_threads = cores;
+    if (max_threads < 1) max_threads = 1;
+
+    printf("=== Benchmark d'exploration (octet d'entree, 256 valeurs par decision, %d coeur(s)) ===\n", cores);
+    printf("%-22s %3s %9s %9s %9s %8s %10s %8s %6s\n", "", "thr", "branches", "elagues", "feuilles",
+           "distincts", "temps", "MIPS", "gain");
+    ExploreStats st;
+    u64 full, pruned;
+    if (!explore_once(&cpu, 2, 1, 0, &st, &full)) return 1;
+    print_explore("2 entrees, sans elagage", &st, full, 0.0);
+    double unpruned = st.seconds;
+    if (!explore_once(&cpu, 2, 1, 1, &st, &pruned)) return 1;
+    print_explore("2 entrees, elagage", &st, pruned, unpruned);
+    int mismatches = full != pruned;
+
+    double base = 0.0;
+    u64 reference = 0;
+    for (int threads = 1; threads <= max_threads; threads = threads * 2 > max_threads && threads < max_threads ? max_threads : threads * 2) {
+        u64 distinct;
+        if (!explore_once(&cpu, 3, threads, 1, &st, &distinct)) return 1;
+        if (threads == 1) {
+            base = st.seconds;
+            reference = distinct;
+        }
+        if (distinct != reference) mismatches++;
+        print_explore("3 entrees, elagage", &st, distinct, base);
+    }
+    printf("Pages recopiees a l'ecriture (dernier passage) : %llu, vols de taches : %llu\n",
+           (unsigned long long)st.pages_copied, (unsigned long long)st.steals);
+    if (max_threads > cores) printf("Plus de threads que de coeurs : le gain ne mesure que le surcout du pool\n");
+    printf("Etats finaux identiques : %s\n", mismatches ? "NON" : "oui");
+    return mismatches ? 1 : 0;
+}
+
+// --- Écran ---
+// Un programme qui remplit sans fin un écran mono 320x200 en $2000 (une
+// instruction sur quatre écrit dans l'écran), sans écran, avec l'écran
+// intercepté, puis avec une image rendue toutes les FB_BENCH_FRAME cycles
+// (lignes touchées seulement, puis tout l'écran)
+#define FB_BENCH_FRAME 20000
+
+static const u8 fill_program[] = {
+    0xA9, 0x20,       // 0200 LDA #$20
+    0x85, 0x11,       // 0202 STA $11
+    0xA9, 0x00,       // 0204 LDA #$00
+    0x85, 0x10,       // 0206 STA $10
+    0xA0, 0x00,       // 0208 LDY #$00
+    0xA5, 0x12,       // 020A LDA $12
+    0x91, 0x10,       // 020C STA ($10),Y
+    0xC8,             // 020E INY
+    0xD0, 0xF9,       // 020F BNE $020A
+    0xE6, 0x11,       // 0211 INC $11
+    0xA5, 0x11,       // 0213 LDA $11
+    0xC9, 0x3F,       // 0215 CMP #$3F
+    0xD0, 0xF1,       // 0217 BNE $020A
+    0xE6, 0x12,       // 0219 INC $12
+    0x4C, 0x00, 0x02, // 021B JMP $0200
+};
+
+static int bench_fb(void) {
+    const u64 cycles = 30000000;
+    static const char *names[4] = { "Sans ecran", "Ecran intercepte", "Rendu des lignes touchees",
+                                    "Rendu complet" };
+    static Memory mem;
+    static Framebuffer fb;
+    double best[4] = { 0.0, 0.0, 0.0, 0.0 };
+    u64 instructions = 0, frames = 0, lines = 0;
+    int same = 1;
+    printf("=== Benchmark de l'ecran (mono 320x200, %llu cycles, une image toutes les %d cycles) ===\n",
+           (unsigned long long)cycles, FB_BENCH_FRAME);
+    for (int k = 0; k < 3; k++) {
+        for (int mode = 0; mode < 4; mode++) {
+            mem_init(&mem);
+            mem_load_bytes(&mem, 0x0200, fill_program, sizeof(fill_program));
+            if (mode && !fb_attach(&fb, &mem, 0x2000, FB_MONO, 320, 200)) return 1;
+            CPU cpu;
+            cpu_reset(&cpu, &mem);
+            cpu.PC = 0x0200;
+            u64 steps = 0;
+            double t0 = now_seconds();
+            while (cpu.cycles < cycles) {
+                u64 end = cpu.cycles + FB_BENCH_FRAME;
+                while (cpu.cycles < end) {
+                    cpu_step(&cpu);
+                    steps++;
+                }
+                if (mode == 3) fb_invalidate(&fb);
+                if (mode >= 2) fb_render(&fb);
+            }
+            double t = now_seconds() - t0;
+            if (k == 0 || t < best[mode]) best[mode] = t;
+            if (mode == 0) instructions = steps;
+            if (mode == 2) {
+                // L'image incrémentale doit être celle d'un rendu complet
+                size_t bytes = (size_t)fb.height * (1 + 3 * (size_t)fb.width);
+                u8 *copy = malloc(bytes);
+                if (copy == NULL) return 1;
+                memcpy(copy, fb.pixels, bytes);
+                frames = fb.renders;
+                lines = fb.lines_rendered;
+                fb_invalidate(&fb);
+                fb_render(&fb);
+                same &= memcmp(copy, fb.pixels, bytes) == 0;
+                free(copy);
+            }
+            if (mode) fb_detach(&fb);
+        }
+    }
+    for (int mode = 0; mode < 4; mode++) {
+        printf("%-26s : %8.2f MIPS, %8.0f images/s", names[mode], instructions / best[mode] / 1e6,
+               cycles / FB_BENCH_FRAME / best[mode]);
+        if (mode) printf(", surcout %5.1f%%", 100.0 * (best[mode] - best[0]) / best[0]);
+        printf("\n");
+    }
+    printf("Lignes redessinees par image : %.1f sur 200 en moyenne\n", frames ? (double)lines / frames : 0.0);
+
+    // Encodage PNG d'une image (non compressée : 192 Ko)
+    FILE *null = fopen("/dev/null", "wb");
+    if (null == NULL || !fb_attach(&fb, &mem, 0x2000, FB_MONO, 320, 200)) return 1;
+    fb_render(&fb);
+    const int shots = 50;
+    double t0 = now_seconds();
+    for (int i = 0; i < shots; i++) same &= fb_write_png(&fb, null);
+    double t = now_seconds() - t0;
+    fb_detach(&fb);
+    fclose(null);
+    printf("Capture PNG : %.2f ms par image\n", t / shots * 1e3);
+    printf("Images identiques a un rendu complet : %s\n", same ? "oui" : "NON");
+    return same ? 0 : 1;
+}
+
+// --- Appels hôte ---
+// 1 Mo écrit dans /dev/null par HC_WRITE, un octet par appel (comme une
+// UART) puis 4 Ko par appel
+static int bench_hostcall(void) {
+    static const u8 programs[2][16] = {
+        { 0xA2, 0x00,         // 0200 LDX #$00    bloc en $0300
+          0xA0, 0x03,         // 0202 LDY #$03
+          0xA9, HC_WRITE,     // 0204 LDA #HC_WRITE
+          0x8D, 0x00, 0xF0,   // 0206 STA $F000
+          0xEE, 0x01, 0x03,   // 0209 INC $0301   octet suivant
+          0x4C, 0x00, 0x02 }, // 020C JMP $0200
+        { 0xA2, 0x00, 0xA0, 0x03, 0xA9, HC_WRITE, 0x8D, 0x00, 0xF0, 0x4C, 0x00, 0x02 },
+    };
+    const u64 total = 1 << 20;
+    const char *names[2] = { "1 octet par appel", "4 Ko par appel" };
+    static Memory mem;
+    static HostCall hc;
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) return 1;
+    printf("=== Benchmark des appels hote (%llu octets vers /dev/null) ===\n", (unsigned long long)total);
+    int ok = 1;
+    for (int k = 0; k < 2; k++) {
+        mem_init(&mem);
+        mem_load_bytes(&mem, 0x0200, programs[k], sizeof(programs[k]));
+        u8 block[5] = { 3, 0x00, 0x10, k ? 0x00 : 0x01, k ? 0x10 : 0x00 }; // Fichier 3, $1000, 1 ou $1000 octets
+        mem_load_bytes(&mem, 0x0300, block, sizeof(block));
+        CPU cpu;
+        cpu_reset(&cpu, &mem);
+        cpu.PC = 0x0200;
+        hostcall_attach(&hc, &mem, 0xF0, &cpu);
+        hc.fds[3] = fd;
+        double t0 = now_seconds();
+        while (hc.bytes_direct < total && !(cpu.P & FLAG_C)) cpu_step(&cpu);
+        double t = now_seconds() - t0;
+        ok &= !(cpu.P & FLAG_C) && hc.bytes_copied == 0;
+        printf("%-18s : %8llu appels, %7.3f cycles emules et %7.1f ns hote par octet (%.0f Mo/s)\n", names[k],
+               (unsigned long long)hc.calls, (double)cpu.cycles / total, t / total * 1e9, total / t / 1e6);
+    }
+    close(fd);
+    printf("Appels sans erreur, sans copie : %s\n", ok ? "oui" : "NON");
+    return ok ? 0 : 1;
+}
+
+// --- Superinstructions ---
+// Moteur à blocs sans puis avec fusion (meilleur de 3 essais chacun) sur la
+// boucle de run_builtin_test de l'émulateur (INX ; CPX #imm ; BNE,
+// recommencée sans fin) et sur le test fonctionnel s'il est dans le
+// répertoire courant, jusqu'à son piège de succès. États finaux comparés.
+#define FUNCTIONAL_SUCCESS_PC 0x3469
+
+static const u8 builtin_loop_program[] = {
+    0xA2, 0x00,       // 8000 LDX #$00
+    0xE8,             // 8002 INX
+    0xE0, 0x00,       // 8003 CPX #$00   (256 tours)
+    0xD0, 0xFB,       // 8005 BNE $8002
+    0x4C, 0x00, 0x80, // 8007 JMP $8000
+};
+
+typedef struct {
+    u8 A, X, Y, P, SP;
+    u16 PC;
+    u64 cycles, hash, fused;
+    double seconds;
+} FuseRun;
+
+// Moteur à blocs jusqu'à 'max_cycles' ou jusqu'à PC == stop_pc (0 : jamais)
+static int fuse_run(const Memory *image, u16 pc, u16 stop_pc, u64 max_cycles, int fuse, FuseRun *r) {
+    static Memory mem;
+    mem_copy(&mem, image);
+    mem_set_hashing(&mem, 1); // Comparaison des mémoires finales
+    CPU cpu;
+    cpu_reset(&cpu, &mem);
+    cpu.PC = pc;
+    BlockCache *bc = block_create(&cpu);
+    if (bc == NULL) return 0;
+    bc->fuse = fuse;
+    double t0 = now_seconds();
+    while (cpu.cycles < max_cycles && (stop_pc == 0 || cpu.PC != stop_pc)) block_exec(bc, max_cycles);
+    r->seconds = now_seconds() - t0;
+    r->A = cpu.A; r->X = cpu.X; r->Y = cpu.Y; r->P = cpu.P; r->SP = cpu.SP; r->PC = cpu.PC;
+    r->cycles = cpu.cycles;
+    r->hash = mem.hash;
+    r->fused = bc->fused;
+    block_free(bc);
+    return 1;
+}
+
+static int bench_fuse(void) {
+    static Memory images[2];
+    const char *names[2] = { "run_builtin_test", "test fonctionnel" };
+    const u16 starts[2] = { 0x8000, 0x0400 };
+    const u16 stops[2] = { 0x0000, FUNCTIONAL_SUCCESS_PC };
+    const u64 limits[2] = { 200000000, 100000000 };
+    mem_init(&images[0]);
+    mem_load_bytes(&images[0], 0x8000, builtin_loop_program, sizeof(builtin_loop_program));
+    mem_init(&images[1]);
+    int workloads = access("6502_functional_test.bin", R_OK) == 0 && mem_load(&images[1], "6502_functional_test.bin", 0) ? 2 : 1;
+
+    printf("=== Benchmark des superinstructions (moteur a blocs) ===\n");
+    int ok = 1;
+    for (int w = 0; w < workloads; w++) {
+        double best[2] = { 0.0, 0.0 };
+        FuseRun r[2];
+        for (int run = 0; run < 3; run++) {
+            for (int fuse = 0; fuse < 2; fuse++) {
+                if (!fuse_run(&images[w], starts[w], stops[w], limits[w], fuse, &r[fuse])) return 1;
+                if (run == 0 || r[fuse].seconds < best[fuse]) best[fuse] = r[fuse].seconds;
+            }
+        }
+        ok &= r[0].A == r[1].A && r[0].X == r[1].X && r[0].Y == r[1].Y && r[0].P == r[1].P && r[0].SP == r[1].SP
+              && r[0].PC == r[1].PC && r[0].cycles == r[1].cycles && r[0].hash == r[1].hash;
+        printf("%-16s : %6.1f M cycles, sans fusion %7.2f MHz, avec %7.2f MHz (x%.2f), %llu superinstructions\n",
+               names[w], r[1].cycles / 1e6, r[0].cycles / best[0] / 1e6, r[1].cycles / best[1] / 1e6,
+               best[0] / best[1], (unsigned long long)r[1].fused);
+    }
+    printf("Etats identiques : %s\n", ok ? "oui" : "NON");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    const char *specs[32];
+    int count = 0;
+    int repeat = 3;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = atoi(argv[i] + 9);
+            if (repeat < 1) repeat = 1;
+        } else if (strcmp(argv[i], "--batch-bench") == 0) {
+            return bench_batch();
+        } else if (strcmp(argv[i], "--device-bench") == 0) {
+            return bench_device();
+        } else if (strcmp(argv[i], "--coverage-bench") == 0) {
+            return bench_coverage();
+        } else if (strcmp(argv[i], "--explore-bench") == 0) {
+            return bench_explore(0);
+        } else if (strncmp(argv[i], "--explore-bench=", 16) == 0) {
+            return bench_explore(atoi(argv[i] + 16));
+        } else if (strcmp(argv[i], "--fb-bench") == 0) {
+            return bench_fb();
+        } else if (strcmp(argv[i], "--hostcall-bench") == 0) {
+            return bench_hostcall();
+        } else if (strcmp(argv[i], "--fuse-bench") == 0) {
+            return bench_fuse();
+        } else if (count < 32) {
+            specs[count++] = argv[i];
+        }
+    }
+    if (count == 0) specs[count++] = "6502_functional_test.bin";
+
+    Emu6502 *emu = emu6502_create(EMU6502_NMOS);
+    static Workload w;
+    if (emu == NULL) return 1;
+
+    uint32_t v = emu6502_version();
+    printf("libemu6502 %u.%u.%u, meilleur temps sur %d execution(s)\n", v >> 16, (v >> 8) & 0xFF, v & 0xFF, repeat);
+    uint64_t total_cycles = 0, total_instructions = 0;
+    double total_time = 0.0;
+    for (int i = 0; i < count; i++) {
+        if (!workload_init(&w, specs[i])) return 1;
+        double best = 0.0;
+        uint64_t cycles = 0, instructions = 0;
+        for (int r = 0; r < repeat; r++) {
+            double t = workload_run(emu, &w, &cycles, &instructions);
+            if (r == 0 || t < best) best = t;
+        }
+        printf("%-28s %11llu cycles %11llu instr %7.3f s %8.2f MHz %8.2f MIPS\n", w.name,
+               (unsigned long long)cycles, (unsigned long long)instructions, best,
+               cycles / best / 1e6, instructions / best / 1e6);
+        total_cycles += cycles;
+        total_instructions += instructions;
+        total_time += best;
+    }
+    printf("Total : %.2f MHz %.2f MIPS\n", total_cycles / total_time / 1e6, total_instructions / total_time / 1e6);
+    emu6502_destroy(emu);
+    return 0;
+}
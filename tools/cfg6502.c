@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codemap.h"
+
+// Analyseur statique hors ligne : carte du code et graphe des blocs de base
+// d'une ROM, écrits dans le cache "rom.bin.cfg" relu par "emu-6502 --engine=block".
+
+static void usage(void) {
+    printf("Usage : cfg6502 [options] rom.bin\n");
+    printf("  -b BASE      adresse de chargement de la ROM (hexadécimal, défaut 0000)\n");
+    printf("  -e ADRESSE   point d'entrée en plus des vecteurs (hexadécimal), répétable\n");
+    printf("  -o FICHIER   cache à écrire (défaut : rom.bin.cfg)\n");
+    printf("  -d FICHIER   graphe des blocs au format Graphviz (dot)\n");
+    printf("  -l           liste des blocs\n");
+    printf("  --cpu=V      variante : nmos, 65c02, 2a03\n");
+}
+
+int main(int argc, char **argv) {
+    const char *rom = NULL, *out = NULL, *dot = NULL;
+    unsigned long base = 0;
+    CpuVariant variant = CPU_NMOS;
+    u16 entries[CODEMAP_MAX_ENTRIES];
+    int entry_count = 0, list = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            base = strtoul(argv[++i], NULL, 16);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc && entry_count < CODEMAP_MAX_ENTRIES - 3) {
+            entries[entry_count++] = (u16)strtoul(argv[++i], NULL, 16);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            dot = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0) {
+            list = 1;
+        } else if (strncmp(argv[i], "--cpu=", 6) == 0) {
+            int v = cpu_variant_from_name(argv[i] + 6);
+            if (v < 0) {
+                printf("Erreur : variante inconnue '%s'\n", argv[i] + 6);
+                return 1;
+            }
+            variant = (CpuVariant)v;
+        } else if (rom == NULL && argv[i][0] != '-') {
+            rom = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (rom == NULL || base > 0xFFFF) {
+        usage();
+        return 1;
+    }
+
+    static Memory mem;
+    mem_init(&mem);
+    if (!mem_load(&mem, rom, (u16)base)) return 1;
+
+    static CodeMap cm;
+    codemap_init(&cm);
+    if (codemap_analyze(&cm, &mem, variant, entries, entry_count) < 0) return 1;
+
+    // Résumé
+    static const char *kinds[] = { "suite", "branchement", "saut", "appel", "retour", "indirect", "arret" };
+    int per_kind[7] = {0};
+    unsigned long insns = 0, bytes = 0;
+    for (int i = 0; i < cm.block_count; i++) {
+        per_kind[cm.blocks[i].kind]++;
+        insns += cm.blocks[i].insns;
+        bytes += cm.blocks[i].end - cm.blocks[i].start + 1u;
+    }
+    printf("Points d'entree :");
+    for (int i = 0; i < cm.entry_count; i++) printf(" $%04X", cm.entries[i]);
+    printf("\n");
+    printf("Blocs : %d, instructions : %lu, octets de code : %lu\n", cm.block_count, insns, bytes);
+    printf("Fins de bloc :");
+    for (int k = 0; k < 7; k++) printf(" %s %d%s", kinds[k], per_kind[k], k < 6 ? "," : "\n");
+    if (cm.conflicts) printf("Conflits (saut au milieu d'une instruction) : %d\n", cm.conflicts);
+
+    if (list) {
+        for (int i = 0; i < cm.block_count; i++) {
+            const CodeBlock *b = &cm.blocks[i];
+            printf("  $%04X-$%04X %3u instr. %-11s", b->start, b->end, b->insns, kinds[b->kind]);
+            for (int s = 0; s < b->succ_count; s++) printf(" -> $%04X", b->succ[s]);
+            printf("\n");
+        }
+    }
+
+    if (dot) {
+        FILE *f = fopen(dot, "w");
+        if (f == NULL) {
+            printf("Erreur : Impossible d'écrire le fichier %s\n", dot);
+            return 1;
+        }
+        codemap_write_dot(&cm, f);
+        fclose(f);
+    }
+
+    char path[1024];
+    if (out == NULL) {
+        codemap_cache_path(rom, path, sizeof(path));
+        out = path;
+    }
+    int ok = codemap_save(&cm, out);
+    if (ok) printf("Cache ecrit : %s\n", out);
+    codemap_free(&cm);
+    return ok ? 0 : 1;
+}
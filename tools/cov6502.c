@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "coverage.h"
+
+// Fichiers de couverture écrits par "emu-6502 --coverage=FICHIER" : bilan,
+// fusion de plusieurs runs, rapport lcov (genhtml, Codecov...) rattaché aux
+// lignes source par le fichier --dbgfile de ld65.
+
+static void usage(void) {
+    printf("Usage : cov6502 COMMANDE [options] fichiers.cov...\n");
+    printf("  info a.cov [b.cov...]              bilan de l'union des fichiers\n");
+    printf("  merge -o out.cov a.cov b.cov...    union des fichiers (out.cov remplacé)\n");
+    printf("  lcov -d prog.dbg rom.bin a.cov...  rapport lcov des lignes source\n");
+    printf("  -d FICHIER   informations de débogage ld65 (--dbgfile)\n");
+    printf("  -b BASE      adresse de chargement de la ROM (hexadécimal, défaut 0000)\n");
+    printf("  -o FICHIER   sortie (lcov : défaut sortie standard)\n");
+}
+
+// Union des fichiers de couverture
+static int load_all(Coverage *c, char **paths, int count) {
+    static Coverage other;
+    if (!cov_load(c, paths[0])) return 0;
+    for (int i = 1; i < count; i++) {
+        if (!cov_load(&other, paths[i])) return 0;
+        if (!cov_merge(c, &other)) {
+            printf("Erreur : %s et %s n'ont pas la meme variante de CPU\n", paths[0], paths[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *cmd = argc > 1 ? argv[1] : NULL;
+    const char *dbg = NULL, *output = NULL;
+    long base = 0;
+    char *paths[256];
+    int path_count = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            dbg = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            base = strtol(argv[++i], NULL, 16) & 0xFFFF;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (path_count < 256) {
+            paths[path_count++] = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (cmd == NULL) {
+        usage();
+        return 1;
+    }
+
+    static Coverage cov;
+    if (strcmp(cmd, "info") == 0 && path_count >= 1) {
+        if (!load_all(&cov, paths, path_count)) return 1;
+        CovSummary s;
+        cov_summary(&cov, &s);
+        printf("CPU %s : %u instructions executees, %u branches conditionnelles\n",
+               cpu_machine(cov.variant)->name, s.instructions, s.branches);
+        printf("Branches prises dans les deux sens : %u (%.1f %%)\n", s.both_ways,
+               s.branches ? 100.0 * s.both_ways / s.branches : 0.0);
+        return 0;
+    }
+    if (strcmp(cmd, "merge") == 0 && output && path_count >= 1) {
+        if (!load_all(&cov, paths, path_count)) return 1;
+        unlink(output); // cov_save fusionne avec un fichier existant
+        return cov_save(&cov, output) ? 0 : 1;
+    }
+    if (strcmp(cmd, "lcov") == 0 && dbg && path_count >= 2) {
+        static Memory mem;
+        mem_init(&mem);
+        if (!mem_load(&mem, paths[0], (u16)base)) return 1;
+        if (!load_all(&cov, paths + 1, path_count - 1)) return 1;
+        FILE *out = output ? fopen(output, "w") : stdout;
+        if (out == NULL) {
+            printf("Erreur : Impossible de creer le fichier %s\n", output);
+            return 1;
+        }
+        int ok = cov_write_lcov(&cov, &mem, dbg, out);
+        if (output) fclose(out);
+        return ok ? 0 : 1;
+    }
+    usage();
+    return 1;
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "disasm.h"
+
+// Désassembleur en ligne de commande : listing d'une plage mémoire, ou
+// annotation d'une trace produite par "emu-6502 --trace".
+
+static void usage(void) {
+    printf("Usage : dis6502 [options] rom.bin [DEBUT[-FIN]]\n");
+    printf("  -s FICHIER   symboles (labels VICE / ld65 -Ln, ou ld65 --dbgfile), répétable\n");
+    printf("  -t FICHIER   annote la trace (lignes contenant \"PC: XXXX\") au lieu du listing\n");
+    printf("  -b BASE      adresse de chargement de la ROM (hexadécimal, défaut 0000)\n");
+    printf("  --cpu=V      variante : nmos, 65c02, 2a03\n");
+}
+
+// Tampon de sortie : on évite printf sur le chemin chaud (une trace fait des millions de lignes)
+static char outbuf[1 << 20];
+static size_t outlen;
+
+static void out_write(const char *data, size_t len) {
+    if (outlen + len > sizeof(outbuf)) {
+        fwrite(outbuf, 1, outlen, stdout);
+        outlen = 0;
+    }
+    memcpy(outbuf + outlen, data, len);
+    outlen += len;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Suffixe "  ; [label: ]instruction\n" déjà formaté, par adresse
+static char suffixes[MAX_MEMORY][96];
+static u8 suffix_len[MAX_MEMORY]; // 0 = pas encore construit
+
+static void build_suffix(DisasmCache *cache, u16 pc) {
+    const DecodedInsn *insn = disasm_get(cache, pc);
+    const char *label = cache->symbols ? cache->symbols->names[pc] : NULL;
+    int n = label ? snprintf(suffixes[pc], sizeof(suffixes[pc]), "  ; %.40s: %s\n", label, insn->text)
+                  : snprintf(suffixes[pc], sizeof(suffixes[pc]), "  ; %s\n", insn->text);
+    suffix_len[pc] = (u8)n;
+}
+
+// Cherche "PC: " (mêmes performances que memmem, sans l'extension GNU)
+static const char *find_pc(const char *p, const char *end) {
+    while ((p = memchr(p, 'P', end - p)) != NULL) {
+        if (end - p >= 4 && p[1] == 'C' && p[2] == ':' && p[3] == ' ') return p;
+        p++;
+    }
+    return NULL;
+}
+
+// Ajoute "  ; [label: ]instruction" si la ligne contient "PC: XXXX" ou "PC: 0xXXXX"
+static void annotate_line(DisasmCache *cache, const char *line, size_t len) {
+    out_write(line, len);
+    const char *end = line + len;
+    const char *p = find_pc(line, end);
+    if (p) {
+        p += 4;
+        if (end - p >= 2 && p[0] == '0' && p[1] == 'x') p += 2;
+        int pc = 0, digits = 0, d;
+        while (p < end && digits < 4 && (d = hex_digit(*p)) >= 0) {
+            pc = (pc << 4) | d;
+            p++;
+            digits++;
+        }
+        if (digits > 0) {
+            if (suffix_len[pc] == 0) build_suffix(cache, (u16)pc);
+            out_write(suffixes[pc], suffix_len[pc]);
+            return;
+        }
+    }
+    out_write("\n", 1);
+}
+
+// Annote chaque ligne de la trace avec l'instruction désassemblée (lecture par blocs)
+static int annotate_trace(DisasmCache *cache, const char *filename) {
+    FILE *in = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "rb");
+    if (in == NULL) {
+        printf("Erreur : Impossible d'ouvrir le fichier %s\n", filename);
+        return 1;
+    }
+    static char inbuf[1 << 20];
+    size_t kept = 0, n;
+    while ((n = fread(inbuf + kept, 1, sizeof(inbuf) - kept, in)) > 0 || kept > 0) {
+        size_t avail = kept + n;
+        char *start = inbuf, *stop = inbuf + avail, *nl;
+        while ((nl = memchr(start, '\n', stop - start)) != NULL) {
+            annotate_line(cache, start, nl - start);
+            start = nl + 1;
+        }
+        kept = stop - start;
+        if (n == 0 || kept == sizeof(inbuf)) {
+            // Fin de fichier sans retour à la ligne, ou ligne plus grande que le tampon
+            annotate_line(cache, start, kept);
+            kept = 0;
+            if (n == 0) break;
+        } else {
+            memmove(inbuf, start, kept);
+        }
+    }
+    fwrite(outbuf, 1, outlen, stdout);
+    outlen = 0;
+    if (in != stdin) fclose(in);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *rom = NULL, *trace = NULL, *range = NULL;
+    unsigned long base = 0;
+    CpuVariant variant = CPU_NMOS;
+
+    static SymbolTable symbols;
+    symbols_init(&symbols);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (symbols_load(&symbols, argv[++i]) < 0) return 1;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            base = strtoul(argv[++i], NULL, 16);
+        } else if (strncmp(argv[i], "--cpu=", 6) == 0) {
+            int v = cpu_variant_from_name(argv[i] + 6);
+            if (v < 0) {
+                printf("Erreur : variante inconnue '%s'\n", argv[i] + 6);
+                return 1;
+            }
+            variant = (CpuVariant)v;
+        } else if (rom == NULL && argv[i][0] != '-') {
+            rom = argv[i];
+        } else if (range == NULL && argv[i][0] != '-') {
+            range = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (rom == NULL || base > 0xFFFF) {
+        usage();
+        return 1;
+    }
+
+    static Memory mem;
+    mem_init(&mem);
+    int size = mem_load(&mem, rom, (u16)base);
+    if (!size) return 1;
+
+    DisasmCache *cache = disasm_create(&mem, variant);
+    if (cache == NULL) return 1;
+    cache->symbols = &symbols;
+
+    int status = 0;
+    if (trace) {
+        status = annotate_trace(cache, trace);
+    } else {
+        unsigned long start = base, end = base + size - 1;
+        if (range) {
+            char *p;
+            start = strtoul(range, &p, 16);
+            end = (*p == '-') ? strtoul(p + 1, NULL, 16) : 0xFFFF;
+        }
+        if (start > 0xFFFF || end > 0xFFFF || start > end) {
+            printf("Erreur : plage invalide\n");
+            status = 1;
+        } else {
+            static char listbuf[1 << 20];
+            setvbuf(stdout, listbuf, _IOFBF, sizeof(listbuf));
+            disasm_listing(cache, (u16)start, (u16)end, stdout);
+        }
+    }
+
+    disasm_free(cache);
+    symbols_free(&symbols);
+    return status;
+}
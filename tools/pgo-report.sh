@@ -0,0 +1,75 @@
+#!/bin/sh
+# Rapport après PGO (make pgo) :
+#  - répartition chaud/froid du code, façon BOLT : GCC range les fonctions
+#    selon le profil dans .text.hot (chaudes), .text.unlikely (jamais ou
+#    rarement exécutées) ou .text (le reste), et découpe les fonctions
+#    mixtes en une partie chaude et une partie "nom.cold" ;
+#  - comparaison des MIPS avant/après, charge de travail par charge de travail.
+#
+# Usage : tools/pgo-report.sh DOSSIER_OBJETS AVANT.txt APRES.txt
+#         (AVANT/APRES : sorties de bench6502)
+
+dir=$1
+before=$2
+after=$3
+if [ -z "$dir" ] || [ ! -d "$dir" ]; then
+    echo "Usage : $0 DOSSIER_OBJETS [AVANT.txt APRES.txt]" >&2
+    exit 1
+fi
+
+tmp=$(mktemp)
+trap 'rm -f "$tmp"' EXIT
+
+# Une ligne par section de code : module, classe, fonction, taille
+for o in "$dir"/*.o; do
+    readelf -SW "$o" | sed -n 's/^ *\[ *[0-9]*\] *//p' | awk -v obj="$(basename "$o" .o)" '
+        function hex(s,   i, n) {
+            n = 0
+            for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", tolower(substr(s, i, 1))) - 1
+            return n
+        }
+        $2 == "PROGBITS" && $1 ~ /^\.text/ {
+            cls = "normal"; fn = $1
+            if (sub(/^\.text\.hot\.?/, "", fn)) cls = "chaud"
+            else if (sub(/^\.text\.unlikely\.?/, "", fn)) cls = "froid"
+            else if (sub(/^\.text\.(startup|exit)\.?/, "", fn)) cls = "demarrage"
+            else sub(/^\.text\.?/, "", fn)
+            if (fn == "") fn = "-"
+            print obj, cls, fn, hex($5)
+        }'
+done > "$tmp"
+
+echo "=== Repartition chaud/froid ($dir) ==="
+awk '
+    { size[$2] += $4; total += $4 }
+    END {
+        n = split("chaud normal froid demarrage", order, " ")
+        for (i = 1; i <= n; i++) {
+            c = order[i]
+            printf "  %-10s %7d octets  %5.1f %%\n", c, size[c], total ? 100 * size[c] / total : 0
+        }
+    }' "$tmp"
+
+echo "Fonctions chaudes (les plus grosses) :"
+awk '$2 == "chaud" && $3 != "-" { printf "  %6d  %s/%s\n", $4, $1, $3 }' "$tmp" | sort -rn | head -15
+echo "  ($(awk '$2 == "chaud" && $3 != "-"' "$tmp" | wc -l) fonctions chaudes au total)"
+
+# Une fonction présente à la fois en .text.unlikely et ailleurs a été découpée :
+# sa partie froide (chemins d'erreur, cas rares) est sortie du chemin chaud
+echo "Fonctions decoupees chaud/froid (taille de la partie froide) :"
+awk '
+    $3 == "-" { next }
+    $2 == "froid" { cold[$1 "/" $3] = $4; next }
+    { warm[$1 "/" $3] = 1 }
+    END { for (f in cold) if (f in warm) printf "  %6d  %s\n", cold[f], f }' "$tmp" | sort -rn | head -15
+
+if [ -n "$before" ] && [ -n "$after" ]; then
+    echo "=== MIPS avant / apres PGO ==="
+    awk '
+        /MIPS$/ && FNR == NR { mips[$1] = $(NF - 1); next }
+        /MIPS$/ {
+            if ($1 == "Total") name = "Total"; else name = $1
+            b = mips[name]
+            printf "  %-28s %8.2f -> %8.2f MIPS  (x%.2f)\n", name, b, $(NF - 1), b ? $(NF - 1) / b : 0
+        }' "$before" "$after"
+fi
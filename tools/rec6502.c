@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codemap.h"
+#include "disasm.h"
+
+// Recompilateur statique : traduit une ROM en C, une fonction par routine
+// découverte par l'analyse du flot de contrôle (codemap.c). Chaque
+// instruction devient un appel direct à son handler de instructions.c avec
+// l'adresse effective résolue à la traduction quand elle ne dépend pas des
+// registres ; les modes indexés et indirects appellent leur fonction de
+// addressing.c. Le fichier produit se compile avec src/aot.c et le cœur
+// (voir "make aot").
+
+static void usage(void) {
+    printf("Usage : rec6502 [options] rom.bin\n");
+    printf("  -b BASE      adresse de chargement de la ROM (hexadécimal, défaut 0000)\n");
+    printf("  -e ADRESSE   point d'entrée en plus des vecteurs (hexadécimal), répétable ;\n");
+    printf("               le premier est l'adresse de démarrage (défaut : vecteur de reset)\n");
+    printf("  -o FICHIER   source C à écrire (défaut : rom.bin.aot.c)\n");
+    printf("  --cpu=V      variante : nmos, 65c02, 2a03\n");
+}
+
+static const char *variant_names[CPU_VARIANT_COUNT] = { "CPU_NMOS", "CPU_65C02", "CPU_2A03" };
+
+// Handlers qui écrivent en mémoire : s'ils peuvent toucher la suite du bloc,
+// le code traduit vérifie ensuite qu'il n'a pas été invalidé
+static int writes_memory(const char *ins) {
+    static const char *stores[] = {
+        "ins_STA", "ins_STX", "ins_STY", "ins_STZ", "ins_INC", "ins_DEC",
+        "ins_ASL", "ins_LSR", "ins_ROL", "ins_ROR", "ins_TSB", "ins_TRB",
+    };
+    for (size_t i = 0; i < sizeof(stores) / sizeof(stores[0]); i++) {
+        if (strcmp(ins, stores[i]) == 0) return 1;
+    }
+    // RMB0..7, SMB0..7 (65C02)
+    return strncmp(ins, "ins_RMB", 7) == 0 || strncmp(ins, "ins_SMB", 7) == 0;
+}
+
+// Handlers qui peuvent lever une interruption ou changer I : écriture sur un
+// périphérique (la page n'est connue qu'à l'exécution), CLI, SEI, PLP. Le
+// code traduit scrute ensuite comme l'interpréteur (aot_interrupted).
+static int raises_events(const char *ins) {
+    return writes_memory(ins) || strcmp(ins, "ins_CLI") == 0 || strcmp(ins, "ins_SEI") == 0
+        || strcmp(ins, "ins_PLP") == 0;
+}
+
+// Modes dont l'adresse effective est connue à la traduction
+static int fixed_mode(u8 mode) {
+    return mode == DIS_ZERO_PAGE || mode == DIS_ABSOLUTE || mode == DIS_RELATIVE;
+}
+
+typedef struct {
+    const CodeMap *cm;
+    Memory *mem;
+    const MachineDesc *machine;
+    int *owner;   // Bloc -> routine
+    int *roots;   // Routine -> bloc d'entrée
+    int *entry;   // Bloc -> numéro dans sa fonction
+    u8 *targeted; // Bloc atteint par un goto (étiquette e_ nécessaire)
+    int routines;
+} Translation;
+
+static int block_index(const CodeMap *cm, u16 address) {
+    const CodeBlock *b = codemap_block_at(cm, address);
+    return b ? (int)(b - cm->blocks) : -1;
+}
+
+// Successeurs qui restent dans la même routine : suite, branchements, sauts
+// directs, retour d'appel (atteint par RTS via aot_run) et retour de BRK
+static int local_successors(const CodeBlock *b, u16 *succ) {
+    switch (b->kind) {
+    case BLOCK_FALL: case BLOCK_BRANCH: case BLOCK_JUMP: case BLOCK_STOP:
+        memcpy(succ, b->succ, sizeof(b->succ));
+        return b->succ_count;
+    case BLOCK_CALL:
+        succ[0] = b->succ[1];
+        return b->succ_count - 1;
+    default:
+        return 0;
+    }
+}
+
+// Attribue à la routine tous les blocs encore libres atteints depuis 'root'
+static void claim(Translation *t, int root, int *queue) {
+    int r = t->routines++;
+    int head = 0, tail = 0;
+    t->roots[r] = root;
+    t->owner[root] = r;
+    queue[tail++] = root;
+    while (head < tail) {
+        u16 succ[2];
+        int n = local_successors(&t->cm->blocks[queue[head++]], succ);
+        for (int s = 0; s < n; s++) {
+            int i = block_index(t->cm, succ[s]);
+            if (i >= 0 && t->owner[i] < 0) {
+                t->owner[i] = r;
+                queue[tail++] = i;
+            }
+        }
+    }
+}
+
+// Découpage en routines : points d'entrée, puis cibles de JSR, puis blocs
+// atteints seulement par un saut indirect ou un vecteur
+static void partition(Translation *t, int *queue) {
+    const CodeMap *cm = t->cm;
+    for (int i = 0; i < cm->block_count; i++) t->owner[i] = -1;
+    for (int e = 0; e < cm->entry_count; e++) {
+        int i = block_index(cm, cm->entries[e]);
+        if (i >= 0 && t->owner[i] < 0) claim(t, i, queue);
+    }
+    for (int b = 0; b < cm->block_count; b++) {
+        if (cm->blocks[b].kind != BLOCK_CALL) continue;
+        int i = block_index(cm, cm->blocks[b].succ[0]);
+        if (i >= 0 && t->owner[i] < 0) claim(t, i, queue);
+    }
+    for (int i = 0; i < cm->block_count; i++) {
+        if (t->owner[i] < 0) claim(t, i, queue);
+    }
+
+    // Numéros dans chaque fonction et cibles de goto
+    int *next_entry = calloc(t->routines, sizeof(int));
+    for (int i = 0; i < cm->block_count; i++) t->entry[i] = next_entry[t->owner[i]]++;
+    free(next_entry);
+    for (int b = 0; b < cm->block_count; b++) {
+        const CodeBlock *blk = &cm->blocks[b];
+        int n = blk->kind == BLOCK_FALL || blk->kind == BLOCK_BRANCH || blk->kind == BLOCK_JUMP
+                || blk->kind == BLOCK_CALL ? blk->succ_count : 0;
+        if (blk->kind == BLOCK_CALL) n = 1;
+        for (int s = 0; s < n; s++) {
+            int i = block_index(cm, blk->succ[s]);
+            if (i >= 0 && t->owner[i] == t->owner[b]) t->targeted[i] = 1;
+        }
+    }
+}
+
+// Continue vers 'target' : goto si le bloc est dans la même fonction, sinon
+// retour à aot_run (PC est déjà positionné)
+static void emit_goto(FILE *out, const Translation *t, int from, u16 target) {
+    int i = block_index(t->cm, target);
+    if (i >= 0 && t->owner[i] == t->owner[from]) {
+        fprintf(out, "    goto e_%04X;\n", target);
+    } else {
+        fprintf(out, "    return;\n");
+    }
+}
+
+// Traduit un bloc. Retourne le nombre d'instructions.
+static int emit_block(FILE *out, FILE *spans, const Translation *t, int b) {
+    const CodeBlock *blk = &t->cm->blocks[b];
+    if (t->targeted[b]) fprintf(out, "e_%04X:\n    if (aot_leave(cpu, rt, 0x%04X)) return;\n", blk->start, blk->start);
+    fprintf(out, "b_%04X:\n", blk->start);
+
+    unsigned int pc = blk->start;
+    int count = 0;
+    while (pc <= blk->end) {
+        DecodedInsn insn;
+        disasm_decode(t->machine->ops, t->mem, (u16)pc, &insn);
+        const OpcodeSymbols *sym = &t->machine->symbols[insn.bytes[0]];
+        char text[64];
+        disasm_format(&insn, NULL, text, sizeof(text));
+        u16 next = (u16)(pc + insn.length);
+
+        fprintf(out, "    cpu->op_pc = 0x%04X; ", pc);
+        switch (insn.mode) {
+        case DIS_IMPLIED: case DIS_ACCUMULATOR:
+            fprintf(out, "cpu->PC = 0x%04X; %s(cpu, 0);", next, sym->instruction);
+            break;
+        case DIS_IMMEDIATE:
+            // L'opérande est relu à l'exécution : le modifier n'invalide rien
+            fprintf(out, "cpu->PC = 0x%04X; %s(cpu, 0x%04X);", next, sym->instruction, (u16)(pc + 1));
+            break;
+        case DIS_ZERO_PAGE: case DIS_ABSOLUTE: case DIS_RELATIVE:
+            fprintf(out, "cpu->PC = 0x%04X; %s(cpu, 0x%04X);", next, sym->instruction, insn.target);
+            break;
+        default:
+            fprintf(out, "cpu->PC = 0x%04X; %s(cpu, %s(cpu));", (u16)(pc + 1), sym->instruction, sym->addrmode);
+            break;
+        }
+        fprintf(out, " cpu->cycles += %u; // %s\n", insn.entry->cycles, text);
+
+        // En fin de bloc, aot_leave fait les deux tests à l'étiquette suivante
+        int fixed = fixed_mode(insn.mode);
+        int dirty = writes_memory(sym->instruction) && next <= blk->end
+                    && (!fixed || (insn.target >= next && insn.target <= blk->end));
+        int events = raises_events(sym->instruction) && next <= blk->end;
+        if (dirty || events) {
+            fprintf(out, "    if (%s%s%s) return;\n", dirty ? "rt->dirty" : "", dirty && events ? " || " : "",
+                    events ? "aot_interrupted(cpu)" : "");
+        }
+
+        // Octets recopiés : l'opcode, et l'opérande des adresses fixes
+        int baked = fixed ? insn.length : 1;
+        fprintf(spans, "    { 0x%04X, 0x%04X, %d, {", blk->start, pc, baked);
+        for (int k = 0; k < baked; k++) fprintf(spans, " 0x%02X%s", insn.bytes[k], k + 1 < baked ? "," : "");
+        fprintf(spans, " } },\n");
+
+        count++;
+        pc += insn.length;
+    }
+
+    switch (blk->kind) {
+    case BLOCK_FALL: case BLOCK_JUMP: case BLOCK_CALL:
+        emit_goto(out, t, b, blk->succ[0]);
+        break;
+    case BLOCK_BRANCH:
+        if (blk->succ_count == 2 && blk->succ[0] != blk->succ[1]) {
+            int i = block_index(t->cm, blk->succ[0]);
+            if (i >= 0 && t->owner[i] == t->owner[b]) {
+                fprintf(out, "    if (cpu->PC == 0x%04X) goto e_%04X;\n", blk->succ[0], blk->succ[0]);
+                emit_goto(out, t, b, blk->succ[1]);
+                break;
+            }
+            emit_goto(out, t, b, blk->succ[1]);
+            break;
+        }
+        emit_goto(out, t, b, blk->succ[0]);
+        break;
+    default: // RTS, RTI, JMP indirect, BRK : aot_run suit PC
+        fprintf(out, "    return;\n");
+        break;
+    }
+    return count;
+}
+
+int main(int argc, char **argv) {
+    const char *rom = NULL, *path = NULL;
+    unsigned long base = 0;
+    CpuVariant variant = CPU_NMOS;
+    u16 entries[CODEMAP_MAX_ENTRIES];
+    int entry_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            base = strtoul(argv[++i], NULL, 16);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc && entry_count < CODEMAP_MAX_ENTRIES - 3) {
+            entries[entry_count++] = (u16)strtoul(argv[++i], NULL, 16);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (strncmp(argv[i], "--cpu=", 6) == 0) {
+            int v = cpu_variant_from_name(argv[i] + 6);
+            if (v < 0) {
+                printf("Erreur : variante inconnue '%s'\n", argv[i] + 6);
+                return 1;
+            }
+            variant = (CpuVariant)v;
+        } else if (rom == NULL && argv[i][0] != '-') {
+            rom = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (rom == NULL || base > 0xFFFF || strchr(rom, '"') || strchr(rom, '\\')) {
+        usage();
+        return 1;
+    }
+
+    static Memory mem;
+    mem_init(&mem);
+    if (!mem_load(&mem, rom, (u16)base)) return 1;
+
+    static CodeMap cm;
+    codemap_init(&cm);
+    if (codemap_analyze(&cm, &mem, variant, entries, entry_count) < 0) return 1;
+    u16 start = entry_count ? entries[0] : (u16)(mem_peek(&mem, 0xFFFC) | (mem_peek(&mem, 0xFFFD) << 8));
+
+    Translation t = { &cm, &mem, cpu_machine(variant), NULL, NULL, NULL, NULL, 0 };
+    int n = cm.block_count;
+    int *queue = malloc(n * sizeof(int));
+    t.owner = malloc(n * sizeof(int));
+    t.roots = malloc(n * sizeof(int));
+    t.entry = malloc(n * sizeof(int));
+    t.targeted = calloc(n, 1);
+    if (queue == NULL || t.owner == NULL || t.roots == NULL || t.entry == NULL || t.targeted == NULL) {
+        printf("Erreur : mémoire insuffisante\n");
+        return 1;
+    }
+    partition(&t, queue);
+
+    char default_path[1024];
+    if (path == NULL) {
+        snprintf(default_path, sizeof(default_path), "%s.aot.c", rom);
+        path = default_path;
+    }
+    FILE *out = fopen(path, "w");
+    FILE *spans = tmpfile();
+    if (out == NULL || spans == NULL) {
+        printf("Erreur : Impossible d'écrire le fichier %s\n", path);
+        return 1;
+    }
+
+    fprintf(out, "// Traduit par rec6502 depuis %s (%s) : ne pas modifier.\n", rom, t.machine->name);
+    fprintf(out, "#include \"aot.h\"\n#include \"instructions.h\"\n#include \"addressing.h\"\n");
+
+    // Une fonction par routine : switch dense vers le bloc demandé, puis
+    // enchaînement des blocs par goto
+    long insns = 0;
+    for (int r = 0; r < t.routines; r++) {
+        u16 root = cm.blocks[t.roots[r]].start;
+        fprintf(out, "\nstatic void r_%04X(CPU *cpu, AotRuntime *rt, int entry) {\n", root);
+        fprintf(out, "    (void)rt;\n    switch (entry) {\n");
+        for (int b = 0; b < n; b++) {
+            if (t.owner[b] == r) fprintf(out, "    case %d: goto b_%04X;\n", t.entry[b], cm.blocks[b].start);
+        }
+        fprintf(out, "    default: return;\n    }\n");
+        for (int b = 0; b < n; b++) {
+            if (t.owner[b] == r) insns += emit_block(out, spans, &t, b);
+        }
+        fprintf(out, "}\n");
+    }
+
+    fprintf(out, "\nstatic const AotBlock blocks[] = {\n");
+    for (int b = 0; b < n; b++) {
+        fprintf(out, "    { 0x%04X, %d, r_%04X },\n", cm.blocks[b].start, t.entry[b], cm.blocks[t.roots[t.owner[b]]].start);
+    }
+    fprintf(out, "};\n\nstatic const AotSpan spans[] = {\n");
+    rewind(spans);
+    char line[128];
+    while (fgets(line, sizeof(line), spans)) fputs(line, out);
+    fclose(spans);
+    fprintf(out, "};\n\nconst AotImage aot_image = {\n");
+    fprintf(out, "    \"%s\", 0x%04lX, 0x%04X, %s, 0x%016llXULL, %d,\n", rom, base, start,
+            variant_names[variant], (unsigned long long)cm.image_hash, t.routines);
+    fprintf(out, "    blocks, %d, spans, %ld,\n};\n", n, insns);
+    int ok = fclose(out) == 0;
+
+    printf("Traduit : %d routines, %d blocs, %ld instructions -> %s\n", t.routines, n, insns, path);
+    free(queue);
+    free(t.owner);
+    free(t.roots);
+    free(t.entry);
+    free(t.targeted);
+    codemap_free(&cm);
+    return ok ? 0 : 1;
+}
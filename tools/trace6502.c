@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+// Lecture des traces binaires écrites par "emu-6502 --trace-file=FICHIER" :
+// tout se fait en flux, un paquet décodé à la fois.
+
+static void usage(void) {
+    printf("Usage : trace6502 COMMANDE [options] trace.bin [trace2.bin]\n");
+    printf("  info trace.bin           taille, paquets, taux de compression\n");
+    printf("  show trace.bin N         entrées autour de l'instruction N\n");
+    printf("  show -c CYCLE trace.bin  entrées autour du cycle CYCLE\n");
+    printf("  grep trace.bin PC        entrées exécutées en PC (hexadécimal)\n");
+    printf("  diff a.bin b.bin         première entrée qui diffère\n");
+    printf("  -w N         entrées affichées avant et après (défaut 5)\n");
+    printf("  -n N         grep : au plus N lignes (défaut 20, 0 : toutes)\n");
+}
+
+// Affiche les entrées [first, first + count) (moins en fin de trace)
+static int print_range(TraceReader *r, u64 first, u64 count, u64 mark) {
+    if (!trace_seek(r, first)) {
+        printf("Erreur : entrée %llu hors de la trace (%llu entrées)\n", (unsigned long long)first,
+               (unsigned long long)r->steps);
+        return 1;
+    }
+    TraceEntry e;
+    for (u64 i = 0; i < count; i++) {
+        int ok = trace_next(r, &e);
+        if (ok < 0) {
+            printf("Erreur : trace corrompue\n");
+            return 1;
+        }
+        if (ok == 0) break;
+        fputs(e.index == mark ? "> " : "  ", stdout);
+        trace_print(&e, stdout);
+    }
+    return 0;
+}
+
+static int cmd_info(TraceReader *r, const char *path) {
+    FILE *f = fopen(path, "rb");
+    long size = 0;
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fclose(f);
+    }
+    printf("Trace %s : %llu instructions, %u paquets, %ld octets%s\n", path, (unsigned long long)r->steps,
+           r->chunk_count, size, r->indexed ? "" : " (index reconstruit : trace interrompue)");
+    if (r->chunk_count == 0) return 0;
+    const TraceChunkInfo *last = &r->chunks[r->chunk_count - 1];
+    printf("Cycles : %llu a %llu (debut du dernier paquet)\n", (unsigned long long)r->chunks[0].first_cycles,
+           (unsigned long long)last->first_cycles);
+    if (r->steps) printf("Moyenne : %.2f octets par instruction\n", (double)size / r->steps);
+    return 0;
+}
+
+static int cmd_grep(TraceReader *r, u16 pc, u64 max) {
+    TraceEntry e;
+    u64 hits = 0;
+    int ok;
+    while ((ok = trace_next(r, &e)) == 1) {
+        if (e.PC != pc) continue;
+        if (max == 0 || hits < max) trace_print(&e, stdout);
+        hits++;
+    }
+    if (ok < 0) {
+        printf("Erreur : trace corrompue\n");
+        return 1;
+    }
+    printf("%llu passages en $%04X\n", (unsigned long long)hits, pc);
+    return 0;
+}
+
+static int cmd_diff(TraceReader *a, TraceReader *b, u64 window) {
+    TraceEntry ea, eb;
+    u64 n = 0; // Entrée comparée
+    for (;; n++) {
+        int ra = trace_next(a, &ea), rb = trace_next(b, &eb);
+        if (ra < 0 || rb < 0) {
+            printf("Erreur : trace corrompue\n");
+            return 1;
+        }
+        if (ra == 0 && rb == 0) {
+            printf("Traces identiques (%llu instructions)\n", (unsigned long long)a->steps);
+            return 0;
+        }
+        if (ra == 0 || rb == 0 || !trace_equal(&ea, &eb)) break;
+    }
+    // Premier écart : contexte commun puis chaque version
+    printf("Premiere divergence a l'instruction %llu\n", (unsigned long long)n);
+    u64 first = n > window ? n - window : 0;
+    if (n > first) {
+        printf("Contexte commun :\n");
+        if (print_range(a, first, n - first, (u64)-1)) return 1;
+    }
+    printf("Trace A :\n");
+    if (n < a->steps) print_range(a, n, window + 1, n); else printf("  (fin de trace)\n");
+    printf("Trace B :\n");
+    if (n < b->steps) print_range(b, n, window + 1, n); else printf("  (fin de trace)\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *cmd = argc > 1 ? argv[1] : NULL;
+    const char *paths[2] = { NULL, NULL };
+    const char *arg = NULL;
+    int path_count = 0;
+    u64 window = 5, max = 20;
+    long long cycle = -1;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            window = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            max = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cycle = strtoll(argv[++i], NULL, 10);
+        } else if (path_count < (cmd && strcmp(cmd, "diff") == 0 ? 2 : 1)) {
+            paths[path_count++] = argv[i];
+        } else if (arg == NULL) {
+            arg = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (cmd == NULL || path_count == 0) {
+        usage();
+        return 1;
+    }
+
+    static TraceReader r, r2;
+    if (!trace_open(&r, paths[0])) return 1;
+    int status = 1;
+    if (strcmp(cmd, "info") == 0) {
+        status = cmd_info(&r, paths[0]);
+    } else if (strcmp(cmd, "show") == 0 && (arg || cycle >= 0)) {
+        u64 n;
+        if (cycle >= 0) {
+            if (!trace_seek_cycle(&r, (u64)cycle)) {
+                printf("Erreur : cycle %lld au-dela de la trace\n", cycle);
+                trace_close(&r);
+                return 1;
+            }
+            n = r.next_index;
+        } else {
+            n = strtoull(arg, NULL, 10);
+        }
+        u64 first = n > window ? n - window : 0;
+        status = print_range(&r, first, n - first + window + 1, n);
+    } else if (strcmp(cmd, "grep") == 0 && arg) {
+        status = cmd_grep(&r, (u16)strtoul(arg, NULL, 16), max);
+    } else if (strcmp(cmd, "diff") == 0 && path_count == 2) {
+        if (trace_open(&r2, paths[1])) {
+            status = cmd_diff(&r, &r2, window);
+            trace_close(&r2);
+        }
+    } else {
+        usage();
+    }
+    trace_close(&r);
+    return status;
+}